@@ -31,6 +31,10 @@ AcceptorConfiguration HTTPServerAcceptor::makeConfig(
   conf.initialReceiveWindow = opts.initialReceiveWindow;
   conf.receiveStreamWindowSize = opts.receiveStreamWindowSize;
   conf.receiveSessionWindowSize = opts.receiveSessionWindowSize;
+  conf.maxReceiveStreamWindowSize = opts.maxReceiveStreamWindowSize;
+  conf.maxReceiveSessionWindowSize = opts.maxReceiveSessionWindowSize;
+  conf.coalesceWindowUpdates = opts.coalesceWindowUpdates;
+  conf.enableTransactionTimings = opts.enableTransactionTimings;
   conf.acceptBacklog = opts.listenBacklog;
   conf.maxConcurrentIncomingStreams = opts.maxConcurrentIncomingStreams;
 
@@ -86,6 +90,11 @@ HTTPServerAcceptor::HTTPServerAcceptor(
     : HTTPSessionAcceptor(conf, codecFactory),
       serverOptions_(options),
       handlerFactories_(handlerFactories) {
+  if (options.sessionProfilerStats) {
+    profiler_ = std::make_unique<HTTPSessionProfiler>(
+      options.sessionProfilerStats.get(), options.slowCallbackThreshold);
+    setSessionProfiler(profiler_.get());
+  }
 }
 
 void HTTPServerAcceptor::setCompletionCallback(std::function<void()> f) {
@@ -107,11 +116,20 @@ HTTPTransactionHandler* HTTPServerAcceptor::newHandler(
 
   // Create filters chain
   RequestHandler* h = nullptr;
+  const std::type_info* handlerType = nullptr;
   for (auto& factory: handlerFactories_) {
     h = factory->onRequest(h, msg);
+    if (profiler_ && !handlerType) {
+      // Attribute the chain to the handler doing the work, not the filters
+      handlerType = &typeid(*h);
+    }
   }
 
-  return new RequestHandlerAdaptor(h);
+  auto adaptor = new RequestHandlerAdaptor(h);
+  if (profiler_) {
+    adaptor->setProfiler(profiler_.get(), *handlerType);
+  }
+  return adaptor;
 }
 
 void HTTPServerAcceptor::onNewConnection(
@@ -54,6 +54,7 @@ class HTTPServerAcceptor final : public HTTPSessionAcceptor {
   const HTTPServerOptions& serverOptions_;
   std::function<void()> completionCallback_;
   const std::vector<RequestHandlerFactory*> handlerFactories_{nullptr};
+  std::unique_ptr<HTTPSessionProfiler> profiler_;
 };
 
 }
@@ -14,6 +14,7 @@
 #include <folly/io/async/AsyncServerSocket.h>
 #include <proxygen/httpserver/Filters.h>
 #include <proxygen/httpserver/RequestHandlerFactory.h>
+#include <proxygen/lib/http/session/HTTPSessionProfiler.h>
 #include <signal.h>
 
 namespace proxygen {
@@ -107,6 +108,34 @@ class HTTPServerOptions {
   size_t receiveStreamWindowSize{65536};
   size_t receiveSessionWindowSize{65536};
 
+  /**
+   * Receive window auto-tuning: if non-zero, the windows above grow up to
+   * these sizes based on the measured RTT and how fast the peer fills them.
+   */
+  size_t maxReceiveStreamWindowSize{0};
+  size_t maxReceiveSessionWindowSize{0};
+
+  /**
+   * Send at most one WINDOW_UPDATE per stream per event loop iteration,
+   * which saves control frames on services receiving many uploads.
+   */
+  bool coalesceWindowUpdates{false};
+
+  /**
+   * Record per-request latency milestones (TransactionTimings) and report
+   * them to HTTPSessionStats::recordTransactionTimings().
+   */
+  bool enableTransactionTimings{false};
+
+  /**
+   * If set, the CPU time of every session and request handler callback is
+   * measured and reported here (see HTTPSessionProfiler).  Shared by all IO
+   * threads, so it must be thread safe.  Callbacks taking longer than
+   * slowCallbackThreshold are reported individually.
+   */
+  std::shared_ptr<HTTPSessionProfilerStats> sessionProfilerStats;
+  std::chrono::microseconds slowCallbackThreshold{10000};
+
   /**
    * The maximum number of transactions the remote could initiate
    * per connection on protocols that allow multiplexing.
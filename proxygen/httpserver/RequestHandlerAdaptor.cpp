@@ -18,7 +18,8 @@
 namespace proxygen {
 
 RequestHandlerAdaptor::RequestHandlerAdaptor(RequestHandler* requestHandler)
-    : ResponseHandler(requestHandler) {
+    : ResponseHandler(requestHandler),
+      handlerType_(&typeid(*requestHandler)) {
 }
 
 void RequestHandlerAdaptor::setTransaction(HTTPTransaction* txn) noexcept {
@@ -30,8 +31,13 @@ void RequestHandlerAdaptor::setTransaction(HTTPTransaction* txn) noexcept {
 
 void RequestHandlerAdaptor::detachTransaction() noexcept {
   if (err_ == kErrorNone) {
+    HTTPSessionProfiler::HandlerScope profile(
+      profiler_, profile_, *handlerType_, "requestComplete");
     upstream_->requestComplete();
   }
+  if (profiler_) {
+    profiler_->onHandlerDetached(*handlerType_, profile_);
+  }
 
   // Otherwise we would have got some error call back and invoked onError
   // on RequestHandler
@@ -60,11 +66,15 @@ void RequestHandlerAdaptor::onHeadersComplete(std::unique_ptr<HTTPMessage> msg)
 
   // Only in case of no error
   if (err_ == kErrorNone) {
+    HTTPSessionProfiler::HandlerScope profile(
+      profiler_, profile_, *handlerType_, "onRequest");
     upstream_->onRequest(std::move(msg));
   }
 }
 
 void RequestHandlerAdaptor::onBody(std::unique_ptr<folly::IOBuf> c) noexcept {
+  HTTPSessionProfiler::HandlerScope profile(
+    profiler_, profile_, *handlerType_, "onBody");
   upstream_->onBody(std::move(c));
 }
 
@@ -80,11 +90,15 @@ void RequestHandlerAdaptor::onTrailers(
 
 void RequestHandlerAdaptor::onEOM() noexcept {
   if (err_ == kErrorNone) {
+    HTTPSessionProfiler::HandlerScope profile(
+      profiler_, profile_, *handlerType_, "onEOM");
     upstream_->onEOM();
   }
 }
 
 void RequestHandlerAdaptor::onUpgrade(UpgradeProtocol protocol) noexcept {
+  HTTPSessionProfiler::HandlerScope profile(
+    profiler_, profile_, *handlerType_, "onUpgrade");
   upstream_->onUpgrade(protocol);
 }
 
@@ -125,10 +139,14 @@ void RequestHandlerAdaptor::onError(const HTTPException& error) noexcept {
 }
 
 void RequestHandlerAdaptor::onEgressPaused() noexcept {
+  HTTPSessionProfiler::HandlerScope profile(
+    profiler_, profile_, *handlerType_, "onEgressPaused");
   upstream_->onEgressPaused();
 }
 
 void RequestHandlerAdaptor::onEgressResumed() noexcept {
+  HTTPSessionProfiler::HandlerScope profile(
+    profiler_, profile_, *handlerType_, "onEgressResumed");
   upstream_->onEgressResumed();
 }
 
@@ -206,6 +224,8 @@ void RequestHandlerAdaptor::getCurrentTransportInfo(
 
 void RequestHandlerAdaptor::setError(ProxygenError err) noexcept {
   err_ = err;
+  HTTPSessionProfiler::HandlerScope profile(
+    profiler_, profile_, *handlerType_, "onError");
   upstream_->onError(err);
 }
 
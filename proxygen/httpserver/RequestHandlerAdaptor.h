@@ -10,6 +10,7 @@
 #pragma once
 
 #include <proxygen/httpserver/ResponseHandler.h>
+#include <proxygen/lib/http/session/HTTPSessionProfiler.h>
 #include <proxygen/lib/http/session/HTTPTransaction.h>
 
 namespace proxygen {
@@ -38,6 +39,16 @@ class RequestHandlerAdaptor
  public:
   explicit RequestHandlerAdaptor(RequestHandler* requestHandler);
 
+  /**
+   * Measure the CPU time of every RequestHandler callback and attribute it
+   * to handlerType.
+   */
+  void setProfiler(HTTPSessionProfiler* profiler,
+                   const std::type_info& handlerType) {
+    profiler_ = profiler;
+    handlerType_ = &handlerType;
+  }
+
  private:
   // HTTPTransactionHandler
   void setTransaction(HTTPTransaction* txn) noexcept override;
@@ -75,6 +86,10 @@ class RequestHandlerAdaptor
   void setError(ProxygenError err) noexcept;
 
   ProxygenError err_{kErrorNone};
+
+  HTTPSessionProfiler* profiler_{nullptr};
+  const std::type_info* handlerType_;
+  CallbackProfile profile_;
 };
 
 }
@@ -118,8 +118,10 @@ class ResponseBuilder {
 
   template <typename T>
   ResponseBuilder& body(T&& t) {
+    // Leave headroom so the codec can write the frame header in place
     return body(folly::IOBuf::maybeCopyBuffer(
-        folly::to<std::string>(std::forward<T>(t))));
+        folly::to<std::string>(std::forward<T>(t)),
+        HTTPTransaction::kEgressBodyHeadroom));
   }
 
   ResponseBuilder& closeConnection() {
@@ -0,0 +1,426 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/httpserver/StaticContentHandler.h>
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/Random.h>
+#include <folly/String.h>
+#include <folly/executors/GlobalExecutor.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <proxygen/httpserver/ResponseBuilder.h>
+#include <proxygen/lib/http/RFC2616.h>
+#include <proxygen/lib/utils/HTTPTime.h>
+
+namespace {
+
+// Size of each read(2) from the file
+constexpr size_t kReadSize = 16384;
+
+/**
+ * Returns true if any entity tag in the comma separated list matches etag, or
+ * if the list is "*".  Weak comparison ignores the W/ prefix, strong
+ * comparison never matches weak tags.
+ */
+bool etagListMatches(folly::StringPiece list,
+                     folly::StringPiece etag,
+                     bool weakComparison) {
+  std::vector<folly::StringPiece> tags;
+  folly::split(",", list, tags);
+  for (auto tag : tags) {
+    tag = folly::trimWhitespace(tag);
+    if (tag == "*") {
+      return true;
+    }
+    if (tag.removePrefix("W/") && !weakComparison) {
+      continue;
+    }
+    if (tag == etag) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Rejects anything that could escape the root directory
+bool isSafePath(folly::StringPiece path) {
+  if (path.empty() || path[0] != '/' ||
+      path.find('\0') != std::string::npos) {
+    return false;
+  }
+  std::vector<folly::StringPiece> parts;
+  folly::split("/", path, parts);
+  for (const auto& part : parts) {
+    if (part == "..") {
+      return false;
+    }
+  }
+  return true;
+}
+
+}
+
+namespace proxygen {
+
+FileMetadata FileMetadata::fromStat(const struct stat& st) {
+  FileMetadata metadata;
+  metadata.size = static_cast<uint64_t>(st.st_size);
+  metadata.mtime = static_cast<int64_t>(st.st_mtim.tv_sec);
+  auto mtimeNs = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000 +
+    static_cast<uint64_t>(st.st_mtim.tv_nsec);
+  metadata.etag = folly::to<std::string>(
+    "\"", st.st_ino, "-", metadata.size, "-", mtimeNs, "\"");
+  metadata.lastModified = formatHTTPDateTime(metadata.mtime);
+  return metadata;
+}
+
+FileMetadataCache::FileMetadataCache(std::chrono::milliseconds ttl,
+                                     size_t maxEntries)
+    : ttl_(ttl),
+      cache_(folly::EvictingCacheMap<std::string, Entry>(maxEntries)) {}
+
+folly::Optional<FileMetadata> FileMetadataCache::get(const std::string& path) {
+  auto cache = cache_.wlock();
+  auto it = cache->find(path);
+  if (it == cache->end()) {
+    return folly::none;
+  }
+  if (it->second.expiry <= getCurrentTime()) {
+    cache->erase(it);
+    return folly::none;
+  }
+  return it->second.metadata;
+}
+
+FileMetadata FileMetadataCache::put(const std::string& path,
+                                    const struct stat& st) {
+  Entry entry{FileMetadata::fromStat(st), getCurrentTime() + ttl_};
+  auto metadata = entry.metadata;
+  cache_.wlock()->set(path, std::move(entry));
+  return metadata;
+}
+
+constexpr size_t StaticContentHandler::kMaxRanges;
+
+StaticContentHandler::StaticContentHandler(
+  std::string root,
+  std::shared_ptr<FileMetadataCache> cache,
+  std::shared_ptr<folly::Executor> ioExecutor)
+    : root_(std::move(root)),
+      cache_(std::move(cache)),
+      ioExecutor_(std::move(ioExecutor)) {
+  if (!ioExecutor_) {
+    ioExecutor_ = folly::getCPUExecutor();
+  }
+}
+
+void StaticContentHandler::onRequest(
+  std::unique_ptr<HTTPMessage> headers) noexcept {
+  auto method = headers->getMethod();
+  if (method != HTTPMethod::GET && method != HTTPMethod::HEAD) {
+    ResponseBuilder(downstream_)
+      .status(405, "Method Not Allowed")
+      .header(HTTP_HEADER_ALLOW, "GET, HEAD")
+      .sendWithEOM();
+    return;
+  }
+  const auto& reqPath = headers->getPath();
+  if (!isSafePath(reqPath)) {
+    sendError(400, "Bad Request");
+    return;
+  }
+  auto path = root_ + reqPath;
+  const auto& reqHeaders = headers->getHeaders();
+
+  // Revalidations of recently served files are answered from the cache
+  auto cached = cache_->get(path);
+  if (cached && isNotModified(reqHeaders, *cached)) {
+    sendNotModified(*cached);
+    return;
+  }
+
+  try {
+    file_ = std::make_unique<folly::File>(path.c_str());
+  } catch (const std::system_error& ex) {
+    VLOG(4) << "Could not open " << path << " ex=" << folly::exceptionStr(ex);
+    sendError(404, "Not Found");
+    return;
+  }
+  struct stat st;
+  if (fstat(file_->fd(), &st) != 0 || !S_ISREG(st.st_mode)) {
+    file_.reset();
+    sendError(404, "Not Found");
+    return;
+  }
+  auto metadata = cache_->put(path, st);
+  if (isNotModified(reqHeaders, metadata)) {
+    file_.reset();
+    sendNotModified(metadata);
+    return;
+  }
+
+  // Range is only defined for GET, and is ignored when If-Range fails
+  std::vector<RFC2616::ByteRange> ranges;
+  const auto& range = reqHeaders.getSingleOrEmpty(HTTP_HEADER_RANGE);
+  if (method == HTTPMethod::GET && !range.empty() &&
+      ifRangeMatches(reqHeaders, metadata) &&
+      RFC2616::parseRangeHeader(range, metadata.size, ranges)) {
+    if (ranges.empty()) {
+      file_.reset();
+      sendRangeNotSatisfiable(metadata);
+      return;
+    }
+    if (ranges.size() > kMaxRanges) {
+      ranges.clear();
+    }
+  }
+
+  HTTPMessage response;
+  response.setHTTPVersion(1, 1);
+  auto& respHeaders = response.getHeaders();
+  respHeaders.add(HTTP_HEADER_ACCEPT_RANGES, "bytes");
+  respHeaders.add(HTTP_HEADER_ETAG, metadata.etag);
+  respHeaders.add(HTTP_HEADER_LAST_MODIFIED, metadata.lastModified);
+
+  uint64_t contentLength = 0;
+  if (ranges.empty()) {
+    response.setStatusCode(200);
+    response.setStatusMessage("OK");
+    segments_.push_back({nullptr, 0, metadata.size});
+    contentLength = metadata.size;
+  } else if (ranges.size() == 1) {
+    response.setStatusCode(206);
+    response.setStatusMessage("Partial Content");
+    respHeaders.add(
+      HTTP_HEADER_CONTENT_RANGE,
+      folly::to<std::string>("bytes ", ranges[0].first, "-", ranges[0].second,
+                             "/", metadata.size));
+    contentLength = ranges[0].second - ranges[0].first + 1;
+    segments_.push_back({nullptr, ranges[0].first, contentLength});
+  } else {
+    response.setStatusCode(206);
+    response.setStatusMessage("Partial Content");
+    auto boundary = folly::to<std::string>(folly::Random::rand64());
+    respHeaders.add(
+      HTTP_HEADER_CONTENT_TYPE,
+      folly::to<std::string>("multipart/byteranges; boundary=", boundary));
+    const char* delimiter = "--";
+    for (const auto& r : ranges) {
+      auto partHeader = folly::to<std::string>(
+        delimiter, boundary, "\r\nContent-Range: bytes ", r.first, "-",
+        r.second, "/", metadata.size, "\r\n\r\n");
+      delimiter = "\r\n--";
+      auto length = r.second - r.first + 1;
+      contentLength += partHeader.size() + length;
+      segments_.push_back(
+        {folly::IOBuf::copyBuffer(partHeader), r.first, length});
+    }
+    auto closeDelimiter = folly::to<std::string>("\r\n--", boundary, "--\r\n");
+    contentLength += closeDelimiter.size();
+    segments_.push_back({folly::IOBuf::copyBuffer(closeDelimiter), 0, 0});
+  }
+  respHeaders.add(HTTP_HEADER_CONTENT_LENGTH,
+                  folly::to<std::string>(contentLength));
+  downstream_->sendHeaders(response);
+
+  if (method == HTTPMethod::HEAD || contentLength == 0) {
+    file_.reset();
+    segments_.clear();
+    downstream_->sendEOM();
+    return;
+  }
+  scheduleReadFile();
+}
+
+bool StaticContentHandler::isNotModified(const HTTPHeaders& headers,
+                                         const FileMetadata& metadata) const {
+  // RFC 7232 section 6: If-Modified-Since is ignored if If-None-Match is
+  // present
+  if (headers.exists(HTTP_HEADER_IF_NONE_MATCH)) {
+    return etagListMatches(headers.combine(HTTP_HEADER_IF_NONE_MATCH),
+                           metadata.etag,
+                           true /* weak comparison */);
+  }
+  const auto& ims = headers.getSingleOrEmpty(HTTP_HEADER_IF_MODIFIED_SINCE);
+  if (!ims.empty()) {
+    auto since = parseHTTPDateTime(ims);
+    return since && metadata.mtime <= *since;
+  }
+  return false;
+}
+
+bool StaticContentHandler::ifRangeMatches(const HTTPHeaders& headers,
+                                          const FileMetadata& metadata) const {
+  if (!headers.exists(HTTP_HEADER_IF_RANGE)) {
+    return true;
+  }
+  const auto& ifRange = headers.getSingleOrEmpty(HTTP_HEADER_IF_RANGE);
+  if (ifRange.empty()) {
+    return false;
+  }
+  if (ifRange[0] == '"' || folly::StringPiece(ifRange).startsWith("W/")) {
+    return etagListMatches(ifRange, metadata.etag,
+                           false /* strong comparison */);
+  }
+  // A date validator must exactly match Last-Modified
+  auto date = parseHTTPDateTime(ifRange);
+  return date && *date == metadata.mtime;
+}
+
+void StaticContentHandler::sendNotModified(const FileMetadata& metadata) {
+  HTTPMessage response;
+  response.setHTTPVersion(1, 1);
+  response.setStatusCode(304);
+  response.setStatusMessage("Not Modified");
+  response.getHeaders().add(HTTP_HEADER_ETAG, metadata.etag);
+  response.getHeaders().add(HTTP_HEADER_LAST_MODIFIED, metadata.lastModified);
+  downstream_->sendHeaders(response);
+  downstream_->sendEOM();
+}
+
+void StaticContentHandler::sendRangeNotSatisfiable(
+  const FileMetadata& metadata) {
+  ResponseBuilder(downstream_)
+    .status(416, "Range Not Satisfiable")
+    .header(HTTP_HEADER_CONTENT_RANGE,
+            folly::to<std::string>("bytes */", metadata.size))
+    .header(HTTP_HEADER_ETAG, metadata.etag)
+    .sendWithEOM();
+}
+
+void StaticContentHandler::sendError(uint16_t code,
+                                     const std::string& message) {
+  ResponseBuilder(downstream_)
+    .status(code, message)
+    .body(message)
+    .sendWithEOM();
+}
+
+void StaticContentHandler::scheduleReadFile() {
+  readFileScheduled_ = true;
+  ioExecutor_->add(
+    std::bind(&StaticContentHandler::readFile, this,
+              folly::EventBaseManager::get()->getEventBase()));
+}
+
+void StaticContentHandler::readFile(folly::EventBase* evb) {
+  folly::IOBufQueue buf;
+  while (file_ && !paused_) {
+    if (curSegment_ == segments_.size()) {
+      file_.reset();
+      VLOG(4) << "Read complete";
+      evb->runInEventBaseThread([this] {
+          downstream_->sendEOM();
+        });
+      break;
+    }
+    auto& segment = segments_[curSegment_];
+    if (segment.prefix) {
+      buf.append(std::move(segment.prefix));
+    }
+    if (segment.length > 0) {
+      if (buf.empty()) {
+        // Leave room for the codec to write the frame header in place
+        auto head = folly::IOBuf::create(
+          HTTPTransaction::kEgressBodyHeadroom + kReadSize);
+        head->advance(HTTPTransaction::kEgressBodyHeadroom);
+        buf.append(std::move(head));
+      }
+      auto data = buf.preallocate(
+        std::min<uint64_t>(segment.length, kReadSize), kReadSize);
+      auto rc = folly::preadNoInt(
+        file_->fd(), data.first,
+        std::min<uint64_t>(segment.length, data.second), segment.offset);
+      if (rc <= 0) {
+        // An error, or the file shrank after Content-Length was sent
+        VLOG(4) << "Read error=" << rc;
+        file_.reset();
+        evb->runInEventBaseThread([this] {
+            LOG(ERROR) << "Error reading file";
+            downstream_->sendAbort();
+          });
+        break;
+      }
+      buf.postallocate(rc);
+      segment.offset += rc;
+      segment.length -= rc;
+    }
+    if (segment.length == 0) {
+      ++curSegment_;
+    }
+    if (!buf.empty()) {
+      evb->runInEventBaseThread([this, body=buf.move()] () mutable {
+          downstream_->sendBody(std::move(body));
+        });
+    }
+  }
+
+  // Notify the request thread that we terminated the readFile loop
+  evb->runInEventBaseThread([this] {
+      readFileScheduled_ = false;
+      if (!checkForCompletion() && !paused_) {
+        VLOG(4) << "Resuming deferred readFile";
+        onEgressResumed();
+      }
+    });
+}
+
+void StaticContentHandler::onEgressPaused() noexcept {
+  // This will terminate readFile soon
+  VLOG(4) << "StaticContentHandler paused";
+  paused_ = true;
+}
+
+void StaticContentHandler::onEgressResumed() noexcept {
+  VLOG(4) << "StaticContentHandler resumed";
+  paused_ = false;
+  // If readFileScheduled_, it will reschedule itself
+  if (!readFileScheduled_ && file_) {
+    scheduleReadFile();
+  } else {
+    VLOG(4) << "Deferred scheduling readFile";
+  }
+}
+
+void StaticContentHandler::onBody(
+  std::unique_ptr<folly::IOBuf> /*body*/) noexcept {
+  // ignore, only GET and HEAD are supported
+}
+
+void StaticContentHandler::onEOM() noexcept {
+}
+
+void StaticContentHandler::onUpgrade(UpgradeProtocol /*protocol*/) noexcept {
+  // handler doesn't support upgrades
+}
+
+void StaticContentHandler::requestComplete() noexcept {
+  finished_ = true;
+  paused_ = true;
+  checkForCompletion();
+}
+
+void StaticContentHandler::onError(ProxygenError /*err*/) noexcept {
+  finished_ = true;
+  paused_ = true;
+  checkForCompletion();
+}
+
+bool StaticContentHandler::checkForCompletion() {
+  if (finished_ && !readFileScheduled_) {
+    VLOG(4) << "deleting StaticContentHandler";
+    delete this;
+    return true;
+  }
+  return false;
+}
+
+}
@@ -0,0 +1,167 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <sys/stat.h>
+
+#include <folly/Executor.h>
+#include <folly/File.h>
+#include <folly/Optional.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/io/IOBuf.h>
+#include <proxygen/httpserver/RequestHandler.h>
+#include <proxygen/httpserver/RequestHandlerFactory.h>
+#include <proxygen/lib/utils/Time.h>
+
+namespace folly {
+class EventBase;
+}
+
+namespace proxygen {
+
+/**
+ * The validators of a file that conditional and range requests are evaluated
+ * against.
+ */
+struct FileMetadata {
+  uint64_t size{0};
+  // seconds since the epoch
+  int64_t mtime{0};
+  // strong entity tag, including the surrounding quotes
+  std::string etag;
+  // mtime formatted as an HTTP-date
+  std::string lastModified;
+
+  static FileMetadata fromStat(const struct stat& st);
+};
+
+/**
+ * Caches FileMetadata by path so that revalidations (If-None-Match and
+ * If-Modified-Since) can be answered with a 304 without opening or stat-ing
+ * the file.  Entries are trusted for at most ttl, which bounds how long a
+ * modified file can be reported as unchanged.  Thread safe, normally one
+ * instance is shared by every handler of a server.
+ */
+class FileMetadataCache {
+ public:
+  explicit FileMetadataCache(
+    std::chrono::milliseconds ttl = std::chrono::milliseconds(1000),
+    size_t maxEntries = 16384);
+
+  folly::Optional<FileMetadata> get(const std::string& path);
+
+  FileMetadata put(const std::string& path, const struct stat& st);
+
+ private:
+  struct Entry {
+    FileMetadata metadata;
+    TimePoint expiry;
+  };
+
+  const std::chrono::milliseconds ttl_;
+  folly::Synchronized<folly::EvictingCacheMap<std::string, Entry>> cache_;
+};
+
+/**
+ * Serves regular files below a root directory.  Supports GET and HEAD,
+ * conditional requests (If-None-Match, If-Modified-Since) and byte range
+ * requests (Range, If-Range), including multipart/byteranges responses for
+ * multiple ranges, so that resumed downloads and media seeks only transfer the
+ * bytes that were asked for.
+ *
+ * Reads happen on ioExecutor (the global CPU executor by default) since
+ * read(2) of a file can block.  If egress pauses, file reading is paused too.
+ */
+class StaticContentHandler : public RequestHandler {
+ public:
+  // Requests asking for more ranges than this are served the full file
+  static constexpr size_t kMaxRanges = 32;
+
+  StaticContentHandler(std::string root,
+                       std::shared_ptr<FileMetadataCache> cache,
+                       std::shared_ptr<folly::Executor> ioExecutor = nullptr);
+
+  void onRequest(std::unique_ptr<HTTPMessage> headers) noexcept override;
+
+  void onBody(std::unique_ptr<folly::IOBuf> body) noexcept override;
+
+  void onEOM() noexcept override;
+
+  void onUpgrade(UpgradeProtocol proto) noexcept override;
+
+  void requestComplete() noexcept override;
+
+  void onError(ProxygenError err) noexcept override;
+
+  void onEgressPaused() noexcept override;
+
+  void onEgressResumed() noexcept override;
+
+ private:
+  // A run of file bytes, optionally preceded by literal bytes such as a
+  // multipart boundary and part headers
+  struct Segment {
+    std::unique_ptr<folly::IOBuf> prefix;
+    uint64_t offset{0};
+    uint64_t length{0};
+  };
+
+  bool isNotModified(const HTTPHeaders& headers,
+                     const FileMetadata& metadata) const;
+  bool ifRangeMatches(const HTTPHeaders& headers,
+                      const FileMetadata& metadata) const;
+  void sendNotModified(const FileMetadata& metadata);
+  void sendRangeNotSatisfiable(const FileMetadata& metadata);
+  void sendError(uint16_t code, const std::string& message);
+  void scheduleReadFile();
+  void readFile(folly::EventBase* evb);
+  bool checkForCompletion();
+
+  const std::string root_;
+  std::shared_ptr<FileMetadataCache> cache_;
+  std::shared_ptr<folly::Executor> ioExecutor_;
+
+  std::unique_ptr<folly::File> file_;
+  // Only touched by readFile while readFileScheduled_ is set
+  std::vector<Segment> segments_;
+  size_t curSegment_{0};
+  bool readFileScheduled_{false};
+  std::atomic<bool> paused_{false};
+  bool finished_{false};
+};
+
+/**
+ * Creates StaticContentHandlers for root that share one FileMetadataCache.
+ */
+class StaticContentHandlerFactory : public RequestHandlerFactory {
+ public:
+  explicit StaticContentHandlerFactory(
+    std::string root,
+    std::chrono::milliseconds metadataTTL = std::chrono::milliseconds(1000))
+      : root_(std::move(root)),
+        cache_(std::make_shared<FileMetadataCache>(metadataTTL)) {}
+
+  void onServerStart(folly::EventBase* /*evb*/) noexcept override {}
+
+  void onServerStop() noexcept override {}
+
+  RequestHandler* onRequest(RequestHandler*, HTTPMessage*) noexcept override {
+    return new StaticContentHandler(root_, cache_);
+  }
+
+ private:
+  const std::string root_;
+  std::shared_ptr<FileMetadataCache> cache_;
+};
+
+}
@@ -17,10 +17,8 @@
 #include <folly/portability/Unistd.h>
 #include <proxygen/httpserver/HTTPServer.h>
 #include <proxygen/httpserver/RequestHandlerFactory.h>
+#include <proxygen/httpserver/StaticContentHandler.h>
 
-#include "StaticHandler.h"
-
-using namespace StaticService;
 using namespace proxygen;
 
 using folly::EventBase;
@@ -32,24 +30,10 @@ using Protocol = HTTPServer::Protocol;
 DEFINE_int32(http_port, 11000, "Port to listen on with HTTP protocol");
 DEFINE_int32(h2_port, 11002, "Port to listen on with HTTP/2 protocol");
 DEFINE_string(ip, "localhost", "IP/Hostname to bind to");
+DEFINE_string(root, ".", "Directory to serve files from");
 DEFINE_int32(threads, 0, "Number of threads to listen on. Numbers <= 0 "
              "will use the number of cores on this machine.");
 
-namespace {
-
-class StaticHandlerFactory : public RequestHandlerFactory {
- public:
-  void onServerStart(folly::EventBase* /*evb*/) noexcept override {}
-
-  void onServerStop() noexcept override {}
-
-  RequestHandler* onRequest(RequestHandler*, HTTPMessage*) noexcept override {
-    return new StaticHandler;
-  }
-};
-
-}
-
 int main(int argc, char* argv[]) {
   folly::init(&argc, &argv, true);
 
@@ -69,7 +53,7 @@ int main(int argc, char* argv[]) {
   options.shutdownOn = {SIGINT, SIGTERM};
   options.enableContentCompression = false;
   options.handlerFactories = RequestHandlerChain()
-      .addThen<StaticHandlerFactory>()
+      .addThen<StaticContentHandlerFactory>(FLAGS_root)
       .build();
   options.h2cEnabled = true;
 
@@ -0,0 +1,502 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/httpserver/HTTPServer.h>
+#include <proxygen/httpserver/RequestHandler.h>
+#include <proxygen/httpserver/ResponseBuilder.h>
+#include <proxygen/httpserver/ScopedHTTPServer.h>
+#include <proxygen/lib/http/HTTPConnector.h>
+#include <proxygen/lib/http/codec/HTTP2Constants.h>
+#include <proxygen/lib/http/session/HTTPUpstreamSession.h>
+#include <proxygen/lib/utils/TestUtils.h>
+#include <proxygen/lib/utils/Time.h>
+#include <proxygen/lib/utils/WheelTimerInstance.h>
+
+#include <folly/Format.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/SSLContext.h>
+#include <folly/portability/GFlags.h>
+#include <folly/init/Init.h>
+#include <folly/portability/Time.h>
+#include <folly/ssl/Init.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+/**
+ * Loopback load test of HTTPServer.  Starts a server in this process, drives
+ * it from --client_threads event bases through HTTPConnector and
+ * HTTPUpstreamSession, and reports requests per second, latency percentiles
+ * and CPU time per request.
+ *
+ * In closed loop mode every connection keeps --concurrency requests
+ * outstanding.  In open loop mode (--rps > 0) requests are issued at a fixed
+ * rate regardless of completions and latency is measured from the time a
+ * request was due, so a slow server is not hidden by the client backing off.
+ *
+ *   HTTPServerBenchmark --protocol=h2 --connections=16 --concurrency=8
+ */
+
+DEFINE_string(protocol, "http1", "http1, h2c (cleartext HTTP/2) or h2 (TLS)");
+DEFINE_int32(server_threads, 1, "HTTPServer IO threads");
+DEFINE_int32(client_threads, 1, "Load generator threads");
+DEFINE_int32(connections, 8, "Connections per load generator thread");
+DEFINE_int32(concurrency, 1,
+             "Outstanding requests per connection in closed loop mode; "
+             "HTTP/1.1 connections are limited to 1");
+DEFINE_int32(rps, 0, "Requests per second per load generator thread; "
+             "0 runs a closed loop");
+DEFINE_int32(request_body_size, 0, "Request body bytes, POST if non-zero");
+DEFINE_int32(response_body_size, 1024, "Response body bytes");
+DEFINE_int32(warmup_ms, 1000, "Time before measuring starts");
+DEFINE_int32(duration_ms, 5000, "Time measured");
+
+using namespace folly;
+using namespace proxygen;
+
+namespace {
+
+const std::string kTestDir = getContainingDirectory(__FILE__).str();
+
+std::chrono::nanoseconds getCPUTime(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+std::unique_ptr<IOBuf> makeBody(size_t size) {
+  auto buf = IOBuf::create(size);
+  memset(buf->writableData(), 'a', size);
+  buf->append(size);
+  return buf;
+}
+
+/**
+ * Replies to every request with --response_body_size bytes once the request
+ * has been read completely.
+ */
+class BenchmarkHandler : public RequestHandler {
+ public:
+  explicit BenchmarkHandler(const IOBuf& body) : body_(body) {}
+
+  void onRequest(std::unique_ptr<HTTPMessage>) noexcept override {}
+
+  void onBody(std::unique_ptr<IOBuf>) noexcept override {}
+
+  void onEOM() noexcept override {
+    ResponseBuilder(downstream_)
+      .status(200, "OK")
+      .body(body_.clone())
+      .sendWithEOM();
+  }
+
+  void onUpgrade(UpgradeProtocol) noexcept override {}
+
+  void requestComplete() noexcept override {
+    delete this;
+  }
+
+  void onError(ProxygenError) noexcept override {
+    delete this;
+  }
+
+ private:
+  const IOBuf& body_;
+};
+
+class BenchmarkHandlerFactory : public RequestHandlerFactory {
+ public:
+  void onServerStart(EventBase*) noexcept override {}
+
+  void onServerStop() noexcept override {}
+
+  RequestHandler* onRequest(RequestHandler*, HTTPMessage*) noexcept override {
+    return new BenchmarkHandler(*body_);
+  }
+
+ private:
+  std::shared_ptr<IOBuf> body_{makeBody(FLAGS_response_body_size)};
+};
+
+struct ClientResult {
+  std::vector<uint32_t> latenciesUs;
+  uint64_t errors{0};
+  // Open loop requests that could not be sent because every connection was
+  // at its stream limit
+  uint64_t dropped{0};
+  std::chrono::nanoseconds cpuTime{0};
+};
+
+class LoadGenerator;
+
+/**
+ * One request.  Deletes itself when the transaction detaches.
+ */
+class ClientRequest : public HTTPTransactionHandler {
+ public:
+  ClientRequest(LoadGenerator& generator,
+                HTTPUpstreamSession* session,
+                TimePoint due)
+      : generator_(generator), session_(session), due_(due) {}
+
+  void setTransaction(HTTPTransaction*) noexcept override {}
+  void detachTransaction() noexcept override;
+  void onHeadersComplete(std::unique_ptr<HTTPMessage> msg) noexcept override {
+    ok_ = msg->getStatusCode() == 200;
+  }
+  void onBody(std::unique_ptr<IOBuf>) noexcept override {}
+  void onTrailers(std::unique_ptr<HTTPHeaders>) noexcept override {}
+  void onEOM() noexcept override {
+    done_ = getCurrentTime();
+  }
+  void onUpgrade(UpgradeProtocol) noexcept override {}
+  void onError(const HTTPException&) noexcept override {
+    ok_ = false;
+  }
+  void onEgressPaused() noexcept override {}
+  void onEgressResumed() noexcept override {}
+
+ private:
+  LoadGenerator& generator_;
+  HTTPUpstreamSession* const session_;
+  const TimePoint due_;
+  TimePoint done_;
+  bool ok_{false};
+};
+
+/**
+ * Drives the server from one event base.
+ */
+class LoadGenerator
+    : private HTTPConnector::Callback,
+      private HTTPSessionBase::InfoCallback {
+ public:
+  LoadGenerator(const SocketAddress& addr,
+                std::shared_ptr<SSLContext> sslContext,
+                TimePoint measureStart,
+                TimePoint measureEnd)
+      : addr_(addr),
+        sslContext_(std::move(sslContext)),
+        measureStart_(measureStart),
+        measureEnd_(measureEnd),
+        timer_(std::chrono::milliseconds(60000), &evb_),
+        tick_(AsyncTimeout::make(evb_, [this] () noexcept { onTick(); })) {
+    if (FLAGS_request_body_size > 0) {
+      requestBody_ = makeBody(FLAGS_request_body_size);
+    }
+  }
+
+  ClientResult run() {
+    auto cpuStart = getCPUTime(CLOCK_THREAD_CPUTIME_ID);
+    evb_.runInEventBaseThread([this] {
+      for (int i = 0; i < FLAGS_connections; i++) {
+        connect();
+      }
+      // Ticks drive the open loop and end the run
+      tick_->scheduleTimeout(1);
+    });
+    evb_.loopForever();
+    result_.cpuTime = getCPUTime(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+    return std::move(result_);
+  }
+
+  void onRequestDone(HTTPUpstreamSession* session,
+                     TimePoint due,
+                     TimePoint done,
+                     bool ok) {
+    if (due >= measureStart_ && done <= measureEnd_) {
+      if (ok) {
+        result_.latenciesUs.push_back(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+            done - due).count());
+      } else {
+        result_.errors++;
+      }
+    }
+    if (FLAGS_rps == 0 && !stopping_) {
+      // Closed loop: replace the request that just finished.  The session
+      // still counts its transaction until detachTransaction returns, so an
+      // HTTP/1.1 one only has a free stream once the loop gets back here.
+      evb_.runInLoop([this, session] { replaceRequest(session); }, true);
+    }
+  }
+
+ private:
+  void connect() {
+    connectors_.push_back(std::make_unique<HTTPConnector>(this, timer_));
+    auto& connector = connectors_.back();
+    if (sslContext_) {
+      connector->connectSSL(&evb_, addr_, sslContext_);
+    } else {
+      if (FLAGS_protocol == "h2c") {
+        connector->setPlaintextProtocol(http2::kProtocolCleartextString);
+      }
+      connector->connect(&evb_, addr_);
+    }
+  }
+
+  void connectSuccess(HTTPUpstreamSession* session) override {
+    session->setInfoCallback(this);
+    sessions_.push_back(session);
+    if (FLAGS_rps == 0) {
+      int concurrency =
+        isParallelCodecProtocol(session->getCodecProtocol()) ?
+        FLAGS_concurrency : 1;
+      for (int i = 0; i < concurrency; i++) {
+        if (!sendRequest(session, getCurrentTime())) {
+          LOG(ERROR) << "Connection took " << i << " of " << concurrency
+                     << " requests";
+          result_.errors++;
+          break;
+        }
+      }
+    }
+  }
+
+  void connectError(const AsyncSocketException& ex) override {
+    LOG(ERROR) << "connect failed: " << ex.what();
+    result_.errors++;
+    if (++failedConnects_ == FLAGS_connections) {
+      evb_.terminateLoopSoon();
+    }
+  }
+
+  void onDestroy(const HTTPSessionBase& session) override {
+    sessions_.erase(std::remove(sessions_.begin(), sessions_.end(), &session),
+                    sessions_.end());
+    if (stopping_ && sessions_.empty()) {
+      evb_.terminateLoopSoon();
+    }
+  }
+
+  void replaceRequest(HTTPUpstreamSession* session) {
+    if (stopping_) {
+      return;
+    }
+    auto now = getCurrentTime();
+    // The session the request finished on, unless it has been closed
+    if (std::find(sessions_.begin(), sessions_.end(), session) !=
+          sessions_.end() &&
+        sendRequest(session, now)) {
+      return;
+    }
+    for (size_t i = 0; i < sessions_.size(); i++) {
+      if (sendRequest(sessions_[nextSession_++ % sessions_.size()], now)) {
+        return;
+      }
+    }
+    // Every connection is busy, so the loop runs one request short from now
+    LOG(ERROR) << "No connection could take a closed loop request";
+    if (now >= measureStart_) {
+      result_.errors++;
+    }
+  }
+
+  bool sendRequest(HTTPUpstreamSession* session, TimePoint due) {
+    auto handler = new ClientRequest(*this, session, due);
+    auto txn = session->newTransaction(handler);
+    if (!txn) {
+      delete handler;
+      return false;
+    }
+    HTTPMessage req;
+    req.setMethod(requestBody_ ? HTTPMethod::POST : HTTPMethod::GET);
+    req.setURL("/");
+    req.setHTTPVersion(1, 1);
+    req.getHeaders().add(HTTP_HEADER_HOST, "localhost");
+    if (requestBody_) {
+      req.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH,
+                           folly::to<std::string>(FLAGS_request_body_size));
+    }
+    txn->sendHeaders(req);
+    if (requestBody_) {
+      txn->sendBody(requestBody_->clone());
+    }
+    txn->sendEOM();
+    return true;
+  }
+
+  void onTick() {
+    auto now = getCurrentTime();
+    if (now >= measureEnd_) {
+      stopping_ = true;
+      auto sessions = sessions_;
+      for (auto session : sessions) {
+        session->closeWhenIdle();
+      }
+      if (sessions_.empty()) {
+        evb_.terminateLoopSoon();
+      }
+      return;
+    }
+    if (FLAGS_rps > 0 && !sessions_.empty()) {
+      if (nextDue_ == TimePoint()) {
+        nextDue_ = now;
+      }
+      auto interval = std::chrono::duration_cast<TimePoint::duration>(
+        std::chrono::seconds(1)) / FLAGS_rps;
+      for (; nextDue_ <= now; nextDue_ += interval) {
+        // Try every connection once, H1 ones are busy until they reply
+        bool sent = false;
+        for (size_t i = 0; i < sessions_.size() && !sent; i++) {
+          sent = sendRequest(sessions_[nextSession_++ % sessions_.size()],
+                             nextDue_);
+        }
+        if (!sent && nextDue_ >= measureStart_) {
+          result_.dropped++;
+        }
+      }
+    }
+    tick_->scheduleTimeout(1);
+  }
+
+  EventBase evb_;
+  const SocketAddress addr_;
+  std::shared_ptr<SSLContext> sslContext_;
+  const TimePoint measureStart_;
+  const TimePoint measureEnd_;
+  WheelTimerInstance timer_;
+  // After evb_, so it is constructed after and destroyed before it
+  std::unique_ptr<AsyncTimeout> tick_;
+  std::unique_ptr<IOBuf> requestBody_;
+  std::vector<std::unique_ptr<HTTPConnector>> connectors_;
+  std::vector<HTTPUpstreamSession*> sessions_;
+  size_t nextSession_{0};
+  int failedConnects_{0};
+  TimePoint nextDue_;
+  bool stopping_{false};
+  ClientResult result_;
+};
+
+void ClientRequest::detachTransaction() noexcept {
+  generator_.onRequestDone(session_, due_, done_,
+                           ok_ && done_ != TimePoint());
+  delete this;
+}
+
+std::unique_ptr<ScopedHTTPServer> startServer() {
+  HTTPServer::IPConfig cfg{SocketAddress("127.0.0.1", 0),
+                           FLAGS_protocol == "h2c"
+                             ? HTTPServer::Protocol::HTTP2
+                             : HTTPServer::Protocol::HTTP};
+  if (FLAGS_protocol == "h2") {
+    wangle::SSLContextConfig sslCfg;
+    sslCfg.isDefault = true;
+    sslCfg.setCertificate(kTestDir + "certs/test_cert1.pem",
+                          kTestDir + "certs/test_key1.pem", "");
+    sslCfg.setNextProtocols({http2::kProtocolString, "http/1.1"});
+    cfg.sslConfigs.push_back(sslCfg);
+  }
+
+  HTTPServerOptions options;
+  options.threads = FLAGS_server_threads;
+  options.handlerFactories.push_back(
+    std::make_unique<BenchmarkHandlerFactory>());
+  return ScopedHTTPServer::start(std::move(cfg), std::move(options));
+}
+
+std::shared_ptr<SSLContext> makeClientSSLContext() {
+  if (FLAGS_protocol != "h2") {
+    return nullptr;
+  }
+  auto ctx = std::make_shared<SSLContext>();
+  ctx->setOptions(SSL_OP_NO_COMPRESSION);
+  ctx->setAdvertisedNextProtocols({http2::kProtocolString});
+  return ctx;
+}
+
+std::chrono::nanoseconds getProcessCPUTime() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+    std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  return sorted[std::min(sorted.size() - 1,
+                         static_cast<size_t>(p * sorted.size()))];
+}
+
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::ssl::init();
+  CHECK(FLAGS_protocol == "http1" || FLAGS_protocol == "h2c" ||
+        FLAGS_protocol == "h2") << "unknown protocol " << FLAGS_protocol;
+
+  auto server = startServer();
+  auto addr = server->getAddresses()[0].address;
+  auto sslContext = makeClientSSLContext();
+
+  auto measureStart = getCurrentTime() +
+    std::chrono::milliseconds(FLAGS_warmup_ms);
+  auto measureEnd = measureStart + std::chrono::milliseconds(FLAGS_duration_ms);
+
+  std::vector<ClientResult> results(FLAGS_client_threads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < FLAGS_client_threads; i++) {
+    threads.emplace_back([&, i] {
+      LoadGenerator generator(addr, sslContext, measureStart, measureEnd);
+      results[i] = generator.run();
+    });
+  }
+  std::this_thread::sleep_until(measureStart);
+  auto cpuAtStart = getProcessCPUTime();
+  std::this_thread::sleep_until(measureEnd);
+  auto processCPU = getProcessCPUTime() - cpuAtStart;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::vector<uint32_t> latencies;
+  uint64_t errors = 0;
+  uint64_t dropped = 0;
+  std::chrono::nanoseconds clientCPU{0};
+  for (auto& result : results) {
+    latencies.insert(latencies.end(), result.latenciesUs.begin(),
+                     result.latenciesUs.end());
+    errors += result.errors;
+    dropped += result.dropped;
+    clientCPU += result.cpuTime;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto requests = std::max<size_t>(latencies.size(), 1);
+  double seconds = FLAGS_duration_ms / 1000.0;
+  // The load generator threads also ran during warmup and shutdown, so scale
+  // their CPU time to the measured window before subtracting it
+  double clientShare = double(FLAGS_duration_ms) /
+    (FLAGS_warmup_ms + FLAGS_duration_ms);
+  auto serverCPU = processCPU -
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      clientCPU * clientShare);
+
+  std::cout << folly::format(
+    "protocol={} server_threads={} clients={}x{} concurrency={} rps={}\n",
+    FLAGS_protocol, FLAGS_server_threads, FLAGS_client_threads,
+    FLAGS_connections, FLAGS_concurrency, FLAGS_rps);
+  std::cout << folly::format(
+    "requests={} errors={} dropped={} rps={:.0f}\n",
+    latencies.size(), errors, dropped, latencies.size() / seconds);
+  std::cout << folly::format(
+    "latency_us p50={} p99={} p999={} max={}\n",
+    percentile(latencies, 0.5), percentile(latencies, 0.99),
+    percentile(latencies, 0.999), latencies.empty() ? 0 : latencies.back());
+  std::cout << folly::format(
+    "cpu_us_per_request process={:.2f} server_estimate={:.2f}\n",
+    processCPU.count() / 1000.0 / requests,
+    serverCPU.count() / 1000.0 / requests);
+  return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/FileUtil.h>
+#include <folly/executors/InlineExecutor.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/httpserver/Mocks.h>
+#include <proxygen/httpserver/StaticContentHandler.h>
+#include <proxygen/lib/utils/HTTPTime.h>
+
+using namespace proxygen;
+using namespace testing;
+
+class StaticContentHandlerTest : public Test {
+ public:
+  void SetUp() override {
+    content_ = "0123456789abcdefghijklmnopqrstuvwxyz";
+    folly::writeFile(content_,
+                     (dir_.path() / "file.txt").string().c_str());
+    cache_ = std::make_shared<FileMetadataCache>();
+  }
+
+ protected:
+  struct Response {
+    uint16_t status{0};
+    HTTPHeaders headers;
+    std::string body;
+    bool eom{false};
+  };
+
+  Response request(const std::string& path,
+                   std::vector<std::pair<HTTPHeaderCode, std::string>> hdrs,
+                   HTTPMethod method = HTTPMethod::GET) {
+    auto handler = new StaticContentHandler(
+      dir_.path().string(), cache_, std::make_shared<folly::InlineExecutor>());
+    NiceMock<MockResponseHandler> downstream(handler);
+    handler->setResponseHandler(&downstream);
+
+    Response response;
+    EXPECT_CALL(downstream, sendHeaders(_))
+      .WillOnce(Invoke([&] (HTTPMessage& msg) {
+            response.status = msg.getStatusCode();
+            response.headers = msg.getHeaders();
+          }));
+    ON_CALL(downstream, sendBody(_))
+      .WillByDefault(Invoke([&] (std::shared_ptr<folly::IOBuf> body) {
+            response.body += body->moveToFbString().toStdString();
+          }));
+    ON_CALL(downstream, sendEOM())
+      .WillByDefault(Invoke([&] { response.eom = true; }));
+
+    auto msg = std::make_unique<HTTPMessage>();
+    msg->setMethod(method);
+    msg->setURL(path);
+    for (auto& hdr : hdrs) {
+      msg->getHeaders().add(hdr.first, hdr.second);
+    }
+    handler->onRequest(std::move(msg));
+    handler->onEOM();
+    evb_->loop();
+    handler->requestComplete();
+    return response;
+  }
+
+  folly::test::TemporaryDirectory dir_;
+  folly::EventBase* evb_{folly::EventBaseManager::get()->getEventBase()};
+  std::shared_ptr<FileMetadataCache> cache_;
+  std::string content_;
+};
+
+TEST_F(StaticContentHandlerTest, FullFile) {
+  auto resp = request("/file.txt", {});
+  EXPECT_EQ(200, resp.status);
+  EXPECT_EQ(content_, resp.body);
+  EXPECT_TRUE(resp.eom);
+  EXPECT_EQ("bytes", resp.headers.getSingleOrEmpty(HTTP_HEADER_ACCEPT_RANGES));
+  EXPECT_FALSE(resp.headers.getSingleOrEmpty(HTTP_HEADER_ETAG).empty());
+  EXPECT_EQ(folly::to<std::string>(content_.size()),
+            resp.headers.getSingleOrEmpty(HTTP_HEADER_CONTENT_LENGTH));
+}
+
+TEST_F(StaticContentHandlerTest, Head) {
+  auto resp = request("/file.txt", {}, HTTPMethod::HEAD);
+  EXPECT_EQ(200, resp.status);
+  EXPECT_TRUE(resp.body.empty());
+  EXPECT_TRUE(resp.eom);
+  EXPECT_EQ(folly::to<std::string>(content_.size()),
+            resp.headers.getSingleOrEmpty(HTTP_HEADER_CONTENT_LENGTH));
+}
+
+TEST_F(StaticContentHandlerTest, NotFound) {
+  EXPECT_EQ(404, request("/missing.txt", {}).status);
+  EXPECT_EQ(400, request("/../file.txt", {}).status);
+  EXPECT_EQ(405, request("/file.txt", {}, HTTPMethod::POST).status);
+}
+
+TEST_F(StaticContentHandlerTest, SingleRange) {
+  auto resp = request("/file.txt", {{HTTP_HEADER_RANGE, "bytes=10-15"}});
+  EXPECT_EQ(206, resp.status);
+  EXPECT_EQ("abcdef", resp.body);
+  EXPECT_EQ(folly::to<std::string>("bytes 10-15/", content_.size()),
+            resp.headers.getSingleOrEmpty(HTTP_HEADER_CONTENT_RANGE));
+  EXPECT_EQ("6", resp.headers.getSingleOrEmpty(HTTP_HEADER_CONTENT_LENGTH));
+
+  resp = request("/file.txt", {{HTTP_HEADER_RANGE, "bytes=-3"}});
+  EXPECT_EQ(206, resp.status);
+  EXPECT_EQ("xyz", resp.body);
+}
+
+TEST_F(StaticContentHandlerTest, MultipleRanges) {
+  auto resp = request("/file.txt", {{HTTP_HEADER_RANGE, "bytes=0-1,-2"}});
+  EXPECT_EQ(206, resp.status);
+  auto contentType = resp.headers.getSingleOrEmpty(HTTP_HEADER_CONTENT_TYPE);
+  folly::StringPiece boundary(contentType);
+  ASSERT_TRUE(boundary.removePrefix("multipart/byteranges; boundary="));
+  auto expected = folly::to<std::string>(
+    "--", boundary, "\r\nContent-Range: bytes 0-1/36\r\n\r\n01",
+    "\r\n--", boundary, "\r\nContent-Range: bytes 34-35/36\r\n\r\nyz",
+    "\r\n--", boundary, "--\r\n");
+  EXPECT_EQ(expected, resp.body);
+  EXPECT_EQ(folly::to<std::string>(expected.size()),
+            resp.headers.getSingleOrEmpty(HTTP_HEADER_CONTENT_LENGTH));
+}
+
+TEST_F(StaticContentHandlerTest, RangeNotSatisfiable) {
+  auto resp = request("/file.txt", {{HTTP_HEADER_RANGE, "bytes=100-"}});
+  EXPECT_EQ(416, resp.status);
+  EXPECT_EQ("bytes */36",
+            resp.headers.getSingleOrEmpty(HTTP_HEADER_CONTENT_RANGE));
+
+  // Malformed ranges are ignored
+  resp = request("/file.txt", {{HTTP_HEADER_RANGE, "bytes=5-1"}});
+  EXPECT_EQ(200, resp.status);
+  EXPECT_EQ(content_, resp.body);
+
+  // Even when the specs before the malformed one are good
+  resp = request("/file.txt", {{HTTP_HEADER_RANGE, "bytes=0-1,garbage"}});
+  EXPECT_EQ(200, resp.status);
+  EXPECT_EQ(content_, resp.body);
+}
+
+TEST_F(StaticContentHandlerTest, IfRange) {
+  auto etag = request("/file.txt", {}).headers.getSingleOrEmpty(
+    HTTP_HEADER_ETAG);
+
+  auto resp = request("/file.txt", {{HTTP_HEADER_RANGE, "bytes=0-0"},
+                                    {HTTP_HEADER_IF_RANGE, etag}});
+  EXPECT_EQ(206, resp.status);
+  EXPECT_EQ("0", resp.body);
+
+  resp = request("/file.txt", {{HTTP_HEADER_RANGE, "bytes=0-0"},
+                               {HTTP_HEADER_IF_RANGE, "\"stale\""}});
+  EXPECT_EQ(200, resp.status);
+  EXPECT_EQ(content_, resp.body);
+
+  resp = request("/file.txt", {{HTTP_HEADER_RANGE, "bytes=0-0"},
+                               {HTTP_HEADER_IF_RANGE,
+                                formatHTTPDateTime(0)}});
+  EXPECT_EQ(200, resp.status);
+}
+
+TEST_F(StaticContentHandlerTest, Conditional) {
+  auto first = request("/file.txt", {});
+  auto etag = first.headers.getSingleOrEmpty(HTTP_HEADER_ETAG);
+  auto lastModified = first.headers.getSingleOrEmpty(
+    HTTP_HEADER_LAST_MODIFIED);
+
+  auto resp = request("/file.txt", {{HTTP_HEADER_IF_NONE_MATCH,
+                                     folly::to<std::string>("\"a\", ", etag)}});
+  EXPECT_EQ(304, resp.status);
+  EXPECT_TRUE(resp.body.empty());
+  EXPECT_TRUE(resp.eom);
+  EXPECT_EQ(etag, resp.headers.getSingleOrEmpty(HTTP_HEADER_ETAG));
+
+  resp = request("/file.txt", {{HTTP_HEADER_IF_MODIFIED_SINCE, lastModified}});
+  EXPECT_EQ(304, resp.status);
+
+  resp = request("/file.txt", {{HTTP_HEADER_IF_MODIFIED_SINCE,
+                                formatHTTPDateTime(0)}});
+  EXPECT_EQ(200, resp.status);
+
+  // If-None-Match takes precedence over If-Modified-Since
+  resp = request("/file.txt", {{HTTP_HEADER_IF_NONE_MATCH, "\"other\""},
+                               {HTTP_HEADER_IF_MODIFIED_SINCE, lastModified}});
+  EXPECT_EQ(200, resp.status);
+  EXPECT_EQ(content_, resp.body);
+}
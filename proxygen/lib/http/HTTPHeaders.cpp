@@ -43,7 +43,9 @@ bitset<256>& HTTPHeaders::perHopHeaderCodes() {
 }
 
 HTTPHeaders::HTTPHeaders() :
-  deletedCount_(0) {
+  deletedCount_(0),
+  wireBlockCount_(0),
+  wireBlockNeedsStrip_(false) {
   codes_.reserve(kInitialVectorReserve);
   headerNames_.reserve(kInitialVectorReserve);
   headerValues_.reserve(kInitialVectorReserve);
@@ -52,6 +54,19 @@ HTTPHeaders::HTTPHeaders() :
 void HTTPHeaders::add(folly::StringPiece name, folly::StringPiece value) {
   CHECK(name.size());
   const HTTPHeaderCode code = HTTPCommonHeaders::hash(name.data(), name.size());
+  clearWireBlockOnAdd(code);
+  codes_.push_back(code);
+  headerNames_.push_back((code == HTTP_HEADER_OTHER)
+      ? new std::string(name.data(), name.size())
+      : HTTPCommonHeaders::getPointerToHeaderName(code));
+  headerValues_.emplace_back(value.data(), value.size());
+}
+
+void HTTPHeaders::add(HTTPHeaderCode code, folly::StringPiece name,
+                      folly::StringPiece value) {
+  DCHECK(code != HTTP_HEADER_NONE);
+  DCHECK(code != HTTP_HEADER_OTHER || name.size());
+  clearWireBlockOnAdd(code);
   codes_.push_back(code);
   headerNames_.push_back((code == HTTP_HEADER_OTHER)
       ? new std::string(name.data(), name.size())
@@ -133,6 +148,9 @@ bool HTTPHeaders::remove(folly::StringPiece name) {
       removed = true;
       ++deletedCount_;
     });
+    if (removed) {
+      clearWireBlock();
+    }
     return removed;
   }
 }
@@ -144,6 +162,9 @@ bool HTTPHeaders::remove(HTTPHeaderCode code) {
     removed = true;
     ++deletedCount_;
   });
+  if (removed) {
+    clearWireBlock();
+  }
   return removed;
 }
 
@@ -159,6 +180,9 @@ bool HTTPHeaders::removeAllVersions(HTTPHeaderCode code,
     removed = true;
     ++deletedCount_;
   });
+  if (removed) {
+    clearWireBlock();
+  }
   return removed;
 }
 
@@ -178,7 +202,10 @@ HTTPHeaders::HTTPHeaders(const HTTPHeaders& hdrs) :
   codes_(hdrs.codes_),
   headerNames_(hdrs.headerNames_),
   headerValues_(hdrs.headerValues_),
-  deletedCount_(hdrs.deletedCount_) {
+  deletedCount_(hdrs.deletedCount_),
+  wireBlock_(hdrs.wireBlock_),
+  wireBlockCount_(hdrs.wireBlockCount_),
+  wireBlockNeedsStrip_(hdrs.wireBlockNeedsStrip_) {
   for (size_t i = 0; i < codes_.size(); ++i) {
     if (codes_[i] == HTTP_HEADER_OTHER) {
       headerNames_[i] = new string(*hdrs.headerNames_[i]);
@@ -190,7 +217,10 @@ HTTPHeaders::HTTPHeaders(HTTPHeaders&& hdrs) noexcept :
     codes_(std::move(hdrs.codes_)),
     headerNames_(std::move(hdrs.headerNames_)),
     headerValues_(std::move(hdrs.headerValues_)),
-    deletedCount_(hdrs.deletedCount_) {
+    deletedCount_(hdrs.deletedCount_),
+    wireBlock_(std::move(hdrs.wireBlock_)),
+    wireBlockCount_(hdrs.wireBlockCount_),
+    wireBlockNeedsStrip_(hdrs.wireBlockNeedsStrip_) {
   hdrs.removeAll();
 }
 
@@ -201,6 +231,9 @@ HTTPHeaders& HTTPHeaders::operator= (const HTTPHeaders& hdrs) {
     headerNames_ = hdrs.headerNames_;
     headerValues_ = hdrs.headerValues_;
     deletedCount_ = hdrs.deletedCount_;
+    wireBlock_ = hdrs.wireBlock_;
+    wireBlockCount_ = hdrs.wireBlockCount_;
+    wireBlockNeedsStrip_ = hdrs.wireBlockNeedsStrip_;
     for (size_t i = 0; i < codes_.size(); ++i) {
       if (codes_[i] == HTTP_HEADER_OTHER) {
         headerNames_[i] = new string(*hdrs.headerNames_[i]);
@@ -216,6 +249,9 @@ HTTPHeaders& HTTPHeaders::operator= (HTTPHeaders&& hdrs) {
     headerNames_ = std::move(hdrs.headerNames_);
     headerValues_ = std::move(hdrs.headerValues_);
     deletedCount_ = hdrs.deletedCount_;
+    wireBlock_ = std::move(hdrs.wireBlock_);
+    wireBlockCount_ = hdrs.wireBlockCount_;
+    wireBlockNeedsStrip_ = hdrs.wireBlockNeedsStrip_;
 
     hdrs.removeAll();
   }
@@ -230,6 +266,7 @@ void HTTPHeaders::removeAll() {
   headerNames_.clear();
   headerValues_.clear();
   deletedCount_ = 0;
+  clearWireBlock();
 }
 
 size_t HTTPHeaders::size() const {
@@ -267,6 +304,14 @@ HTTPHeaders::transferHeaderIfPresent(folly::StringPiece name,
 
 void
 HTTPHeaders::stripPerHopHeaders(HTTPHeaders& strippedHeaders) {
+  // The wire lines left out the headers named by the Connection headers
+  // that came with them, but not by one added since
+  ITERATE_OVER_CODES(HTTP_HEADER_CONNECTION, {
+    if (pos >= wireBlockCount_) {
+      clearWireBlock();
+    }
+  });
+
   int len;
   forEachValueOfHeader(HTTP_HEADER_CONNECTION, [&]
                        (const string& stdStr) -> bool {
@@ -323,6 +368,20 @@ HTTPHeaders::stripPerHopHeaders(HTTPHeaders& strippedHeaders) {
       VLOG(5) << "Stripped hop-by-hop header " << *headerNames_[i];
     }
   }
+  wireBlockNeedsStrip_ = false;
+}
+
+void HTTPHeaders::setWireBlock(std::string lines, bool hasPerHopHeaders) {
+  wireBlock_ = std::make_shared<const std::string>(std::move(lines));
+  wireBlockCount_ = codes_.size();
+  wireBlockNeedsStrip_ = hasPerHopHeaders;
+}
+
+folly::StringPiece HTTPHeaders::getWireBlock() const {
+  if (!wireBlock_ || wireBlockNeedsStrip_) {
+    return folly::StringPiece();
+  }
+  return *wireBlock_;
 }
 
 void HTTPHeaders::copyTo(HTTPHeaders& hdrs) const {
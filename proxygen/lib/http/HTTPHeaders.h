@@ -18,6 +18,7 @@
 
 #include <bitset>
 #include <cstring>
+#include <memory>
 #include <string>
 #include <initializer_list>
 
@@ -109,6 +110,12 @@ class HTTPHeaders {
   template <typename T> // T = string
   void add(HTTPHeaderCode code, T&& value);
   void add(headers_initializer_list l);
+  /**
+   * As add(name, value), for callers that already know the code of name, so
+   * it is not hashed again.  name is only used if code is HTTP_HEADER_OTHER.
+   */
+  void add(HTTPHeaderCode code, folly::StringPiece name,
+           folly::StringPiece value);
   void rawAdd(const std::string& name, const std::string& value);
 
   void addFromCodec(const char* str, size_t len, std::string&& value);
@@ -267,6 +274,31 @@ class HTTPHeaders {
    */
   static std::bitset<256>& perHopHeaderCodes();
 
+  /**
+   * Keep the header lines of a message as an HTTP/1.x peer sent them,
+   * leaving out per-hop headers, so that HTTP1xCodec can forward them by
+   * copying the lines rather than writing each header again.  The lines
+   * stand for all the headers added so far.  hasPerHopHeaders says whether
+   * any lines were left out, in which case they only stand for the headers
+   * once stripPerHopHeaders() has been called.
+   */
+  void setWireBlock(std::string lines, bool hasPerHopHeaders);
+
+  /**
+   * The lines given to setWireBlock, or empty if they no longer stand for
+   * the headers they were set with.  Removing a header drops them, as does
+   * adding a Content-Length, Transfer-Encoding or Host header, which the
+   * lines may already have; other headers added since are left for
+   * forEachWithCodeAfterWireBlock.
+   */
+  folly::StringPiece getWireBlock() const;
+
+  /**
+   * As forEachWithCode, for the headers added after setWireBlock.
+   */
+  template <typename LAMBDA>
+  inline void forEachWithCodeAfterWireBlock(LAMBDA func) const;
+
  private:
   // vector storing the 1-byte hashes of header names
   folly::fbvector<HTTPHeaderCode> codes_;
@@ -281,6 +313,11 @@ class HTTPHeaders {
 
   size_t deletedCount_;
 
+  // Lines from setWireBlock, standing for the first wireBlockCount_ headers
+  std::shared_ptr<const std::string> wireBlock_;
+  size_t wireBlockCount_;
+  bool wireBlockNeedsStrip_;
+
   /**
    * The initial capacity of the three vectors, reserved right after
    * construction.
@@ -296,6 +333,20 @@ class HTTPHeaders {
 
   // deletes the strings in headerNames_ that we own
   void disposeOfHeaderNames();
+
+  void clearWireBlock() {
+    wireBlock_.reset();
+    wireBlockCount_ = 0;
+  }
+
+  // A second one of these, after the lines, would contradict them
+  void clearWireBlockOnAdd(HTTPHeaderCode code) {
+    if (wireBlock_ && (code == HTTP_HEADER_CONTENT_LENGTH ||
+                       code == HTTP_HEADER_TRANSFER_ENCODING ||
+                       code == HTTP_HEADER_HOST)) {
+      clearWireBlock();
+    }
+  }
 };
 
 // Implementation follows - it has to be in the .h because of the templates
@@ -304,6 +355,7 @@ template <typename T> // T = string
 void HTTPHeaders::add(folly::StringPiece name, T&& value) {
   assert(name.size());
   const HTTPHeaderCode code = HTTPCommonHeaders::hash(name.data(), name.size());
+  clearWireBlockOnAdd(code);
   codes_.push_back(code);
   headerNames_.push_back((code == HTTP_HEADER_OTHER)
       ? new std::string(name.data(), name.size())
@@ -314,6 +366,7 @@ void HTTPHeaders::add(folly::StringPiece name, T&& value) {
 
 template <typename T> // T = string
 void HTTPHeaders::add(HTTPHeaderCode code, T&& value) {
+  clearWireBlockOnAdd(code);
   codes_.push_back(code);
   headerNames_.push_back(HTTPCommonHeaders::getPointerToHeaderName(code));
   auto s = folly::rtrimWhitespace(std::forward<T>(value));
@@ -368,6 +421,15 @@ void HTTPHeaders::forEachWithCode(LAMBDA func) const {
   }
 }
 
+template <typename LAMBDA>
+void HTTPHeaders::forEachWithCodeAfterWireBlock(LAMBDA func) const {
+  for (size_t i = wireBlockCount_; i < codes_.size(); ++i) {
+    if (codes_[i] != HTTP_HEADER_NONE) {
+      func(codes_[i], *headerNames_[i], headerValues_[i]);
+    }
+  }
+}
+
 template <typename LAMBDA> // const string & -> bool
 bool HTTPHeaders::forEachValueOfHeader(folly::StringPiece name,
                                        LAMBDA func) const {
@@ -430,6 +492,9 @@ bool HTTPHeaders::removeByPredicate(LAMBDA func) {
     removed = true;
   }
 
+  if (removed) {
+    clearWireBlock();
+  }
   return removed;
 }
 
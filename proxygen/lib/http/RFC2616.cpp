@@ -9,8 +9,10 @@
  */
 #include <proxygen/lib/http/RFC2616.h>
 
+#include <limits>
 #include <stdlib.h>
 
+#include <folly/Conv.h>
 #include <folly/String.h>
 #include <folly/ThreadLocal.h>
 #include <proxygen/lib/http/HTTPHeaders.h>
@@ -170,4 +172,71 @@ bool parseByteRangeSpec(
   return true;
 }
 
+bool parseRangeHeader(
+    folly::StringPiece value,
+    uint64_t instanceLength,
+    std::vector<ByteRange>& output) {
+  value = folly::trimWhitespace(value);
+  if (!value.removePrefix("bytes=")) {
+    return false;
+  }
+
+  std::vector<folly::StringPiece> specs;
+  folly::split(",", value, specs);
+  // Only appended to output once every spec has parsed
+  std::vector<ByteRange> ranges;
+  bool sawSpec = false;
+  for (auto spec : specs) {
+    spec = folly::trimWhitespace(spec);
+    if (spec.empty()) {
+      // RFC 7230 section 7 allows empty list elements
+      continue;
+    }
+    sawSpec = true;
+    auto dash = spec.find('-');
+    if (dash == std::string::npos) {
+      return false;
+    }
+    auto firstStr = folly::trimWhitespace(spec.subpiece(0, dash));
+    auto lastStr = folly::trimWhitespace(spec.subpiece(dash + 1));
+
+    if (firstStr.empty()) {
+      // suffix-byte-range-spec: the final N bytes
+      auto suffix = folly::tryTo<uint64_t>(lastStr);
+      if (!suffix) {
+        return false;
+      }
+      if (*suffix == 0 || instanceLength == 0) {
+        continue;
+      }
+      auto len = std::min(*suffix, instanceLength);
+      ranges.emplace_back(instanceLength - len, instanceLength - 1);
+      continue;
+    }
+
+    auto first = folly::tryTo<uint64_t>(firstStr);
+    if (!first) {
+      return false;
+    }
+    uint64_t last = std::numeric_limits<uint64_t>::max();
+    if (!lastStr.empty()) {
+      auto parsedLast = folly::tryTo<uint64_t>(lastStr);
+      if (!parsedLast || *parsedLast < *first) {
+        return false;
+      }
+      last = *parsedLast;
+    }
+    if (*first >= instanceLength) {
+      // unsatisfiable, but other ranges in the set may still be served
+      continue;
+    }
+    ranges.emplace_back(*first, std::min(last, instanceLength - 1));
+  }
+  if (!sawSpec) {
+    return false;
+  }
+  output.insert(output.end(), ranges.begin(), ranges.end());
+  return true;
+}
+
 }}
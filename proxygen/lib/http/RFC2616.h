@@ -90,4 +90,28 @@ bool parseByteRangeSpec(
     unsigned long& lastByte,
     unsigned long& instanceLength);
 
+/**
+ * A single satisfiable byte range, inclusive of both the first and last byte
+ * positions, resolved against the length of the selected representation.
+ */
+using ByteRange = std::pair<uint64_t, uint64_t>;
+
+/**
+ * Parse an RFC 7233 section 3.1 "Range" request header value such as
+ * "bytes=0-499,-500,9500-" against a representation of instanceLength bytes.
+ * Suffix ranges and open-ended ranges are resolved, last byte positions past
+ * the end are clamped, and unsatisfiable ranges are dropped. Ranges are
+ * appended to output in the order they were requested.
+ *
+ * Returns false if the header is malformed or uses a unit other than "bytes";
+ * callers should then ignore the header and serve the full representation.
+ * Returns true with an empty output if the header is well formed but none of
+ * its ranges is satisfiable (416 Range Not Satisfiable). output is left as it
+ * was on failure.
+ */
+bool parseRangeHeader(
+    folly::StringPiece value,
+    uint64_t instanceLength,
+    std::vector<ByteRange>& output);
+
 }}
@@ -0,0 +1,50 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/ReceiveWindowTuner.h>
+
+#include <glog/logging.h>
+#include <limits>
+
+namespace proxygen {
+
+constexpr uint32_t ReceiveWindowTuner::kGrowthRTTs;
+
+uint32_t ReceiveWindowTuner::getTargetCapacity(uint32_t capacity,
+                                               std::chrono::microseconds rtt,
+                                               TimePoint now) {
+  auto lastCreditTime = lastCreditTime_;
+  lastCreditTime_ = now;
+  if (capacity >= maxCapacity_) {
+    return maxCapacity_;
+  }
+  if (rtt.count() <= 0 || lastCreditTime == TimePoint()) {
+    return capacity;
+  }
+  if (now - lastCreditTime >= rtt * kGrowthRTTs) {
+    // The peer is not using the window as fast as it could
+    return capacity;
+  }
+  uint64_t target = std::min<uint64_t>(uint64_t(capacity) * 2, maxCapacity_);
+  target = std::min<uint64_t>(target, std::numeric_limits<int32_t>::max());
+  VLOG(4) << "Growing receive window from " << capacity << " to " << target
+          << ", rtt=" << rtt.count() << "us";
+  return static_cast<uint32_t>(target);
+}
+
+bool ReceiveWindowTuner::onBytesConsumed(uint32_t capacity, uint32_t bytes) {
+  consumed_ = std::min<uint64_t>(uint64_t(consumed_) + bytes, capacity);
+  if (consumed_ < capacity / 2) {
+    return false;
+  }
+  consumed_ = 0;
+  return true;
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <proxygen/lib/utils/Time.h>
+
+namespace proxygen {
+
+/**
+ * Decides how large a receive window should be, based on how quickly its
+ * credit is consumed relative to the round trip time.
+ *
+ * Receivers return credit once about half of a window has been consumed.  If
+ * that happens again within kGrowthRTTs round trips, the peer is sending as
+ * fast as the window allows, i.e. the window rather than the application is
+ * limiting throughput, and the window is doubled, up to maxCapacity.  A
+ * capacity above maxCapacity (e.g. after maxCapacity was lowered due to memory
+ * pressure) is brought back down to it.
+ *
+ * This class only makes the decision.  Callers grow a window by returning the
+ * extra credit to the peer, and shrink it by withholding credit for consumed
+ * bytes, which never invalidates data the peer already has in flight.
+ */
+class ReceiveWindowTuner {
+ public:
+  static constexpr uint32_t kGrowthRTTs = 2;
+
+  explicit ReceiveWindowTuner(uint32_t maxCapacity)
+      : maxCapacity_(maxCapacity) {}
+
+  /**
+   * Changes the largest window this tuner will ask for.  Lowering it below the
+   * current capacity makes getTargetCapacity() ask for a smaller window.
+   */
+  void setMaxCapacity(uint32_t maxCapacity) {
+    maxCapacity_ = maxCapacity;
+  }
+
+  uint32_t getMaxCapacity() const {
+    return maxCapacity_;
+  }
+
+  /**
+   * Called each time credit is about to be returned for a window of the given
+   * capacity.  Returns the capacity the window should have from now on.
+   *
+   * @param rtt  The current round trip time estimate, zero if unknown.  No
+   *             growth happens without an estimate.
+   */
+  uint32_t getTargetCapacity(uint32_t capacity,
+                             std::chrono::microseconds rtt,
+                             TimePoint now = getCurrentTime());
+
+  /**
+   * For transports that return credit on their own, such as QUIC: counts
+   * consumed bytes and returns true each time half of the window has been
+   * consumed, which is when getTargetCapacity() should be consulted.
+   */
+  bool onBytesConsumed(uint32_t capacity, uint32_t bytes);
+
+ private:
+  TimePoint lastCreditTime_;
+  uint32_t maxCapacity_;
+  uint32_t consumed_{0};
+};
+
+}
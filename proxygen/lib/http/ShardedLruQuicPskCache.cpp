@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/ShardedLruQuicPskCache.h>
+
+#include <folly/lang/Bits.h>
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+
+namespace {
+
+// One in this many hits per thread moves its entry to the front of the LRU
+constexpr uint32_t kPromoteEvery = 8;
+
+} // namespace
+
+namespace proxygen {
+
+constexpr size_t ShardedLruQuicPskCache::kDefaultNumShards;
+
+ShardedLruQuicPskCache::ShardedLruQuicPskCache(uint64_t mapMax,
+                                               size_t numShards) {
+  numShards = folly::nextPowTwo(std::max<size_t>(numShards, 1));
+  auto shardMax = std::max<uint64_t>((mapMax + numShards - 1) / numShards, 1);
+  shards_.reserve(numShards);
+  for (size_t i = 0; i < numShards; i++) {
+    shards_.push_back(std::make_unique<Shard>(shardMax));
+  }
+  // Shards take the top bits of the hash; the maps index by the low ones
+  shardShift_ = 64 - folly::findLastSet(numShards) + 1;
+}
+
+size_t ShardedLruQuicPskCache::getShardIndex(
+    const std::string& identity) const {
+  if (shards_.size() == 1) {
+    return 0;
+  }
+  uint64_t hash = std::hash<std::string>()(identity);
+  return hash >> shardShift_;
+}
+
+ShardedLruQuicPskCache::Shard& ShardedLruQuicPskCache::getShard(
+    const std::string& identity) {
+  return *shards_[getShardIndex(identity)];
+}
+
+folly::Optional<quic::QuicCachedPsk> ShardedLruQuicPskCache::getPsk(
+    const std::string& identity) {
+  auto& shard = getShard(identity);
+  folly::Optional<quic::QuicCachedPsk> result;
+  {
+    folly::SharedMutex::ReadHolder guard(shard.mutex);
+    auto it = shard.map.findWithoutPromotion(identity);
+    if (it == shard.map.end()) {
+      return folly::none;
+    }
+    result = it->second;
+  }
+
+  static thread_local uint32_t hits = 0;
+  if (++hits % kPromoteEvery == 0) {
+    std::unique_lock<folly::SharedMutex> guard(shard.mutex, std::try_to_lock);
+    if (guard.owns_lock()) {
+      // A no-op if the entry was removed meanwhile
+      shard.map.find(identity);
+    }
+  }
+  return result;
+}
+
+void ShardedLruQuicPskCache::putPsk(const std::string& identity,
+                                    quic::QuicCachedPsk psk) {
+  auto& shard = getShard(identity);
+  folly::SharedMutex::WriteHolder guard(shard.mutex);
+  shard.map.set(identity, std::move(psk));
+}
+
+void ShardedLruQuicPskCache::removePsk(const std::string& identity) {
+  auto& shard = getShard(identity);
+  folly::SharedMutex::WriteHolder guard(shard.mutex);
+  shard.map.erase(identity);
+}
+
+} // namespace proxygen
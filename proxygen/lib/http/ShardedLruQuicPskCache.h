@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/SharedMutex.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <quic/client/handshake/QuicPskCache.h>
+
+#include <memory>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * A QuicPskCache for clients that resume from many threads at once.  Like
+ * SynchronizedLruQuicPskCache, but identities are hashed to shards, each an
+ * LRU map with its own lock, so threads only contend when they use the same
+ * shard.
+ *
+ * Lookups take the shard's lock shared.  Moving the entry to the front of
+ * the LRU needs it exclusive, so only a sample of hits does that, and only
+ * if the lock is free.  Each shard holds mapMax / numShards entries, so
+ * which entry gets evicted is approximate.
+ */
+class ShardedLruQuicPskCache : public quic::QuicPskCache {
+ public:
+  static constexpr size_t kDefaultNumShards = 32;
+
+  ~ShardedLruQuicPskCache() override = default;
+
+  /**
+   * @param numShards  rounded up to a power of two
+   */
+  explicit ShardedLruQuicPskCache(uint64_t mapMax,
+                                  size_t numShards = kDefaultNumShards);
+
+  folly::Optional<quic::QuicCachedPsk> getPsk(
+      const std::string& identity) override;
+
+  void putPsk(const std::string& identity, quic::QuicCachedPsk psk) override;
+
+  void removePsk(const std::string& identity) override;
+
+  size_t getNumShards() const {
+    return shards_.size();
+  }
+
+  /**
+   * The shard identity is kept in, less than getNumShards()
+   */
+  size_t getShardIndex(const std::string& identity) const;
+
+ private:
+  using EvictingPskMap =
+      folly::EvictingCacheMap<std::string, quic::QuicCachedPsk>;
+
+  struct Shard {
+    explicit Shard(size_t maxSize) : map(maxSize) {}
+
+    folly::SharedMutex mutex;
+    EvictingPskMap map;
+  };
+
+  Shard& getShard(const std::string& identity);
+
+  // Each shard is its own allocation, so that threads locking different
+  // shards do not share a cache line
+  std::vector<std::unique_ptr<Shard>> shards_;
+  uint32_t shardShift_;
+};
+
+} // namespace proxygen
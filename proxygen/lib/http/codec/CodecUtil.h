@@ -16,6 +16,8 @@
 #include <string>
 #include <proxygen/lib/utils/UtilInl.h>
 #include <proxygen/lib/http/HTTPMessage.h>
+#include <proxygen/lib/http/codec/HeaderConstants.h>
+#include <proxygen/lib/http/codec/HeaderValidation.h>
 #include <proxygen/lib/http/codec/compress/Header.h>
 
 namespace proxygen {
@@ -41,15 +43,7 @@ class CodecUtil {
   }
 
   static bool validateHeaderName(folly::ByteRange name) {
-    if (name.size() == 0) {
-      return false;
-    }
-    for (auto p: name) {
-      if (p < 0x80 && http_tokens[(uint8_t)p] != p) {
-        return false;
-      }
-    }
-    return true;
+    return HeaderValidation::validateName(name);
   }
 
   /**
@@ -65,6 +59,10 @@ class CodecUtil {
 
   static bool validateHeaderValue(folly::ByteRange value,
                                   CtlEscapeMode mode) {
+    if (HeaderValidation::isPlainValue(value)) {
+      // Nothing for the state machine below to reject
+      return true;
+    }
     bool escape = false;
     bool quote = false;
     enum { lws_none,
@@ -147,5 +145,80 @@ class CodecUtil {
   static bool appendHeaders(const HTTPHeaders& inputHeaders,
                             std::vector<compress::Header>& headers,
                             HTTPHeaderCode headerToCheck);
+
+  /**
+   * Calls fn(HTTPHeaderCode, const std::string& name, const std::string&
+   * value) for each header prepareMessageForCompression would return, in the
+   * same order, without building the vector.  The arguments are only valid
+   * during the call.
+   */
+  template <typename Fn>
+  static void forEachHeaderForCompression(const HTTPMessage& msg, Fn&& fn) {
+    auto pseudo = [&fn] (HTTPHeaderCode code, const std::string& value) {
+      fn(code, *HTTPCommonHeaders::getPointerToHeaderName(code), value);
+    };
+    if (msg.isRequest()) {
+      if (msg.isEgressWebsocketUpgrade()) {
+        pseudo(HTTP_HEADER_COLON_METHOD, methodToString(HTTPMethod::CONNECT));
+        pseudo(HTTP_HEADER_COLON_PROTOCOL, headers::kWebsocketString);
+      } else {
+        pseudo(HTTP_HEADER_COLON_METHOD, msg.getMethodString());
+      }
+
+      if (msg.getMethod() != HTTPMethod::CONNECT ||
+          msg.isEgressWebsocketUpgrade()) {
+        pseudo(HTTP_HEADER_COLON_SCHEME,
+               msg.isSecure() ? headers::kHttps : headers::kHttp);
+        pseudo(HTTP_HEADER_COLON_PATH, msg.getURL());
+      }
+      const std::string& host =
+        msg.getHeaders().getSingleOrEmpty(HTTP_HEADER_HOST);
+      if (!host.empty()) {
+        pseudo(HTTP_HEADER_COLON_AUTHORITY, host);
+      }
+    } else if (msg.isEgressWebsocketUpgrade()) {
+      pseudo(HTTP_HEADER_COLON_STATUS, headers::kStatus200);
+    } else {
+      pseudo(HTTP_HEADER_COLON_STATUS,
+             folly::to<std::string>(msg.getStatusCode()));
+    }
+
+    bool hasDateHeader =
+      forEachHeaderForCompression(msg.getHeaders(), HTTP_HEADER_DATE, fn);
+
+    if (msg.isResponse() && !hasDateHeader) {
+      pseudo(HTTP_HEADER_DATE, HTTPMessage::formatDateHeader());
+    }
+  }
+
+  /**
+   * Calls fn for each header appendHeaders would append.
+   *
+   * @return true if there is a headerToCheck
+   */
+  template <typename Fn>
+  static bool forEachHeaderForCompression(const HTTPHeaders& inputHeaders,
+                                          HTTPHeaderCode headerToCheck,
+                                          Fn&& fn) {
+    bool headerToCheckExists = false;
+    inputHeaders.forEachWithCode([&](HTTPHeaderCode code,
+                                     const std::string& name,
+                                     const std::string& value) {
+      if (skipHeaderForCompression(code, name, value)) {
+        return;
+      }
+      fn(code, name, value);
+      if (code == headerToCheck) {
+        headerToCheckExists = true;
+      }
+    });
+    return headerToCheckExists;
+  }
+
+ private:
+  // True for the headers that do not go into HTTP/2 or HTTP/3 header blocks
+  static bool skipHeaderForCompression(HTTPHeaderCode code,
+                                       const std::string& name,
+                                       const std::string& value);
 };
 }
@@ -75,13 +75,59 @@ bool FlowControlFilter::ingressBytesProcessed(folly::IOBufQueue& writeBuf,
           << " bytes, will ack=" << willAck;
   if (willAck) {
     CHECK(recvWindow_.free(toAck_));
-    call_->generateWindowUpdate(writeBuf, 0, toAck_);
+    if (recvWindowTuner_) {
+      tuneReceiveWindow();
+    }
+    bool acked = toAck_ > 0;
+    if (acked && deferWindowUpdates_) {
+      pendingAck_ += toAck_;
+    } else if (acked) {
+      call_->generateWindowUpdate(writeBuf, 0, toAck_);
+    }
     toAck_ = 0;
-    return true;
+    return acked;
   }
   return false;
 }
 
+size_t FlowControlFilter::flushWindowUpdate(folly::IOBufQueue& writeBuf) {
+  if (pendingAck_ == 0) {
+    return 0;
+  }
+  VLOG(4) << "flushing deferred conn-level window update of " << pendingAck_;
+  auto ret = call_->generateWindowUpdate(writeBuf, 0, pendingAck_);
+  pendingAck_ = 0;
+  return ret;
+}
+
+void FlowControlFilter::setReceiveWindowTuning(uint32_t maxCapacity) {
+  if (maxCapacity == 0) {
+    recvWindowTuner_.reset();
+  } else if (recvWindowTuner_) {
+    recvWindowTuner_->setMaxCapacity(maxCapacity);
+  } else {
+    recvWindowTuner_ = std::make_unique<ReceiveWindowTuner>(maxCapacity);
+  }
+}
+
+void FlowControlFilter::tuneReceiveWindow() {
+  const uint32_t capacity = recvWindow_.getCapacity();
+  const uint32_t target = recvWindowTuner_->getTargetCapacity(
+    capacity, notify_.getRTT());
+  if (target > capacity) {
+    if (recvWindow_.setCapacity(target)) {
+      toAck_ += target - capacity;
+    }
+  } else if (target < capacity) {
+    // Withhold credit for bytes that were already consumed, so the peer's
+    // view of the window never shrinks below what it may have in flight.
+    uint32_t shrink = std::min<uint32_t>(capacity - target, toAck_);
+    CHECK(recvWindow_.setCapacity(capacity - shrink));
+    toAck_ -= shrink;
+    VLOG(4) << "Shrunk conn-level recv window to " << capacity - shrink;
+  }
+}
+
 uint32_t FlowControlFilter::getAvailableSend() const {
   return sendWindow_.getNonNegativeSize();
 }
@@ -114,6 +160,11 @@ void FlowControlFilter::onBody(StreamID stream,
   }
 }
 
+void FlowControlFilter::onHeadersBatch(std::vector<IngressHeaders>& batch) {
+  // Nothing here looks at new messages
+  callback_->onHeadersBatch(batch);
+}
+
 void FlowControlFilter::onWindowUpdate(StreamID stream, uint32_t amount) {
   if (!stream) {
     bool success = sendWindow_.free(amount);
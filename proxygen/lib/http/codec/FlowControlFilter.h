@@ -9,6 +9,9 @@
  */
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <proxygen/lib/http/ReceiveWindowTuner.h>
 #include <proxygen/lib/http/Window.h>
 #include <proxygen/lib/http/codec/HTTPCodecFilter.h>
 
@@ -34,6 +37,14 @@ class FlowControlFilter:
      */
     virtual void onConnectionSendWindowOpen() = 0;
     virtual void onConnectionSendWindowClosed() = 0;
+
+    /**
+     * The current round trip time estimate of the connection, zero if
+     * unknown.  Used to auto-tune the receive window.
+     */
+    virtual std::chrono::microseconds getRTT() const noexcept {
+      return std::chrono::microseconds::zero();
+    }
   };
 
   /**
@@ -64,6 +75,21 @@ class FlowControlFilter:
    */
   void setReceiveWindowSize(folly::IOBufQueue& writeBuf, uint32_t capacity);
 
+  /**
+   * Enable receive window auto-tuning.  Whenever a WINDOW_UPDATE is due, the
+   * window may be grown up to maxCapacity (see ReceiveWindowTuner).  Calling
+   * this again with a smaller maxCapacity shrinks a grown window back as
+   * credit is returned.  0 disables auto-tuning.
+   */
+  void setReceiveWindowTuning(uint32_t maxCapacity);
+
+  /**
+   * @returns the capacity of the connection-level receive window
+   */
+  uint32_t getReceiveWindowCapacity() const {
+    return recvWindow_.getCapacity();
+  }
+
   /**
    * Notify the flow control filter that some ingress bytes were
    * processed. If the number of bytes to acknowledge exceeds half the
@@ -75,6 +101,26 @@ class FlowControlFilter:
    */
   bool ingressBytesProcessed(folly::IOBufQueue& writeBuf, uint32_t delta);
 
+  /**
+   * When deferred, ingressBytesProcessed() only accumulates the credit that
+   * is due (and still returns true), and flushWindowUpdate() writes it as a
+   * single WINDOW_UPDATE.  This lets the session merge the credit returned
+   * during one event loop iteration.
+   */
+  void setDeferWindowUpdates(bool defer) {
+    deferWindowUpdates_ = defer;
+  }
+
+  bool hasPendingWindowUpdate() const {
+    return pendingAck_ > 0;
+  }
+
+  /**
+   * Writes the WINDOW_UPDATE accumulated while deferring, if any.
+   * @returns the number of bytes written to writeBuf
+   */
+  size_t flushWindowUpdate(folly::IOBufQueue& writeBuf);
+
   /**
    * @returns the number of bytes available in the connection-level send window
    */
@@ -87,6 +133,8 @@ class FlowControlFilter:
   void onBody(StreamID stream, std::unique_ptr<folly::IOBuf> chain,
               uint16_t padding) override;
 
+  void onHeadersBatch(std::vector<IngressHeaders>& batch) override;
+
   void onWindowUpdate(StreamID stream, uint32_t amount) override;
 
   size_t generateBody(folly::IOBufQueue& writeBuf,
@@ -100,11 +148,20 @@ class FlowControlFilter:
                               uint32_t delta) override;
 
  private:
+  /**
+   * Applies the tuner's target capacity to recvWindow_ and toAck_.  Must be
+   * called after toAck_ bytes were freed in recvWindow_.
+   */
+  void tuneReceiveWindow();
 
   Callback& notify_;
   Window recvWindow_;
   Window sendWindow_;
+  std::unique_ptr<ReceiveWindowTuner> recvWindowTuner_;
   int32_t toAck_{0};
+  // credit that is due but deferred until flushWindowUpdate()
+  uint32_t pendingAck_{0};
+  bool deferWindowUpdates_{false};
   bool error_:1;
   bool sendsBlocked_:1;
 };
@@ -196,9 +196,17 @@ ParseResult HQStreamCodec::parsePushPromise(Cursor& cursor,
 
 void HQStreamCodec::onHeader(const folly::fbstring& name,
                              const folly::fbstring& value) {
-  if (decodeInfo_.onHeader(name, value)) {
-    if (name == "user-agent" && userAgent_.empty()) {
-      userAgent_ = value.toStdString();
+  // The decoder calls onHeaderView, this is only for other callers
+  HPACKHeaderName headerName(name);
+  onHeaderView(headerName.getHeaderCode(), headerName.get(), value);
+}
+
+void HQStreamCodec::onHeaderView(HTTPHeaderCode code,
+                                 folly::StringPiece name,
+                                 folly::StringPiece value) {
+  if (decodeInfo_.onHeader(code, name, value)) {
+    if (code == HTTP_HEADER_USER_AGENT && userAgent_.empty()) {
+      userAgent_ = value.str();
     }
   } else {
     VLOG(4) << "dir=" << uint32_t(transportDirection_)
@@ -524,10 +532,8 @@ void HQStreamCodec::generateHeaderImpl(folly::IOBufQueue& writeBuf,
                                        const HTTPMessage& msg,
                                        folly::Optional<StreamID> pushId,
                                        HTTPHeaderSize* size) {
-  std::vector<std::string> temps;
-  auto allHeaders = CodecUtil::prepareMessageForCompression(msg, temps);
-  auto result =
-      headerCodec_.encode(allHeaders, streamId_, maxEncoderStreamData());
+  auto result = headerCodec_.encodeHTTPMessage(
+      msg, streamId_, maxEncoderStreamData());
   if (size) {
     *size = headerCodec_.getEncodedSize();
   }
@@ -157,6 +157,9 @@ class HQStreamCodec
 
   void onHeader(const folly::fbstring& name,
                 const folly::fbstring& value) override;
+  void onHeaderView(HTTPHeaderCode code,
+                    folly::StringPiece name,
+                    folly::StringPiece value) override;
   void onHeadersComplete(HTTPHeaderSize decodedSize, bool acknowledge) override;
   void onDecodeError(HPACK::DecodeError decodeError) override;
 
@@ -15,6 +15,7 @@
 #include <proxygen/lib/http/HTTPHeaderSize.h>
 #include <proxygen/lib/http/RFC2616.h>
 #include <proxygen/lib/http/codec/CodecProtocol.h>
+#include <proxygen/lib/http/codec/HeaderValidation.h>
 #include <proxygen/lib/utils/Base64.h>
 
 using folly::IOBuf;
@@ -83,6 +84,7 @@ HTTP1xCodec::HTTP1xCodec(TransportDirection direction, bool forceUpstream1_1)
       ingressTxnID_(0),
       egressTxnID_(0),
       currentIngressBuf_(nullptr),
+      headerLinesStart_(nullptr),
       headerParseState_(HeaderParseState::kParsingHeaderIdle),
       transportDirection_(direction),
       keepaliveRequested_(KeepaliveRequested::UNSET),
@@ -108,7 +110,8 @@ HTTP1xCodec::HTTP1xCodec(TransportDirection direction, bool forceUpstream1_1)
       ingressUpgradeComplete_(false),
       egressUpgrade_(false),
       nativeUpgrade_(false),
-      headersComplete_(false) {
+      headersComplete_(false),
+      keepIngressHeaderLines_(false) {
   switch (direction) {
   case TransportDirection::DOWNSTREAM:
     http_parser_init(&parser_, HTTP_REQUEST);
@@ -219,6 +222,10 @@ HTTP1xCodec::onIngress(const IOBuf& buf) {
       currentHeaderName_.assign(currentHeaderNameStringPiece_.begin(),
                                 currentHeaderNameStringPiece_.size());
     }
+    if (isParsingHeaders()) {
+      // The rest of the header lines will be in another buffer
+      headerLinesStart_ = nullptr;
+    }
     currentIngressBuf_ = nullptr;
     if (pendingEOF_) {
       onIngressEOF();
@@ -508,9 +515,9 @@ HTTP1xCodec::generateHeader(IOBufQueue& writeBuf,
   size_t lastConnectionToken = 0;
   bool egressWebsocketUpgrade = msg.isEgressWebsocketUpgrade();
   bool hasUpgradeTokeninConnection = false;
-  msg.getHeaders().forEachWithCode([&] (HTTPHeaderCode code,
-                                        const string& header,
-                                        const string& value) {
+  auto writeHeader = [&] (HTTPHeaderCode code,
+                          const string& header,
+                          const string& value) {
     if (code == HTTP_HEADER_CONTENT_LENGTH) {
       // Write the Content-Length last (t1071703)
       deferredContentLength = &value;
@@ -562,6 +569,15 @@ HTTP1xCodec::generateHeader(IOBufQueue& writeBuf,
       // will generate our own accept per hop, not client's.
       return;
     }
+    if (HeaderValidation::hasForbiddenValueChars(
+          folly::ByteRange(StringPiece(header))) ||
+        HeaderValidation::hasForbiddenValueChars(
+          folly::ByteRange(StringPiece(value)))) {
+      // It would end the header line early and let the rest of it be read
+      // as another header, or as the body
+      LOG(ERROR) << "Dropping header with CR, LF or NUL, name=" << header;
+      return; // continue
+    }
     size_t lineLen = header.length() + value.length() + 4; // 4 for ": " + CRLF
     auto writable = writeBuf.preallocate(lineLen,
         std::max(lineLen, size_t(2000)));
@@ -577,7 +593,23 @@ HTTP1xCodec::generateHeader(IOBufQueue& writeBuf,
     DCHECK_EQ(size_t(++dst - (char*)writable.first), lineLen);
     writeBuf.postallocate(lineLen);
     len += lineLen;
-  });
+  };
+  const HTTPHeaders& headers = msg.getHeaders();
+  StringPiece wireBlock;
+  if (!egressWebsocketUpgrade) {
+    wireBlock = headers.getWireBlock();
+  }
+  bool hasWireContentLength = false;
+  if (!wireBlock.empty()) {
+    // The headers came from an HTTP/1.x peer and only per-hop headers have
+    // been removed, which the lines leave out, so copy them
+    appendString(writeBuf, len, wireBlock);
+    hasWireContentLength = headers.exists(HTTP_HEADER_CONTENT_LENGTH);
+    hasDateHeader = headers.exists(HTTP_HEADER_DATE);
+    headers.forEachWithCodeAfterWireBlock(writeHeader);
+  } else {
+    headers.forEachWithCode(writeHeader);
+  }
   bool bodyCheck =
     (downstream && keepalive_ && !expectNoResponseBody_ && !egressUpgrade_) ||
     // auto chunk POSTs and any request that came to us chunked
@@ -585,7 +617,8 @@ HTTP1xCodec::generateHeader(IOBufQueue& writeBuf,
   // TODO: 400 a 1.0 POST with no content-length
   // clear egressChunked_ if the header wasn't actually set
   egressChunked_ &= hasTransferEncodingChunked;
-  if (bodyCheck && !egressChunked_ && !deferredContentLength) {
+  if (bodyCheck && !egressChunked_ && !deferredContentLength &&
+      !hasWireContentLength) {
     // On a connection that would otherwise be eligible for keep-alive,
     // we're being asked to send a response message with no Content-Length,
     // no chunked encoding, and no special circumstances that would eliminate
@@ -819,6 +852,7 @@ HTTP1xCodec::onMessageBegin() {
   headersComplete_ = false;
   headerSize_.uncompressed = 0;
   headerParseState_ = HeaderParseState::kParsingHeaderStart;
+  headerLinesStart_ = nullptr;
   msg_.reset(new HTTPMessage());
   trailers_.reset();
   if (transportDirection_ == TransportDirection::DOWNSTREAM) {
@@ -863,6 +897,74 @@ void HTTP1xCodec::pushHeaderNameAndValue(HTTPHeaders& hdrs) {
   currentHeaderValue_.clear();
 }
 
+void HTTP1xCodec::keepHeaderLines() {
+  HTTPHeaders& hdrs = msg_->getHeaders();
+  const char* p = headerLinesStart_;
+  const char* end = (const char*)currentIngressBuf_->tail();
+
+  // Leave out the headers that stripPerHopHeaders would remove
+  std::bitset<256> perHopCodes = HTTPHeaders::perHopHeaderCodes();
+  std::vector<StringPiece> perHopNames;
+  hdrs.forEachValueOfHeader(HTTP_HEADER_CONNECTION,
+                            [&] (const string& value) -> bool {
+    StringPiece tokens(value);
+    while (!tokens.empty()) {
+      auto token = trimWhitespace(tokens.split_step(','));
+      if (token.empty()) {
+        continue;
+      }
+      auto code = HTTPCommonHeaders::hash(token.data(), token.size());
+      if (code == HTTP_HEADER_OTHER) {
+        perHopNames.push_back(token);
+      } else {
+        perHopCodes[code] = true;
+      }
+    }
+    return false;
+  });
+
+  // The headers were added in the order of their lines, so walk both.  Give
+  // up on anything but one "name:value\r\n" line per header, like obs-fold.
+  std::string lines;
+  const char* runStart = p;
+  bool valid = true;
+  bool hasPerHopHeaders = false;
+  hdrs.forEachWithCode([&] (HTTPHeaderCode code,
+                            const string& name,
+                            const string& /*value*/) {
+    if (!valid) {
+      return;
+    }
+    auto eol = (const char*)memchr(p, '\n', end - p);
+    if (!eol || size_t(eol - p) < name.size() + 2 || eol[-1] != '\r' ||
+        p[name.size()] != ':' ||
+        !caseInsensitiveEqual(StringPiece(p, name.size()), name) ||
+        HeaderValidation::hasForbiddenValueChars(
+          folly::ByteRange(StringPiece(p, eol - 1)))) {
+      valid = false;
+      return;
+    }
+    bool perHop = perHopCodes[code];
+    if (code == HTTP_HEADER_OTHER) {
+      for (auto perHopName : perHopNames) {
+        perHop |= caseInsensitiveEqual(perHopName, name);
+      }
+    }
+    if (perHop) {
+      lines.append(runStart, p);
+      runStart = eol + 1;
+      hasPerHopHeaders = true;
+    }
+    p = eol + 1;
+  });
+  // The blank line ends them
+  if (!valid || end - p < 2 || p[0] != '\r' || p[1] != '\n') {
+    return;
+  }
+  lines.append(runStart, p);
+  hdrs.setWireBlock(std::move(lines), hasPerHopHeaders);
+}
+
 int
 HTTP1xCodec::onHeaderField(const char* buf, size_t len) {
   if (headerParseState_ == HeaderParseState::kParsingHeaderValue) {
@@ -902,6 +1004,10 @@ HTTP1xCodec::onHeaderField(const char* buf, size_t len) {
     // we're not yet parsing a header name - this is the first chunk
     // (typically, there is only one)
     currentHeaderNameStringPiece_.reset(buf, len);
+    if (keepIngressHeaderLines_ &&
+        headerParseState_ == HeaderParseState::kParsingHeaderStart) {
+      headerLinesStart_ = buf;
+    }
 
     if (headerParseState_ >= HeaderParseState::kParsingHeadersComplete) {
       headerParseState_ = HeaderParseState::kParsingTrailerName;
@@ -928,6 +1034,11 @@ HTTP1xCodec::onHeadersComplete(size_t len) {
   if (headerParseState_ == HeaderParseState::kParsingHeaderValue) {
     pushHeaderNameAndValue(msg_->getHeaders());
   }
+  if (headerLinesStart_) {
+    // Before the codec changes any header below
+    keepHeaderLines();
+    headerLinesStart_ = nullptr;
+  }
 
   // discard messages with folded or multiple valued Transfer-Encoding headers
   // ex : "chunked , zorg\r\n" or "\r\n chunked \r\n" (t12767790)
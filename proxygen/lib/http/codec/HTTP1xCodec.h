@@ -89,6 +89,16 @@ class HTTP1xCodec : public HTTPCodec {
   void setAllowedUpgradeProtocols(std::list<std::string> protocols);
   const std::string& getAllowedUpgradeProtocols();
 
+  /**
+   * Keep the header lines of each ingress message with its headers, see
+   * HTTPHeaders::setWireBlock, so that an HTTP1xCodec forwarding it
+   * unmodified can copy them.  Only header blocks that arrive in one
+   * onIngress call are kept.  Off by default.
+   */
+  void setKeepIngressHeaderLines(bool enabled) {
+    keepIngressHeaderLines_ = enabled;
+  }
+
   /**
    * @returns true if the codec supports the given NPN protocol.
    */
@@ -142,6 +152,9 @@ class HTTP1xCodec : public HTTPCodec {
   /** Push out header name-value pair to hdrs and clear currentHeader*_ */
   void pushHeaderNameAndValue(HTTPHeaders& hdrs);
 
+  /** Give msg_ the header lines starting at headerLinesStart_ */
+  void keepHeaderLines();
+
   /** Serialize websocket headers into a buffer **/
   void serializeWebsocketHeader(folly::IOBufQueue& writeBuf, size_t& len,
       bool upstream);
@@ -163,6 +176,8 @@ class HTTP1xCodec : public HTTPCodec {
   StreamID egressTxnID_;
   http_parser parser_;
   const folly::IOBuf* currentIngressBuf_;
+  // start of the first header line in currentIngressBuf_, when kept
+  const char* headerLinesStart_;
   std::unique_ptr<HTTPMessage> msg_;
   std::unique_ptr<HTTPMessage> upgradeRequest_;
   std::unique_ptr<HTTPHeaders> trailers_;
@@ -203,6 +218,7 @@ class HTTP1xCodec : public HTTPCodec {
   bool egressUpgrade_:1;
   bool nativeUpgrade_:1;
   bool headersComplete_:1;
+  bool keepIngressHeaderLines_:1;
 
   // C-callable wrappers for the http_parser callbacks
   static int onMessageBeginCB(http_parser* parser);
@@ -68,9 +68,14 @@ size_t HTTP2Codec::onIngress(const folly::IOBuf& buf) {
   Cursor cursor(&buf);
   size_t parsed = 0;
   ErrorCode connError = ErrorCode::NO_ERROR;
-  for (auto bufLen = cursor.totalLength();
+  // Every successfully parsed frame consumes exactly what it accounts for in
+  // parsed, so track the remaining length rather than walking the chain with
+  // Cursor::totalLength() once per frame.
+  const size_t totalLen = cursor.totalLength();
+  for (auto bufLen = totalLen;
        connError == ErrorCode::NO_ERROR;
-       bufLen = cursor.totalLength()) {
+       bufLen = totalLen - parsed) {
+    DCHECK_EQ(bufLen, cursor.totalLength());
     if (frameState_ == FrameState::UPSTREAM_CONNECTION_PREFACE) {
       if (bufLen >= http2::kConnectionPreface.length()) {
         auto test = cursor.readFixedString(http2::kConnectionPreface.length());
@@ -88,8 +93,19 @@ size_t HTTP2Codec::onIngress(const folly::IOBuf& buf) {
                frameState_ == FrameState::DOWNSTREAM_CONNECTION_PREFACE) {
       // Waiting to parse the common frame header
       if (bufLen >= http2::kFrameHeaderSize) {
-        connError = parseFrameHeader(cursor, curHeader_);
+        auto contiguous = cursor.peekBytes();
+        if (contiguous.size() >= http2::kFrameHeaderSize) {
+          // Fast path: the header doesn't straddle IOBufs in the chain
+          connError = http2::parseFrameHeader(contiguous.data(), curHeader_);
+          cursor.skip(http2::kFrameHeaderSize);
+        } else {
+          connError = parseFrameHeader(cursor, curHeader_);
+        }
         parsed += http2::kFrameHeaderSize;
+        if (curHeader_.type != http2::FrameType::HEADERS) {
+          // Batched requests go before any other frame's callbacks
+          flushIngressHeadersBatch();
+        }
         if (frameState_ == FrameState::DOWNSTREAM_CONNECTION_PREFACE &&
             curHeader_.type != http2::FrameType::SETTINGS) {
           goawayErrorMessage_ = folly::to<string>(
@@ -150,6 +166,7 @@ size_t HTTP2Codec::onIngress(const folly::IOBuf& buf) {
       }
     }
   }
+  flushIngressHeadersBatch();
   checkConnectionError(connError, &buf);
   return parsed;
 }
@@ -447,6 +464,11 @@ ErrorCode HTTP2Codec::parseHeadersImpl(
     bool allHeaderFramesReceived =
         (curHeader_.flags & http2::END_HEADERS) &&
         (headerBlockFrameType_ == http2::FrameType::HEADERS);
+    if (allHeaderFramesReceived && !trailers &&
+        maybeBatchIngressHeaders(msg)) {
+      return ErrorCode::NO_ERROR;
+    }
+    flushIngressHeadersBatch();
     if (allHeaderFramesReceived && !trailers) {
       // Only deliver onMessageBegin once per stream.
       // For responses with CONTINUATION, this will be delayed until
@@ -498,6 +520,38 @@ ErrorCode HTTP2Codec::parseHeadersImpl(
   return ErrorCode::NO_ERROR;
 }
 
+bool HTTP2Codec::maybeBatchIngressHeaders(std::unique_ptr<HTTPMessage>& msg) {
+  // Requests in one HEADERS frame are complete as soon as it is parsed, and
+  // are the bulk of a burst.  Suppressed streams and websocket upgrades,
+  // which need extra callbacks, take the regular path.
+  if (!batchIngressHeaders_ ||
+      transportDirection_ != TransportDirection::DOWNSTREAM ||
+      curHeader_.type != http2::FrameType::HEADERS ||
+      !(curHeader_.flags & http2::END_HEADERS) || !msg ||
+      ingressWebsocketUpgrade_ ||
+      !isStreamIngressEgressAllowed(curHeader_.stream)) {
+    return false;
+  }
+  bool eom = curHeader_.flags & http2::END_STREAM;
+  if (!eom) {
+    // If it there are DATA frames coming, consider it chunked
+    msg->setIsChunked(true);
+  }
+  ingressHeadersBatch_.push_back({curHeader_.stream, std::move(msg), eom});
+  return true;
+}
+
+void HTTP2Codec::flushIngressHeadersBatch() {
+  if (ingressHeadersBatch_.empty()) {
+    return;
+  }
+  VLOG(4) << "delivering batch of " << ingressHeadersBatch_.size()
+          << " requests";
+  DCHECK(callback_);
+  callback_->onHeadersBatch(ingressHeadersBatch_);
+  ingressHeadersBatch_.clear();
+}
+
 folly::Optional<ErrorCode> HTTP2Codec::parseHeadersDecodeFrames(
     const folly::Optional<http2::PriorityUpdate>& priority,
     const folly::Optional<uint32_t>& promisedStream,
@@ -571,6 +625,7 @@ folly::Optional<ErrorCode> HTTP2Codec::parseHeadersDecodeFrames(
                                              " error: ",
                                              decodeInfo_.parsingError));
     err.setHttpStatusCode(400);
+    flushIngressHeadersBatch();
     callback_->onError(curHeader_.stream, err, true);
     return ErrorCode::NO_ERROR;
   }
@@ -587,8 +642,9 @@ folly::Optional<ErrorCode> HTTP2Codec::parseHeadersCheckConcurrentStreams(
       // callback_->onPriority(priority.get());
     }
 
-    // callback checks total number of streams is smaller than settings max
-    if (callback_->numIncomingStreams() >=
+    // callback checks total number of streams is smaller than settings max,
+    // counting the batched ones it hasn't seen yet
+    if (callback_->numIncomingStreams() + ingressHeadersBatch_.size() >=
         egressSettings_.getSetting(SettingsId::MAX_CONCURRENT_STREAMS,
                                    std::numeric_limits<int32_t>::max())) {
       streamError(folly::to<string>("Exceeded max_concurrent_streams"),
@@ -601,9 +657,17 @@ folly::Optional<ErrorCode> HTTP2Codec::parseHeadersCheckConcurrentStreams(
 
 void HTTP2Codec::onHeader(const folly::fbstring& name,
                           const folly::fbstring& value) {
-  if (decodeInfo_.onHeader(name, value)) {
-    if (name == "user-agent" && userAgent_.empty()) {
-      userAgent_ = value.toStdString();
+  // The decoder calls onHeaderView, this is only for other callers
+  HPACKHeaderName headerName(name);
+  onHeaderView(headerName.getHeaderCode(), headerName.get(), value);
+}
+
+void HTTP2Codec::onHeaderView(HTTPHeaderCode code,
+                              folly::StringPiece name,
+                              folly::StringPiece value) {
+  if (decodeInfo_.onHeader(code, name, value)) {
+    if (code == HTTP_HEADER_USER_AGENT && userAgent_.empty()) {
+      userAgent_ = value.str();
     }
   } else {
     VLOG(4) << "dir=" << uint32_t(transportDirection_) <<
@@ -803,18 +867,66 @@ ErrorCode HTTP2Codec::handleSettings(const std::deque<SettingPair>& settings) {
         break;
       case SettingsId::SETTINGS_HTTP_CERT_AUTH:
         break;
+      case SettingsId::HPACK_TEMPLATE:
+        if (receivedSettings_) {
+          // Only the first SETTINGS frame counts; the template can't be
+          // loaded once header blocks may have been coded without it
+          continue;
+        }
+        break;
       default:
         continue; // ignore unknown setting
     }
     ingressSettings_.setSetting(setting.first, setting.second);
     settingsList.push_back(*ingressSettings_.getSetting(setting.first));
   }
+  if (!receivedSettings_) {
+    receivedSettings_ = true;
+    maybeLoadHPACKTemplate();
+  }
   if (callback_) {
     callback_->onSettings(settingsList);
   }
   return ErrorCode::NO_ERROR;
 }
 
+void HTTP2Codec::setHPACKTemplate(
+    std::shared_ptr<const HPACKTemplate> hpackTemplate) {
+  if (sentSettings_ || receivedSettings_) {
+    // Too late to agree on one, e.g. after an h2c upgrade, where the client's
+    // settings came in its HTTP2-Settings header
+    VLOG(4) << "ignoring HPACK template set after SETTINGS";
+    return;
+  }
+  hpackTemplate_ = std::move(hpackTemplate);
+  if (hpackTemplate_) {
+    egressSettings_.setSetting(SettingsId::HPACK_TEMPLATE,
+                               hpackTemplate_->getId());
+  } else {
+    egressSettings_.unsetSetting(SettingsId::HPACK_TEMPLATE);
+  }
+}
+
+void HTTP2Codec::maybeLoadHPACKTemplate() {
+  if (!hpackTemplate_ ||
+      ingressSettings_.getSetting(SettingsId::HPACK_TEMPLATE, 0) !=
+      hpackTemplate_->getId()) {
+    return;
+  }
+  VLOG(4) << getTransportDirectionString(getTransportDirection())
+          << " loading HPACK template id=" << hpackTemplate_->getId();
+  // The server has applied the client's HEADER_TABLE_SIZE above, so its
+  // encoder keeps the newest headers that fit.  The client's decoder starts
+  // at the initial table size, which always fits the whole template, and
+  // drops the same oldest headers when it decodes the server's table size
+  // update.
+  if (transportDirection_ == TransportDirection::DOWNSTREAM) {
+    headerCodec_.loadEncoderTemplate(*hpackTemplate_);
+  } else {
+    headerCodec_.loadDecoderTemplate(*hpackTemplate_);
+  }
+}
+
 ErrorCode HTTP2Codec::parsePushPromise(Cursor& cursor) {
   // stream id must be idle - protocol error
   // assoc-stream-id=closed/unknown - protocol error, unless rst_stream sent
@@ -1139,9 +1251,7 @@ void HTTP2Codec::generateHeaderImpl(
            exAttributes);
   }
 
-  std::vector<std::string> temps;
-  auto allHeaders = CodecUtil::prepareMessageForCompression(msg, temps);
-  auto out = encodeHeaders(msg.getHeaders(), allHeaders, size);
+  auto out = encodeHeaders(msg.getHeaders(), &msg, size);
   IOBufQueue queue(IOBufQueue::cacheChainLength());
   queue.append(std::move(out));
   auto maxFrameSize = maxSendFrameSize();
@@ -1218,11 +1328,12 @@ void HTTP2Codec::generateContinuation(folly::IOBufQueue& writeBuf,
 
 std::unique_ptr<folly::IOBuf> HTTP2Codec::encodeHeaders(
     const HTTPHeaders& headers,
-    std::vector<compress::Header>& allHeaders,
+    const HTTPMessage* msg,
     HTTPHeaderSize* size) {
   headerCodec_.setEncodeHeadroom(http2::kFrameHeaderSize +
                                  http2::kFrameHeadersBaseMaxSize);
-  auto out = headerCodec_.encode(allHeaders);
+  auto out = msg ? headerCodec_.encodeHTTPMessage(*msg)
+                 : headerCodec_.encodeTrailers(headers);
   if (size) {
     *size = headerCodec_.getEncodedSize();
   }
@@ -1268,9 +1379,22 @@ size_t HTTP2Codec::generateBody(folly::IOBufQueue& writeBuf,
             << ingressGoawayAck_;
     return 0;
   }
+  size_t maxFrameSize = maxSendFrameSize();
+  if (!chain || chain->computeChainDataLength() <= maxFrameSize) {
+    // Common case: the body fits in a single frame, so hand the chain
+    // straight to the framer which can write the header into its headroom
+    return generateHeaderCallbackWrapper(
+                      stream,
+                      http2::FrameType::DATA,
+                      http2::writeData(writeBuf,
+                                       std::move(chain),
+                                       stream,
+                                       padding,
+                                       eom,
+                                       reuseIOBufHeadroomForData_));
+  }
   IOBufQueue queue(IOBufQueue::cacheChainLength());
   queue.append(std::move(chain));
-  size_t maxFrameSize = maxSendFrameSize();
   while (queue.chainLength() > maxFrameSize) {
     auto chunk = queue.split(maxFrameSize);
     written += generateHeaderCallbackWrapper(
@@ -1312,11 +1436,8 @@ size_t HTTP2Codec::generateTrailers(folly::IOBufQueue& writeBuf,
                                     StreamID stream,
                                     const HTTPHeaders& trailers) {
   VLOG(4) << "generating TRAILERS for stream=" << stream;
-  std::vector<compress::Header> allHeaders;
-  CodecUtil::appendHeaders(trailers, allHeaders, HTTP_HEADER_NONE);
-
   HTTPHeaderSize size;
-  auto out = encodeHeaders(trailers, allHeaders, &size);
+  auto out = encodeHeaders(trailers, nullptr, &size);
 
   IOBufQueue queue(IOBufQueue::cacheChainLength());
   queue.append(std::move(out));
@@ -1457,6 +1578,7 @@ size_t HTTP2Codec::generatePingReply(folly::IOBufQueue& writeBuf,
 
 size_t HTTP2Codec::generateSettings(folly::IOBufQueue& writeBuf) {
   std::deque<SettingPair> settings;
+  sentSettings_ = true;
   for (auto& setting: egressSettings_.getAllSettings()) {
     switch (setting.id) {
       case SettingsId::HEADER_TABLE_SIZE:
@@ -1498,6 +1620,7 @@ size_t HTTP2Codec::generateSettings(folly::IOBufQueue& writeBuf) {
         break;
       case SettingsId::THRIFT_CHANNEL_ID:
       case SettingsId::THRIFT_CHANNEL_ID_DEPRECATED:
+      case SettingsId::HPACK_TEMPLATE:
         break;
       default:
         LOG(ERROR) << "ignore unknown settingsId="
@@ -1632,6 +1755,7 @@ void HTTP2Codec::streamError(const std::string& msg, ErrorCode code,
                       msg);
   error.setCodecStatusCode(code);
   if (callback_) {
+    flushIngressHeadersBatch();
     callback_->onError(curHeader_.stream, error, newTxn);
   }
 }
@@ -30,6 +30,9 @@ class HTTP2Codec: public HTTPParallelCodec, HPACK::StreamingCallback {
 public:
   void onHeader(const folly::fbstring& name,
                 const folly::fbstring& value) override;
+  void onHeaderView(HTTPHeaderCode code,
+                    folly::StringPiece name,
+                    folly::StringPiece value) override;
   void onHeadersComplete(HTTPHeaderSize decodedSize, bool acknowledge) override;
   void onDecodeError(HPACK::DecodeError decodeError) override;
 
@@ -175,6 +178,25 @@ public:
     return headerCodec_.getHeaderIndexingStrategy();
   }
 
+  /**
+   * Advertises hpackTemplate's id in the HPACK_TEMPLATE setting.  If the
+   * peer's first SETTINGS frame has the same id, the server's encoder and
+   * the client's decoder preload the template, so responses are compressed
+   * against it from the first one.  Requests are not, since the client may
+   * send them before it sees the server's SETTINGS.  Ignored once SETTINGS
+   * have been sent or received.
+   */
+  void setHPACKTemplate(std::shared_ptr<const HPACKTemplate> hpackTemplate);
+
+  /**
+   * Deliver consecutive new requests parsed from one onIngress call with a
+   * single onHeadersBatch callback, rather than three callbacks per request.
+   * Only requests in a single HEADERS frame are batched.  Off by default.
+   */
+  void setIngressHeadersBatching(bool enabled) {
+    batchIngressHeaders_ = enabled;
+  }
+
  private:
   void generateHeaderImpl(folly::IOBufQueue& writeBuf,
                           StreamID stream,
@@ -183,9 +205,10 @@ public:
                           const folly::Optional<ExAttributes>& exAttributes,
                           bool eom,
                           HTTPHeaderSize* size);
+  // Encodes msg, or headers as trailers if msg is nullptr
   std::unique_ptr<folly::IOBuf> encodeHeaders(
       const HTTPHeaders& headers,
-      std::vector<compress::Header>& allHeaders,
+      const HTTPMessage* msg,
       HTTPHeaderSize* size);
 
   size_t generateHeaderCallbackWrapper(StreamID stream, http2::FrameType type, size_t length);
@@ -227,6 +250,9 @@ public:
   bool checkConnectionError(ErrorCode, const folly::IOBuf* buf);
   ErrorCode handleSettings(const std::deque<SettingPair>& settings);
   void handleSettingsAck();
+  void maybeLoadHPACKTemplate();
+  bool maybeBatchIngressHeaders(std::unique_ptr<HTTPMessage>& msg);
+  void flushIngressHeadersBatch();
   size_t maxSendFrameSize() const {
     return (uint32_t)ingressSettings_.getSetting(SettingsId::MAX_FRAME_SIZE,
                                        http2::kMaxFramePayloadLengthMin);
@@ -283,7 +309,13 @@ public:
   HeaderDecodeInfo decodeInfo_;
   std::vector<StreamID> virtualPriorityNodes_;
   folly::Optional<uint32_t> pendingTableMaxSize_;
+  std::shared_ptr<const HPACKTemplate> hpackTemplate_;
+  bool sentSettings_{false};
+  bool receivedSettings_{false};
   bool reuseIOBufHeadroomForData_{true};
+  bool batchIngressHeaders_{false};
+  // Requests parsed but not yet delivered, kept to reuse its capacity
+  std::vector<IngressHeaders> ingressHeadersBatch_;
 
   // True if last parsed HEADERS frame was trailers.
   // Reset only when HEADERS frame is parsed, thus
@@ -9,6 +9,7 @@
  */
 #include <proxygen/lib/http/codec/HTTP2Framer.h>
 
+#include <folly/lang/Bits.h>
 #include <folly/tracing/ScopedTraceSection.h>
 
 using namespace folly::io;
@@ -268,6 +269,18 @@ bool frameAffectsCompression(FrameType t) {
     return ErrorCode::NO_ERROR;
   }
 
+  ErrorCode parseFrameHeader(const uint8_t* data,
+                             FrameHeader& header) noexcept {
+    // MUST ignore the 2 bits before the length
+    uint32_t lengthAndType = Endian::big(loadUnaligned<uint32_t>(data));
+    header.length = kLengthMask & (lengthAndType >> 8);
+    header.type = FrameType(lengthAndType & 0xff);
+    header.flags = data[4];
+    // MUST ignore the 1 bit before the stream-id
+    header.stream = kUint31Mask & Endian::big(loadUnaligned<uint32_t>(data + 5));
+    return ErrorCode::NO_ERROR;
+  }
+
   ErrorCode parseData(Cursor & cursor,
                       const FrameHeader& header,
                       std::unique_ptr<IOBuf>& outBuf,
@@ -621,7 +634,6 @@ writeData(IOBufQueue& queue,
   }
   const uint64_t dataLen = data ? data->computeChainDataLength() : 0;
   // Caller must not exceed peer setting for MAX_FRAME_SIZE
-  // TODO: look into using headroom from data to hold the frame header
   const auto frameLen = writeFrameHeader(queue,
                                          dataLen,
                                          FrameType::DATA,
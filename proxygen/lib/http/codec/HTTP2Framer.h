@@ -121,6 +121,19 @@ ErrorCode
 parseFrameHeader(folly::io::Cursor& cursor,
                  FrameHeader& header) noexcept;
 
+/**
+ * Same as above, but parses the kFrameHeaderSize bytes starting at data
+ * directly, without any Cursor bookkeeping. The caller must ensure that many
+ * contiguous bytes are available.
+ *
+ * @param data   Pointer to the first byte of the common frame header.
+ * @param header The frame header struct to populate.
+ * @return Nothing if success. The connection error code if failure.
+ */
+ErrorCode
+parseFrameHeader(const uint8_t* data,
+                 FrameHeader& header) noexcept;
+
 /**
  * This function parses the section of the DATA frame after the common
  * frame header. It discards any padding and returns the body data in
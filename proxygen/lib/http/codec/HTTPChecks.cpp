@@ -13,12 +13,20 @@
 
 namespace proxygen {
 
+namespace {
+
+bool isBodyForbidden(const HTTPMessage& msg) {
+  return msg.isRequest() && (RFC2616::isRequestBodyAllowed(msg.getMethod())
+                             == RFC2616::BodyAllowed::NOT_ALLOWED) &&
+    RFC2616::bodyImplied(msg.getHeaders());
+}
+
+}
+
 void HTTPChecks::onHeadersComplete(StreamID stream,
                                    std::unique_ptr<HTTPMessage> msg) {
 
-  if (msg->isRequest() && (RFC2616::isRequestBodyAllowed(msg->getMethod())
-                           == RFC2616::BodyAllowed::NOT_ALLOWED) &&
-      RFC2616::bodyImplied(msg->getHeaders())) {
+  if (isBodyForbidden(*msg)) {
     HTTPException ex(
       HTTPException::Direction::INGRESS, "RFC2616: Request Body Not Allowed");
     ex.setProxygenError(kErrorParseHeader);
@@ -32,6 +40,17 @@ void HTTPChecks::onHeadersComplete(StreamID stream,
   callback_->onHeadersComplete(stream, std::move(msg));
 }
 
+void HTTPChecks::onHeadersBatch(std::vector<IngressHeaders>& batch) {
+  for (const auto& headers : batch) {
+    if (isBodyForbidden(*headers.msg)) {
+      // Fail just that message, one at a time
+      HTTPCodec::Callback::onHeadersBatch(batch);
+      return;
+    }
+  }
+  callback_->onHeadersBatch(batch);
+}
+
 void HTTPChecks::generateHeader(folly::IOBufQueue& writeBuf,
                                 StreamID stream,
                                 const HTTPMessage& msg,
@@ -26,6 +26,8 @@ class HTTPChecks: public PassThroughHTTPCodecFilter {
   void onHeadersComplete(StreamID stream,
                          std::unique_ptr<HTTPMessage> msg) override;
 
+  void onHeadersBatch(std::vector<IngressHeaders>& batch) override;
+
   // HTTPCodec methods
 
   void generateHeader(folly::IOBufQueue& writeBuf,
@@ -65,6 +65,17 @@ class HTTPCodec {
 
   static const folly::Optional<ExAttributes> NoExAttributes;
 
+  /**
+   * A message whose headers were parsed as part of a batch, see
+   * Callback::onHeadersBatch
+   */
+  struct IngressHeaders {
+    StreamID stream;
+    std::unique_ptr<HTTPMessage> msg;
+    // The message has no body, so it is also complete
+    bool eom;
+  };
+
   class PriorityQueue {
    public:
     virtual ~PriorityQueue() {}
@@ -118,6 +129,29 @@ class HTTPCodec {
     virtual void onHeadersComplete(StreamID stream,
                                    std::unique_ptr<HTTPMessage> msg) = 0;
 
+    /**
+     * Called with consecutive new messages from one onIngress call, by codecs
+     * that batch them (see HTTP2Codec::setIngressHeadersBatching), instead
+     * of onMessageBegin, onHeadersComplete and, for those with eom set,
+     * onMessageComplete for each one.  The batch is delivered before any
+     * other callback for its streams.  The messages may be moved from, and
+     * the vector is reused by the codec afterwards.
+     *
+     * The default delivers each message's callbacks in order.  Codec
+     * filters do too, unless they forward the batch whole (HTTPChecks,
+     * FlowControlFilter).
+     * @param batch   The messages, in the order they were parsed
+     */
+    virtual void onHeadersBatch(std::vector<IngressHeaders>& batch) {
+      for (auto& headers : batch) {
+        onMessageBegin(headers.stream, headers.msg.get());
+        onHeadersComplete(headers.stream, std::move(headers.msg));
+        if (headers.eom) {
+          onMessageComplete(headers.stream, false);
+        }
+      }
+    }
+
     /**
      * Called for each block of message body data
      * @param stream  The stream ID
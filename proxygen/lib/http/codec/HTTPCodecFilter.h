@@ -46,6 +46,11 @@ class PassThroughHTTPCodecFilter: public HTTPCodecFilter {
   void onHeadersComplete(StreamID stream,
                          std::unique_ptr<HTTPMessage> msg) override;
 
+  // onHeadersBatch is not passed through: by default each message is
+  // replayed through the methods above, so a subclass that overrides any of
+  // them still sees every message.  Subclasses that do not can override it
+  // to forward the batch whole.
+
   void onBody(StreamID stream,
               std::unique_ptr<folly::IOBuf> chain,
               uint16_t padding) override;
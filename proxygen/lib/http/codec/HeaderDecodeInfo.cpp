@@ -13,8 +13,9 @@ using std::string;
 
 namespace proxygen {
 
-bool HeaderDecodeInfo::onHeader(const folly::fbstring& name,
-                                const folly::fbstring& value) {
+bool HeaderDecodeInfo::onHeader(HTTPHeaderCode code,
+                                folly::StringPiece name,
+                                folly::StringPiece value) {
   // Refuse decoding other headers if an error is already found
   if (decodeError != HPACK::DecodeError::NONE
       || parsingError != "") {
@@ -23,71 +24,75 @@ bool HeaderDecodeInfo::onHeader(const folly::fbstring& name,
     return true;
   }
   VLOG(5) << "Processing header=" << name << " value=" << value;
-  folly::StringPiece nameSp(name);
-  folly::StringPiece valueSp(value);
 
-  if (nameSp.startsWith(':')) {
+  if (name.startsWith(':')) {
     pseudoHeaderSeen_ = true;
     if (regularHeaderSeen_) {
-      parsingError = folly::to<string>("Illegal pseudo header name=", nameSp);
+      parsingError = folly::to<string>("Illegal pseudo header name=", name);
       return false;
     }
     if (isRequest_) {
-      if (nameSp == headers::kMethod) {
-        if (!verifier.setMethod(valueSp)) {
+      switch (code) {
+        case HTTP_HEADER_COLON_METHOD:
+          if (!verifier.setMethod(value)) {
+            return false;
+          }
+          break;
+        case HTTP_HEADER_COLON_SCHEME:
+          if (!verifier.setScheme(value)) {
+            return false;
+          }
+          break;
+        case HTTP_HEADER_COLON_AUTHORITY:
+          if (!verifier.setAuthority(value)) {
+            return false;
+          }
+          break;
+        case HTTP_HEADER_COLON_PATH:
+          if (!verifier.setPath(value)) {
+            return false;
+          }
+          break;
+        case HTTP_HEADER_COLON_PROTOCOL:
+          if (!verifier.setUpgradeProtocol(value)) {
+            return false;
+          }
+          break;
+        default:
+          parsingError = folly::to<string>("Invalid req header name=", name);
           return false;
-        }
-      } else if (nameSp == headers::kScheme) {
-        if (!verifier.setScheme(valueSp)) {
-          return false;
-        }
-      } else if (nameSp == headers::kAuthority) {
-        if (!verifier.setAuthority(valueSp)) {
-          return false;
-        }
-      } else if (nameSp == headers::kPath) {
-        if (!verifier.setPath(valueSp)) {
-          return false;
-        }
-      } else if (nameSp == headers::kProtocol) {
-        if (!verifier.setUpgradeProtocol(valueSp)) {
-          return false;
-        }
-      } else {
-        parsingError = folly::to<string>("Invalid req header name=", nameSp);
-        return false;
       }
     } else {
-      if (nameSp == headers::kStatus) {
+      if (code == HTTP_HEADER_COLON_STATUS) {
         if (hasStatus_) {
           parsingError = string("Duplicate status");
           return false;
         }
         hasStatus_ = true;
-        int32_t code = -1;
-        folly::tryTo<int32_t>(valueSp).then(
-            [&code](int32_t num) { code = num; });
-        if (code >= 100 && code <= 999) {
-          msg->setStatusCode(code);
-          msg->setStatusMessage(HTTPMessage::getDefaultReason(code));
+        int32_t statusCode = -1;
+        folly::tryTo<int32_t>(value).then(
+            [&statusCode](int32_t num) { statusCode = num; });
+        if (statusCode >= 100 && statusCode <= 999) {
+          msg->setStatusCode(statusCode);
+          msg->setStatusMessage(HTTPMessage::getDefaultReason(statusCode));
         } else {
-          parsingError = folly::to<string>("Malformed status code=", valueSp);
+          parsingError = folly::to<string>("Malformed status code=", value);
           return false;
         }
       } else {
-        parsingError = folly::to<string>("Invalid resp header name=", nameSp);
+        parsingError = folly::to<string>("Invalid resp header name=", name);
         return false;
       }
     }
   } else {
     regularHeaderSeen_ = true;
-    if (nameSp == "connection") {
+    if (code == HTTP_HEADER_CONNECTION) {
       parsingError = string("HTTP/2 Message with Connection header");
       return false;
     }
-    if (nameSp == "content-length") {
+    if (code == HTTP_HEADER_CONTENT_LENGTH) {
       uint32_t cl = 0;
-      folly::tryTo<uint32_t>(valueSp).then(
+      folly::tryTo<uint32_t>(value).then(
           [&cl](uint32_t num) { cl = num; });
       if (contentLength_ && *contentLength_ != cl) {
         parsingError = string("Multiple content-length headers");
@@ -95,15 +100,17 @@ bool HeaderDecodeInfo::onHeader(const folly::fbstring& name,
       }
       contentLength_ = cl;
     }
-    bool nameOk = CodecUtil::validateHeaderName(nameSp);
-    bool valueOk = CodecUtil::validateHeaderValue(valueSp, CodecUtil::STRICT);
+    // Common header names are valid tokens, only others need checking
+    bool nameOk = (code != HTTP_HEADER_OTHER ||
+                   CodecUtil::validateHeaderName(name));
+    bool valueOk = CodecUtil::validateHeaderValue(value, CodecUtil::STRICT);
     if (!nameOk || !valueOk) {
       parsingError = folly::to<string>("Bad header value: name=",
-                                       nameSp, " value=", valueSp);
+                                       name, " value=", value);
       return false;
     }
     // Add the (name, value) pair to headers
-    msg->getHeaders().add(nameSp, valueSp);
+    msg->getHeaders().add(code, name, value);
   }
   return true;
 }
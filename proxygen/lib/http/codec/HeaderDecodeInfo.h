@@ -27,12 +27,19 @@ class HeaderDecodeInfo {
     contentLength_ = folly::none;
     regularHeaderSeen_ = false;
     pseudoHeaderSeen_ = false;
-    parsingError = "";
+    // Keeps its capacity for the next header block
+    parsingError.clear();
     decodeError = HPACK::DecodeError::NONE;
     verifier.reset(msg.get());
   }
 
-  bool onHeader(const folly::fbstring& name, const folly::fbstring& value);
+  /**
+   * code is the HTTPHeaderCode of name, which decoders already know, so
+   * headers are matched and added without hashing their names again.
+   */
+  bool onHeader(HTTPHeaderCode code,
+                folly::StringPiece name,
+                folly::StringPiece value);
 
   void onHeadersComplete(HTTPHeaderSize decodedSize);
 
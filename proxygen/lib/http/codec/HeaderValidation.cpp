@@ -0,0 +1,176 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/codec/HeaderValidation.h>
+
+#include <proxygen/lib/http/codec/CodecUtil.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+using proxygen::CodecUtil;
+
+inline uint8_t toLower(uint8_t c) {
+  return (c >= 'A' && c <= 'Z') ? (c | 0x20) : c;
+}
+
+// http_tokens maps NUL to itself too, but it is never a token
+inline bool isToken(uint8_t c) {
+  return c >= 0x80 ||
+    (c != 0 && CodecUtil::http_tokens[c] == static_cast<char>(c));
+}
+
+#if defined(__SSE2__)
+const size_t kWidth = sizeof(__m128i);
+
+inline __m128i load(const uint8_t* p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+// 0xff in the lanes of x that are within [lo, hi], compared unsigned
+inline __m128i inRange(__m128i x, uint8_t lo, uint8_t hi) {
+  __m128i shifted = _mm_sub_epi8(x, _mm_set1_epi8(static_cast<char>(lo)));
+  __m128i span = _mm_set1_epi8(static_cast<char>(hi - lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(shifted, span), shifted);
+}
+
+inline __m128i equals(__m128i x, uint8_t c) {
+  return _mm_cmpeq_epi8(x, _mm_set1_epi8(static_cast<char>(c)));
+}
+
+inline __m128i lowercase(__m128i x) {
+  return _mm_or_si128(
+    x, _mm_and_si128(inRange(x, 'A', 'Z'), _mm_set1_epi8(0x20)));
+}
+
+// The lanes of x that isToken accepts, as ranges of http_tokens
+inline __m128i tokenMask(__m128i x) {
+  __m128i ok = inRange(x, ' ', '\'');
+  ok = _mm_or_si128(ok, inRange(x, '*', '+'));
+  // - . / and digits
+  ok = _mm_or_si128(ok, inRange(x, '-', '9'));
+  // ^ _ ` and lowercase letters
+  ok = _mm_or_si128(ok, inRange(x, '^', 'z'));
+  ok = _mm_or_si128(ok, inRange(x, '|', '~'));
+  return _mm_or_si128(ok, inRange(x, 0x80, 0xff));
+}
+
+inline bool all(__m128i mask) {
+  return _mm_movemask_epi8(mask) == 0xffff;
+}
+
+inline bool any(__m128i mask) {
+  return _mm_movemask_epi8(mask) != 0;
+}
+#endif
+
+}
+
+namespace proxygen {
+
+bool HeaderValidation::validateName(folly::ByteRange name) {
+  if (name.empty()) {
+    return false;
+  }
+  const uint8_t* p = name.begin();
+#if defined(__SSE2__)
+  for (; name.end() - p >= ptrdiff_t(kWidth); p += kWidth) {
+    if (!all(tokenMask(load(p)))) {
+      return false;
+    }
+  }
+#endif
+  for (; p < name.end(); ++p) {
+    if (!isToken(*p)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool HeaderValidation::lowercaseAndValidateName(folly::ByteRange name,
+                                                uint8_t* out) {
+  const uint8_t* p = name.begin();
+  bool valid = !name.empty();
+#if defined(__SSE2__)
+  // Keep going after an invalid byte, the caller still wants the name
+  __m128i ok = _mm_set1_epi8(-1);
+  for (; name.end() - p >= ptrdiff_t(kWidth); p += kWidth, out += kWidth) {
+    __m128i lower = lowercase(load(p));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), lower);
+    ok = _mm_and_si128(ok, tokenMask(lower));
+  }
+  valid &= all(ok);
+#endif
+  for (; p < name.end(); ++p, ++out) {
+    *out = toLower(*p);
+    valid &= isToken(*out);
+  }
+  return valid;
+}
+
+bool HeaderValidation::hasUppercase(folly::ByteRange name) {
+  const uint8_t* p = name.begin();
+#if defined(__SSE2__)
+  for (; name.end() - p >= ptrdiff_t(kWidth); p += kWidth) {
+    if (any(inRange(load(p), 'A', 'Z'))) {
+      return true;
+    }
+  }
+#endif
+  for (; p < name.end(); ++p) {
+    if (*p >= 'A' && *p <= 'Z') {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HeaderValidation::hasForbiddenValueChars(folly::ByteRange value) {
+  const uint8_t* p = value.begin();
+#if defined(__SSE2__)
+  for (; value.end() - p >= ptrdiff_t(kWidth); p += kWidth) {
+    __m128i x = load(p);
+    if (any(_mm_or_si128(_mm_or_si128(equals(x, '\0'), equals(x, '\r')),
+                         equals(x, '\n')))) {
+      return true;
+    }
+  }
+#endif
+  for (; p < value.end(); ++p) {
+    if (*p == '\0' || *p == '\r' || *p == '\n') {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HeaderValidation::isPlainValue(folly::ByteRange value) {
+  const uint8_t* p = value.begin();
+#if defined(__SSE2__)
+  for (; value.end() - p >= ptrdiff_t(kWidth); p += kWidth) {
+    __m128i x = load(p);
+    if (any(_mm_or_si128(_mm_or_si128(inRange(x, 0, 0x1f), equals(x, 0x7f)),
+                         equals(x, '\\')))) {
+      return false;
+    }
+  }
+#endif
+  for (; p < value.end(); ++p) {
+    if (*p < 0x20 || *p == 0x7f || *p == '\\') {
+      return false;
+    }
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,53 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+
+namespace proxygen {
+
+/**
+ * Checks of header names and values that every decoded header goes through.
+ * Where SSE2 is available, which includes every x86-64 CPU, they look at 16
+ * bytes at a time, and at one byte at a time otherwise and for the tail.
+ */
+class HeaderValidation {
+ public:
+  /**
+   * Returns true if name is not empty and every byte is a token character
+   * or non-ASCII, as CodecUtil::http_tokens defines them.  Uppercase letters
+   * and NUL are not accepted.
+   */
+  static bool validateName(folly::ByteRange name);
+
+  /**
+   * Writes name to out with ASCII letters lowercased, and returns whether
+   * validateName would accept the result.  out must have room for
+   * name.size() bytes, and may be name itself.
+   */
+  static bool lowercaseAndValidateName(folly::ByteRange name, uint8_t* out);
+
+  static bool hasUppercase(folly::ByteRange name);
+
+  /**
+   * Returns true if value has a NUL, CR or LF.  HTTP/2 and HTTP/3 forbid
+   * them in field values, and in HTTP/1 they would end the header early.
+   */
+  static bool hasForbiddenValueChars(folly::ByteRange value);
+
+  /**
+   * Returns true if value has no control characters, DEL or backslash, in
+   * which case CodecUtil::validateHeaderValue accepts it in any mode without
+   * running its state machine.
+   */
+  static bool isPlainValue(folly::ByteRange value);
+};
+
+}
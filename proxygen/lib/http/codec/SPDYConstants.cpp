@@ -112,6 +112,8 @@ folly::Optional<proxygen::spdy::SettingsId> httpToSpdySettingsId(
     case proxygen::SettingsId::THRIFT_CHANNEL_ID_DEPRECATED:
     case proxygen::SettingsId::THRIFT_CHANNEL_ID:
       return folly::none;
+    case proxygen::SettingsId::HPACK_TEMPLATE:
+      return folly::none;
     case proxygen::SettingsId::_HQ_NUM_PLACEHOLDERS:
     case proxygen::SettingsId::_HQ_QPACK_BLOCKED_STREAMS:
     case proxygen::SettingsId::SETTINGS_HTTP_CERT_AUTH:
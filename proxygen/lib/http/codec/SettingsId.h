@@ -34,6 +34,8 @@ enum class SettingsId : uint64_t {
   // 0xf000 and 0xffff being reserved for Experimental Use
   ENABLE_EX_HEADERS = 0xfbfb,
   THRIFT_CHANNEL_ID = 0xf100,
+  // Id of the HPACKTemplate both peers preload, see HTTP2Codec
+  HPACK_TEMPLATE = 0xf200,
 
   // For secondary authentication in HTTP/2
   SETTINGS_HTTP_CERT_AUTH = 0xff00,
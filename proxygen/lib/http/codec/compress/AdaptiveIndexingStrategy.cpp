@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/codec/compress/AdaptiveIndexingStrategy.h>
+
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/lang/Bits.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace proxygen {
+
+AdaptiveIndexingStrategy::AdaptiveIndexingStrategy(
+  const HeaderIndexingStrategy* base, Config config)
+    : base_(base),
+      config_(config) {
+  CHECK_GT(config_.window, 0);
+  CHECK_LE(config_.window, 256);
+}
+
+bool AdaptiveIndexingStrategy::indexHeader(const HPACKHeaderName& name,
+                                           folly::StringPiece value) const {
+  if (base_ && !base_->indexHeader(name, value)) {
+    return false;
+  }
+
+  auto& stats = getStats(name);
+  uint8_t bit = folly::hash::SpookyHashV2::Hash64(value.data(),
+                                                  value.size(), 0);
+  stats.sketch[bit / 64] |= uint64_t(1) << (bit % 64);
+  if (++stats.observations == config_.window) {
+    // Linear counting: with z of m bits still zero, about -m * ln(z / m)
+    // distinct values were added
+    const double m = 256;
+    uint32_t set = 0;
+    for (auto word : stats.sketch) {
+      set += folly::popcount(word);
+    }
+    double distinct = (set == m) ? stats.observations :
+      -m * std::log((m - set) / m);
+    double repeatRatio = std::max(0.0, 1 - distinct / stats.observations);
+    if (stats.repeatRatio < 0) {
+      stats.repeatRatio = repeatRatio;
+    } else {
+      stats.repeatRatio = config_.decay * repeatRatio +
+        (1 - config_.decay) * stats.repeatRatio;
+    }
+    stats.sketch.fill(0);
+    stats.observations = 0;
+  }
+  return stats.repeatRatio < 0 || stats.repeatRatio >= config_.minRepeatRatio;
+}
+
+double AdaptiveIndexingStrategy::getRepeatRatio(
+  const HPACKHeaderName& name) const {
+  return getStats(name).repeatRatio;
+}
+
+AdaptiveIndexingStrategy::NameStats& AdaptiveIndexingStrategy::getStats(
+  const HPACKHeaderName& name) const {
+  auto code = name.getHeaderCode();
+  if (code != HTTP_HEADER_OTHER) {
+    return stats_[code];
+  }
+  return stats_[HTTPCommonHeaders::num_header_codes +
+                std::hash<std::string>()(name.get()) % kOtherNameBuckets];
+}
+
+}
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <proxygen/lib/http/codec/compress/HeaderIndexingStrategy.h>
+
+#include <array>
+
+namespace proxygen {
+
+/**
+ * Learns which header names have values that repeat often enough to be worth
+ * inserting into the dynamic table.  Names whose values rarely repeat, like
+ * request ids or timestamps, only evict useful entries, so they stop being
+ * indexed.
+ *
+ * Every call to indexHeader is an observation.  For each name, the values of
+ * the last window observations are counted into a 256 bit linear counting
+ * sketch, which estimates how many of them were distinct.  At the end of each
+ * window, the share of repeated values is blended into a running ratio, and
+ * the name is indexed while that ratio is at least minRepeatRatio.  Names are
+ * indexed until their first window completes.  The base strategy's rules
+ * always apply.
+ *
+ * Common headers are tracked by HTTPHeaderCode, and other names share a fixed
+ * number of buckets by hash, so memory use is constant.  Not thread safe: use
+ * one instance per encoder, or per thread.
+ */
+class AdaptiveIndexingStrategy : public HeaderIndexingStrategy {
+ public:
+  struct Config {
+    // Observations of a name between decisions, at most 256
+    uint32_t window{64};
+    // Lowest share of repeated values for which a name is indexed
+    double minRepeatRatio{0.25};
+    // Weight of the newest window in the running ratio
+    double decay{0.5};
+  };
+
+  explicit AdaptiveIndexingStrategy(
+    const HeaderIndexingStrategy* base = getDefaultInstance())
+      : AdaptiveIndexingStrategy(base, Config()) {}
+
+  AdaptiveIndexingStrategy(const HeaderIndexingStrategy* base, Config config);
+
+  using HeaderIndexingStrategy::indexHeader;
+
+  bool indexHeader(const HPACKHeaderName& name,
+                   folly::StringPiece value) const override;
+
+  /**
+   * The running share of repeated values for name, or -1 if its first window
+   * has not completed.
+   */
+  double getRepeatRatio(const HPACKHeaderName& name) const;
+
+ private:
+  static const size_t kOtherNameBuckets = 64;
+
+  struct NameStats {
+    std::array<uint64_t, 4> sketch{};
+    uint32_t observations{0};
+    double repeatRatio{-1};
+  };
+
+  NameStats& getStats(const HPACKHeaderName& name) const;
+
+  const HeaderIndexingStrategy* base_;
+  const Config config_;
+  mutable std::array<NameStats,
+                     HTTPCommonHeaders::num_header_codes + kOtherNameBuckets>
+    stats_;
+};
+
+}
@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <folly/String.h>
 #include <folly/io/Cursor.h>
+#include <proxygen/lib/http/codec/CodecUtil.h>
 #include <proxygen/lib/http/codec/compress/HPACKHeader.h>
 #include <iosfwd>
 
@@ -53,6 +54,38 @@ unique_ptr<IOBuf> HPACKCodec::encode(vector<Header>& headers) noexcept {
   return buf;
 }
 
+unique_ptr<IOBuf> HPACKCodec::encodeHTTPMessage(
+    const HTTPMessage& msg) noexcept {
+  encoder_.startEncode(encodeHeadroom_);
+  encodedSize_.uncompressed = 0;
+  CodecUtil::forEachHeaderForCompression(
+    msg,
+    [this] (HTTPHeaderCode code,
+            const std::string& name,
+            const std::string& value) {
+      encodedSize_.uncompressed += encoder_.encodeHeader(code, name, value);
+    });
+  auto buf = encoder_.completeEncode();
+  recordCompressedSize(buf.get());
+  return buf;
+}
+
+unique_ptr<IOBuf> HPACKCodec::encodeTrailers(
+    const HTTPHeaders& trailers) noexcept {
+  encoder_.startEncode(encodeHeadroom_);
+  encodedSize_.uncompressed = 0;
+  CodecUtil::forEachHeaderForCompression(
+    trailers, HTTP_HEADER_NONE,
+    [this] (HTTPHeaderCode code,
+            const std::string& name,
+            const std::string& value) {
+      encodedSize_.uncompressed += encoder_.encodeHeader(code, name, value);
+    });
+  auto buf = encoder_.completeEncode();
+  recordCompressedSize(buf.get());
+  return buf;
+}
+
 void HPACKCodec::recordCompressedSize(
   const IOBuf* stream) {
   encodedSize_.compressed = 0;
@@ -26,6 +26,7 @@ class Cursor;
 namespace proxygen {
 
 class HPACKHeader;
+class HTTPMessage;
 
 namespace compress {
 std::pair<std::vector<HPACKHeader>, uint32_t> prepareHeaders(
@@ -46,6 +47,20 @@ class HPACKCodec : public HeaderCodec {
   std::unique_ptr<folly::IOBuf> encode(
     std::vector<compress::Header>& headers) noexcept;
 
+  /**
+   * Encodes the headers CodecUtil::prepareMessageForCompression would return
+   * for msg, straight from msg.  Only values inserted into the dynamic table
+   * are copied.
+   */
+  std::unique_ptr<folly::IOBuf> encodeHTTPMessage(
+    const HTTPMessage& msg) noexcept;
+
+  /**
+   * Same for trailers, which have no pseudo headers.
+   */
+  std::unique_ptr<folly::IOBuf> encodeTrailers(
+    const HTTPHeaders& trailers) noexcept;
+
   void decodeStreaming(
       folly::io::Cursor& cursor,
       uint32_t length,
@@ -59,6 +74,18 @@ class HPACKCodec : public HeaderCodec {
     decoder_.setHeaderTableMaxSize(size);
   }
 
+  /**
+   * Warm start: preload the encoder or decoder dynamic table.  The peer must
+   * load the same template into its other side before the next header block.
+   */
+  void loadEncoderTemplate(const HPACKTemplate& hpackTemplate) {
+    encoder_.seedHeaderTable(hpackTemplate);
+  }
+
+  void loadDecoderTemplate(const HPACKTemplate& hpackTemplate) {
+    decoder_.seedHeaderTable(hpackTemplate);
+  }
+
   void describe(std::ostream& os) const;
 
   void setMaxUncompressed(uint64_t maxUncompressed) override {
@@ -58,6 +58,7 @@ const uint8_t Q_INSERT_NAME_REF_STATIC = 0x40;
 const uint8_t Q_LITERAL_STATIC = 0x10;
 
 const uint32_t kDefaultBlocking = 100;
+const uint32_t kDefaultMaxQueuedBytes = 1024 * 1024;
 
 const uint32_t kTableSize = 4096;
 
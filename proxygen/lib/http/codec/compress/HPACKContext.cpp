@@ -16,6 +16,11 @@ HPACKContext::HPACKContext(uint32_t tableSize) :
 }
 
 uint32_t HPACKContext::getIndex(const HPACKHeader& header) const {
+  return getIndex(header.name, header.value);
+}
+
+uint32_t HPACKContext::getIndex(const HPACKHeaderName& name,
+                                folly::StringPiece value) const {
   // First consult the static header table if applicable
   // Applicability is determined by the following guided optimizations:
   // 1) The set of CommonHeaders includes all StaticTable headers and so we can
@@ -25,23 +30,19 @@ uint32_t HPACKContext::getIndex(const HPACKHeader& header) const {
   // of header names.  As getIndex is only meaingful if both name and value
   // match, we know that if our header has a value and is not part of the very
   // small subset of header names, there is no point consulting the StaticTable
-  bool consultStaticTable = false;
-  if (header.value.empty()) {
-    consultStaticTable = header.name.isCommonHeader();
-  } else {
-    consultStaticTable =
-      StaticHeaderTable::isHeaderCodeInTableWithNonEmptyValue(
-        header.name.getHeaderCode());
-  }
-  if (consultStaticTable) {
-    uint32_t staticIndex = getStaticTable().getIndex(header);
-    if (staticIndex) {
-      return staticToGlobalIndex(staticIndex);
+  if (name.isCommonHeader()) {
+    auto headerCode = name.getHeaderCode();
+    if (value.empty() ||
+        StaticHeaderTable::isHeaderCodeInTableWithNonEmptyValue(headerCode)) {
+      uint32_t staticIndex = getStaticTable().getIndex(headerCode, value);
+      if (staticIndex) {
+        return staticToGlobalIndex(staticIndex);
+      }
     }
   }
 
   // Else check the dynamic table
-  uint32_t dynamicIndex = table_.getIndex(header);
+  uint32_t dynamicIndex = table_.getIndex(name, value);
   if (dynamicIndex) {
     return dynamicToGlobalIndex(dynamicIndex);
   } else {
@@ -50,7 +51,11 @@ uint32_t HPACKContext::getIndex(const HPACKHeader& header) const {
 }
 
 uint32_t HPACKContext::nameIndex(const HPACKHeaderName& headerName) const {
-  uint32_t index = getStaticTable().nameIndex(headerName);
+  // The static table only has common headers
+  uint32_t index = 0;
+  if (headerName.isCommonHeader()) {
+    index = getStaticTable().nameIndex(headerName.getHeaderCode());
+  }
   if (index) {
     return staticToGlobalIndex(index);
   }
@@ -79,6 +84,12 @@ void HPACKContext::seedHeaderTable(
   }
 }
 
+void HPACKContext::seedHeaderTable(const HPACKTemplate& hpackTemplate) {
+  for (const auto& header: hpackTemplate.getHeaders()) {
+    table_.add(header.copy());
+  }
+}
+
 void HPACKContext::describe(std::ostream& os) const {
   os << table_;
 }
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
+#include <proxygen/lib/http/codec/compress/HPACKTemplate.h>
 #include <proxygen/lib/http/codec/compress/HeaderTable.h>
 #include <proxygen/lib/http/codec/compress/StaticHeaderTable.h>
 
@@ -28,6 +29,9 @@ class HPACKContext {
    */
   uint32_t getIndex(const HPACKHeader& header) const;
 
+  uint32_t getIndex(const HPACKHeaderName& name,
+                    folly::StringPiece value) const;
+
   /**
    * index of a header entry with the given name from dynamic or static table
    *
@@ -63,6 +67,12 @@ class HPACKContext {
 
   void seedHeaderTable(std::vector<HPACKHeader>& headers);
 
+  /**
+   * Adds copies of the template's headers, oldest first.  Headers that do not
+   * fit the table capacity evict older ones as usual.
+   */
+  void seedHeaderTable(const HPACKTemplate& hpackTemplate);
+
   void describe(std::ostream& os) const;
 
  protected:
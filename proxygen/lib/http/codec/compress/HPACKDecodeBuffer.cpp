@@ -56,6 +56,25 @@ DecodeError HPACKDecodeBuffer::decodeLiteral(folly::fbstring& literal) {
 
 DecodeError HPACKDecodeBuffer::decodeLiteral(uint8_t nbit,
                                              folly::fbstring& literal) {
+  folly::StringPiece view;
+  DecodeError result = decodeLiteral(nbit, literal, view);
+  if (result != DecodeError::NONE) {
+    literal.clear();
+  } else if (view.data() != literal.data()) {
+    literal.assign(view.data(), view.size());
+  }
+  return result;
+}
+
+DecodeError HPACKDecodeBuffer::decodeLiteral(folly::fbstring& scratch,
+                                             folly::StringPiece& literal) {
+  return decodeLiteral(7, scratch, literal);
+}
+
+DecodeError HPACKDecodeBuffer::decodeLiteral(uint8_t nbit,
+                                             folly::fbstring& scratch,
+                                             folly::StringPiece& literal) {
+  scratch.clear();
   literal.clear();
   if (remainingBytes_ == 0) {
     EOB_LOG("remainingBytes_ == 0");
@@ -86,18 +105,23 @@ DecodeError HPACKDecodeBuffer::decodeLiteral(uint8_t nbit,
   if (cursor_.length() >= size) {
     data = cursor_.data();
     cursor_.skip(size);
+  } else if (!huffman) {
+    // pull() will move the cursor
+    scratch.resize(size);
+    cursor_.pull(&scratch[0], size);
+    data = reinterpret_cast<const uint8_t*>(scratch.data());
   } else {
     // temporary buffer to pull the chunks together
     tmpbuf = IOBuf::create(size);
-    // pull() will move the cursor
     cursor_.pull(tmpbuf->writableData(), size);
     data = tmpbuf->data();
   }
   if (huffman) {
     static auto& huffmanTree = huffman::huffTree();
-    huffmanTree.decode(data, size, literal);
+    huffmanTree.decode(data, size, scratch);
+    literal = scratch;
   } else {
-    literal.append((const char *)data, size);
+    literal.reset(reinterpret_cast<const char*>(data), size);
   }
   remainingBytes_ -= size;
   return DecodeError::NONE;
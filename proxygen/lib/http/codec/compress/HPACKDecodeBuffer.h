@@ -86,6 +86,19 @@ class HPACKDecodeBuffer {
 
   HPACK::DecodeError decodeLiteral(uint8_t nbit, folly::fbstring& literal);
 
+  /**
+   * decode a literal without copying it when possible.  literal points into
+   * the buffer being decoded if the literal is not Huffman coded and is
+   * contiguous, and into scratch otherwise, so it is only valid while both
+   * are unchanged.
+   */
+  HPACK::DecodeError decodeLiteral(folly::fbstring& scratch,
+                                   folly::StringPiece& literal);
+
+  HPACK::DecodeError decodeLiteral(uint8_t nbit,
+                                   folly::fbstring& scratch,
+                                   folly::StringPiece& literal);
+
 private:
   void EOB_LOG(std::string msg,
                HPACK::DecodeError code=
@@ -47,7 +47,6 @@ uint32_t HPACKDecoder::decodeLiteralHeader(
     headers_t* emitted) {
   uint8_t byte = dbuf.peek();
   bool indexing = byte & HPACK::LITERAL_INC_INDEX.code;
-  HPACKHeader header;
   uint8_t indexMask = 0x3F;  // 0011 1111
   uint8_t length = HPACK::LITERAL_INC_INDEX.prefixLength;
   if (!indexing) {
@@ -56,6 +55,10 @@ uint32_t HPACKDecoder::decodeLiteralHeader(
     indexMask = 0x0F; // 0000 1111
     length = HPACK::LITERAL.prefixLength;
   }
+  // The name and value are viewed in place, and only copied if indexing
+  const HPACKHeaderName* indexedName = nullptr;
+  HTTPHeaderCode code;
+  folly::StringPiece name;
   if (byte & indexMask) {
     uint64_t index;
     err_ = dbuf.decodeInteger(length, index);
@@ -69,29 +72,40 @@ uint32_t HPACKDecoder::decodeLiteralHeader(
       err_ = HPACK::DecodeError::INVALID_INDEX;
       return 0;
     }
-    header.name = getHeader(index).name;
+    indexedName = &getHeader(index).name;
+    code = indexedName->getHeaderCode();
+    name = indexedName->get();
   } else {
     // skip current byte
     dbuf.next();
-    folly::fbstring headerName;
-    err_ = dbuf.decodeLiteral(headerName);
-    header.name = headerName;
+    err_ = dbuf.decodeLiteral(nameBuf_, name);
     if (err_ != HPACK::DecodeError::NONE) {
       LOG(ERROR) << "Error decoding header name err_=" << err_;
       return 0;
     }
+    code = canonicalizeName(name);
   }
   // value
-  err_ = dbuf.decodeLiteral(header.value);
+  folly::StringPiece value;
+  err_ = dbuf.decodeLiteral(valueBuf_, value);
   if (err_ != HPACK::DecodeError::NONE) {
-    LOG(ERROR) << "Error decoding header value name=" << header.name
+    LOG(ERROR) << "Error decoding header value name=" << name
                << " err_=" << err_;
     return 0;
   }
 
-  uint32_t emittedSize = emit(header, streamingCb, emitted);
+  uint32_t emittedSize = emit(code, name, value, streamingCb, emitted);
 
   if (indexing) {
+    HPACKHeader header;
+    if (indexedName) {
+      header.name = *indexedName;
+    } else if (code != HTTP_HEADER_OTHER) {
+      header.name = HPACKHeaderName(code);
+    } else {
+      header.name = name;
+    }
+    header.value.assign(value.data(), value.size());
     table_.add(std::move(header));
   }
 
@@ -8,6 +8,7 @@
  *
  */
 #include <proxygen/lib/http/codec/compress/HPACKDecoderBase.h>
+#include <proxygen/lib/http/codec/HeaderValidation.h>
 #include <proxygen/lib/http/codec/compress/HeaderTable.h>
 
 namespace proxygen {
@@ -15,13 +16,45 @@ namespace proxygen {
 uint32_t HPACKDecoderBase::emit(const HPACKHeader& header,
                                 HPACK::StreamingCallback* streamingCb,
                                 headers_t* emitted) {
+  return emit(header.name.getHeaderCode(), header.name.get(), header.value,
+              streamingCb, emitted);
+}
+
+uint32_t HPACKDecoderBase::emit(HTTPHeaderCode code,
+                                folly::StringPiece name,
+                                folly::StringPiece value,
+                                HPACK::StreamingCallback* streamingCb,
+                                headers_t* emitted) {
   if (streamingCb) {
-    streamingCb->onHeader(header.name.get(), header.value);
+    streamingCb->onHeaderView(code, name, value);
   } else if (emitted) {
     // copying HPACKHeader
-    emitted->emplace_back(header.name.get(), header.value);
+    if (code != HTTP_HEADER_NONE && code != HTTP_HEADER_OTHER) {
+      emitted->emplace_back(HPACKHeaderName(code),
+                            folly::fbstring(value.data(), value.size()));
+    } else {
+      emitted->emplace_back(name, value);
+    }
+  }
+  return folly::to<uint32_t>(name.size() + value.size());
+}
+
+HTTPHeaderCode HPACKDecoderBase::canonicalizeName(folly::StringPiece& name) {
+  HTTPHeaderCode code = HTTPCommonHeaders::hash(name.data(), name.size());
+  if (code != HTTP_HEADER_NONE && code != HTTP_HEADER_OTHER) {
+    name = *HTTPCommonHeaders::getPointerToHeaderName(code, TABLE_LOWERCASE);
+    return code;
+  }
+  if (HeaderValidation::hasUppercase(folly::ByteRange(name))) {
+    if (name.data() != nameBuf_.data()) {
+      nameBuf_.assign(name.data(), name.size());
+      name = nameBuf_;
+    }
+    // In place
+    HeaderValidation::lowercaseAndValidateName(
+      folly::ByteRange(name), reinterpret_cast<uint8_t*>(&nameBuf_[0]));
   }
-  return header.realBytes();
+  return HTTP_HEADER_OTHER;
 }
 
 void HPACKDecoderBase::completeDecode(
@@ -50,6 +50,19 @@ class HPACKDecoderBase {
                 HPACK::StreamingCallback* streamingCb,
                 headers_t* emitted);
 
+  uint32_t emit(HTTPHeaderCode code,
+                folly::StringPiece name,
+                folly::StringPiece value,
+                HPACK::StreamingCallback* streamingCb,
+                headers_t* emitted);
+
+  /**
+   * Returns the HTTPHeaderCode of a literal header name, and points name at
+   * its lowercase form, as HPACKHeaderName would store it: the common header
+   * table entry, name itself if it is already lowercase, or nameBuf_.
+   */
+  HTTPHeaderCode canonicalizeName(folly::StringPiece& name);
+
   void completeDecode(
       HeaderCodec::Type type,
       HPACK::StreamingCallback* streamingCb,
@@ -67,6 +80,10 @@ class HPACKDecoderBase {
   HPACK::DecodeError err_{HPACK::DecodeError::NONE};
   uint32_t maxTableSize_;
   uint64_t maxUncompressed_;
+  // Scratch space for literals that can't be viewed in place, reused by
+  // every header
+  folly::fbstring nameBuf_;
+  folly::fbstring valueBuf_;
 };
 
 }
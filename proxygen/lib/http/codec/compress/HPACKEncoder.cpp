@@ -15,18 +15,38 @@ namespace proxygen {
 
 std::unique_ptr<folly::IOBuf>
 HPACKEncoder::encode(const vector<HPACKHeader>& headers, uint32_t headroom) {
+  startEncode(headroom);
+  for (const auto& header : headers) {
+    encodeHeader(header.name, header.value);
+  }
+  return completeEncode();
+}
+
+void HPACKEncoder::startEncode(uint32_t headroom) {
   if (headroom) {
     streamBuffer_.addHeadroom(headroom);
   }
   handlePendingContextUpdate(streamBuffer_, table_.capacity());
-  for (const auto& header : headers) {
-    encodeHeader(header);
-  }
+}
+
+uint32_t HPACKEncoder::encodeHeader(HTTPHeaderCode code,
+                                    const std::string& name,
+                                    folly::StringPiece value) {
+  // Only names that are not common need hashing and lowercasing
+  auto headerName = (code == HTTP_HEADER_OTHER) ? HPACKHeaderName(name)
+                                                : HPACKHeaderName(code);
+  encodeHeader(headerName, value);
+  return headerName.size() + value.size() + 2;
+}
+
+std::unique_ptr<folly::IOBuf> HPACKEncoder::completeEncode() {
   return streamBuffer_.release();
 }
 
-bool HPACKEncoder::encodeAsLiteral(const HPACKHeader& header, bool indexing) {
-  if (header.bytes() > table_.capacity()) {
+bool HPACKEncoder::encodeAsLiteral(const HPACKHeaderName& name,
+                                   folly::StringPiece value,
+                                   bool indexing) {
+  if (HPACKHeader::bytes(name, value) > table_.capacity()) {
     // May want to investigate further whether or not this is wanted.
     // Flushing the table on a large header frees up some memory,
     // however, there will be no compression due to an empty table, and
@@ -37,15 +57,16 @@ bool HPACKEncoder::encodeAsLiteral(const HPACKHeader& header, bool indexing) {
   HPACK::Instruction instruction = (indexing) ?
     HPACK::LITERAL_INC_INDEX : HPACK::LITERAL;
 
-  encodeLiteral(header, nameIndex(header.name), instruction);
+  encodeLiteral(name, value, nameIndex(name), instruction);
   // indexed ones need to get added to the header table
   if (indexing) {
-    CHECK(table_.add(header.copy()));
+    CHECK(table_.add(HPACKHeader(name, value.fbstr())));
   }
   return true;
 }
 
-void HPACKEncoder::encodeLiteral(const HPACKHeader& header,
+void HPACKEncoder::encodeLiteral(const HPACKHeaderName& name,
+                                 folly::StringPiece value,
                                  uint32_t nameIndex,
                                  const HPACK::Instruction& instruction) {
   // name
@@ -54,10 +75,10 @@ void HPACKEncoder::encodeLiteral(const HPACKHeader& header,
     streamBuffer_.encodeInteger(nameIndex, instruction);
   } else {
     streamBuffer_.encodeInteger(0, instruction);
-    streamBuffer_.encodeLiteral(header.name.get());
+    streamBuffer_.encodeLiteral(name.get());
   }
   // value
-  streamBuffer_.encodeLiteral(header.value);
+  streamBuffer_.encodeLiteral(value);
 }
 
 void HPACKEncoder::encodeAsIndex(uint32_t index) {
@@ -65,10 +86,11 @@ void HPACKEncoder::encodeAsIndex(uint32_t index) {
   streamBuffer_.encodeInteger(index, HPACK::INDEX_REF);
 }
 
-void HPACKEncoder::encodeHeader(const HPACKHeader& header) {
+void HPACKEncoder::encodeHeader(const HPACKHeaderName& name,
+                                folly::StringPiece value) {
   // First determine whether the header is defined as indexable using the
   // set strategy if applicable, else assume it is indexable
-  bool indexable = !indexingStrat_ || indexingStrat_->indexHeader(header);
+  bool indexable = !indexingStrat_ || indexingStrat_->indexHeader(name, value);
 
   // If the header was not defined as indexable, its a reasonable assumption
   // that it does not appear in either the static or dynamic table and should
@@ -78,14 +100,14 @@ void HPACKEncoder::encodeHeader(const HPACKHeader& header) {
   // as an override so we assume this is desired if such a case occurs
   uint32_t index = 0;
   if (indexable) {
-    index = getIndex(header);
+    index = getIndex(name, value);
   }
 
   // Finally encode the header as determined above
   if (index) {
     encodeAsIndex(index);
   } else {
-    encodeAsLiteral(header, indexable);
+    encodeAsLiteral(name, value, indexable);
   }
 }
 
@@ -32,6 +32,25 @@ class HPACKEncoder : public HPACKEncoderBase, public HPACKContext {
     const std::vector<HPACKHeader>& headers,
     uint32_t headroom = 0);
 
+  /**
+   * Encode a header block one header at a time, straight from where the
+   * caller stores them: startEncode(), encodeHeader() for each header, then
+   * completeEncode().  Values are only copied when they are added to the
+   * table.
+   */
+  void startEncode(uint32_t headroom = 0);
+
+  /**
+   * name is only used if code is HTTP_HEADER_OTHER.
+   *
+   * @return the uncompressed size of the header
+   */
+  uint32_t encodeHeader(HTTPHeaderCode code,
+                        const std::string& name,
+                        folly::StringPiece value);
+
+  std::unique_ptr<folly::IOBuf> completeEncode();
+
   void setHeaderTableSize(uint32_t size) {
     HPACKEncoderBase::setHeaderTableSize(table_, size);
   }
@@ -39,11 +58,14 @@ class HPACKEncoder : public HPACKEncoderBase, public HPACKContext {
  private:
   void encodeAsIndex(uint32_t index);
 
-  void encodeHeader(const HPACKHeader& header);
+  void encodeHeader(const HPACKHeaderName& name, folly::StringPiece value);
 
-  bool encodeAsLiteral(const HPACKHeader& header, bool indexing);
+  bool encodeAsLiteral(const HPACKHeaderName& name,
+                       folly::StringPiece value,
+                       bool indexing);
 
-  void encodeLiteral(const HPACKHeader& header,
+  void encodeLiteral(const HPACKHeaderName& name,
+                     folly::StringPiece value,
                      uint32_t nameIndex,
                      const HPACK::Instruction& instruction);
 };
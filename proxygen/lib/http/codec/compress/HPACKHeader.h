@@ -28,6 +28,10 @@ class HPACKHeader {
               const folly::fbstring& value_):
       name(name_), value(value_) {}
 
+  HPACKHeader(const HPACKHeaderName& name_,
+              folly::fbstring&& value_):
+      name(name_), value(std::move(value_)) {}
+
   HPACKHeader(folly::StringPiece name_,
               folly::StringPiece value_):
       name(name_), value(value_.data(), value_.size()) {}
@@ -59,6 +63,13 @@ class HPACKHeader {
     return kMinLength + realBytes();
   }
 
+  /**
+   * size in bytes the given header would have as an entry
+   */
+  static uint32_t bytes(const HPACKHeaderName& name, folly::StringPiece value) {
+    return kMinLength + name.size() + folly::to<uint32_t>(value.size());
+  }
+
   bool operator==(const HPACKHeader& other) const {
     return name == other.name && value == other.value;
   }
@@ -16,7 +16,9 @@
 #include <iostream>
 #include <boost/variant.hpp>
 #include <proxygen/lib/http/HTTPCommonHeaders.h>
+#include <proxygen/lib/http/codec/HeaderValidation.h>
 #include <folly/Range.h>
+#include <glog/logging.h>
 
 namespace proxygen {
 
@@ -33,6 +35,15 @@ class HPACKHeaderName {
   explicit HPACKHeaderName(folly::StringPiece name) {
     storeAddress(name);
   }
+  /*
+   * For common headers; does not hash or copy the name
+   */
+  explicit HPACKHeaderName(HTTPHeaderCode headerCode) {
+    DCHECK(headerCode != HTTPHeaderCode::HTTP_HEADER_NONE &&
+           headerCode != HTTPHeaderCode::HTTP_HEADER_OTHER);
+    address_ = HTTPCommonHeaders::getPointerToHeaderName(
+      headerCode, TABLE_LOWERCASE);
+  }
   HPACKHeaderName(const HPACKHeaderName& headerName) {
     copyAddress(headerName);
   }
@@ -143,7 +154,8 @@ class HPACKHeaderName {
     if (headerCode == HTTPHeaderCode::HTTP_HEADER_NONE ||
         headerCode == HTTPHeaderCode::HTTP_HEADER_OTHER) {
       std::string* newAddress = new std::string(name.size(), 0);
-      std::transform(name.begin(), name.end(), newAddress->begin(), ::tolower);
+      HeaderValidation::lowercaseAndValidateName(
+        folly::ByteRange(name), reinterpret_cast<uint8_t*>(&(*newAddress)[0]));
       address_ = newAddress;
     } else {
       address_ = HTTPCommonHeaders::getPointerToHeaderName(
@@ -212,6 +224,11 @@ namespace std {
 template<>
 struct hash<proxygen::HPACKHeaderName> {
   size_t operator()(const proxygen::HPACKHeaderName& headerName) const {
+    // Common names are only ever equal to themselves, so their code will do
+    auto headerCode = headerName.getHeaderCode();
+    if (headerCode >= proxygen::HTTPHeaderCodeCommonOffset) {
+      return headerCode;
+    }
     return std::hash<std::string>()(headerName.get());
   }
 };
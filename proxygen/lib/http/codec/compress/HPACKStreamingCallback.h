@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include <folly/Range.h>
+#include <proxygen/lib/http/HTTPCommonHeaders.h>
 #include <proxygen/lib/http/codec/compress/HeaderCodec.h>
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
 
@@ -19,6 +21,20 @@ namespace proxygen { namespace HPACK {
 
     virtual void onHeader(const folly::fbstring& name,
                           const folly::fbstring& value) = 0;
+
+    /**
+     * What decoders call for each header.  name and value may point into the
+     * buffer being decoded, and are only valid during the call.  code is the
+     * HTTPHeaderCode of name, or HTTP_HEADER_OTHER if it is not a common
+     * header, so receivers need not hash the name again.  Names are
+     * lowercase.  The default copies the header and calls onHeader.
+     */
+    virtual void onHeaderView(HTTPHeaderCode /*code*/,
+                              folly::StringPiece name,
+                              folly::StringPiece value) {
+      onHeader(folly::fbstring(name.data(), name.size()),
+               folly::fbstring(value.data(), value.size()));
+    }
     virtual void onHeadersComplete(HTTPHeaderSize decodedSize,
                                    bool acknowledge) = 0;
     virtual void onDecodeError(HPACK::DecodeError decodeError) = 0;
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/codec/compress/HPACKTemplate.h>
+
+#include <folly/hash/Hash.h>
+#include <glog/logging.h>
+#include <proxygen/lib/http/codec/compress/HeaderIndexingStrategy.h>
+#include <proxygen/lib/http/codec/compress/StaticHeaderTable.h>
+
+#include <algorithm>
+
+namespace {
+
+uint32_t hashHeaders(const std::vector<proxygen::HPACKHeader>& headers) {
+  uint32_t hash = folly::hash::FNV_32_HASH_START;
+  for (const auto& header : headers) {
+    // Include the lengths so that moving bytes between name and value changes
+    // the id
+    uint32_t lengths[] = {
+      static_cast<uint32_t>(header.name.size()),
+      static_cast<uint32_t>(header.value.size())
+    };
+    hash = folly::hash::fnv32_buf(lengths, sizeof(lengths), hash);
+    hash = folly::hash::fnv32_buf(header.name.get().data(),
+                                  header.name.size(), hash);
+    hash = folly::hash::fnv32_buf(header.value.data(), header.value.size(),
+                                  hash);
+  }
+  return hash != 0 ? hash : 1;
+}
+
+}
+
+namespace proxygen {
+
+std::shared_ptr<const HPACKTemplate> HPACKTemplate::create(
+    std::vector<HPACKHeader> headers) {
+  uint32_t bytes = 0;
+  for (const auto& header : headers) {
+    bytes += header.bytes();
+  }
+  if (bytes > kMaxBytes) {
+    LOG(ERROR) << "HPACK template of " << bytes << " bytes is larger than "
+               << kMaxBytes;
+    return nullptr;
+  }
+  return std::shared_ptr<const HPACKTemplate>(
+    new HPACKTemplate(std::move(headers), bytes));
+}
+
+HPACKTemplate::HPACKTemplate(std::vector<HPACKHeader> headers, uint32_t bytes)
+    : headers_(std::move(headers)),
+      bytes_(bytes),
+      id_(hashHeaders(headers_)) {
+}
+
+void HPACKTemplateBuilder::add(const std::string& name,
+                               const std::string& value,
+                               uint64_t count) {
+  counts_[std::make_pair(name, value)] += count;
+}
+
+std::shared_ptr<const HPACKTemplate> HPACKTemplateBuilder::build(
+    uint32_t maxBytes) const {
+  struct Candidate {
+    HPACKHeader header;
+    uint64_t score;
+  };
+  const auto& staticTable = StaticHeaderTable::get();
+  const auto indexingStrat = HeaderIndexingStrategy::getDefaultInstance();
+  std::vector<Candidate> candidates;
+  for (const auto& entry : counts_) {
+    HPACKHeader header(entry.first.first, entry.first.second);
+    if (staticTable.getIndex(header) != 0 ||
+        !indexingStrat->indexHeader(header)) {
+      continue;
+    }
+    uint64_t score = entry.second * header.bytes();
+    candidates.push_back({std::move(header), score});
+  }
+  // Stable, so ties keep the deterministic order of counts_ and the same
+  // traffic builds the same template
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [] (const Candidate& a, const Candidate& b) {
+                     return a.score > b.score;
+                   });
+
+  maxBytes = std::min(maxBytes, HPACKTemplate::kMaxBytes);
+  std::vector<HPACKHeader> headers;
+  uint32_t bytes = 0;
+  for (auto& candidate : candidates) {
+    if (bytes + candidate.header.bytes() <= maxBytes) {
+      bytes += candidate.header.bytes();
+      headers.push_back(std::move(candidate.header));
+    }
+  }
+  // The best headers go last, where the table keeps them longest
+  std::reverse(headers.begin(), headers.end());
+  return HPACKTemplate::create(std::move(headers));
+}
+
+}
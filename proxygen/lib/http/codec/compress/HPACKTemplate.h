@@ -0,0 +1,87 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <proxygen/lib/http/codec/compress/HPACKConstants.h>
+#include <proxygen/lib/http/codec/compress/HPACKHeader.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * An immutable set of headers an HPACK encoder and decoder can load into
+ * their dynamic tables before the first header block, so that headers every
+ * connection sends are indexed from the start.  One template is shared by
+ * every connection in the process.
+ *
+ * Headers are stored oldest first, so the last ones are those kept when the
+ * table is smaller than the template.  A template is at most kMaxBytes, the
+ * initial HPACK table size, which lets the decoder load it before it knows
+ * the table size the encoder will use.
+ *
+ * Both peers must load the same template, which HTTP2Codec negotiates with
+ * the HPACK_TEMPLATE setting and getId().
+ */
+class HPACKTemplate {
+ public:
+  static const uint32_t kMaxBytes = HPACK::kTableSize;
+
+  /**
+   * Returns nullptr if headers are larger than kMaxBytes.
+   */
+  static std::shared_ptr<const HPACKTemplate> create(
+    std::vector<HPACKHeader> headers);
+
+  /**
+   * A non-zero hash of the headers, advertised to the peer.
+   */
+  uint32_t getId() const {
+    return id_;
+  }
+
+  const std::vector<HPACKHeader>& getHeaders() const {
+    return headers_;
+  }
+
+  uint32_t bytes() const {
+    return bytes_;
+  }
+
+ private:
+  HPACKTemplate(std::vector<HPACKHeader> headers, uint32_t bytes);
+
+  const std::vector<HPACKHeader> headers_;
+  const uint32_t bytes_;
+  const uint32_t id_;
+};
+
+/**
+ * Builds an HPACKTemplate from headers seen in traffic.  build() picks the
+ * headers that would save the most bytes, count times size, skipping those
+ * the static table already has and those the default indexing strategy
+ * would not index.
+ */
+class HPACKTemplateBuilder {
+ public:
+  void add(const std::string& name, const std::string& value,
+           uint64_t count = 1);
+
+  std::shared_ptr<const HPACKTemplate> build(
+    uint32_t maxBytes = HPACKTemplate::kMaxBytes) const;
+
+ private:
+  std::map<std::pair<std::string, std::string>, uint64_t> counts_;
+};
+
+}
@@ -16,15 +16,16 @@ const HeaderIndexingStrategy* HeaderIndexingStrategy::getDefaultInstance() {
   return instance;
 }
 
-bool HeaderIndexingStrategy::indexHeader(const HPACKHeader& header) const {
+bool HeaderIndexingStrategy::indexHeader(const HPACKHeaderName& name,
+                                         folly::StringPiece value) const {
   // Handle all the cases where we want to return false in the switch statement
   // below; else let the code fall through and return true
-  switch(header.name.getHeaderCode()) {
+  switch(name.getHeaderCode()) {
     case HTTP_HEADER_COLON_PATH:
-      if (header.value.find('=') != std::string::npos) {
+      if (value.find('=') != std::string::npos) {
         return false;
       }
-      if (header.value.find("jpg") != std::string::npos) {
+      if (value.find("jpg") != std::string::npos) {
         return false;
       }
       break;
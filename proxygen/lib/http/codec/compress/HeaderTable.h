@@ -50,6 +50,9 @@ class HeaderTable {
    */
   uint32_t getIndex(const HPACKHeader& header) const;
 
+  uint32_t getIndex(const HPACKHeaderName& name,
+                    folly::StringPiece value) const;
+
   /**
    * Get the table entry at the given external index.
    *
@@ -199,7 +202,7 @@ class HeaderTable {
    * Shared implementation for getIndex and nameIndex
    */
   uint32_t getIndexImpl(const HPACKHeaderName& header,
-                        const folly::fbstring& value,
+                        folly::StringPiece value,
                         bool nameOnly) const;
 };
 
@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <folly/String.h>
 #include <folly/io/Cursor.h>
+#include <proxygen/lib/http/codec/CodecUtil.h>
 #include <proxygen/lib/http/codec/compress/HPACKCodec.h> // for prepareHeaders
 #include <proxygen/lib/http/codec/compress/HPACKHeader.h>
 #include <iosfwd>
@@ -50,11 +51,32 @@ void QPACKCodec::recordCompressedSize(
 QPACKEncoder::EncodeResult QPACKCodec::encode(
     vector<Header>& headers,
     uint64_t streamId,
-    uint32_t maxEncoderStreamBytes) noexcept {
+    uint32_t maxEncoderStreamBytes,
+    bool latencySensitive) noexcept {
   auto prepared = compress::prepareHeaders(headers);
   encodedSize_.uncompressed = prepared.second;
   auto res = encoder_.encode(prepared.first, encodeHeadroom_, streamId,
-                             maxEncoderStreamBytes);
+                             maxEncoderStreamBytes, latencySensitive);
+  recordCompressedSize(res);
+  return res;
+}
+
+QPACKEncoder::EncodeResult QPACKCodec::encodeHTTPMessage(
+    const HTTPMessage& msg,
+    uint64_t streamId,
+    uint32_t maxEncoderStreamBytes,
+    bool latencySensitive) noexcept {
+  encoder_.startEncode(encodeHeadroom_, streamId, maxEncoderStreamBytes,
+                       latencySensitive);
+  encodedSize_.uncompressed = 0;
+  CodecUtil::forEachHeaderForCompression(
+    msg,
+    [this] (HTTPHeaderCode code,
+            const std::string& name,
+            const std::string& value) {
+      encodedSize_.uncompressed += encoder_.encodeHeader(code, name, value);
+    });
+  auto res = encoder_.completeEncode();
   recordCompressedSize(res);
   return res;
 }
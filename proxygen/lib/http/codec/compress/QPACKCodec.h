@@ -38,11 +38,22 @@ class QPACKCodec : public HeaderCodec {
   QPACKCodec();
   ~QPACKCodec() override {}
 
-  // QPACK encode: id is used for internal tracking of references
+  // QPACK encode: id is used for internal tracking of references.  See
+  // QPACKEncoder::encode for latencySensitive.
   QPACKEncoder::EncodeResult encode(
       std::vector<compress::Header>& headers, uint64_t id,
       uint32_t maxEncoderStreamBytes=
-      std::numeric_limits<uint32_t>::max()) noexcept;
+      std::numeric_limits<uint32_t>::max(),
+      bool latencySensitive=false) noexcept;
+
+  // Encodes the headers CodecUtil::prepareMessageForCompression would return
+  // for msg, straight from msg.  Only values inserted into the dynamic table
+  // are copied.
+  QPACKEncoder::EncodeResult encodeHTTPMessage(
+      const HTTPMessage& msg, uint64_t id,
+      uint32_t maxEncoderStreamBytes=
+      std::numeric_limits<uint32_t>::max(),
+      bool latencySensitive=false) noexcept;
 
   HPACK::DecodeError decodeEncoderStream(std::unique_ptr<folly::IOBuf> buf) {
     // stats?
@@ -130,10 +141,34 @@ class QPACKCodec : public HeaderCodec {
     encoder_.setMaxVulnerable(maxVulnerable);
   }
 
+  void setMaxBlockingDelay(std::chrono::milliseconds maxBlockingDelay) {
+    encoder_.setMaxBlockingDelay(maxBlockingDelay);
+  }
+
+  void setProactiveDuplication(bool enabled) {
+    encoder_.setProactiveDuplication(enabled);
+  }
+
+  std::chrono::microseconds getAckDelayEstimate() const {
+    return encoder_.getAckDelayEstimate();
+  }
+
+  const QPACKEncoder::BlockingStats& getBlockingStats() const {
+    return encoder_.getBlockingStats();
+  }
+
   void setMaxBlocking(uint32_t maxBlocking) {
     decoder_.setMaxBlocking(maxBlocking);
   }
 
+  void setMaxQueuedBytes(uint64_t maxQueuedBytes) {
+    decoder_.setMaxQueuedBytes(maxQueuedBytes);
+  }
+
+  const QPACKDecoder::QueueStats& getQueueStats() const {
+    return decoder_.getQueueStats();
+  }
+
   void setMaxNumOutstandingBlocks(uint32_t value) {
     encoder_.setMaxNumOutstandingBlocks(value);
   }
@@ -10,6 +10,8 @@
 #include <proxygen/lib/http/codec/compress/QPACKDecoder.h>
 #include <proxygen/lib/http/codec/compress/HPACKEncodeBuffer.h>
 
+#include <algorithm>
+
 using folly::IOBuf;
 using folly::io::Cursor;
 using std::unique_ptr;
@@ -34,9 +36,14 @@ void QPACKDecoder::decodeStreaming(
   if (requiredInsertCount > table_.getInsertCount()) {
     VLOG(5) << "requiredInsertCount=" << requiredInsertCount
             << " > insertCount=" << table_.getInsertCount() << ", queuing";
-    if (queue_.size() >= maxBlocking_) {
-      VLOG(2) << "QPACK queue is full size=" << queue_.size()
-              << " maxBlocking_=" << maxBlocking_;
+    uint32_t length = totalBytes - dbuf.consumedBytes();
+    if (numQueued_ >= maxBlocking_ ||
+        queuedBytes_ + length > maxQueuedBytes_) {
+      VLOG(2) << "QPACK queue is full size=" << numQueued_
+              << " maxBlocking_=" << maxBlocking_
+              << " queuedBytes_=" << queuedBytes_
+              << " maxQueuedBytes_=" << maxQueuedBytes_;
+      queueStats_.rejected++;
       err_ = HPACK::DecodeError::TOO_MANY_BLOCKING;
       completeDecode(HeaderCodec::Type::QPACK, streamingCb, 0, 0, 0, false);
     } else {
@@ -44,8 +51,7 @@ void QPACKDecoder::decodeStreaming(
       q.append(std::move(block));
       q.trimStart(dbuf.consumedBytes());
       enqueueHeaderBlock(streamID, requiredInsertCount, baseIndex_,
-                         dbuf.consumedBytes(), q.move(),
-                         totalBytes - dbuf.consumedBytes(), streamingCb);
+                         dbuf.consumedBytes(), q.move(), length, streamingCb);
     }
   } else {
     decodeStreamingImpl(requiredInsertCount, 0, dbuf, streamingCb);
@@ -241,6 +247,31 @@ void QPACKDecoder::decodeEncoderStreamInstruction(HPACKDecodeBuffer& dbuf) {
   }
 }
 
+const HPACKHeaderName* QPACKDecoder::decodeNameIndexQ(
+    HPACKDecodeBuffer& dbuf,
+    uint8_t prefixLength,
+    bool aboveBase,
+    bool allowPartial) {
+  uint64_t nameIndex = 0;
+  bool isStaticName = !aboveBase && (dbuf.peek() & (1 << prefixLength));
+  err_ = dbuf.decodeInteger(prefixLength, nameIndex);
+  if (allowPartial && err_ == HPACK::DecodeError::BUFFER_UNDERFLOW) {
+    return nullptr;
+  }
+  if (err_ != HPACK::DecodeError::NONE) {
+    LOG(ERROR) << "Decode error decoding index err_=" << err_;
+    return nullptr;
+  }
+  nameIndex++;
+  // validate the index
+  if (!isValid(isStaticName, nameIndex, aboveBase)) {
+    LOG(ERROR) << "received invalid index: " << nameIndex;
+    err_ = HPACK::DecodeError::INVALID_INDEX;
+    return nullptr;
+  }
+  return &getHeader(isStaticName, nameIndex, baseIndex_, aboveBase).name;
+}
+
 uint32_t QPACKDecoder::decodeLiteralHeaderQ(
     HPACKDecodeBuffer& dbuf,
     bool indexing,
@@ -248,34 +279,26 @@ uint32_t QPACKDecoder::decodeLiteralHeaderQ(
     uint8_t prefixLength,
     bool aboveBase,
     HPACK::StreamingCallback* streamingCb) {
-  bool allowPartial = (streamingCb == nullptr);
-  Partial localPartial;
-  Partial* partial = (allowPartial) ? &partial_ : &localPartial;
+  if (streamingCb) {
+    // Literals in header blocks are never inserted, so they need not be copied
+    DCHECK(!indexing);
+    return decodeLiteralHeaderViewQ(dbuf, nameIndexed, prefixLength, aboveBase,
+                                    streamingCb);
+  }
+  // Encoder stream instructions may span reads, so the header is kept in
+  // partial_ until it is complete
+  Partial* partial = &partial_;
   if (partial->state == Partial::NAME) {
     if (nameIndexed) {
-      uint64_t nameIndex = 0;
-      bool isStaticName = !aboveBase && (dbuf.peek() & (1 << prefixLength));
-      err_ = dbuf.decodeInteger(prefixLength, nameIndex);
-      if (allowPartial && err_ == HPACK::DecodeError::BUFFER_UNDERFLOW) {
-        return 0;
-      }
-      if (err_ != HPACK::DecodeError::NONE) {
-        LOG(ERROR) << "Decode error decoding index err_=" << err_;
-        return 0;
-      }
-      nameIndex++;
-      // validate the index
-      if (!isValid(isStaticName, nameIndex, aboveBase)) {
-        LOG(ERROR) << "received invalid index: " << nameIndex;
-        err_ = HPACK::DecodeError::INVALID_INDEX;
+      auto name = decodeNameIndexQ(dbuf, prefixLength, aboveBase, true);
+      if (!name) {
         return 0;
       }
-      partial->header.name = getHeader(
-          isStaticName, nameIndex, baseIndex_, aboveBase).name;
+      partial->header.name = *name;
     } else {
       folly::fbstring headerName;
       err_ = dbuf.decodeLiteral(prefixLength, headerName);
-      if (allowPartial && err_ == HPACK::DecodeError::BUFFER_UNDERFLOW) {
+      if (err_ == HPACK::DecodeError::BUFFER_UNDERFLOW) {
         return 0;
       }
       if (err_ != HPACK::DecodeError::NONE) {
@@ -289,7 +312,7 @@ uint32_t QPACKDecoder::decodeLiteralHeaderQ(
   }
   // value
   err_ = dbuf.decodeLiteral(partial->header.value);
-  if (allowPartial && err_ == HPACK::DecodeError::BUFFER_UNDERFLOW) {
+  if (err_ == HPACK::DecodeError::BUFFER_UNDERFLOW) {
     return 0;
   }
   if (err_ != HPACK::DecodeError::NONE) {
@@ -299,7 +322,7 @@ uint32_t QPACKDecoder::decodeLiteralHeaderQ(
   }
   partial->state = Partial::NAME;
 
-  uint32_t emittedSize = emit(partial->header, streamingCb, nullptr);
+  uint32_t emittedSize = partial->header.realBytes();
 
   if (indexing) {
     if (!table_.add(std::move(partial->header))) {
@@ -312,6 +335,40 @@ uint32_t QPACKDecoder::decodeLiteralHeaderQ(
   return emittedSize;
 }
 
+uint32_t QPACKDecoder::decodeLiteralHeaderViewQ(
+    HPACKDecodeBuffer& dbuf,
+    bool nameIndexed,
+    uint8_t prefixLength,
+    bool aboveBase,
+    HPACK::StreamingCallback* streamingCb) {
+  HTTPHeaderCode code;
+  folly::StringPiece name;
+  if (nameIndexed) {
+    auto indexedName = decodeNameIndexQ(dbuf, prefixLength, aboveBase, false);
+    if (!indexedName) {
+      return 0;
+    }
+    code = indexedName->getHeaderCode();
+    name = indexedName->get();
+  } else {
+    err_ = dbuf.decodeLiteral(prefixLength, nameBuf_, name);
+    if (err_ != HPACK::DecodeError::NONE) {
+      LOG(ERROR) << "Error decoding header name err_=" << err_;
+      return 0;
+    }
+    code = canonicalizeName(name);
+  }
+  // value
+  folly::StringPiece value;
+  err_ = dbuf.decodeLiteral(valueBuf_, value);
+  if (err_ != HPACK::DecodeError::NONE) {
+    LOG(ERROR) << "Error decoding header value name=" << name
+               << " err_=" << err_;
+    return 0;
+  }
+  return emit(code, name, value, streamingCb, nullptr);
+}
+
 uint32_t QPACKDecoder::decodeIndexedHeaderQ(
     HPACKDecodeBuffer& dbuf,
     uint32_t prefixLength,
@@ -383,12 +440,35 @@ std::unique_ptr<folly::IOBuf> QPACKDecoder::encodeHeaderAck(
 std::unique_ptr<folly::IOBuf> QPACKDecoder::encodeCancelStream(
     uint64_t streamId) {
   // Remove this stream from the queue
-  auto it = queue_.begin();
-  while (it != queue_.end()) {
-    if (it->second.streamID == streamId) {
-      it = queue_.erase(it);
-    } else {
-      it++;
+  for (auto& slot : queue_) {
+    if (numQueued_ == 0) {
+      break;
+    }
+    auto it = slot.begin();
+    while (it != slot.end()) {
+      if (it->streamID == streamId) {
+        DCHECK_LE(it->length, queuedBytes_);
+        queuedBytes_ -= it->length;
+        numQueued_--;
+        queueStats_.cancelled++;
+        it = slot.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+  if (draining_) {
+    // A callback of drainQueue is cancelling a stream blocked on the same
+    // insert count, which drainQueue skips once its callback is cleared
+    for (size_t i = drainingNext_; i < draining_->size(); i++) {
+      auto& pending = (*draining_)[i];
+      if (pending.streamID == streamId && pending.cb) {
+        DCHECK_LE(pending.length, queuedBytes_);
+        queuedBytes_ -= pending.length;
+        numQueued_--;
+        queueStats_.cancelled++;
+        pending.cb = nullptr;
+      }
     }
   }
   HPACKEncodeBuffer ackEncoder(kGrowth, false);
@@ -404,16 +484,25 @@ void QPACKDecoder::enqueueHeaderBlock(
   std::unique_ptr<folly::IOBuf> block,
   size_t length,
   HPACK::StreamingCallback* streamingCb) {
-  // TDOO: this queue is currently unbounded and has no timeouts
+  // TDOO: this queue has no timeouts
   CHECK_GT(requiredInsertCount, table_.getInsertCount());
-  queue_.emplace(
-    std::piecewise_construct,
-    std::forward_as_tuple(requiredInsertCount),
-    std::forward_as_tuple(streamID, baseIndex, length, consumed,
-                          std::move(block), streamingCb));
+  if (queue_.empty()) {
+    // decodePrefix only accepts a requiredInsertCount up to maxEntries past
+    // the insert count
+    queue_.resize(std::max<uint64_t>(getMaxEntries(maxTableSize_), 1));
+  }
+  if (numQueued_ == 0) {
+    drainedInsertCount_ = table_.getInsertCount();
+  }
+  queue_[requiredInsertCount % queue_.size()].emplace_back(
+    streamID, requiredInsertCount, baseIndex, length, consumed,
+    std::move(block), streamingCb);
+  numQueued_++;
   holBlockCount_++;
   VLOG(5) << "queued block=" << requiredInsertCount << " len=" << length;
   queuedBytes_ += length;
+  queueStats_.maxQueuedBytes = std::max(queueStats_.maxQueuedBytes,
+                                        queuedBytes_);
 }
 
 bool QPACKDecoder::decodeBlock(uint32_t requiredInsertCount,
@@ -437,16 +526,56 @@ bool QPACKDecoder::decodeBlock(uint32_t requiredInsertCount,
 }
 
 void QPACKDecoder::drainQueue() {
-  auto it = queue_.begin();
-  while (!queue_.empty() && it->first <= table_.getInsertCount() &&
+  while (numQueued_ > 0 && drainedInsertCount_ < table_.getInsertCount() &&
          !hasError()) {
-    auto id = it->first;
-    PendingBlock block = std::move(it->second);
-    queue_.erase(it);
-    if (decodeBlock(id, block)) {
-      return;
+    auto requiredInsertCount = ++drainedInsertCount_;
+    auto& slot = queue_[requiredInsertCount % queue_.size()];
+    if (slot.empty()) {
+      continue;
+    }
+    // Callbacks can queue or cancel blocks, so decode from a detached list
+    std::vector<PendingBlock> blocks;
+    blocks.swap(slot);
+    auto now = Clock::now();
+    bool requeued = false;
+    draining_ = &blocks;
+    for (size_t i = 0; i < blocks.size(); i++) {
+      auto& pending = blocks[i];
+      drainingNext_ = i + 1;
+      if (!pending.cb) {
+        // Cancelled by the callback of a block before it
+        continue;
+      }
+      if (pending.requiredInsertCount != requiredInsertCount) {
+        // A callback queued this for a later insert count, a full ring ahead
+        slot.push_back(std::move(pending));
+        continue;
+      }
+      if (hasError()) {
+        // Stay queued, like the blocks of later insert counts
+        slot.push_back(std::move(pending));
+        requeued = true;
+        continue;
+      }
+      numQueued_--;
+      auto blockedTime = std::chrono::duration_cast<std::chrono::microseconds>(
+        now - pending.queuedAt);
+      queueStats_.unblocked++;
+      queueStats_.totalBlockedTime += blockedTime;
+      queueStats_.maxBlockedTime = std::max(queueStats_.maxBlockedTime,
+                                            blockedTime);
+      if (decodeBlock(requiredInsertCount, pending)) {
+        return;
+      }
+    }
+    draining_ = nullptr;
+    if (requeued) {
+      drainedInsertCount_--;
+    } else if (slot.empty()) {
+      // Keep the slot's capacity for the next blocks
+      blocks.clear();
+      slot.swap(blocks);
     }
-    it = queue_.begin();
   }
 }
 
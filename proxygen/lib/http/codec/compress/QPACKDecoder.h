@@ -17,6 +17,9 @@
 #include <proxygen/lib/http/codec/compress/QPACKContext.h>
 #include <folly/io/async/DestructorCheck.h>
 
+#include <chrono>
+#include <vector>
+
 namespace proxygen {
 
 class QPACKDecoder : public HPACKDecoderBase,
@@ -55,6 +58,31 @@ class QPACKDecoder : public HPACKDecoderBase,
     maxBlocking_ = maxBlocking;
   }
 
+  /**
+   * Limit on the bytes of all queued header blocks.  A block that would go
+   * over it fails with TOO_MANY_BLOCKING, like one over maxBlocking.
+   */
+  void setMaxQueuedBytes(uint64_t maxQueuedBytes) {
+    maxQueuedBytes_ = maxQueuedBytes;
+  }
+
+  struct QueueStats {
+    // Blocks refused because the queue was full, and those cancelled while
+    // queued
+    uint64_t rejected{0};
+    uint64_t cancelled{0};
+    uint64_t maxQueuedBytes{0};
+    // Blocks decoded after waiting for inserts, how long they waited in
+    // total, and the longest wait
+    uint64_t unblocked{0};
+    std::chrono::microseconds totalBlockedTime{0};
+    std::chrono::microseconds maxBlockedTime{0};
+  };
+
+  const QueueStats& getQueueStats() const {
+    return queueStats_;
+  }
+
   void setHeaderTableMaxSize(uint32_t maxSize) {
     CHECK(maxTableSize_ == 0 || maxTableSize_ == maxSize)
       << "Cannot change non-zero max header table size, "
@@ -83,6 +111,15 @@ class QPACKDecoder : public HPACKDecoderBase,
       HPACK::StreamingCallback* streamingCb,
       headers_t* emitted);
 
+  /**
+   * Returns the name at the decoded index, or nullptr on error.
+   */
+  const HPACKHeaderName* decodeNameIndexQ(
+      HPACKDecodeBuffer& dbuf,
+      uint8_t prefixLength,
+      bool aboveBase,
+      bool allowPartial);
+
   uint32_t decodeLiteralHeaderQ(
       HPACKDecodeBuffer& dbuf,
       bool indexing,
@@ -91,6 +128,17 @@ class QPACKDecoder : public HPACKDecoderBase,
       bool aboveBase,
       HPACK::StreamingCallback* streamingCb);
 
+  /**
+   * Decodes a literal in a header block, emitting views of its name and
+   * value instead of copies.
+   */
+  uint32_t decodeLiteralHeaderViewQ(
+      HPACKDecodeBuffer& dbuf,
+      bool nameIndexed,
+      uint8_t prefixLength,
+      bool aboveBase,
+      HPACK::StreamingCallback* streamingCb);
+
   void decodeEncoderStreamInstruction(HPACKDecodeBuffer& dbuf);
 
   void enqueueHeaderBlock(
@@ -102,21 +150,26 @@ class QPACKDecoder : public HPACKDecoderBase,
       size_t length,
       HPACK::StreamingCallback* streamingCb);
 
+  using Clock = std::chrono::steady_clock;
+
   struct PendingBlock {
     PendingBlock(
-        uint64_t sid,
+        uint64_t sid, uint32_t ric,
         uint32_t bi, uint32_t l, uint32_t cons,
         std::unique_ptr<folly::IOBuf> b,
         HPACK::StreamingCallback* c)
-        : streamID(sid), baseIndex(bi), length(l), consumed(cons),
-          block(std::move(b)), cb(c)
+        : streamID(sid), requiredInsertCount(ric), baseIndex(bi), length(l),
+          consumed(cons), block(std::move(b)), cb(c),
+          queuedAt(Clock::now())
       {}
     uint64_t streamID;
+    uint32_t requiredInsertCount;
     uint32_t baseIndex;
     uint32_t length;
     uint32_t consumed;
     std::unique_ptr<folly::IOBuf> block;
     HPACK::StreamingCallback* cb;
+    Clock::time_point queuedAt;
   };
 
   // Returns true if this object was destroyed by its callback.  Callers
@@ -131,7 +184,20 @@ class QPACKDecoder : public HPACKDecoderBase,
   uint32_t holBlockCount_{0};
   uint32_t pendingEncoderBytes_{0};
   uint64_t queuedBytes_{0};
-  std::multimap<uint32_t, PendingBlock> queue_;
+  uint64_t maxQueuedBytes_{HPACK::kDefaultMaxQueuedBytes};
+  // Blocked header blocks, in a ring indexed by required insert count.  A
+  // block's required insert count is at most a table's worth of entries past
+  // the insert count, so slots are rarely shared, and the blocks an insert
+  // unblocks are found without searching.
+  std::vector<std::vector<PendingBlock>> queue_;
+  uint32_t numQueued_{0};
+  // The blocks drainQueue has taken out of their slot, of which the ones from
+  // drainingNext_ on are still queued
+  std::vector<PendingBlock>* draining_{nullptr};
+  size_t drainingNext_{0};
+  // Every block with a required insert count up to this has been woken
+  uint32_t drainedInsertCount_{0};
+  QueueStats queueStats_;
 
   // This holds the state of a partially decoded literal insert on the control
   // stream
@@ -10,6 +10,10 @@
 #include <proxygen/lib/http/codec/compress/QPACKEncoder.h>
 #include <proxygen/lib/http/codec/compress/HPACKDecodeBuffer.h>
 
+#include <folly/Optional.h>
+
+#include <algorithm>
+
 using std::vector;
 
 namespace proxygen {
@@ -27,29 +31,53 @@ QPACKEncoder::EncodeResult
 QPACKEncoder::encode(const vector<HPACKHeader>& headers,
                      uint32_t headroom,
                      uint64_t streamId,
-                     uint32_t maxEncoderStreamBytes) {
+                     uint32_t maxEncoderStreamBytes,
+                     bool latencySensitive) {
+  startEncode(headroom, streamId, maxEncoderStreamBytes, latencySensitive);
+  for (const auto& header: headers) {
+    encodeHeaderQ(header.name, header.value, curBaseIndex_,
+                  &curRequiredInsertCount_);
+  }
+  return completeEncode();
+}
+
+void QPACKEncoder::startEncode(uint32_t headroom,
+                               uint64_t streamId,
+                               uint32_t maxEncoderStreamBytes,
+                               bool latencySensitive) {
   if (headroom) {
     streamBuffer_.addHeadroom(headroom);
   }
   maxEncoderStreamBytes_ = maxEncoderStreamBytes;
   maxEncoderStreamBytes_ -=
     handlePendingContextUpdate(controlBuffer_, table_.capacity());
-  return encodeQ(headers, streamId);
+
+  DCHECK(!curOutstanding_) << "startEncode without completeEncode";
+  // curOutstanding_ is mostly for convenience so other methods invoked while
+  // encoding can access the block.
+  curBlock_ = OutstandingBlock();
+  curOutstanding_ = &curBlock_;
+  curStreamId_ = streamId;
+  curBaseIndex_ = table_.getInsertCount();
+  curRequiredInsertCount_ = 0;
+  curLatencySensitive_ = latencySensitive;
 }
 
-QPACKEncoder::EncodeResult
-QPACKEncoder::encodeQ(const vector<HPACKHeader>& headers, uint64_t streamId) {
-  OutstandingBlock outstandingBlock;
-  // curOutstanding_ points to a local stack variable, it's mostly for
-  // convenience so other methods invoked from here can access it.
-  curOutstanding_ = &outstandingBlock;
-  auto baseIndex = table_.getInsertCount();
-
-  uint32_t requiredInsertCount = 0;
-  for (const auto& header: headers) {
-    encodeHeaderQ(header, baseIndex, &requiredInsertCount);
-  }
+uint32_t QPACKEncoder::encodeHeader(HTTPHeaderCode code,
+                                    const std::string& name,
+                                    folly::StringPiece value) {
+  CHECK(curOutstanding_);
+  // Only names that are not common need hashing and lowercasing
+  auto headerName = (code == HTTP_HEADER_OTHER) ? HPACKHeaderName(name)
+                                                : HPACKHeaderName(code);
+  encodeHeaderQ(headerName, value, curBaseIndex_, &curRequiredInsertCount_);
+  return headerName.size() + value.size() + 2;
+}
 
+QPACKEncoder::EncodeResult QPACKEncoder::completeEncode() {
+  CHECK(curOutstanding_);
+  auto baseIndex = curBaseIndex_;
+  auto requiredInsertCount = curRequiredInsertCount_;
   auto streamBlock = streamBuffer_.release();
 
   // encode the prefix
@@ -74,26 +102,41 @@ QPACKEncoder::encodeQ(const vector<HPACKHeader>& headers, uint64_t streamId) {
   streamBuffer->prependChain(std::move(streamBlock));
 
   auto controlBuf = controlBuffer_.release();
+  blockingStats_.blocks++;
+  auto insertCount = table_.getInsertCount();
+  if (insertCount > std::max<uint32_t>(table_.getAcknowledgedInsertCount(),
+                                       insertTimes_.empty() ? 0 :
+                                       insertTimes_.back().first)) {
+    insertTimes_.emplace_back(insertCount, Clock::now());
+    if (insertTimes_.size() > kMaxInsertTimes) {
+      insertTimes_.pop_front();
+    }
+  }
   // curOutstanding_.references could be empty, if the block encodes only static
   // headers and/or literals.  If so we don't track anything.
   if (!curOutstanding_->references.empty()) {
     if (curOutstanding_->vulnerable) {
       DCHECK(allowVulnerable());
       numVulnerable_++;
+      blockingStats_.vulnerableBlocks++;
     }
     numOutstandingBlocks_++;
-    outstanding_[streamId].emplace_back(std::move(outstandingBlock));
+    outstanding_[curStreamId_].emplace_back(std::move(curBlock_));
   }
-  // Clear the pointer to our stack
   curOutstanding_ = nullptr;
+  curLatencySensitive_ = false;
 
   return { std::move(controlBuf), std::move(streamBuffer) };
 }
 
 void QPACKEncoder::encodeHeaderQ(
-  const HPACKHeader& header, uint32_t baseIndex,
+  const HPACKHeaderName& name, folly::StringPiece value, uint32_t baseIndex,
   uint32_t* requiredInsertCount) {
-  uint32_t index = getStaticTable().getIndex(header);
+  // The static table only has common headers
+  uint32_t index = 0;
+  if (name.isCommonHeader()) {
+    index = getStaticTable().getIndex(name.getHeaderCode(), value);
+  }
   if (index > 0) {
     // static reference
     streamBuffer_.encodeInteger(index - 1,
@@ -102,9 +145,9 @@ void QPACKEncoder::encodeHeaderQ(
     return;
   }
 
-  bool indexable = shouldIndex(header);
+  bool indexable = shouldIndex(name, value);
   if (indexable) {
-    index = table_.getIndex(header, allowVulnerable());
+    index = table_.getIndex(name, value, allowVulnerable());
     if (index == QPACKHeaderTable::UNACKED) {
       index = 0;
       indexable = false;
@@ -123,14 +166,15 @@ void QPACKEncoder::encodeHeaderQ(
     uint32_t absoluteNameIndex = 0;
     bool isStaticName = false;
     std::tie(isStaticName, nameIndex, absoluteNameIndex) =
-      getNameIndexQ(header.name);
+      getNameIndexQ(name);
 
     // Now check if we should emit an insertion on the control stream
     // Don't try to index if we're out of encoder flow control
     indexable &= maxEncoderStreamBytes_ > 0;
-    if (indexable && table_.canIndex(header)) {
-      encodeInsertQ(header, isStaticName, nameIndex);
-      CHECK(table_.add(header.copy()));
+    if (indexable && table_.canIndex(name, value)) {
+      encodeInsertQ(name, value, isStaticName, nameIndex);
+      // The only copy of the value, for the table
+      CHECK(table_.add(HPACKHeader(name, value.fbstr())));
       if (allowVulnerable() && lastEntryAvailable()) {
         index = table_.getInsertCount();
       } else {
@@ -148,7 +192,7 @@ void QPACKEncoder::encodeHeaderQ(
     if (index == 0) {
       // Couldn't insert it: table full, not indexable, or table contains
       // vulnerable reference.  Encode a literal on the request stream.
-      encodeStreamLiteralQ(header, isStaticName, nameIndex, absoluteNameIndex,
+      encodeStreamLiteralQ(name, value, isStaticName, nameIndex, absoluteNameIndex,
                            baseIndex, requiredInsertCount);
       return;
     }
@@ -162,11 +206,13 @@ void QPACKEncoder::encodeHeaderQ(
   } else {
     streamBuffer_.encodeInteger(baseIndex - index, HPACK::Q_INDEXED);
   }
+  maybeDuplicateNearDraining(name, value, index);
 }
 
-bool QPACKEncoder::shouldIndex(const HPACKHeader& header) const {
-  return (header.bytes() <= table_.capacity()) &&
-    (!indexingStrat_ || indexingStrat_->indexHeader(header)) &&
+bool QPACKEncoder::shouldIndex(const HPACKHeaderName& name,
+                               folly::StringPiece value) const {
+  return (HPACKHeader::bytes(name, value) <= table_.capacity()) &&
+    (!indexingStrat_ || indexingStrat_->indexHeader(name, value)) &&
     dynamicReferenceAllowed();
 }
 
@@ -180,6 +226,7 @@ std::pair<bool, uint32_t> QPACKEncoder::maybeDuplicate(
   if (res.first) {
     VLOG(4) << "Encoded duplicate index=" << relativeIndex;
     encodeDuplicate(relativeIndex);
+    blockingStats_.duplications++;
     // Note we will emit duplications even when we are out of flow control,
     // but we won't reference them (eg: like we were at vulnerable max).
     if (!lastEntryAvailable()) {
@@ -191,10 +238,39 @@ std::pair<bool, uint32_t> QPACKEncoder::maybeDuplicate(
   return res;
 }
 
+void QPACKEncoder::maybeDuplicateNearDraining(const HPACKHeaderName& name,
+                                              folly::StringPiece value,
+                                              uint32_t absoluteIndex) {
+  if (!proactiveDuplication_ || maxEncoderStreamBytes_ <= 0) {
+    return;
+  }
+  auto relativeIndex = table_.absoluteToRelative(absoluteIndex);
+  // A copy of an unacknowledged entry would only be acknowledged later, and
+  // entries with a newer copy already have one
+  if (table_.isVulnerable(absoluteIndex) ||
+      !table_.isNearDraining(relativeIndex) ||
+      table_.getIndex(name, value) != relativeIndex) {
+    return;
+  }
+  // This block already references the original, so it won't be evicted to
+  // make room for the copy
+  const HPACKHeader& header = table_.getHeader(relativeIndex);
+  if (!table_.canIndex(header)) {
+    return;
+  }
+  VLOG(4) << "Encoded duplicate of near draining index=" << relativeIndex;
+  encodeDuplicate(relativeIndex);
+  CHECK(table_.add(header.copy()));
+  blockingStats_.proactiveDuplications++;
+}
+
 std::tuple<bool, uint32_t, uint32_t> QPACKEncoder::getNameIndexQ(
   const HPACKHeaderName& headerName) {
   uint32_t absoluteNameIndex = 0;
-  uint32_t nameIndex = getStaticTable().nameIndex(headerName);
+  uint32_t nameIndex = 0;
+  if (headerName.isCommonHeader()) {
+    nameIndex = getStaticTable().nameIndex(headerName.getHeaderCode());
+  }
   bool isStatic = true;
   if (nameIndex == 0 && dynamicReferenceAllowed()) {
     // check dynamic table
@@ -215,8 +291,8 @@ std::tuple<bool, uint32_t, uint32_t> QPACKEncoder::getNameIndexQ(
 }
 
 void QPACKEncoder::encodeStreamLiteralQ(
-  const HPACKHeader& header, bool isStaticName, uint32_t nameIndex,
-  uint32_t absoluteNameIndex, uint32_t baseIndex,
+  const HPACKHeaderName& name, folly::StringPiece value, bool isStaticName,
+  uint32_t nameIndex, uint32_t absoluteNameIndex, uint32_t baseIndex,
   uint32_t* requiredInsertCount) {
   if (absoluteNameIndex > 0) {
     // Dynamic name reference, vulnerability checks already done
@@ -224,13 +300,13 @@ void QPACKEncoder::encodeStreamLiteralQ(
     trackReference(absoluteNameIndex, requiredInsertCount);
   }
   if (absoluteNameIndex > baseIndex) {
-    encodeLiteralQ(header,
+    encodeLiteralQ(name, value,
                    false, /* not static */
                    true, /* post base */
                    absoluteNameIndex - baseIndex,
                    HPACK::Q_LITERAL_NAME_REF_POST);
   } else {
-    encodeLiteralQ(header,
+    encodeLiteralQ(name, value,
                    isStaticName,
                    false, /* not post base */
                    isStaticName ? nameIndex : baseIndex - absoluteNameIndex + 1,
@@ -261,31 +337,34 @@ void QPACKEncoder::encodeDuplicate(uint32_t index) {
     controlBuffer_.encodeInteger(index - 1, HPACK::Q_DUPLICATE);
 }
 
-void QPACKEncoder::encodeInsertQ(const HPACKHeader& header,
+void QPACKEncoder::encodeInsertQ(const HPACKHeaderName& name,
+                                 folly::StringPiece value,
                                  bool isStaticName,
                                  uint32_t nameIndex) {
   auto encoded = encodeLiteralQHelper(
-      controlBuffer_, header, isStaticName, nameIndex,
+      controlBuffer_, name, value, isStaticName, nameIndex,
       HPACK::Q_INSERT_NAME_REF_STATIC, HPACK::Q_INSERT_NAME_REF,
       HPACK::Q_INSERT_NO_NAME_REF);
   maxEncoderStreamBytes_ -= encoded;
 }
 
-void QPACKEncoder::encodeLiteralQ(const HPACKHeader& header,
+void QPACKEncoder::encodeLiteralQ(const HPACKHeaderName& name,
+                                  folly::StringPiece value,
                                   bool isStaticName,
                                   bool postBase,
                                   uint32_t nameIndex,
                                   const HPACK::Instruction& idxInstr) {
   DCHECK(!isStaticName || !postBase);
   encodeLiteralQHelper(
-      streamBuffer_, header, isStaticName, nameIndex,
+      streamBuffer_, name, value, isStaticName, nameIndex,
       HPACK::Q_LITERAL_STATIC, idxInstr,
       HPACK::Q_LITERAL);
 }
 
 uint32_t QPACKEncoder::encodeLiteralQHelper(
     HPACKEncodeBuffer& buffer,
-    const HPACKHeader& header,
+    const HPACKHeaderName& name,
+    folly::StringPiece value,
     bool isStaticName,
     uint32_t nameIndex,
     uint8_t staticFlag,
@@ -304,10 +383,10 @@ uint32_t QPACKEncoder::encodeLiteralQHelper(
     encoded += buffer.encodeInteger(nameIndex, byte, idxInstr.prefixLength);
   } else {
     encoded += buffer.encodeLiteral(litInstr.code, litInstr.prefixLength,
-                                    header.name.get());
+                                    name.get());
   }
   // value
-  encoded += buffer.encodeLiteral(header.value);
+  encoded += buffer.encodeLiteral(value);
   return encoded;
 }
 
@@ -363,9 +442,27 @@ HPACK::DecodeError QPACKEncoder::onInsertCountIncrement(uint32_t inserts) {
   if (inserts == 0 || !table_.onInsertCountIncrement(inserts)) {
     return HPACK::DecodeError::INVALID_ACK;
   }
+  updateAckDelay();
   return HPACK::DecodeError::NONE;
 }
 
+void QPACKEncoder::updateAckDelay() {
+  auto ackedInsertCount = table_.getAcknowledgedInsertCount();
+  folly::Optional<Clock::time_point> encodeTime;
+  while (!insertTimes_.empty() &&
+         insertTimes_.front().first <= ackedInsertCount) {
+    encodeTime = insertTimes_.front().second;
+    insertTimes_.pop_front();
+  }
+  if (!encodeTime) {
+    return;
+  }
+  auto sample = std::chrono::duration_cast<std::chrono::microseconds>(
+    Clock::now() - *encodeTime);
+  // Smoothed like TCP's SRTT
+  ackDelay_ = (ackDelay_.count() == 0) ? sample : (7 * ackDelay_ + sample) / 8;
+}
+
 HPACK::DecodeError QPACKEncoder::onHeaderAck(uint64_t streamId, bool all) {
   auto it = outstanding_.find(streamId);
   if (it == outstanding_.end()) {
@@ -414,6 +511,7 @@ HPACK::DecodeError QPACKEncoder::onHeaderAck(uint64_t streamId, bool all) {
       VLOG(5) << "Implicitly acknowledging requiredInsertCount="
               << requiredInsertCount;
       table_.setAcknowledgedInsertCount(requiredInsertCount);
+      updateAckDelay();
     }
   }
   if (it->second.empty()) {
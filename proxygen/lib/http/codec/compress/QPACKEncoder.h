@@ -10,6 +10,8 @@
 #pragma once
 
 #include <folly/io/IOBuf.h>
+#include <chrono>
+#include <deque>
 #include <list>
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
 #include <proxygen/lib/http/codec/compress/QPACKContext.h>
@@ -45,12 +47,35 @@ class QPACKEncoder : public HPACKEncoderBase, public QPACKContext {
   };
 
   // Returns a pair of buffers.  One for the control stream and one for the
-  // request stream
+  // request stream.  The block of a latencySensitive stream only references
+  // acknowledged entries, so it never blocks the decoder.
   EncodeResult encode(
     const std::vector<HPACKHeader>& headers,
     uint32_t headroom,
     uint64_t streamId,
-    uint32_t maxEncoderStreamBytes=std::numeric_limits<uint32_t>::max());
+    uint32_t maxEncoderStreamBytes=std::numeric_limits<uint32_t>::max(),
+    bool latencySensitive=false);
+
+  /**
+   * Encode a header block one header at a time, like HPACKEncoder:
+   * startEncode(), encodeHeader() for each header, then completeEncode().
+   */
+  void startEncode(
+    uint32_t headroom,
+    uint64_t streamId,
+    uint32_t maxEncoderStreamBytes=std::numeric_limits<uint32_t>::max(),
+    bool latencySensitive=false);
+
+  /**
+   * name is only used if code is HTTP_HEADER_OTHER.
+   *
+   * @return the uncompressed size of the header
+   */
+  uint32_t encodeHeader(HTTPHeaderCode code,
+                        const std::string& name,
+                        folly::StringPiece value);
+
+  EncodeResult completeEncode();
 
   HPACK::DecodeError decodeDecoderStream(
       std::unique_ptr<folly::IOBuf> buf);
@@ -86,6 +111,46 @@ class QPACKEncoder : public HPACKEncoderBase, public QPACKContext {
     maxVulnerable_ = maxVulnerable;
   }
 
+  /**
+   * Stop referencing unacknowledged entries while the estimated time for the
+   * decoder to acknowledge an insert is above maxBlockingDelay, since blocks
+   * that do may wait that long.  Zero, the default, never stops.
+   */
+  void setMaxBlockingDelay(std::chrono::milliseconds maxBlockingDelay) {
+    maxBlockingDelay_ = maxBlockingDelay;
+  }
+
+  /**
+   * Duplicate acknowledged entries that are referenced when they are about to
+   * start draining, so that a fresh copy has been acknowledged by the time
+   * the original can't be referenced anymore.  Off by default.
+   */
+  void setProactiveDuplication(bool enabled) {
+    proactiveDuplication_ = enabled;
+  }
+
+  /**
+   * Smoothed time between an insert and its acknowledgement, or zero if no
+   * insert has been acknowledged yet.
+   */
+  std::chrono::microseconds getAckDelayEstimate() const {
+    return ackDelay_;
+  }
+
+  struct BlockingStats {
+    // Blocks encoded, and those referencing unacknowledged entries, which
+    // can block the decoder
+    uint64_t blocks{0};
+    uint64_t vulnerableBlocks{0};
+    // Duplications of draining entries, and of entries about to drain
+    uint64_t duplications{0};
+    uint64_t proactiveDuplications{0};
+  };
+
+  const BlockingStats& getBlockingStats() const {
+    return blockingStats_;
+  }
+
   // This API is only for tests, and doesn't work correctly if the table is
   // already populated.
   void setMinFreeForTesting(uint32_t minFree) {
@@ -96,43 +161,49 @@ class QPACKEncoder : public HPACKEncoderBase, public QPACKContext {
 
  private:
   bool allowVulnerable() const {
-    return numVulnerable_ < maxVulnerable_;
+    return numVulnerable_ < maxVulnerable_ && !curLatencySensitive_ &&
+      (maxBlockingDelay_.count() == 0 || ackDelay_ <= maxBlockingDelay_);
   }
 
-  bool shouldIndex(const HPACKHeader& header) const;
+  bool shouldIndex(const HPACKHeaderName& name,
+                   folly::StringPiece value) const;
 
   bool dynamicReferenceAllowed() const;
 
-  void encodeControl(const HPACKHeader& header);
-
   std::pair<bool, uint32_t> maybeDuplicate(uint32_t relativeIndex);
 
-  QPACKEncoder::EncodeResult
-  encodeQ(const std::vector<HPACKHeader>& headers, uint64_t streamId);
+  void maybeDuplicateNearDraining(const HPACKHeaderName& name,
+                                  folly::StringPiece value,
+                                  uint32_t absoluteIndex);
+
+  void updateAckDelay();
 
   std::tuple<bool, uint32_t, uint32_t> getNameIndexQ(
     const HPACKHeaderName& headerName);
 
   void encodeStreamLiteralQ(
-    const HPACKHeader& header, bool isStaticName, uint32_t nameIndex,
-    uint32_t absoluteNameIndex, uint32_t baseIndex,
+    const HPACKHeaderName& name, folly::StringPiece value, bool isStaticName,
+    uint32_t nameIndex, uint32_t absoluteNameIndex, uint32_t baseIndex,
     uint32_t* requiredInsertCount);
 
-  void encodeHeaderQ(const HPACKHeader& header, uint32_t baseIndex,
-                     uint32_t* requiredInsertCount);
+  void encodeHeaderQ(const HPACKHeaderName& name, folly::StringPiece value,
+                     uint32_t baseIndex, uint32_t* requiredInsertCount);
 
-  void encodeInsertQ(const HPACKHeader& header,
+  void encodeInsertQ(const HPACKHeaderName& name,
+                     folly::StringPiece value,
                      bool isStaticName,
                      uint32_t nameIndex);
 
-  void encodeLiteralQ(const HPACKHeader& header,
+  void encodeLiteralQ(const HPACKHeaderName& name,
+                      folly::StringPiece value,
                       bool isStaticName,
                       bool postBase,
                       uint32_t nameIndex,
                       const HPACK::Instruction& idxInstr);
 
   uint32_t encodeLiteralQHelper(HPACKEncodeBuffer& buffer,
-                                const HPACKHeader& header,
+                                const HPACKHeaderName& name,
+                                folly::StringPiece value,
                                 bool isStaticName,
                                 uint32_t nameIndex,
                                 uint8_t staticFlag,
@@ -163,7 +234,13 @@ class QPACKEncoder : public HPACKEncoderBase, public QPACKContext {
   };
   // Map streamID -> list of table index references for each outstanding block;
   std::unordered_map<uint64_t, std::list<OutstandingBlock>> outstanding_;
+  // The block being encoded, between startEncode and completeEncode
+  OutstandingBlock curBlock_;
   OutstandingBlock* curOutstanding_{nullptr};
+  uint64_t curStreamId_{0};
+  uint32_t curBaseIndex_{0};
+  uint32_t curRequiredInsertCount_{0};
+  bool curLatencySensitive_{false};
   uint32_t maxDepends_{0};
   uint32_t maxVulnerable_{HPACK::kDefaultBlocking};
   uint32_t numVulnerable_{0};
@@ -172,6 +249,15 @@ class QPACKEncoder : public HPACKEncoderBase, public QPACKContext {
   folly::IOBufQueue decoderIngress_{folly::IOBufQueue::cacheChainLength()};
   uint32_t numOutstandingBlocks_{0};
   uint32_t maxNumOutstandingBlocks_{kDefaultMaxOutstandingListSize};
+
+  using Clock = std::chrono::steady_clock;
+  static const size_t kMaxInsertTimes = 64;
+  // Insert count after each block that inserted, and when it was encoded
+  std::deque<std::pair<uint32_t, Clock::time_point>> insertTimes_;
+  std::chrono::microseconds ackDelay_{0};
+  std::chrono::milliseconds maxBlockingDelay_{0};
+  bool proactiveDuplication_{false};
+  BlockingStats blockingStats_;
 };
 
 }
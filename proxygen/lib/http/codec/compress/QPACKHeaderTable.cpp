@@ -90,8 +90,14 @@ uint32_t QPACKHeaderTable::getIndex(const HPACKHeader& header,
   return getIndexImpl(header.name, header.value, false, allowVulnerable);
 }
 
+uint32_t QPACKHeaderTable::getIndex(const HPACKHeaderName& name,
+                                    folly::StringPiece value,
+                                    bool allowVulnerable) const {
+  return getIndexImpl(name, value, false, allowVulnerable);
+}
+
 uint32_t QPACKHeaderTable::getIndexImpl(const HPACKHeaderName& headerName,
-                                        const folly::fbstring& value,
+                                        folly::StringPiece value,
                                         bool nameOnly,
                                         bool allowVulnerable) const {
   auto it = names_.find(headerName);
@@ -104,7 +110,7 @@ uint32_t QPACKHeaderTable::getIndexImpl(const HPACKHeaderName& headerName,
   for (auto indexIt = it->second.rbegin(); indexIt != it->second.rend();
        ++indexIt) {
     auto i = *indexIt;
-    if (nameOnly || table_[i].value == value) {
+    if (nameOnly || folly::StringPiece(table_[i].value) == value) {
       // allow vulnerable or not vulnerable
       if (allowVulnerable || internalToAbsolute(i) <= ackedInsertCount_) {
         // index *may* be draining, caller has to check
@@ -122,8 +128,8 @@ uint32_t QPACKHeaderTable::getIndexImpl(const HPACKHeaderName& headerName,
 
 uint32_t QPACKHeaderTable::nameIndex(const HPACKHeaderName& headerName,
                                      bool allowVulnerable) const {
-  folly::fbstring value;
-  return getIndexImpl(headerName, value, true /* name only */, allowVulnerable);
+  return getIndexImpl(headerName, folly::StringPiece(), true /* name only */,
+                      allowVulnerable);
 }
 
 const HPACKHeader& QPACKHeaderTable::getHeader(uint32_t index,
@@ -221,6 +227,24 @@ bool QPACKHeaderTable::isValid(uint32_t index, uint32_t base) const {
   return HeaderTable::isValid(testIndex);
 }
 
+bool QPACKHeaderTable::isNearDraining(uint32_t relativeIndex) const {
+  if (minFree_ == 0) {
+    return false;
+  }
+  uint32_t absIndex = relativeToAbsolute(relativeIndex);
+  if (absIndex < minUsable_) {
+    return false;
+  }
+  uint32_t bytes = 0;
+  for (uint32_t i = minUsable_; i < absIndex; i++) {
+    bytes += table_[absoluteToInternal(i)].bytes();
+    if (bytes >= minFree_) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Checks if relativeIndex is draining.  If not, returns the corresponding
 // absolute index.  Otherwise, attempt to duplicate.  If duplication is
 // successful, and vulnerable references are allowed, return absolute index of
@@ -53,9 +53,14 @@ class QPACKHeaderTable : public HeaderTable {
    * in the number of entries
    */
   bool canIndex(const HPACKHeader& header) {
-    auto totalBytes = bytes_ + header.bytes();
+    return canIndex(header.name, header.value);
+  }
+
+  bool canIndex(const HPACKHeaderName& name, folly::StringPiece value) {
+    auto headerBytes = HPACKHeader::bytes(name, value);
+    auto totalBytes = bytes_ + headerBytes;
     // Don't index headers that would immediately be drained
-    return ((header.bytes() <= (capacity_ - minFree_)) &&
+    return ((headerBytes <= (capacity_ - minFree_)) &&
             (totalBytes <= capacity_ || canEvict(totalBytes - capacity_)));
   }
 
@@ -66,6 +71,13 @@ class QPACKHeaderTable : public HeaderTable {
     return relativeToAbsolute(relativeIndex) < minUsable_;
   }
 
+  /**
+   * Returns true if the entry at relativeIndex is not draining, but is among
+   * the next entries to drain: those before it that are not draining yet
+   * hold fewer than minFree bytes.
+   */
+  bool isNearDraining(uint32_t relativeIndex) const;
+
   /**
    * Returns the absolute index for a reference to the header at relativeIndex,
    * along with a boolean indicating if the returned index is a duplicate.  It
@@ -100,6 +112,10 @@ class QPACKHeaderTable : public HeaderTable {
   uint32_t getIndex(const HPACKHeader& header,
                     bool allowVulnerable = true) const;
 
+  uint32_t getIndex(const HPACKHeaderName& name,
+                    folly::StringPiece value,
+                    bool allowVulnerable = true) const;
+
   /**
    * Get the table entry at the given external index.  If base is 0,
    * index is relative to head/insertCount.  If base is non-zero, index is
@@ -140,6 +156,10 @@ class QPACKHeaderTable : public HeaderTable {
     return true;
   }
 
+  uint32_t getAcknowledgedInsertCount() const {
+    return ackedInsertCount_;
+  }
+
   void setAcknowledgedInsertCount(uint32_t ackInsertCount) {
     if (ackInsertCount < ackedInsertCount_) {
       return;
@@ -180,7 +200,7 @@ class QPACKHeaderTable : public HeaderTable {
    * Shared implementation for getIndex and nameIndex
    */
   uint32_t getIndexImpl(const HPACKHeaderName& header,
-                        const folly::fbstring& value,
+                        folly::StringPiece value,
                         bool nameOnly,
                         bool allowVulnerable=true) const;
 
@@ -10,7 +10,10 @@
 #include <proxygen/lib/http/codec/compress/StaticHeaderTable.h>
 
 #include <folly/Indestructible.h>
+#include <folly/Portability.h>
+#include <proxygen/lib/http/codec/compress/StaticHeaderTables.h>
 
+#include <cstring>
 #include <glog/logging.h>
 #include <list>
 
@@ -18,78 +21,6 @@ using std::list;
 using std::string;
 using std::vector;
 
-namespace {
-
-// Array of static header table entires pair
-// Note: if updating this table (should never have to but whatever), update
-// isHeaderNameInTableWithNonEmptyValue as well
-const char* s_tableEntries[][2] = {
-  {":authority", ""},
-  {":method", "GET"},
-  {":method", "POST"},
-  {":path", "/"},
-  {":path", "/index.html"},
-  {":scheme", "http"},
-  {":scheme", "https"},
-  {":status", "200"},
-  {":status", "204"},
-  {":status", "206"},
-  {":status", "304"},
-  {":status", "400"},
-  {":status", "404"},
-  {":status", "500"},
-  {"accept-charset", ""},
-  {"accept-encoding", "gzip, deflate"},
-  {"accept-language", ""},
-  {"accept-ranges", ""},
-  {"accept", ""},
-  {"access-control-allow-origin", ""},
-  {"age", ""},
-  {"allow", ""},
-  {"authorization", ""},
-  {"cache-control", ""},
-  {"content-disposition", ""},
-  {"content-encoding", ""},
-  {"content-language", ""},
-  {"content-length", ""},
-  {"content-location", ""},
-  {"content-range", ""},
-  {"content-type", ""},
-  {"cookie", ""},
-  {"date", ""},
-  {"etag", ""},
-  {"expect", ""},
-  {"expires", ""},
-  {"from", ""},
-  {"host", ""},
-  {"if-match", ""},
-  {"if-modified-since", ""},
-  {"if-none-match", ""},
-  {"if-range", ""},
-  {"if-unmodified-since", ""},
-  {"last-modified", ""},
-  {"link", ""},
-  {"location", ""},
-  {"max-forwards", ""},
-  {"proxy-authenticate", ""},
-  {"proxy-authorization", ""},
-  {"range", ""},
-  {"referer", ""},
-  {"refresh", ""},
-  {"retry-after", ""},
-  {"server", ""},
-  {"set-cookie", ""},
-  {"strict-transport-security", ""},
-  {"transfer-encoding", ""},
-  {"user-agent", ""},
-  {"vary", ""},
-  {"via", ""},
-  {"www-authenticate", ""}
-};
-
-const int kEntriesSize = sizeof(s_tableEntries) / (2 * sizeof(const char*));
-}
-
 namespace proxygen {
 
 bool StaticHeaderTable::isHeaderCodeInTableWithNonEmptyValue(
@@ -107,15 +38,14 @@ bool StaticHeaderTable::isHeaderCodeInTableWithNonEmptyValue(
   }
 }
 
-StaticHeaderTable::StaticHeaderTable(
-    const char* entries[][2],
-    int size)
-    : HeaderTable(0) {
+StaticHeaderTable::StaticHeaderTable(const StaticHeaderTableDef& def)
+    : HeaderTable(0),
+      def_(def) {
   // calculate the size
   list<HPACKHeader> hlist;
   uint32_t byteCount = 0;
-  for (int i = 0; i < size; ++i) {
-    hlist.push_back(HPACKHeader(entries[i][0], entries[i][1]));
+  for (uint32_t i = 0; i < def.size; ++i) {
+    hlist.push_back(HPACKHeader(def.entries[i][0], def.entries[i][1]));
     byteCount += hlist.back().bytes();
   }
   // initialize with a capacity that will exactly fit the static headers
@@ -124,11 +54,35 @@ StaticHeaderTable::StaticHeaderTable(
   for (auto& header : hlist) {
     add(std::move(header));
   }
+  if (kIsDebug) {
+    // The generated indexes agree with the table
+    for (uint32_t i = 1; i <= size_; ++i) {
+      const auto& header = getHeader(i);
+      DCHECK(header.name.isCommonHeader()) << header.name.get();
+      DCHECK_EQ(getIndex(header.name.getHeaderCode(), header.value),
+                getIndex(header));
+      DCHECK_EQ(nameIndex(header.name.getHeaderCode()),
+                nameIndex(header.name));
+    }
+  }
+}
+
+uint32_t StaticHeaderTable::getIndex(HTTPHeaderCode headerCode,
+                                     folly::StringPiece value) const {
+  for (auto i = def_.codeOffsets[headerCode];
+       i < def_.codeOffsets[headerCode + 1]; ++i) {
+    uint32_t index = def_.codeIndexes[i];
+    if (def_.valueLengths[index - 1] == value.size() &&
+        memcmp(def_.entries[index - 1][1], value.data(), value.size()) == 0) {
+      return index;
+    }
+  }
+  return 0;
 }
 
 const StaticHeaderTable& StaticHeaderTable::get() {
   static const folly::Indestructible<StaticHeaderTable> table(
-    s_tableEntries, kEntriesSize);
+    kHPACKStaticTable);
   return *table;
 }
 
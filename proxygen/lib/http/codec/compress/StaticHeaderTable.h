@@ -14,14 +14,53 @@
 
 namespace proxygen {
 
+/**
+ * A static table as generated into StaticHeaderTables.h by
+ * gen_StaticHeaderTables.h.sh, with the entries' indexes grouped by
+ * HTTPHeaderCode.
+ */
+struct StaticHeaderTableDef {
+  const char* const (*entries)[2];
+  uint32_t size;
+  // codeIndexes[codeOffsets[code]] up to codeIndexes[codeOffsets[code + 1]]
+  // are the indexes of the entries named code, in increasing order
+  const uint8_t* codeOffsets;
+  const uint8_t* codeIndexes;
+  // The length of each entry's value, by index - 1
+  const uint8_t* valueLengths;
+};
+
 class StaticHeaderTable : public HeaderTable {
 
  public:
-  explicit StaticHeaderTable(const char* entries[][2], int size);
+  explicit StaticHeaderTable(const StaticHeaderTableDef& def);
 
   static const StaticHeaderTable& get();
 
   static bool isHeaderCodeInTableWithNonEmptyValue(HTTPHeaderCode headerCode);
+
+  using HeaderTable::getIndex;
+  using HeaderTable::nameIndex;
+
+  /**
+   * Every entry is a common header, so these look entries up by code in the
+   * generated tables, with no hashing.
+   *
+   * @return 0 if not found
+   */
+  uint32_t getIndex(HTTPHeaderCode headerCode, folly::StringPiece value) const;
+
+  /**
+   * @return the first index with the given name, 0 if not found
+   */
+  uint32_t nameIndex(HTTPHeaderCode headerCode) const {
+    auto offset = def_.codeOffsets[headerCode];
+    return (offset < def_.codeOffsets[headerCode + 1]) ?
+      def_.codeIndexes[offset] : 0;
+  }
+
+ private:
+  const StaticHeaderTableDef def_;
 };
 
 }
@@ -57,6 +57,10 @@ class CompressionScheme : public folly::EventBase::LoopCallback {
   /* Return the number of times the decoder was head-of-line blocked */
   virtual uint32_t getHolBlockCount() const = 0;
 
+  /* Add the encoder's blocking and duplication counts to stats */
+  virtual void addEncoderStats(SimStats& /*stats*/) const {
+  }
+
   /* Loop callback simulates packet flushing once per loop*/
   void runLoopCallback() noexcept override;
 
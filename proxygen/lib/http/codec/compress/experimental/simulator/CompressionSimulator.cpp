@@ -83,6 +83,7 @@ void CompressionSimulator::run() {
   uint32_t holBlockCount = 0;
   for (auto& scheme : domains_) {
     holBlockCount += scheme.second->getHolBlockCount();
+    scheme.second->addEncoderStats(stats_);
   }
   LOG(INFO) << "Complete"
             << "\nStats:"
@@ -93,6 +94,9 @@ void CompressionSimulator::run() {
             << "\nPacket Losses: " << stats_.packetLosses
             << "\nHOL Block Count: " << holBlockCount
             << "\nHOL Delay (ms): " << stats_.holDelay.count()
+            << "\nVulnerable Blocks: " << stats_.vulnerableBlocks
+            << "\nDuplications: " << stats_.duplications
+            << "\nProactive Duplications: " << stats_.proactiveDuplications
             << "\nMax Queue Buffer Bytes: " << stats_.maxQueueBufferBytes
             << "\nUncompressed Bytes: " << stats_.uncompressed
             << "\nCompressed Bytes: " << stats_.compressed
@@ -273,11 +277,15 @@ unique_ptr<CompressionScheme> CompressionSimulator::makeScheme() {
   switch (params_.type) {
     case SchemeType::QPACK:
       return make_unique<QPACKScheme>(this, params_.tableSize,
-                                      params_.maxBlocking);
+                                      params_.maxBlocking,
+                                      params_.adaptiveIndexing,
+                                      params_.maxBlockingDelay,
+                                      params_.proactiveDuplication);
     case SchemeType::QMIN:
       return make_unique<QMINScheme>(this, params_.tableSize);
     case SchemeType::HPACK:
-      return make_unique<HPACKScheme>(this, params_.tableSize);
+      return make_unique<HPACKScheme>(this, params_.tableSize,
+                                      params_.adaptiveIndexing);
   }
   LOG(FATAL) << "Bad scheme";
   return nullptr;
@@ -37,6 +37,9 @@ struct SimParams {
   bool samePacketCompression;
   uint32_t tableSize;
   uint32_t maxBlocking;
+  bool adaptiveIndexing;
+  std::chrono::milliseconds maxBlockingDelay;
+  bool proactiveDuplication;
 };
 
 struct SimStats {
@@ -47,5 +50,8 @@ struct SimStats {
   uint64_t uncompressed{0};
   uint64_t compressed{0};
   uint64_t packets{0};
+  uint64_t vulnerableBlocks{0};
+  uint64_t duplications{0};
+  uint64_t proactiveDuplications{0};
 };
 }} // namespace proxygen::compress
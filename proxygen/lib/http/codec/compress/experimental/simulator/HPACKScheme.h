@@ -10,6 +10,7 @@
 #pragma once
 
 #include "proxygen/lib/http/codec/compress/experimental/simulator/CompressionScheme.h"
+#include <proxygen/lib/http/codec/compress/AdaptiveIndexingStrategy.h>
 #include <proxygen/lib/http/codec/compress/HPACKCodec.h>
 #include <proxygen/lib/http/codec/compress/HPACKQueue.h>
 #include <proxygen/lib/http/codec/compress/NoPathIndexingStrategy.h>
@@ -21,10 +22,15 @@ namespace proxygen { namespace compress {
  */
 class HPACKScheme : public CompressionScheme {
  public:
-  explicit HPACKScheme(CompressionSimulator* sim, uint32_t tableSize)
+  explicit HPACKScheme(CompressionSimulator* sim, uint32_t tableSize,
+                       bool adaptiveIndexing = false)
       : CompressionScheme(sim) {
     client_.setEncodeHeadroom(2);
-    client_.setHeaderIndexingStrategy(NoPathIndexingStrategy::getInstance());
+    if (adaptiveIndexing) {
+      client_.setHeaderIndexingStrategy(&adaptiveIndexingStrat_);
+    } else {
+      client_.setHeaderIndexingStrategy(NoPathIndexingStrategy::getInstance());
+    }
     server_.setHeaderIndexingStrategy(NoPathIndexingStrategy::getInstance());
     client_.setEncoderHeaderTableSize(tableSize);
     server_.setDecoderHeaderTableMaxSize(tableSize);
@@ -80,6 +86,8 @@ class HPACKScheme : public CompressionScheme {
     return serverQueue_.getHolBlockCount();
   }
 
+  // Learns :path too, which NoPathIndexingStrategy never indexes
+  AdaptiveIndexingStrategy adaptiveIndexingStrat_;
   HPACKCodec client_{TransportDirection::UPSTREAM};
   HPACKCodec server_{TransportDirection::DOWNSTREAM};
   HPACKQueue serverQueue_{server_};
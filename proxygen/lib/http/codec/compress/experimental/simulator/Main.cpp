@@ -29,6 +29,14 @@ DEFINE_int64(seed, 0, "RNG seed");
 DEFINE_bool(blend, true, "Blend all facebook.com and fbcdn.net domains");
 DEFINE_int32(max_blocking, 100,
              "Maximum number of vulnerable/blocking header blocks");
+DEFINE_bool(adaptive_indexing, false,
+            "Learn which headers to index with AdaptiveIndexingStrategy "
+            "instead of never indexing :path");
+DEFINE_int32(max_blocking_delay, 0,
+             "Stop sending QPACK blocks that could block once the estimated "
+             "ack delay exceeds this many ms, 0 for no limit");
+DEFINE_bool(proactive_duplication, false,
+            "Duplicate referenced QPACK entries before they start draining");
 DEFINE_bool(same_packet_compression,
             true,
             "Allow QPACK to compress across "
@@ -76,7 +84,10 @@ int main(int argc, char* argv[]) {
               FLAGS_blend,
               FLAGS_same_packet_compression,
               uint32_t(FLAGS_table_size),
-              uint32_t(FLAGS_max_blocking)};
+              uint32_t(FLAGS_max_blocking),
+              FLAGS_adaptive_indexing,
+              std::chrono::milliseconds(FLAGS_max_blocking_delay),
+              FLAGS_proactive_duplication};
   CompressionSimulator sim(p);
   if (sim.readInputFromFileAndSchedule(FLAGS_input)) {
     sim.run();
@@ -9,6 +9,7 @@
  */
 #pragma once
 
+#include <proxygen/lib/http/codec/compress/AdaptiveIndexingStrategy.h>
 #include <proxygen/lib/http/codec/compress/QPACKCodec.h>
 #include <proxygen/lib/http/codec/compress/NoPathIndexingStrategy.h>
 #include <proxygen/lib/http/codec/compress/experimental/simulator/CompressionScheme.h>
@@ -18,13 +19,22 @@ namespace proxygen { namespace compress {
 class QPACKScheme : public CompressionScheme {
  public:
   explicit QPACKScheme(CompressionSimulator* sim, uint32_t tableSize,
-                       uint32_t maxBlocking)
+                       uint32_t maxBlocking, bool adaptiveIndexing = false,
+                       std::chrono::milliseconds maxBlockingDelay =
+                         std::chrono::milliseconds(0),
+                       bool proactiveDuplication = false)
       : CompressionScheme(sim) {
-    client_.setHeaderIndexingStrategy(NoPathIndexingStrategy::getInstance());
+    if (adaptiveIndexing) {
+      client_.setHeaderIndexingStrategy(&adaptiveIndexingStrat_);
+    } else {
+      client_.setHeaderIndexingStrategy(NoPathIndexingStrategy::getInstance());
+    }
     server_.setHeaderIndexingStrategy(NoPathIndexingStrategy::getInstance());
     client_.setEncoderHeaderTableSize(tableSize);
     server_.setDecoderHeaderTableMaxSize(tableSize);
     client_.setMaxVulnerable(maxBlocking);
+    client_.setMaxBlockingDelay(maxBlockingDelay);
+    client_.setProactiveDuplication(proactiveDuplication);
     server_.setMaxBlocking(maxBlocking);
   }
 
@@ -165,6 +175,15 @@ class QPACKScheme : public CompressionScheme {
     return server_.getHolBlockCount();
   }
 
+  void addEncoderStats(SimStats& stats) const override {
+    const auto& blockingStats = client_.getBlockingStats();
+    stats.vulnerableBlocks += blockingStats.vulnerableBlocks;
+    stats.duplications += blockingStats.duplications;
+    stats.proactiveDuplications += blockingStats.proactiveDuplications;
+  }
+
+  // Learns :path too, which NoPathIndexingStrategy never indexes
+  AdaptiveIndexingStrategy adaptiveIndexingStrat_;
   QPACKCodec client_;
   QPACKCodec server_;
   std::map<uint16_t, std::unique_ptr<folly::IOBuf>> controlQueue_;
@@ -358,6 +358,32 @@ TEST_F(HPACKBufferTests, DecodePlainLiteralN) {
   CHECK_EQ(literal, gzip);
 }
 
+TEST_F(HPACKBufferTests, DecodeLiteralView) {
+  buf_ = IOBuf::create(512);
+  std::string gzip("gzip");
+  uint8_t* wdata = buf_->writableData();
+  // a plain literal followed by the Huffman coding of "gzip"
+  buf_->append(1 + gzip.size() + 4);
+  wdata[0] = gzip.size();
+  memcpy(wdata + 1, gzip.c_str(), gzip.size());
+  std::array<uint8_t, 4> huffman{0x83, 0x9b, 0xd9, 0xab};
+  memcpy(wdata + 1 + gzip.size(), huffman.data(), huffman.size());
+
+  resetDecoder();
+  folly::fbstring scratch;
+  folly::StringPiece literal;
+  EXPECT_EQ(decoder_.decodeLiteral(scratch, literal), DecodeError::NONE);
+  EXPECT_EQ(literal, gzip);
+  // not copied
+  EXPECT_EQ(literal.data(), (const char*)wdata + 1);
+  EXPECT_TRUE(scratch.empty());
+
+  EXPECT_EQ(decoder_.decodeLiteral(scratch, literal), DecodeError::NONE);
+  EXPECT_EQ(literal, gzip);
+  EXPECT_EQ(literal.data(), scratch.data());
+  EXPECT_TRUE(decoder_.empty());
+}
+
 TEST_F(HPACKBufferTests, IntegerEncodeDecode) {
   HPACKEncodeBuffer encoder(512);
   // first encode
@@ -12,6 +12,7 @@
 #include <folly/io/IOBuf.h>
 #include <glog/logging.h>
 #include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/CodecUtil.h>
 #include <proxygen/lib/http/codec/compress/HPACKCodec.h>
 #include <proxygen/lib/http/codec/compress/HPACKQueue.h>
 #include <proxygen/lib/http/codec/compress/Header.h>
@@ -158,6 +159,46 @@ TEST_F(HPACKCodecTests, MultivalueHeaders) {
   EXPECT_EQ(count, 2);
 }
 
+/**
+ * the decoder passes the code of each name, whether it came from a table or
+ * a literal
+ */
+TEST_F(HPACKCodecTests, HeaderViewCodes) {
+  class CodeCallback : public TestStreamingCallback {
+   public:
+    void onHeaderView(HTTPHeaderCode code,
+                      StringPiece name,
+                      StringPiece value) override {
+      codes.push_back(code);
+      TestStreamingCallback::onHeaderView(code, name, value);
+    }
+    std::vector<HTTPHeaderCode> codes;
+  };
+  vector<vector<string>> headers = {
+    {":method", "GET"},
+    {"content-type", "text/html"},
+    {"X-FB-Debug", "bleah"},
+    {"Accept-Encoding", "gzip"}
+  };
+  vector<HTTPHeaderCode> expected = {
+    HTTP_HEADER_COLON_METHOD, HTTP_HEADER_CONTENT_TYPE, HTTP_HEADER_OTHER,
+    HTTP_HEADER_ACCEPT_ENCODING
+  };
+  vector<Header> req = headersFromArray(headers);
+  for (int i = 0; i < 2; i++) {
+    // literals the first time, indexed the second
+    unique_ptr<IOBuf> encoded = client.encode(req);
+    Cursor cursor(encoded.get());
+    CodeCallback cb;
+    server.decodeStreaming(cursor, cursor.totalLength(), &cb);
+    EXPECT_FALSE(cb.hasError());
+    EXPECT_EQ(cb.codes, expected);
+    CHECK_EQ(cb.headers.size(), 8);
+    EXPECT_EQ(cb.headers[4].str, "x-fb-debug");
+    EXPECT_EQ(cb.headers[7].str, "gzip");
+  }
+}
+
 /**
  * test that we're propagating the error correctly in the decoder
  */
@@ -296,6 +337,48 @@ TEST_F(HPACKCodecTests, DefaultHeaderIndexingStrategy) {
 }
 
 
+TEST_F(HPACKCodecTests, EncodeHTTPMessage) {
+  HTTPMessage req;
+  req.setMethod(HTTPMethod::GET);
+  req.setURL("/index.html");
+  req.setSecure(true);
+  req.getHeaders().add(HTTP_HEADER_HOST, "www.facebook.com");
+  req.getHeaders().add(HTTP_HEADER_CONNECTION, "keep-alive");
+  req.getHeaders().add(HTTP_HEADER_ACCEPT_ENCODING, "gzip, deflate");
+  req.getHeaders().add(HTTP_HEADER_COOKIE, string(100, 'c'));
+  req.getHeaders().add("X-Custom-Header", "custom value");
+  HTTPMessage resp;
+  resp.setStatusCode(200);
+  resp.getHeaders().add(HTTP_HEADER_DATE, "Tue, 15 Nov 1994 08:12:31 GMT");
+  resp.getHeaders().add(HTTP_HEADER_CONTENT_TYPE, "text/html");
+  resp.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH, "1234");
+  HTTPHeaders trailers;
+  trailers.add("X-Trailer", "done");
+
+  // The direct path matches encoding the prepared vector, including the
+  // dynamic table state it leaves behind
+  for (auto i = 0; i < 3; i++) {
+    for (auto msg : {&req, &resp}) {
+      std::vector<std::string> temps;
+      auto allHeaders = CodecUtil::prepareMessageForCompression(*msg, temps);
+      auto expected = client.encode(allHeaders);
+      auto expectedSize = client.getEncodedSize();
+      auto encoded = server.encodeHTTPMessage(*msg);
+      EXPECT_TRUE(IOBufEqualTo()(expected, encoded));
+      EXPECT_EQ(server.getEncodedSize().uncompressed,
+                expectedSize.uncompressed);
+      EXPECT_EQ(server.getEncodedSize().compressed, expectedSize.compressed);
+    }
+    vector<Header> allTrailers;
+    CodecUtil::appendHeaders(trailers, allTrailers, HTTP_HEADER_NONE);
+    auto expected = client.encode(allTrailers);
+    EXPECT_TRUE(IOBufEqualTo()(expected, server.encodeTrailers(trailers)));
+  }
+  EXPECT_EQ(client.getCompressionInfo().egressHeadersStored_,
+            server.getCompressionInfo().egressHeadersStored_);
+}
+
+
 class HPACKQueueTests : public testing::TestWithParam<int> {
  public:
   HPACKQueueTests()
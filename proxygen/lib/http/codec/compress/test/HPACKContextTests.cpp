@@ -16,6 +16,7 @@
 #include <proxygen/lib/http/codec/compress/HPACKEncoder.h>
 #include <proxygen/lib/http/codec/compress/QPACKDecoder.h>
 #include <proxygen/lib/http/codec/compress/QPACKEncoder.h>
+#include <proxygen/lib/http/codec/compress/QPACKStaticHeaderTable.h>
 #include <proxygen/lib/http/codec/compress/Logging.h>
 #include <proxygen/lib/http/codec/compress/test/TestUtil.h>
 
@@ -84,6 +85,26 @@ TEST_F(HPACKContextTests, StaticTableHeaderNamesAreCommon) {
   }
 }
 
+TEST_F(HPACKContextTests, StaticTableCodeIndexes) {
+  for (auto table : {&StaticHeaderTable::get(),
+                     &QPACKStaticHeaderTable::get()}) {
+    for (uint32_t i = 1; i <= table->size(); ++i) {
+      const HPACKHeader& header = table->getHeader(i);
+      auto code = header.name.getHeaderCode();
+      EXPECT_EQ(table->getIndex(code, header.value), table->getIndex(header));
+      EXPECT_EQ(table->nameIndex(code), table->nameIndex(header.name));
+    }
+    EXPECT_EQ(table->getIndex(HTTP_HEADER_COLON_METHOD, "PATCH"), 0);
+    EXPECT_EQ(table->getIndex(HTTP_HEADER_COLON_PATH, "/index"), 0);
+    EXPECT_EQ(table->getIndex(HTTP_HEADER_CONNECTION, ""), 0);
+    EXPECT_EQ(table->nameIndex(HTTP_HEADER_CONNECTION), 0);
+  }
+  EXPECT_EQ(StaticHeaderTable::get().getIndex(HTTP_HEADER_COLON_METHOD,
+                                              "POST"), 3);
+  EXPECT_EQ(QPACKStaticHeaderTable::get().getIndex(HTTP_HEADER_CONTENT_TYPE,
+                                                   "text/plain"), 54);
+}
+
 TEST_F(HPACKContextTests,
        static_table_is_header_code_in_table_with_non_empty_value) {
   auto& table = StaticHeaderTable::get();
@@ -7,11 +7,13 @@
  *  of patent rights can be found in the PATENTS file in the same directory.
  *
  */
+#include <folly/Conv.h>
 #include <folly/portability/GTest.h>
 #include <proxygen/lib/http/codec/compress/HPACKHeader.h>
 
 #include <glog/logging.h>
 
+#include <proxygen/lib/http/codec/compress/AdaptiveIndexingStrategy.h>
 #include <proxygen/lib/http/codec/compress/HeaderIndexingStrategy.h>
 #include <sstream>
 
@@ -68,6 +70,34 @@ TEST_F(HPACKHeaderTests, HeaderIndexingStrategyBasic) {
   EXPECT_TRUE(indexingStrat.indexHeader(data));
 }
 
+TEST_F(HPACKHeaderTests, AdaptiveIndexingStrategy) {
+  AdaptiveIndexingStrategy indexingStrat;
+  HPACKHeaderName requestId("x-request-id");
+  HPACKHeaderName userAgent(HTTP_HEADER_USER_AGENT);
+  // Everything is indexed while learning
+  EXPECT_EQ(indexingStrat.getRepeatRatio(requestId), -1);
+  for (int i = 0; i < 64; i++) {
+    EXPECT_TRUE(indexingStrat.indexHeader(requestId, folly::to<string>(i)));
+    EXPECT_TRUE(indexingStrat.indexHeader(userAgent, "agent"));
+  }
+  EXPECT_LT(indexingStrat.getRepeatRatio(requestId), 0.25);
+  EXPECT_GT(indexingStrat.getRepeatRatio(userAgent), 0.9);
+  EXPECT_FALSE(indexingStrat.indexHeader(requestId, "64"));
+  EXPECT_TRUE(indexingStrat.indexHeader(userAgent, "agent"));
+
+  // Relearns once values start repeating
+  for (int i = 0; i < 64 * 3; i++) {
+    indexingStrat.indexHeader(requestId, folly::to<string>(i % 4));
+  }
+  EXPECT_TRUE(indexingStrat.indexHeader(requestId, "0"));
+
+  // The base strategy still applies
+  HPACKHeader clen("content-length", "512");
+  for (int i = 0; i < 64; i++) {
+    EXPECT_FALSE(indexingStrat.indexHeader(clen));
+  }
+}
+
 class HPACKHeaderNameTest : public testing::Test {
 };
 
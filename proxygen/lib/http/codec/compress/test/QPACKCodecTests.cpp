@@ -12,6 +12,7 @@
 #include <folly/io/IOBuf.h>
 #include <glog/logging.h>
 #include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/CodecUtil.h>
 #include <proxygen/lib/http/codec/compress/Header.h>
 #include <proxygen/lib/http/codec/compress/HeaderCodec.h>
 #include <proxygen/lib/http/codec/compress/QPACKCodec.h>
@@ -93,6 +94,44 @@ TEST_F(QPACKTests, TestSimple) {
   EXPECT_GT(server.getCompressionInfo().ingressHeadersStored_, 0);
 }
 
+TEST_F(QPACKTests, TestEncodeHTTPMessage) {
+  EXPECT_TRUE(client.setEncoderHeaderTableSize(4096));
+  QPACKCodec direct;
+  EXPECT_TRUE(direct.setEncoderHeaderTableSize(4096));
+  HTTPMessage req;
+  req.setMethod(HTTPMethod::POST);
+  req.setURL("/upload");
+  req.getHeaders().add(HTTP_HEADER_HOST, "www.facebook.com");
+  req.getHeaders().add(HTTP_HEADER_TRANSFER_ENCODING, "chunked");
+  req.getHeaders().add(HTTP_HEADER_CONTENT_TYPE, "application/json");
+  req.getHeaders().add(HTTP_HEADER_USER_AGENT, "proxygen");
+  req.getHeaders().add("X-Custom-Header", "custom value");
+
+  // The direct path matches encoding the prepared vector, including what it
+  // inserts and references
+  for (uint64_t streamId = 1; streamId < 4; streamId++) {
+    std::vector<std::string> temps;
+    auto allHeaders = CodecUtil::prepareMessageForCompression(req, temps);
+    auto expected = client.encode(allHeaders, streamId);
+    auto encoded = direct.encodeHTTPMessage(req, streamId);
+    EXPECT_TRUE(IOBufEqualTo()(expected.control, encoded.control));
+    EXPECT_TRUE(IOBufEqualTo()(expected.stream, encoded.stream));
+    EXPECT_EQ(direct.getEncodedSize().uncompressed,
+              client.getEncodedSize().uncompressed);
+
+    TestStreamingCallback cb;
+    if (encoded.control) {
+      EXPECT_EQ(server.decodeEncoderStream(std::move(encoded.control)),
+                HPACK::DecodeError::NONE);
+    }
+    auto length = encoded.stream->computeChainDataLength();
+    server.decodeStreaming(streamId, std::move(encoded.stream), length, &cb);
+    auto result = cb.getResult();
+    ASSERT_FALSE(result.hasError());
+    headersEq(allHeaders, result->headers);
+  }
+}
+
 TEST_F(QPACKTests, TestAbsoluteIndex) {
   EXPECT_TRUE(client.setEncoderHeaderTableSize(4096));
   int flights = 10;
@@ -12,6 +12,7 @@
 #include <folly/portability/GTest.h>
 #include <folly/Format.h>
 #include <memory>
+#include <thread>
 #include <proxygen/lib/http/codec/compress/QPACKDecoder.h>
 #include <proxygen/lib/http/codec/compress/QPACKEncoder.h>
 #include <proxygen/lib/http/codec/compress/Logging.h>
@@ -347,6 +348,84 @@ TEST(QPACKContextTests, TestDuplicate) {
   verifyDecode(decoder, std::move(result), req);
 }
 
+TEST(QPACKContextTests, TestProactiveDuplicate) {
+  QPACKEncoder encoder(false, 200);
+  QPACKDecoder decoder(200);
+  encoder.setProactiveDuplication(true);
+  vector<HPACKHeader> req;
+  // 4 inserts, a=0 and b=1 are the next to drain
+  for (auto i = 0; i < 4; i++) {
+    req.emplace_back(folly::to<string>('a' + i), folly::to<string>(i));
+  }
+  auto result = encoder.encode(req, 0, 1);
+  verifyDecode(decoder, std::move(result), req);
+  EXPECT_EQ(encoder.onInsertCountIncrement(4), HPACK::DecodeError::NONE);
+  EXPECT_EQ(headerAck(decoder, encoder, 1), HPACK::DecodeError::NONE);
+
+  // References the acknowledged a=0, and duplicates it
+  req.erase(req.begin() + 1, req.end());
+  result = encoder.encode(req, 0, 2);
+  EXPECT_EQ(result.control->computeChainDataLength(), 1);
+  EXPECT_EQ(result.stream->computeChainDataLength(), 3);
+  verifyDecode(decoder, std::move(result), req);
+  EXPECT_EQ(encoder.getBlockingStats().proactiveDuplications, 1);
+
+  // The copy is not about to drain
+  result = encoder.encode(req, 0, 3);
+  EXPECT_EQ(result.control, nullptr);
+  verifyDecode(decoder, std::move(result), req);
+  EXPECT_EQ(encoder.getBlockingStats().proactiveDuplications, 1);
+  EXPECT_EQ(encoder.getBlockingStats().duplications, 0);
+}
+
+TEST(QPACKContextTests, TestLatencySensitive) {
+  QPACKEncoder encoder(false, 200);
+  QPACKDecoder decoder(200);
+  vector<HPACKHeader> req;
+  req.emplace_back("Blarf", "Blah");
+  auto result = encoder.encode(req, 0, 1);
+  verifyDecode(decoder, std::move(result), req);
+
+  // Blarf: Blah is unacknowledged -> literal
+  result = encoder.encode(req, 0, 2, std::numeric_limits<uint32_t>::max(),
+                          true /* latencySensitive */);
+  EXPECT_EQ(result.control, nullptr);
+  EXPECT_TRUE(stringInOutput(result.stream.get(), "blarf"));
+  verifyDecode(decoder, std::move(result), req);
+  EXPECT_EQ(encoder.getBlockingStats().blocks, 2);
+  EXPECT_EQ(encoder.getBlockingStats().vulnerableBlocks, 1);
+
+  EXPECT_EQ(encoder.onInsertCountIncrement(1), HPACK::DecodeError::NONE);
+  result = encoder.encode(req, 0, 3, std::numeric_limits<uint32_t>::max(),
+                          true /* latencySensitive */);
+  EXPECT_EQ(result.stream->computeChainDataLength(), 3);
+  verifyDecode(decoder, std::move(result), req);
+}
+
+TEST(QPACKContextTests, TestMaxBlockingDelay) {
+  QPACKEncoder encoder(false, 200);
+  QPACKDecoder decoder(200);
+  encoder.setMaxBlockingDelay(std::chrono::milliseconds(1));
+  EXPECT_EQ(encoder.getAckDelayEstimate().count(), 0);
+  vector<HPACKHeader> req;
+  req.emplace_back("Blarf", "Blah");
+  auto result = encoder.encode(req, 0, 1);
+  verifyDecode(decoder, std::move(result), req);
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_EQ(headerAck(decoder, encoder, 1), HPACK::DecodeError::NONE);
+  EXPECT_GE(encoder.getAckDelayEstimate(), std::chrono::milliseconds(5));
+
+  // Acks are too slow to block on: inserted, but encoded as a literal
+  req.clear();
+  req.emplace_back("Foo", "Bar");
+  result = encoder.encode(req, 0, 2);
+  EXPECT_GT(result.control->computeChainDataLength(), 1);
+  EXPECT_TRUE(stringInOutput(result.stream.get(), "foo"));
+  verifyDecode(decoder, std::move(result), req);
+  EXPECT_EQ(encoder.getBlockingStats().vulnerableBlocks, 1);
+}
+
 TEST(QPACKContextTests, TestTableSizeUpdate) {
   QPACKEncoder encoder(false, 100);
   QPACKDecoder decoder(200);
@@ -598,6 +677,94 @@ TEST(QPACKContextTests, TestDecodeQueueResetSelf) {
             HPACK::DecodeError::NONE);
 }
 
+TEST(QPACKContextTests, TestDecodeQueueCancelOther) {
+  // cb1 cancels stream 2, which is blocked on the same insert, and frees its
+  // callback, like a session aborting the stream would
+  QPACKEncoder encoder(true, 100);
+  QPACKDecoder decoder(100);
+
+  vector<HPACKHeader> req;
+  req.emplace_back("Blarf", "Blah");
+  auto result1 = encoder.encode(req, 0, 1);
+  auto result2 = encoder.encode(req, 0, 2);
+
+  auto cb2 = std::make_unique<TestStreamingCallback>();
+  TestStreamingCallback cb1;
+  cb1.headersCompleteCb = [&] {
+    decoder.encodeCancelStream(2);
+    cb2.reset();
+  };
+  auto length = result1.stream->computeChainDataLength();
+  decoder.decodeStreaming(1, std::move(result1.stream), length, &cb1);
+  length = result2.stream->computeChainDataLength();
+  decoder.decodeStreaming(2, std::move(result2.stream), length, cb2.get());
+  EXPECT_GT(decoder.getQueuedBytes(), 0);
+
+  EXPECT_EQ(decoder.decodeEncoderStream(std::move(result1.control)),
+            HPACK::DecodeError::NONE);
+  EXPECT_EQ(cb1.error, HPACK::DecodeError::NONE);
+  ASSERT_EQ(cb1.headers.size(), 2);
+  EXPECT_EQ(cb2, nullptr);
+  EXPECT_EQ(decoder.getQueuedBytes(), 0);
+  const auto& stats = decoder.getQueueStats();
+  EXPECT_EQ(stats.unblocked, 1);
+  EXPECT_EQ(stats.cancelled, 1);
+}
+
+TEST(QPACKContextTests, TestDecodeQueueBudget) {
+  QPACKEncoder encoder(true, 100);
+  QPACKDecoder decoder(100);
+  decoder.setMaxQueuedBytes(1);
+
+  vector<HPACKHeader> req1;
+  req1.emplace_back("Blarf", "Blah");
+  auto result1 = encoder.encode(req1, 0, 1);
+
+  vector<HPACKHeader> req2;
+  req2.emplace_back("Blarf", "Blerg");
+  auto result2 = encoder.encode(req2, 0, 2);
+
+  // Decode #1, no control stream, queued
+  TestStreamingCallback cb1;
+  auto length = result1.stream->computeChainDataLength();
+  decoder.decodeStreaming(1, std::move(result1.stream), length, &cb1);
+  EXPECT_EQ(decoder.getQueuedBytes(), 1);
+
+  // Decode #2 would go over the budget
+  TestStreamingCallback cb2;
+  length = result2.stream->computeChainDataLength();
+  decoder.decodeStreaming(2, result2.stream->clone(), length, &cb2);
+  EXPECT_EQ(cb2.error, HPACK::DecodeError::TOO_MANY_BLOCKING);
+
+  // Cancelling #1 frees its bytes, so #2 can be queued
+  decoder.encodeCancelStream(1);
+  EXPECT_EQ(decoder.getQueuedBytes(), 0);
+  TestStreamingCallback cb3;
+  decoder.decodeStreaming(2, std::move(result2.stream), length, &cb3);
+  EXPECT_EQ(decoder.getQueuedBytes(), 1);
+
+  // The first insert doesn't unblock #2
+  EXPECT_EQ(decoder.decodeEncoderStream(std::move(result1.control)),
+            HPACK::DecodeError::NONE);
+  EXPECT_EQ(decoder.getQueuedBytes(), 1);
+  EXPECT_EQ(cb3.headers.size(), 0);
+  EXPECT_EQ(decoder.decodeEncoderStream(std::move(result2.control)),
+            HPACK::DecodeError::NONE);
+  EXPECT_EQ(decoder.getQueuedBytes(), 0);
+  EXPECT_EQ(cb3.error, HPACK::DecodeError::NONE);
+  ASSERT_EQ(cb3.headers.size(), 2);
+  EXPECT_EQ(cb3.headers[1].str, "Blerg");
+  EXPECT_EQ(cb1.headers.size(), 0);
+
+  const auto& stats = decoder.getQueueStats();
+  EXPECT_EQ(decoder.getHolBlockCount(), 2);
+  EXPECT_EQ(stats.rejected, 1);
+  EXPECT_EQ(stats.cancelled, 1);
+  EXPECT_EQ(stats.unblocked, 1);
+  EXPECT_EQ(stats.maxQueuedBytes, 1);
+  EXPECT_LE(stats.maxBlockedTime, stats.totalBlockedTime);
+}
+
 TEST(QPACKContextTests, TestDecodeMaxUncompressed) {
   QPACKEncoder encoder(false, 64);
   QPACKDecoder decoder(64);
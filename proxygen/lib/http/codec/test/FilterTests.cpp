@@ -29,6 +29,12 @@ class MockFlowControlCallback: public FlowControlFilter::Callback {
  public:
   MOCK_METHOD0(onConnectionSendWindowOpen, void());
   MOCK_METHOD0(onConnectionSendWindowClosed, void());
+
+  std::chrono::microseconds getRTT() const noexcept override {
+    return rtt;
+  }
+
+  std::chrono::microseconds rtt{0};
 };
 
 class FilterTest : public testing::Test {
@@ -49,6 +55,18 @@ class FilterTest : public testing::Test {
   folly::IOBufQueue writeBuf_{folly::IOBufQueue::cacheChainLength()};
 };
 
+// Only intercepts onHeadersComplete, like filters written before batching
+class HeadersCountingFilter: public PassThroughHTTPCodecFilter {
+ public:
+  void onHeadersComplete(StreamID stream,
+                         std::unique_ptr<HTTPMessage> msg) override {
+    headersComplete++;
+    callback_->onHeadersComplete(stream, std::move(msg));
+  }
+
+  size_t headersComplete{0};
+};
+
 class HTTPChecksTest: public FilterTest {
  public:
   void SetUp() override {
@@ -151,6 +169,56 @@ TEST_F(DefaultFlowControl, SendUpdate) {
   filter_->ingressBytesProcessed(writeBuf_, 1);
 }
 
+TEST_F(DefaultFlowControl, DeferredWindowUpdate) {
+  filter_->setDeferWindowUpdates(true);
+  InSequence enforceSequence;
+  EXPECT_CALL(callback_, onBody(_, _, _))
+    .WillRepeatedly(Return());
+  const uint32_t half = kInitialCapacity / 2 + 1;
+
+  // Crossing the threshold twice produces a single merged update on flush
+  callbackStart_->onBody(1, makeBuf(half), 0);
+  EXPECT_TRUE(filter_->ingressBytesProcessed(writeBuf_, half));
+  callbackStart_->onBody(1, makeBuf(half), 0);
+  EXPECT_TRUE(filter_->ingressBytesProcessed(writeBuf_, half));
+  EXPECT_TRUE(filter_->hasPendingWindowUpdate());
+
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 0, half * 2))
+    .WillOnce(Return(13));
+  EXPECT_EQ(filter_->flushWindowUpdate(writeBuf_), 13);
+  EXPECT_FALSE(filter_->hasPendingWindowUpdate());
+  EXPECT_EQ(filter_->flushWindowUpdate(writeBuf_), 0);
+}
+
+TEST_F(DefaultFlowControl, AutoTuneReceiveWindow) {
+  flowCallback_.rtt = std::chrono::seconds(10);
+  filter_->setReceiveWindowTuning(kInitialCapacity * 4);
+  InSequence enforceSequence;
+  EXPECT_CALL(callback_, onBody(_, _, _))
+    .WillRepeatedly(Return());
+  const uint32_t half = kInitialCapacity / 2 + 1;
+
+  // The first update only starts the clock
+  callbackStart_->onBody(1, makeBuf(half), 0);
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 0, half));
+  filter_->ingressBytesProcessed(writeBuf_, half);
+  EXPECT_EQ(filter_->getReceiveWindowCapacity(), kInitialCapacity);
+
+  // Half the window was consumed again well within 2 RTTs, so it doubles
+  callbackStart_->onBody(1, makeBuf(half), 0);
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 0, half + kInitialCapacity));
+  filter_->ingressBytesProcessed(writeBuf_, half);
+  EXPECT_EQ(filter_->getReceiveWindowCapacity(), kInitialCapacity * 2);
+
+  // Lowering the limit shrinks the window by withholding credit
+  filter_->setReceiveWindowTuning(kInitialCapacity);
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity + 1), 0);
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 0, 1));
+  filter_->ingressBytesProcessed(writeBuf_, kInitialCapacity + 1);
+  EXPECT_EQ(filter_->getReceiveWindowCapacity(), kInitialCapacity);
+  ASSERT_TRUE(chain_->isReusable());
+}
+
 TEST_F(BigWindow, RecvTooMuch) {
   // Constructing the filter with a large capacity causes a WINDOW_UPDATE
   // for stream zero to be generated
@@ -212,6 +280,23 @@ TEST_F(BigWindow, RemoteIncrease) {
   ASSERT_FALSE(chain_->isReusable());
 }
 
+TEST_F(FilterTest, PassThroughReplaysHeadersBatch) {
+  auto filter = new HeadersCountingFilter();
+  chain_.addFilters(std::unique_ptr<HeadersCountingFilter>(filter));
+
+  std::vector<HTTPCodec::IngressHeaders> batch;
+  batch.push_back({1, makeGetRequest(), true});
+  batch.push_back({3, makePostRequest(), false});
+  InSequence seq;
+  EXPECT_CALL(callback_, onMessageBegin(1, _));
+  EXPECT_CALL(callback_, onHeadersComplete(1, _));
+  EXPECT_CALL(callback_, onMessageComplete(1, false));
+  EXPECT_CALL(callback_, onMessageBegin(3, _));
+  EXPECT_CALL(callback_, onHeadersComplete(3, _));
+  callbackStart_->onHeadersBatch(batch);
+  EXPECT_EQ(filter->headersComplete, 2);
+}
+
 TEST_F(HTTPChecksTest, SendTraceBodyDeath) {
   // It is NOT allowed to send a TRACE with a body.
 
@@ -0,0 +1,380 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/codec/HQStreamCodec.h>
+#include <proxygen/lib/http/codec/HQUnidirectionalCodec.h>
+#include <proxygen/lib/http/codec/HTTP1xCodec.h>
+#include <proxygen/lib/http/codec/HTTP2Codec.h>
+#include <proxygen/lib/http/codec/QPACKDecoderCodec.h>
+#include <proxygen/lib/http/codec/QPACKEncoderCodec.h>
+#include <proxygen/lib/http/codec/compress/test/HTTPArchive.h>
+#include <proxygen/lib/test/AllocationCounter.h>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/portability/GFlags.h>
+
+#include <iostream>
+#include <limits>
+
+/**
+ * Replays the exchanges of a HAR file through each codec end to end: the
+ * upstream codec generates a request, the downstream codec parses it with
+ * onIngress and generates the response, which the upstream codec parses.
+ * Codec state, including the header compression tables, lives for the whole
+ * run as it would on one long lived connection.
+ *
+ * The benchmarks report time per exchange.  Before them a table of bytes on
+ * the wire and heap allocations per exchange is printed, measured over a
+ * second pass of the corpus so the compression tables are warm.
+ *
+ *   HARReplayBenchmark --har=path/to/capture.har
+ */
+
+DEFINE_string(har, "", "HAR file to replay");
+DEFINE_bool(public_har, false, "The HAR file is in the public test format");
+
+using namespace folly;
+using namespace proxygen;
+
+namespace {
+
+constexpr uint32_t kTableSize = 4096;
+
+struct Exchange {
+  HTTPMessage request;
+  HTTPMessage response;
+};
+
+std::vector<Exchange> corpus;
+
+bool isConnectionSpecific(HTTPHeaderCode code, const std::string& name) {
+  switch (code) {
+    case HTTP_HEADER_CONNECTION:
+    case HTTP_HEADER_CONTENT_LENGTH:
+    case HTTP_HEADER_EXPECT:
+    case HTTP_HEADER_KEEP_ALIVE:
+    case HTTP_HEADER_PROXY_CONNECTION:
+    case HTTP_HEADER_TE:
+    case HTTP_HEADER_TRANSFER_ENCODING:
+    case HTTP_HEADER_UPGRADE:
+      return true;
+    default:
+      return name == "http2-settings";
+  }
+}
+
+/**
+ * Rebuilds a captured message so every codec can carry it: pseudo headers
+ * (found in public HARs) become message fields, headers that describe the
+ * connection or a body are dropped, and bodies are left out.
+ */
+HTTPMessage normalize(const HTTPMessage& in, bool request) {
+  HTTPMessage out;
+  out.setHTTPVersion(1, 1);
+  if (request) {
+    out.setMethod(in.isRequest() ? in.getMethodString() : "GET");
+    std::string url = in.isRequest() ? in.getPath() : "/";
+    if (in.isRequest() && !in.getQueryString().empty()) {
+      url += "?" + in.getQueryString();
+    }
+    out.setURL(url.empty() ? "/" : url);
+  } else {
+    out.setStatusCode(in.isResponse() && in.getStatusCode() >= 200 ?
+                      in.getStatusCode() : 200);
+    out.setStatusMessage("OK");
+  }
+  in.getHeaders().forEachWithCode(
+    [&] (HTTPHeaderCode code, const std::string& name,
+         const std::string& value) {
+      if (name.empty() || isConnectionSpecific(code, name)) {
+        return;
+      }
+      if (name[0] != ':') {
+        out.getHeaders().add(name, value);
+      } else if (name == ":method") {
+        out.setMethod(value);
+      } else if (name == ":path") {
+        out.setURL(value);
+      } else if (name == ":authority") {
+        out.getHeaders().set(HTTP_HEADER_HOST, value);
+      } else if (name == ":status") {
+        out.setStatusCode(folly::to<uint16_t>(value));
+      }
+    });
+  if (request && !out.getHeaders().exists(HTTP_HEADER_HOST)) {
+    out.getHeaders().add(HTTP_HEADER_HOST, "localhost");
+  }
+  if (!request) {
+    out.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH, "0");
+  }
+  return out;
+}
+
+std::vector<Exchange> loadCorpus() {
+  CHECK(!FLAGS_har.empty()) << "--har is required";
+  auto har = FLAGS_public_har ? HTTPArchive::fromPublicFile(FLAGS_har) :
+    HTTPArchive::fromFile(FLAGS_har);
+  CHECK(har && !har->requests.empty()) << "no requests in " << FLAGS_har;
+  // HTTPArchive drops entries without headers, so requests and responses
+  // don't always line up; public HARs have no responses at all
+  std::vector<Exchange> exchanges;
+  HTTPMessage emptyResponse;
+  for (size_t i = 0; i < har->requests.size(); i++) {
+    const auto& response = har->responses.empty() ? emptyResponse :
+      har->responses[i % har->responses.size()];
+    exchanges.push_back({normalize(har->requests[i], true),
+                         normalize(response, false)});
+  }
+  return exchanges;
+}
+
+class ReplayCallback
+    : public HTTPCodec::Callback,
+      public HQUnidirectionalCodec::Callback {
+ public:
+  void onMessageBegin(HTTPCodec::StreamID stream, HTTPMessage*) override {
+    lastStream = stream;
+  }
+  void onHeadersComplete(HTTPCodec::StreamID,
+                         std::unique_ptr<HTTPMessage>) override {}
+  void onBody(HTTPCodec::StreamID,
+              std::unique_ptr<IOBuf>,
+              uint16_t) override {}
+  void onTrailersComplete(HTTPCodec::StreamID,
+                          std::unique_ptr<HTTPHeaders>) override {}
+  void onMessageComplete(HTTPCodec::StreamID, bool) override {
+    messages++;
+  }
+  void onError(HTTPCodec::StreamID,
+               const HTTPException& error,
+               bool) override {
+    VLOG(4) << "parse error: " << error.what();
+    errors++;
+  }
+
+  HTTPCodec::StreamID lastStream{0};
+  uint64_t messages{0};
+  uint64_t errors{0};
+};
+
+/**
+ * The two ends of one connection.
+ */
+class CodecPair {
+ public:
+  virtual ~CodecPair() {}
+
+  // Returns the bytes written by both ends
+  virtual size_t replay(const Exchange& exchange) = 0;
+
+  uint64_t getErrors() const {
+    return upstreamCallback_.errors + downstreamCallback_.errors;
+  }
+
+  uint64_t getMessages() const {
+    return upstreamCallback_.messages + downstreamCallback_.messages;
+  }
+
+ protected:
+  // Hands everything written so far to codec, returns the bytes delivered
+  size_t deliver(HTTPCodec& codec, ReplayCallback& callback) {
+    size_t length = wire_.chainLength();
+    if (length > 0) {
+      wire_.trimStart(codec.onIngress(*wire_.front()));
+      if (!wire_.empty()) {
+        // The parser stalled, don't let the leftovers corrupt the next
+        // exchange
+        callback.errors++;
+        wire_.move();
+      }
+    }
+    return length;
+  }
+
+  ReplayCallback upstreamCallback_;
+  ReplayCallback downstreamCallback_;
+  IOBufQueue wire_{IOBufQueue::cacheChainLength()};
+};
+
+/**
+ * HTTP/1.1 and HTTP/2, where one codec serves the whole connection.
+ */
+template <class Codec>
+class ConnectionCodecPair : public CodecPair {
+ public:
+  ConnectionCodecPair()
+      : upstream_(TransportDirection::UPSTREAM),
+        downstream_(TransportDirection::DOWNSTREAM) {
+    upstream_.setCallback(&upstreamCallback_);
+    downstream_.setCallback(&downstreamCallback_);
+    upstream_.generateConnectionPreface(wire_);
+    upstream_.generateSettings(wire_);
+    deliver(downstream_, downstreamCallback_);
+    downstream_.generateSettings(wire_);
+    deliver(upstream_, upstreamCallback_);
+  }
+
+  size_t replay(const Exchange& exchange) override {
+    auto stream = upstream_.createStream();
+    upstream_.generateHeader(wire_, stream, exchange.request, true);
+    size_t bytes = deliver(downstream_, downstreamCallback_);
+    downstream_.generateHeader(wire_, downstreamCallback_.lastStream,
+                               exchange.response, true);
+    return bytes + deliver(upstream_, upstreamCallback_);
+  }
+
+ private:
+  Codec upstream_;
+  Codec downstream_;
+};
+
+/**
+ * HTTP/3, where each exchange gets a pair of stream codecs sharing the
+ * connection's QPACK state.  The QPACK encoder and decoder streams are
+ * delivered ahead of the request streams so nothing blocks.
+ */
+class HQCodecPair : public CodecPair {
+ public:
+  HQCodecPair() {
+    upstreamQPACK_.setEncoderHeaderTableSize(kTableSize);
+    upstreamQPACK_.setDecoderHeaderTableMaxSize(kTableSize);
+    downstreamQPACK_.setEncoderHeaderTableSize(kTableSize);
+    downstreamQPACK_.setDecoderHeaderTableMaxSize(kTableSize);
+  }
+
+  size_t replay(const Exchange& exchange) override {
+    HQStreamCodec upstream(nextStream_, TransportDirection::UPSTREAM,
+                           upstreamQPACK_, upstreamEncoderWrite_,
+                           upstreamDecoderWrite_, maxData_,
+                           egressSettings_, ingressSettings_, false);
+    HQStreamCodec downstream(nextStream_, TransportDirection::DOWNSTREAM,
+                             downstreamQPACK_, downstreamEncoderWrite_,
+                             downstreamDecoderWrite_, maxData_,
+                             ingressSettings_, egressSettings_, false);
+    upstream.setCallback(&upstreamCallback_);
+    downstream.setCallback(&downstreamCallback_);
+    nextStream_ += 4;
+
+    auto stream = upstream.createStream();
+    upstream.generateHeader(wire_, stream, exchange.request, true);
+    size_t bytes = deliverControl();
+    bytes += deliver(downstream, downstreamCallback_);
+    downstream.onIngressEOF();
+    downstream.generateHeader(wire_, stream, exchange.response, true);
+    bytes += deliverControl();
+    bytes += deliver(upstream, upstreamCallback_);
+    upstream.onIngressEOF();
+    return bytes + deliverControl();
+  }
+
+ private:
+  size_t deliverControl() {
+    return deliverUnidirectional(upstreamEncoderWrite_, downstreamEncoder_) +
+      deliverUnidirectional(upstreamDecoderWrite_, downstreamDecoder_) +
+      deliverUnidirectional(downstreamEncoderWrite_, upstreamEncoder_) +
+      deliverUnidirectional(downstreamDecoderWrite_, upstreamDecoder_);
+  }
+
+  static size_t deliverUnidirectional(IOBufQueue& queue,
+                                      HQUnidirectionalCodec& codec) {
+    size_t length = queue.chainLength();
+    if (length > 0) {
+      queue.append(codec.onUnidirectionalIngress(queue.move()));
+    }
+    return length;
+  }
+
+  HTTPSettings egressSettings_;
+  HTTPSettings ingressSettings_;
+  QPACKCodec upstreamQPACK_;
+  QPACKCodec downstreamQPACK_;
+  IOBufQueue upstreamEncoderWrite_{IOBufQueue::cacheChainLength()};
+  IOBufQueue upstreamDecoderWrite_{IOBufQueue::cacheChainLength()};
+  IOBufQueue downstreamEncoderWrite_{IOBufQueue::cacheChainLength()};
+  IOBufQueue downstreamDecoderWrite_{IOBufQueue::cacheChainLength()};
+  // Each side parses the other side's encoder and decoder streams
+  QPACKEncoderCodec upstreamEncoder_{upstreamQPACK_, upstreamCallback_};
+  QPACKDecoderCodec upstreamDecoder_{upstreamQPACK_, upstreamCallback_};
+  QPACKEncoderCodec downstreamEncoder_{downstreamQPACK_, downstreamCallback_};
+  QPACKDecoderCodec downstreamDecoder_{downstreamQPACK_, downstreamCallback_};
+  std::function<uint64_t()> maxData_{
+    [] { return std::numeric_limits<uint64_t>::max(); }};
+  HTTPCodec::StreamID nextStream_{0};
+};
+
+template <class Pair>
+size_t replay(unsigned iters) {
+  BenchmarkSuspender braces;
+  Pair pair;
+  braces.dismiss();
+  for (unsigned i = 0; i < iters; i++) {
+    pair.replay(corpus[i % corpus.size()]);
+  }
+  return iters;
+}
+
+template <class Pair>
+void printStats(const std::string& name) {
+  Pair pair;
+  for (const auto& exchange : corpus) {
+    pair.replay(exchange);
+  }
+  size_t bytes = 0;
+  AllocationCounter::Scope allocations;
+  for (const auto& exchange : corpus) {
+    bytes += pair.replay(exchange);
+  }
+  auto stats = allocations.get();
+  double n = corpus.size();
+  std::cout << folly::format(
+    "{:<8} {:>14.1f} {:>14.1f} {:>18.1f} {:>8}\n",
+    name, bytes / n, stats.allocations / n, stats.bytes / n,
+    pair.getErrors());
+}
+
+}
+
+BENCHMARK_MULTI(HTTP1x, iters) {
+  return replay<ConnectionCodecPair<HTTP1xCodec>>(iters);
+}
+
+BENCHMARK_MULTI(HTTP2, iters) {
+  return replay<ConnectionCodecPair<HTTP2Codec>>(iters);
+}
+
+BENCHMARK_MULTI(HQ, iters) {
+  return replay<HQCodecPair>(iters);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  corpus = loadCorpus();
+
+  uint64_t headerBytes = 0;
+  for (const auto& exchange : corpus) {
+    headerBytes += HTTPArchive::getSize(exchange.request) +
+      HTTPArchive::getSize(exchange.response);
+  }
+  std::cout << folly::format(
+    "{} exchanges, {:.1f} header bytes per exchange{}\n\n",
+    corpus.size(), double(headerBytes) / corpus.size(),
+    AllocationCounter::countsMalloc() ? "" :
+    " (allocations only count operator new)");
+  std::cout << folly::format("{:<8} {:>14} {:>14} {:>18} {:>8}\n", "codec",
+                             "wire bytes/req", "allocs/req",
+                             "alloc bytes/req", "errors");
+  printStats<ConnectionCodecPair<HTTP1xCodec>>("HTTP1x");
+  printStats<ConnectionCodecPair<HTTP2Codec>>("HTTP2");
+  printStats<HQCodecPair>("HQ");
+  std::cout << std::endl;
+
+  folly::runBenchmarks();
+  return 0;
+}
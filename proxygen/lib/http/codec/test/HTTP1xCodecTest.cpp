@@ -175,6 +175,140 @@ TEST(HTTP1xCodecTest, TestHeadRequestChunkedResponse) {
   EXPECT_TRUE(respStr.find("0\r\n") == string::npos);
 }
 
+TEST(HTTP1xCodecTest, TestEgressHeaderWithCRLF) {
+  HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
+  HTTP1xCodecCallback callbacks;
+  codec.setCallback(&callbacks);
+  auto txnID = codec.createStream();
+
+  auto reqBuf = folly::IOBuf::copyBuffer(
+      "GET /www.facebook.com HTTP/1.1\nHost: www.facebook.com\n\n");
+  codec.onIngress(*reqBuf);
+  EXPECT_EQ(callbacks.headersComplete, 1);
+
+  // Headers that would split the response are dropped
+  HTTPMessage resp;
+  resp.setHTTPVersion(1, 1);
+  resp.setStatusCode(200);
+  resp.getHeaders().add("X-Good", "ok");
+  resp.getHeaders().add("X-Split", "a\r\nSet-Cookie: b");
+  resp.getHeaders().add("X-Nul", std::string("a\0b", 3));
+  resp.getHeaders().set(HTTP_HEADER_CONTENT_LENGTH, "0");
+  folly::IOBufQueue respBuf(folly::IOBufQueue::cacheChainLength());
+  codec.generateHeader(respBuf, txnID, resp, true);
+  auto respStr = respBuf.move()->moveToFbString();
+  EXPECT_NE(respStr.find("X-Good: ok\r\n"), string::npos);
+  EXPECT_EQ(respStr.find("X-Split"), string::npos);
+  EXPECT_EQ(respStr.find("Set-Cookie"), string::npos);
+  EXPECT_EQ(respStr.find("X-Nul"), string::npos);
+}
+
+TEST(HTTP1xCodecTest, TestForwardIngressHeaderLines) {
+  HTTP1xCodec downstream(TransportDirection::DOWNSTREAM);
+  HTTP1xCodecCallback callbacks;
+  downstream.setCallback(&callbacks);
+  downstream.setKeepIngressHeaderLines(true);
+
+  auto reqBuf = folly::IOBuf::copyBuffer(
+      "GET /yeah HTTP/1.1\r\n"
+      "Host: www.facebook.com\r\n"
+      "Connection: keep-alive, X-Hop\r\n"
+      "x-custom:  spaced\r\n"
+      "X-Hop: 1\r\n"
+      "Keep-Alive: 300\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n");
+  downstream.onIngress(*reqBuf);
+  ASSERT_EQ(callbacks.headersComplete, 1);
+  HTTPMessage& msg = *callbacks.msg_;
+  // The lines leave out the per-hop headers, so they only stand for the
+  // headers once those are stripped
+  EXPECT_TRUE(msg.getHeaders().getWireBlock().empty());
+  msg.stripPerHopHeaders();
+  EXPECT_EQ(msg.getHeaders().getWireBlock(),
+            "Host: www.facebook.com\r\n"
+            "x-custom:  spaced\r\n"
+            "Content-Length: 0\r\n");
+  msg.getHeaders().add("X-Forwarded-For", "127.0.0.1");
+
+  HTTP1xCodec upstream(TransportDirection::UPSTREAM);
+  auto txnID = upstream.createStream();
+  folly::IOBufQueue reqOut(folly::IOBufQueue::cacheChainLength());
+  upstream.generateHeader(reqOut, txnID, msg, true);
+  auto reqStr = reqOut.move()->moveToFbString();
+  EXPECT_EQ(reqStr.find("GET /yeah HTTP/1.1\r\n"
+                        "Host: www.facebook.com\r\n"
+                        "x-custom:  spaced\r\n"
+                        "Content-Length: 0\r\n"
+                        "X-Forwarded-For: 127.0.0.1\r\n"), 0);
+  EXPECT_EQ(reqStr.find("X-Hop"), string::npos);
+  EXPECT_EQ(reqStr.find("Keep-Alive"), string::npos);
+  EXPECT_EQ(reqStr.find("Transfer-Encoding"), string::npos);
+  EXPECT_NE(reqStr.find("Connection: keep-alive\r\n"), string::npos);
+
+  // Modified headers are written out one by one again
+  msg.getHeaders().remove("x-custom");
+  EXPECT_TRUE(msg.getHeaders().getWireBlock().empty());
+}
+
+TEST(HTTP1xCodecTest, TestForwardIngressHeaderLinesNewLength) {
+  HTTP1xCodec downstream(TransportDirection::DOWNSTREAM);
+  HTTP1xCodecCallback callbacks;
+  downstream.setCallback(&callbacks);
+  downstream.setKeepIngressHeaderLines(true);
+
+  auto reqBuf = folly::IOBuf::copyBuffer(
+      "POST /yeah HTTP/1.1\r\n"
+      "Host: www.facebook.com\r\n"
+      "Content-Length: 5\r\n"
+      "\r\n");
+  downstream.onIngress(*reqBuf);
+  ASSERT_EQ(callbacks.headersComplete, 1);
+  HTTPMessage& msg = *callbacks.msg_;
+  EXPECT_FALSE(msg.getHeaders().getWireBlock().empty());
+  // As a filter that rewrites the body might, without removing the old one
+  msg.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH, "10");
+  EXPECT_TRUE(msg.getHeaders().getWireBlock().empty());
+
+  HTTP1xCodec upstream(TransportDirection::UPSTREAM);
+  auto txnID = upstream.createStream();
+  folly::IOBufQueue reqOut(folly::IOBufQueue::cacheChainLength());
+  upstream.generateHeader(reqOut, txnID, msg, false);
+  auto reqStr = reqOut.move()->moveToFbString();
+  // Written one by one, so only the last Content-Length is
+  EXPECT_EQ(reqStr.find("Content-Length: 5"), string::npos);
+  auto length = reqStr.find("Content-Length: 10\r\n");
+  EXPECT_NE(length, string::npos);
+  EXPECT_EQ(reqStr.find("Content-Length", length + 1), string::npos);
+}
+
+TEST(HTTP1xCodecTest, TestIngressHeaderLinesNotKept) {
+  auto parse = [] (std::vector<string> reads) {
+    HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
+    HTTP1xCodecCallback callbacks;
+    codec.setCallback(&callbacks);
+    codec.setKeepIngressHeaderLines(true);
+    for (const auto& read : reads) {
+      codec.onIngress(*folly::IOBuf::copyBuffer(read));
+    }
+    EXPECT_EQ(callbacks.headersComplete, 1);
+    return callbacks.msg_->getHeaders().getWireBlock().str();
+  };
+
+  EXPECT_EQ(parse({"GET /yeah HTTP/1.1\r\nHost: www.facebook.com\r\n\r\n"}),
+            "Host: www.facebook.com\r\n");
+  // Folded lines are not one line per header
+  EXPECT_EQ(parse({"GET /yeah HTTP/1.1\r\n"
+                   "Host: www.facebook.com\r\n"
+                   "X-Folded: a\r\n b\r\n"
+                   "\r\n"}), "");
+  // Nor are lines split across reads
+  EXPECT_EQ(parse({"GET /yeah HTTP/1.1\r\nHost: www.facebook.com\r\n",
+                   "X-Custom: 1\r\n\r\n"}), "");
+  // Nor bare LF line endings
+  EXPECT_EQ(parse({"GET /yeah HTTP/1.1\nHost: www.facebook.com\n\n"}), "");
+}
+
 TEST(HTTP1xCodecTest, TestGetRequestChunkedResponse) {
   HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
   HTTP1xCodecCallback callbacks;
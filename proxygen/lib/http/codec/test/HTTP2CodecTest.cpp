@@ -203,6 +203,47 @@ TEST_F(HTTP2CodecTest, BasicHeader) {
   EXPECT_EQ("www.foo.com", headers.getSingleOrEmpty(HTTP_HEADER_HOST));
 }
 
+TEST_F(HTTP2CodecTest, HeadersBatch) {
+  downstreamCodec_.setIngressHeadersBatching(true);
+  auto get = getGetRequest("/guacamole");
+  auto post = getPostRequest(10);
+  upstreamCodec_.generateHeader(output_, 1, get, true /* eom */);
+  upstreamCodec_.generateHeader(output_, 3, post, false /* eom */);
+  upstreamCodec_.generateHeader(output_, 5, get, true /* eom */);
+  // The DATA frame ends the batch, so its stream has begun first
+  upstreamCodec_.generateBody(output_, 3, makeBuf(10), HTTPCodec::NoPadding,
+                              true /* eom */);
+  upstreamCodec_.generateHeader(output_, 7, get, true /* eom */);
+
+  EXPECT_TRUE(parse());
+  EXPECT_EQ(callbacks_.headersBatches, 2);
+  EXPECT_EQ(callbacks_.messageBegin, 4);
+  EXPECT_EQ(callbacks_.headersComplete, 4);
+  EXPECT_EQ(callbacks_.messageComplete, 4);
+  EXPECT_EQ(callbacks_.bodyCalls, 1);
+  EXPECT_EQ(callbacks_.bodyLength, 10);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+  EXPECT_EQ(callbacks_.headersCompleteId, 7);
+}
+
+TEST_F(HTTP2CodecTest, HeadersBatchMaxConcurrentStreams) {
+  downstreamCodec_.setIngressHeadersBatching(true);
+  downstreamCodec_.getEgressSettings()->setSetting(
+    SettingsId::MAX_CONCURRENT_STREAMS, 2);
+  auto get = getGetRequest("/guacamole");
+  upstreamCodec_.generateHeader(output_, 1, get, false /* eom */);
+  upstreamCodec_.generateHeader(output_, 3, get, false /* eom */);
+  upstreamCodec_.generateHeader(output_, 5, get, false /* eom */);
+
+  // Batched streams count towards the limit before they are delivered
+  EXPECT_TRUE(parse());
+  EXPECT_EQ(callbacks_.headersBatches, 1);
+  EXPECT_EQ(callbacks_.messageBegin, 2);
+  EXPECT_EQ(callbacks_.streamErrors, 1);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
 TEST_F(HTTP2CodecTest, RequestFromServer) {
   // this is to test EX_HEADERS frame, which carrys the HTTP request initiated
   // by server side
@@ -849,6 +890,23 @@ TEST_F(HTTP2CodecTest, BasicData) {
   EXPECT_EQ(callbacks_.data.move()->moveToFbString(), data);
 }
 
+TEST_F(HTTP2CodecTest, DataHeadroom) {
+  // A body with enough headroom gets its frame header written in place
+  string data("abcde");
+  auto buf = folly::IOBuf::copyBuffer(data, http2::kFrameHeaderSize);
+  output_.move();
+  upstreamCodec_.generateBody(output_, 2, std::move(buf),
+                              HTTPCodec::NoPadding, true);
+  EXPECT_FALSE(output_.front()->isChained());
+  EXPECT_EQ(http2::kFrameHeaderSize + data.length(), output_.chainLength());
+
+  parse();
+  EXPECT_EQ(callbacks_.messageComplete, 1);
+  EXPECT_EQ(callbacks_.bodyLength, 5);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+  EXPECT_EQ(callbacks_.data.move()->moveToFbString(), data);
+}
+
 TEST_F(HTTP2CodecTest, LongData) {
   // Hack the max frame size artificially low
   HTTPSettings* settings = (HTTPSettings*)upstreamCodec_.getIngressSettings();
@@ -868,6 +926,34 @@ TEST_F(HTTP2CodecTest, LongData) {
   EXPECT_EQ(callbacks_.data.move()->moveToFbString(), buf->moveToFbString());
 }
 
+TEST_F(HTTP2CodecTest, LongDataSplitBuffers) {
+  // Frame headers that straddle IOBufs in the read buffer can't use the
+  // contiguous fast path and must fall back to the Cursor based parse
+  HTTPSettings* settings = (HTTPSettings*)upstreamCodec_.getIngressSettings();
+  settings->setSetting(SettingsId::MAX_FRAME_SIZE, 16);
+  auto buf = makeBuf(100);
+  upstreamCodec_.generateBody(output_, 1, buf->clone(), HTTPCodec::NoPadding,
+                              true);
+
+  auto ingress = output_.move();
+  ingress->coalesce();
+  IOBufQueue chunked(IOBufQueue::cacheChainLength());
+  Cursor cursor(ingress.get());
+  while (!cursor.isAtEnd()) {
+    std::unique_ptr<IOBuf> piece;
+    cursor.clone(piece, std::min<size_t>(7, cursor.totalLength()));
+    chunked.append(std::move(piece));
+  }
+  EXPECT_EQ(downstreamCodec_.onIngress(*chunked.front()),
+            chunked.chainLength());
+
+  EXPECT_EQ(callbacks_.messageComplete, 1);
+  EXPECT_EQ(callbacks_.bodyLength, 100);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+  EXPECT_EQ(callbacks_.data.move()->moveToFbString(), buf->moveToFbString());
+}
+
 TEST_F(HTTP2CodecTest, MalformedPaddingLength) {
   const uint8_t badInput[] = {0x50, 0x52, 0x49, 0x20, 0x2a, 0x20, 0x48, 0x54,
                               0x54, 0x50, 0x2f, 0x32, 0x2e, 0x30, 0x0d, 0x0a,
@@ -2199,3 +2285,95 @@ TEST_F(HTTP2CodecTest, TrailersNotLatest) {
   EXPECT_EQ(callbacks_.streamErrors, 1);
   EXPECT_EQ(callbacks_.sessionErrors, 0);
 }
+
+namespace {
+
+HTTPMessage getTemplateResponse() {
+  HTTPMessage resp;
+  resp.setStatusCode(200);
+  resp.getHeaders().add("content-security-policy",
+                        "default-src 'self' *.example.com; "
+                        "script-src 'self' 'unsafe-eval' *.example.com; "
+                        "report-uri https://www.example.com/csp_report");
+  resp.getHeaders().add("strict-transport-security",
+                        "max-age=15552000; preload");
+  resp.getHeaders().add("x-frame-options", "DENY");
+  return resp;
+}
+
+std::shared_ptr<const HPACKTemplate> getTemplate() {
+  HPACKTemplateBuilder builder;
+  auto resp = getTemplateResponse();
+  resp.getHeaders().forEach([&] (const std::string& name,
+                                 const std::string& value) {
+    builder.add(name, value);
+  });
+  return builder.build();
+}
+
+// Returns the compressed size of the first response on a new connection,
+// checking that the client decodes it
+uint32_t firstResponseSize(std::shared_ptr<const HPACKTemplate> clientTemplate,
+                           std::shared_ptr<const HPACKTemplate> serverTemplate,
+                           uint32_t clientTableSize = 4096) {
+  FakeHTTPCodecCallback callbacks;
+  HTTP2Codec client(TransportDirection::UPSTREAM);
+  HTTP2Codec server(TransportDirection::DOWNSTREAM);
+  client.setCallback(&callbacks);
+  server.setCallback(&callbacks);
+  client.setHPACKTemplate(clientTemplate);
+  server.setHPACKTemplate(serverTemplate);
+  client.getEgressSettings()->setSetting(SettingsId::HEADER_TABLE_SIZE,
+                                         clientTableSize);
+
+  IOBufQueue clientOutput{IOBufQueue::cacheChainLength()};
+  IOBufQueue serverOutput{IOBufQueue::cacheChainLength()};
+  client.generateConnectionPreface(clientOutput);
+  client.generateSettings(clientOutput);
+  server.generateSettings(serverOutput);
+  server.onIngress(*clientOutput.move());
+
+  HTTPHeaderSize size;
+  server.generateHeader(serverOutput, 1, getTemplateResponse(), false, &size);
+  client.onIngress(*serverOutput.move());
+
+  EXPECT_EQ(callbacks.sessionErrors, 0);
+  EXPECT_EQ(callbacks.headersComplete, 1);
+  auto resp = getTemplateResponse();
+  resp.getHeaders().forEach([&] (const std::string& name,
+                                 const std::string& value) {
+    EXPECT_EQ(value, callbacks.msg->getHeaders().getSingleOrEmpty(name));
+  });
+  return size.compressed;
+}
+
+}
+
+TEST_F(HTTP2CodecTest, HPACKTemplate) {
+  auto hpackTemplate = getTemplate();
+  ASSERT_NE(hpackTemplate, nullptr);
+  EXPECT_EQ(hpackTemplate->getHeaders().size(), 3);
+
+  auto coldSize = firstResponseSize(nullptr, nullptr);
+  auto warmSize = firstResponseSize(hpackTemplate, hpackTemplate);
+  // Each templated header is a one byte index
+  EXPECT_LT(warmSize + 100, coldSize);
+
+  // Only used when both peers have the same one
+  EXPECT_EQ(firstResponseSize(nullptr, hpackTemplate), coldSize);
+  EXPECT_EQ(firstResponseSize(hpackTemplate, nullptr), coldSize);
+  HPACKTemplateBuilder builder;
+  builder.add("x-other", "value");
+  EXPECT_EQ(firstResponseSize(builder.build(), hpackTemplate), coldSize);
+
+  // With a smaller table both sides keep the same newest headers
+  EXPECT_LT(firstResponseSize(hpackTemplate, hpackTemplate, 256), coldSize);
+  EXPECT_GT(firstResponseSize(hpackTemplate, hpackTemplate, 256), warmSize);
+}
+
+TEST_F(HTTP2CodecTest, HPACKTemplateAfterSettings) {
+  upstreamCodec_.generateSettings(output_);
+  upstreamCodec_.setHPACKTemplate(getTemplate());
+  EXPECT_EQ(upstreamCodec_.getEgressSettings()->getSetting(
+              SettingsId::HPACK_TEMPLATE), nullptr);
+}
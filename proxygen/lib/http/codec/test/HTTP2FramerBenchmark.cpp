@@ -0,0 +1,147 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/codec/HTTP2Codec.h>
+#include <proxygen/lib/http/codec/HTTP2Framer.h>
+#include <proxygen/lib/http/codec/test/HTTP2FramerTest.h>
+#include <proxygen/lib/http/codec/test/TestUtils.h>
+
+#include <folly/Benchmark.h>
+#include <folly/io/Cursor.h>
+#include <folly/portability/GFlags.h>
+
+using namespace folly;
+using namespace folly::io;
+using namespace proxygen;
+using namespace proxygen::http2;
+
+/**
+ * Measures HTTP/2 ingress parsing in frames per second (the iters/s column,
+ * since every benchmark reports per-frame times).  The *Chained variants
+ * split the read buffer into small IOBufs so that frame headers straddle
+ * buffer boundaries, which exercises the Cursor fallback of the parser.
+ */
+
+namespace {
+
+constexpr uint32_t kFramesPerBuffer = 100;
+constexpr uint32_t kDataFrameSize = 64;
+
+std::unique_ptr<IOBuf> makeFrameHeaders() {
+  IOBufQueue queue{IOBufQueue::cacheChainLength()};
+  for (uint32_t i = 0; i < kFramesPerBuffer; i++) {
+    writeFrameHeaderManual(queue, kDataFrameSize,
+                           static_cast<uint8_t>(FrameType::DATA), 0, 1);
+  }
+  auto buf = queue.move();
+  buf->coalesce();
+  return buf;
+}
+
+// A mix of frames typical of a busy connection: mostly small DATA frames
+// with interleaved WINDOW_UPDATEs
+std::unique_ptr<IOBuf> makeFrames() {
+  IOBufQueue queue{IOBufQueue::cacheChainLength()};
+  for (uint32_t i = 0; i < kFramesPerBuffer; i++) {
+    if (i % 10 == 9) {
+      writeWindowUpdate(queue, 1, kDataFrameSize * 10);
+    } else {
+      writeData(queue, makeBuf(kDataFrameSize), 1 + 2 * (i % 4),
+                kNoPadding, false, true);
+    }
+  }
+  auto buf = queue.move();
+  buf->coalesce();
+  return buf;
+}
+
+std::unique_ptr<IOBuf> chain(const IOBuf& buf, size_t pieceSize) {
+  IOBufQueue queue{IOBufQueue::cacheChainLength()};
+  Cursor cursor(&buf);
+  while (!cursor.isAtEnd()) {
+    std::unique_ptr<IOBuf> piece;
+    cursor.clone(piece, std::min(pieceSize, cursor.totalLength()));
+    queue.append(std::move(piece));
+  }
+  return queue.move();
+}
+
+struct CodecHolder {
+  CodecHolder() : codec(TransportDirection::DOWNSTREAM) {
+    codec.setCallback(&callbacks);
+    HTTP2Codec upstream(TransportDirection::UPSTREAM);
+    IOBufQueue preface{IOBufQueue::cacheChainLength()};
+    upstream.generateConnectionPreface(preface);
+    upstream.generateSettings(preface);
+    auto buf = preface.move();
+    CHECK_EQ(codec.onIngress(*buf), buf->computeChainDataLength());
+  }
+
+  FakeHTTPCodecCallback callbacks;
+  HTTP2Codec codec;
+};
+
+}
+
+BENCHMARK_MULTI(ParseFrameHeaderCursor, iters) {
+  auto buf = makeFrameHeaders();
+  FrameHeader header;
+  for (unsigned i = 0; i < iters; i++) {
+    Cursor cursor(buf.get());
+    for (uint32_t j = 0; j < kFramesPerBuffer; j++) {
+      parseFrameHeader(cursor, header);
+      folly::doNotOptimizeAway(header.stream);
+    }
+  }
+  return iters * kFramesPerBuffer;
+}
+
+BENCHMARK_RELATIVE_MULTI(ParseFrameHeaderPointer, iters) {
+  auto buf = makeFrameHeaders();
+  FrameHeader header;
+  for (unsigned i = 0; i < iters; i++) {
+    const uint8_t* data = buf->data();
+    for (uint32_t j = 0; j < kFramesPerBuffer; j++) {
+      parseFrameHeader(data, header);
+      folly::doNotOptimizeAway(header.stream);
+      data += kFrameHeaderSize;
+    }
+  }
+  return iters * kFramesPerBuffer;
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_MULTI(OnIngressContiguous, iters) {
+  BenchmarkSuspender braces;
+  CodecHolder holder;
+  auto buf = makeFrames();
+  braces.dismiss();
+  for (unsigned i = 0; i < iters; i++) {
+    holder.codec.onIngress(*buf);
+  }
+  return iters * kFramesPerBuffer;
+}
+
+BENCHMARK_RELATIVE_MULTI(OnIngressChained, iters) {
+  BenchmarkSuspender braces;
+  CodecHolder holder;
+  auto buf = chain(*makeFrames(), 7);
+  braces.dismiss();
+  for (unsigned i = 0; i < iters; i++) {
+    holder.codec.onIngress(*buf);
+  }
+  return iters * kFramesPerBuffer;
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -24,15 +24,6 @@ using namespace proxygen::http2;
 using namespace proxygen;
 using namespace std;
 
-void writeFrameHeaderManual(IOBufQueue& queue, uint32_t length, uint8_t type,
-                            uint8_t flags, uint32_t stream) {
-  QueueAppender appender(&queue, kFrameHeaderSize);
-  uint32_t lengthAndType = length << 8 | type;
-  appender.writeBE<uint32_t>(lengthAndType);
-  appender.writeBE<uint8_t>(flags);
-  appender.writeBE<uint32_t>(stream);
-}
-
 class HTTP2FramerTest : public testing::Test {
  public:
   HTTP2FramerTest() {}
@@ -147,6 +138,31 @@ TEST_F(HTTP2FramerTest, BadPad) {
             ErrorCode::PROTOCOL_ERROR);
 }
 
+TEST_F(HTTP2FramerTest, ParseFrameHeaderContiguous) {
+  // The pointer based parse must agree with the Cursor based one, including
+  // ignoring the reserved bit before the stream id
+  writeFrameHeaderManual(queue_, 0x123456,
+                         static_cast<uint8_t>(FrameType::WINDOW_UPDATE),
+                         0xab, 0x80000007);
+  auto buf = queue_.move();
+  buf->coalesce();
+
+  FrameHeader cursorHeader;
+  Cursor cursor(buf.get());
+  EXPECT_EQ(parseFrameHeader(cursor, cursorHeader), ErrorCode::NO_ERROR);
+
+  FrameHeader header;
+  EXPECT_EQ(parseFrameHeader(buf->data(), header), ErrorCode::NO_ERROR);
+  EXPECT_EQ(header.length, 0x123456);
+  EXPECT_EQ(header.type, FrameType::WINDOW_UPDATE);
+  EXPECT_EQ(header.flags, 0xab);
+  EXPECT_EQ(header.stream, 7);
+  EXPECT_EQ(header.length, cursorHeader.length);
+  EXPECT_EQ(header.type, cursorHeader.type);
+  EXPECT_EQ(header.flags, cursorHeader.flags);
+  EXPECT_EQ(header.stream, cursorHeader.stream);
+}
+
 TEST_F(HTTP2FramerTest, NoHeadroomOptimization) {
   queue_.move();
   auto buf = folly::IOBuf::create(200);
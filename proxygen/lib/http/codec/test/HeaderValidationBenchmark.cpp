@@ -0,0 +1,175 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/codec/CodecUtil.h>
+#include <proxygen/lib/http/codec/HeaderValidation.h>
+
+#include <folly/Benchmark.h>
+#include <folly/portability/GFlags.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace folly;
+using namespace proxygen;
+
+/**
+ * Compares the vectorized header checks with the byte at a time loops they
+ * replaced, over the headers of a typical browser request and response.
+ * Most names are short and most bytes are in a few long values, like
+ * cookie, user-agent and accept.  Times are per header block.
+ */
+
+namespace {
+
+std::vector<std::pair<std::string, std::string>> makeHeaders() {
+  return {
+    {"Host", "www.facebook.com"},
+    {"User-Agent",
+     "Mozilla/5.0 (Macintosh; Intel Mac OS X 10_14_3) AppleWebKit/537.36 "
+     "(KHTML, like Gecko) Chrome/72.0.3626.121 Safari/537.36"},
+    {"Accept",
+     "text/html,application/xhtml+xml,application/xml;q=0.9,image/webp,"
+     "image/apng,*/*;q=0.8"},
+    {"Accept-Encoding", "gzip, deflate, br"},
+    {"Accept-Language", "en-US,en;q=0.9"},
+    {"Cookie",
+     "datr=Mb2qW1CcdfHdTjRk6VVh5gQu; sb=Mb2qW9s0PNkYnRmR1Sv1M1Lo; "
+     "c_user=100000000000000; xs=25%3AYlB2bBxxZEkO8A%3A2%3A1537916320%3A"
+     "11231%3A15033; fr=0b5Ld0Ztf1TcWKZq0.AWX9yDCjiE0Vy8KfpaxF6V6RnZk."
+     "BbqL0x.Bc.FwQ.0.0.Bch3Xu.AWUYd2Ns; spin=r.4812347_b.trunk_t."
+     "1552380398_s.1_v.2_; presence=EDvF3EtimeF1552380437EuserFA21B0000"},
+    {"Referer", "https://www.facebook.com/"},
+    {"Upgrade-Insecure-Requests", "1"},
+    {"X-Requested-With", "XMLHttpRequest"},
+    {"Cache-Control", "max-age=0"},
+    {"Content-Type", "text/html; charset=UTF-8"},
+    {"Content-Length", "53412"},
+    {"Date", "Tue, 12 Mar 2019 08:47:17 GMT"},
+    {"Strict-Transport-Security", "max-age=15552000; preload"},
+    {"X-Content-Type-Options", "nosniff"},
+    {"X-Frame-Options", "DENY"},
+    {"X-FB-Debug",
+     "u5X0N4ZDA0d5vdrv7LrXnAPbwjnT7wvBB7F2vGsTXW7OhYrsq3KhzHpU2QzbCH0Qx0"
+     "mZ5wYYyC6Yc8zG9Ua/vg=="},
+    {"Vary", "Accept-Encoding"},
+  };
+}
+
+const std::vector<std::pair<std::string, std::string>> kHeaders =
+  makeHeaders();
+
+ByteRange range(const std::string& str) {
+  return ByteRange(StringPiece(str));
+}
+
+// What CodecUtil::validateHeaderName did before
+bool validateNameScalar(ByteRange name) {
+  if (name.size() == 0) {
+    return false;
+  }
+  for (auto p : name) {
+    if (p < 0x80 && CodecUtil::http_tokens[(uint8_t)p] != p) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool hasForbiddenValueCharsScalar(ByteRange value) {
+  for (auto p : value) {
+    if (p == '\0' || p == '\r' || p == '\n') {
+      return true;
+    }
+  }
+  return false;
+}
+
+}
+
+BENCHMARK(LowercaseNameScalar, iters) {
+  std::string out(64, '\0');
+  while (iters--) {
+    for (const auto& header : kHeaders) {
+      std::transform(header.first.begin(), header.first.end(), out.begin(),
+                     ::tolower);
+      folly::doNotOptimizeAway(validateNameScalar(
+        ByteRange(StringPiece(out.data(), header.first.size()))));
+    }
+  }
+}
+
+BENCHMARK_RELATIVE(LowercaseNameVector, iters) {
+  std::string out(64, '\0');
+  auto outData = reinterpret_cast<uint8_t*>(&out[0]);
+  while (iters--) {
+    for (const auto& header : kHeaders) {
+      folly::doNotOptimizeAway(HeaderValidation::lowercaseAndValidateName(
+        range(header.first), outData));
+    }
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(ValidateValueScalar, iters) {
+  while (iters--) {
+    for (const auto& header : kHeaders) {
+      folly::doNotOptimizeAway(
+        hasForbiddenValueCharsScalar(range(header.second)));
+    }
+  }
+}
+
+BENCHMARK_RELATIVE(ValidateValueVector, iters) {
+  while (iters--) {
+    for (const auto& header : kHeaders) {
+      folly::doNotOptimizeAway(
+        HeaderValidation::hasForbiddenValueChars(range(header.second)));
+    }
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+// CodecUtil::validateHeaderValue when its isPlainValue fast path misses at
+// the last byte and the state machine runs, as it always did before, and
+// when it hits, as it does for every value here
+BENCHMARK(ValidateValueStrictScalar, iters) {
+  std::string value;
+  while (iters--) {
+    for (const auto& header : kHeaders) {
+      // A trailing tab is allowed, but is not plain
+      value = header.second;
+      value.push_back('\t');
+      folly::doNotOptimizeAway(
+        CodecUtil::validateHeaderValue(range(value), CodecUtil::STRICT));
+    }
+  }
+}
+
+BENCHMARK_RELATIVE(ValidateValueStrictVector, iters) {
+  std::string value;
+  while (iters--) {
+    for (const auto& header : kHeaders) {
+      // Same copy as above, so only the check differs
+      value = header.second;
+      value.push_back('a');
+      folly::doNotOptimizeAway(
+        CodecUtil::validateHeaderValue(range(value), CodecUtil::STRICT));
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/CodecUtil.h>
+#include <proxygen/lib/http/codec/HeaderValidation.h>
+
+#include <string>
+#include <vector>
+
+using namespace proxygen;
+using folly::ByteRange;
+using folly::StringPiece;
+
+namespace {
+
+ByteRange range(const std::string& str) {
+  return ByteRange(StringPiece(str));
+}
+
+// Every byte value at every position of names and values long enough to go
+// through both the vector loop and the scalar tail
+std::vector<std::string> makeInputs() {
+  std::vector<std::string> inputs;
+  for (size_t len : {1, 15, 16, 17, 40}) {
+    for (int c = 0; c < 256; c++) {
+      for (size_t pos : {size_t(0), len / 2, len - 1}) {
+        std::string str(len, 'a');
+        str[pos] = static_cast<char>(c);
+        inputs.push_back(std::move(str));
+      }
+    }
+  }
+  return inputs;
+}
+
+bool isTokenScalar(uint8_t c) {
+  return c >= 0x80 ||
+    (c != 0 && CodecUtil::http_tokens[c] == static_cast<char>(c));
+}
+
+}
+
+TEST(HeaderValidationTest, Name) {
+  EXPECT_FALSE(HeaderValidation::validateName(ByteRange()));
+  EXPECT_TRUE(HeaderValidation::validateName(range("x-fb-debug")));
+  EXPECT_FALSE(HeaderValidation::validateName(range("X-FB-Debug")));
+  EXPECT_FALSE(HeaderValidation::validateName(range("x-fb:debug")));
+  for (const auto& name : makeInputs()) {
+    bool expected = true;
+    for (uint8_t c : range(name)) {
+      expected &= isTokenScalar(c);
+    }
+    EXPECT_EQ(HeaderValidation::validateName(range(name)), expected) << name;
+  }
+}
+
+TEST(HeaderValidationTest, LowercaseName) {
+  std::string out(64, '\0');
+  auto outData = reinterpret_cast<uint8_t*>(&out[0]);
+  EXPECT_TRUE(HeaderValidation::lowercaseAndValidateName(
+                range("X-FB-Debug-With-A-Long-Name"), outData));
+  EXPECT_EQ(out.substr(0, 27), "x-fb-debug-with-a-long-name");
+  for (const auto& name : makeInputs()) {
+    std::string expected(name);
+    bool expectedValid = true;
+    for (auto& c : expected) {
+      if (c >= 'A' && c <= 'Z') {
+        c |= 0x20;
+      }
+      expectedValid &= isTokenScalar(static_cast<uint8_t>(c));
+    }
+    bool hasUpper = (expected != name);
+    EXPECT_EQ(HeaderValidation::hasUppercase(range(name)), hasUpper);
+    // In place
+    std::string lower(name);
+    EXPECT_EQ(HeaderValidation::lowercaseAndValidateName(
+                range(lower), reinterpret_cast<uint8_t*>(&lower[0])),
+              expectedValid);
+    EXPECT_EQ(lower, expected);
+  }
+}
+
+TEST(HeaderValidationTest, Value) {
+  for (const auto& value : makeInputs()) {
+    bool forbidden = false;
+    bool plain = true;
+    for (uint8_t c : range(value)) {
+      forbidden |= (c == '\0' || c == '\r' || c == '\n');
+      plain &= (c >= 0x20 && c != 0x7f && c != '\\');
+    }
+    EXPECT_EQ(HeaderValidation::hasForbiddenValueChars(range(value)),
+              forbidden);
+    EXPECT_EQ(HeaderValidation::isPlainValue(range(value)), plain);
+  }
+  // The state machine still decides values that are not plain
+  EXPECT_TRUE(CodecUtil::validateHeaderValue(
+                range("a\r\n b"), CodecUtil::STRICT));
+  EXPECT_FALSE(CodecUtil::validateHeaderValue(
+                 range("a\r\nb"), CodecUtil::STRICT));
+  EXPECT_FALSE(CodecUtil::validateHeaderValue(
+                 range("\"a\\"), CodecUtil::STRICT));
+}
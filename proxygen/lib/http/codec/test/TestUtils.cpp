@@ -8,7 +8,9 @@
  *
  */
 #include <proxygen/lib/http/codec/HTTP2Constants.h>
+#include <proxygen/lib/http/codec/HTTP2Framer.h>
 #include <proxygen/lib/http/codec/SPDYConstants.h>
+#include <proxygen/lib/http/codec/test/HTTP2FramerTest.h>
 #include <proxygen/lib/http/codec/test/TestUtils.h>
 
 #include <boost/optional/optional_io.hpp>
@@ -20,6 +22,15 @@ using namespace folly;
 using namespace std;
 using namespace testing;
 
+void writeFrameHeaderManual(IOBufQueue& queue, uint32_t length, uint8_t type,
+                            uint8_t flags, uint32_t stream) {
+  QueueAppender appender(&queue, proxygen::http2::kFrameHeaderSize);
+  uint32_t lengthAndType = length << 8 | type;
+  appender.writeBE<uint32_t>(lengthAndType);
+  appender.writeBE<uint8_t>(flags);
+  appender.writeBE<uint32_t>(stream);
+}
+
 namespace proxygen {
 
 const HTTPSettings kDefaultIngressSettings{
@@ -131,6 +131,11 @@ class FakeHTTPCodecCallback : public HTTPCodec::Callback {
     headersCompleteId = stream;
     msg = std::move(inMsg);
   }
+  void onHeadersBatch(
+      std::vector<HTTPCodec::IngressHeaders>& batch) override {
+    headersBatches++;
+    HTTPCodec::Callback::onHeadersBatch(batch);
+  }
   void onBody(HTTPCodec::StreamID /*stream*/,
               std::unique_ptr<folly::IOBuf> chain,
               uint16_t padding) override {
@@ -306,6 +311,7 @@ class FakeHTTPCodecCallback : public HTTPCodec::Callback {
     isUnidirectional = false;
     messageBegin = 0;
     headersComplete = 0;
+    headersBatches = 0;
     messageComplete = 0;
     bodyCalls = 0;
     bodyLength = 0;
@@ -345,6 +351,7 @@ class FakeHTTPCodecCallback : public HTTPCodec::Callback {
     VLOG(verbosity) << "unidirectional: " << isUnidirectional;
     VLOG(verbosity) << "messageBegin: " << messageBegin;
     VLOG(verbosity) << "headersComplete: " << headersComplete;
+    VLOG(verbosity) << "headersBatches: " << headersBatches;
     VLOG(verbosity) << "bodyCalls: " << bodyCalls;
     VLOG(verbosity) << "bodyLength: " << bodyLength;
     VLOG(verbosity) << "paddingBytes: " << paddingBytes;
@@ -376,6 +383,7 @@ class FakeHTTPCodecCallback : public HTTPCodec::Callback {
   HTTPCodec::StreamID sessionStreamId{0};
   uint32_t messageBegin{0};
   uint32_t headersComplete{0};
+  uint32_t headersBatches{0};
   uint32_t messageComplete{0};
   uint32_t bodyCalls{0};
   uint32_t bodyLength{0};
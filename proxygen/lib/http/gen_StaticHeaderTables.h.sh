@@ -0,0 +1,140 @@
+#!/usr/bin/env bash
+# Copyright (c) Facebook, Inc. and its affiliates. All Rights Reserved
+
+if [ "x$1" != "x" ];then
+	export HEADERS_LIST="$1"
+fi
+if [ "x$2" != "x" ];then
+	export FBCODE_DIR="$2"
+fi
+if [ "x$3" != "x" ];then
+	export INSTALL_DIR="$3"
+fi
+
+COMPRESS_DIR="${FBCODE_DIR?}/proxygen/lib/http/codec/compress"
+
+# Generates the HPACK and QPACK static tables from
+# codec/compress/{HPACK,QPACK}StaticHeaderTable.txt, along with the indexes of
+# each table's entries grouped by HTTPHeaderCode, so that encoders look up
+# common headers by code instead of hashing their names.
+#
+# The first input is the header list, sorted and numbered the same way as in
+# gen_HTTPCommonHeaders.h.sh, which gives each name its HTTPHeaderCode.  Every
+# static table name must be in the list.
+cat ${HEADERS_LIST?} | LC_ALL=C sort | uniq \
+| awk '
+  function cstring(s) {
+    gsub(/\\/, "\\\\", s);
+    gsub(/"/, "\\\"", s);
+    return "\"" s "\"";
+  }
+
+  function printArray(name, values, n,    i, line) {
+    print "constexpr uint8_t " name "[] = {";
+    line = " ";
+    for (i = 0; i < n; i++) {
+      if (length(line) + length(values[i]) + 2 > 80) {
+        print line;
+        line = " ";
+      }
+      line = line " " values[i] ",";
+    }
+    print line;
+    print "};";
+  }
+
+  function printTable(t, prefix,    i, c, n, line, offsets, indexes,
+                      lengths) {
+    print "";
+    print "constexpr const char* k" prefix "StaticTableEntries[][2] = {";
+    for (i = 1; i <= size[t]; i++) {
+      line = "  {" cstring(names[t, i]) ", " cstring(values[t, i]) "},";
+      if (length(line) > 80) {
+        print "  {" cstring(names[t, i]) ",";
+        line = "   " cstring(values[t, i]) "},";
+      }
+      print line;
+    }
+    print "};";
+    print "";
+    n = 0;
+    for (c = 0; c < numCodes; c++) {
+      offsets[c] = n;
+      for (i = 1; i <= size[t]; i++) {
+        if (codes[t, i] == c) {
+          indexes[n++] = i;
+        }
+      }
+    }
+    offsets[numCodes] = n;
+    printArray("k" prefix "StaticTableCodeOffsets", offsets, numCodes + 1);
+    print "";
+    printArray("k" prefix "StaticTableCodeIndexes", indexes, n);
+    print "";
+    for (i = 1; i <= size[t]; i++) {
+      lengths[i - 1] = length(values[t, i]);
+    }
+    printArray("k" prefix "StaticTableValueLengths", lengths, size[t]);
+    print "";
+    print "constexpr StaticHeaderTableDef k" prefix "StaticTable{";
+    print "  k" prefix "StaticTableEntries,";
+    print "  " size[t] ",";
+    print "  k" prefix "StaticTableCodeOffsets,";
+    print "  k" prefix "StaticTableCodeIndexes,";
+    print "  k" prefix "StaticTableValueLengths";
+    print "};";
+  }
+
+  FNR == 1 {
+    t++;
+  }
+  t == 1 {
+    codeOf[tolower($1)] = FNR + 1;
+    numCodes = FNR + 2;
+    next;
+  }
+  /^#/ || NF == 0 {
+    next;
+  }
+  {
+    name = $1;
+    value = (NF > 1) ? substr($0, length(name) + 2) : "";
+    if (!(name in codeOf)) {
+      print FILENAME ": " name " is not in the common headers list" \
+        > "/dev/stderr";
+      failed = 1;
+      exit 1;
+    }
+    if (length(value) > 255) {
+      print FILENAME ": value of " name " is too long" > "/dev/stderr";
+      failed = 1;
+      exit 1;
+    }
+    i = ++size[t];
+    names[t, i] = name;
+    values[t, i] = value;
+    codes[t, i] = codeOf[name];
+  }
+
+  END {
+    if (failed) {
+      exit 1;
+    }
+    print "// Generated by gen_StaticHeaderTables.h.sh, do not edit";
+    print "#pragma once";
+    print "";
+    print "#include <proxygen/lib/http/HTTPCommonHeaders.h>";
+    print "#include <proxygen/lib/http/codec/compress/StaticHeaderTable.h>";
+    print "";
+    print "namespace proxygen {";
+    print "";
+    print "static_assert(HTTPCommonHeaders::num_header_codes == " numCodes ",";
+    print "              \"StaticHeaderTables.h is out of date\");";
+    printTable(2, "HPACK");
+    printTable(3, "QPACK");
+    print "";
+    print "}";
+  }
+' - "${COMPRESS_DIR}/HPACKStaticHeaderTable.txt" \
+    "${COMPRESS_DIR}/QPACKStaticHeaderTable.txt" \
+    > "${INSTALL_DIR?}/StaticHeaderTables.h"
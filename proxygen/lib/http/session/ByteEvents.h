@@ -11,8 +11,8 @@
 
 #include <folly/IntrusiveList.h>
 #include <proxygen/lib/http/session/HTTPTransaction.h>
-#include <proxygen/lib/utils/AsyncTimeoutSet.h>
 #include <proxygen/lib/utils/Time.h>
+#include <proxygen/lib/utils/TimerWheel.h>
 
 namespace proxygen {
 
@@ -72,7 +72,7 @@ class TransactionByteEvent : public ByteEvent {
 };
 
 class AckTimeout
-    : public AsyncTimeoutSet::Callback {
+    : public TimerWheel::Callback {
  public:
   /**
    * The instances of AckTimeout::Callback *MUST* outlive the AckTimeout it is
@@ -98,7 +98,7 @@ class AckTimeout
 
 class TxByteEvent
     : public TransactionByteEvent
-    , public AsyncTimeoutSet::Callback {
+    , public TimerWheel::Callback {
  public:
   /**
    * The instances of TxByteEvent::Callback *MUST* outlive the ByteEvent it is
@@ -1154,7 +1154,7 @@ void HQSession::readRequestStream(quic::StreamId id) noexcept {
           << " eof=" << uint32_t(hqStream->readEOF_) << " sess=" << *this;
   if (hqStream->readEOF_) {
     auto timeDiff = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - hqStream->createdTime);
+        getClock().now() - hqStream->createdTime);
     QUIC_TRACE_SOCK(stream_event,
                     sock_,
                     "on_eom",
@@ -1338,6 +1338,86 @@ void HQSession::notifyEgressBodyBuffered(int64_t bytes) {
   }
 }
 
+std::chrono::microseconds HQSession::getRTT() const {
+  return sock_ ? sock_->getTransportInfo().srtt
+               : std::chrono::microseconds::zero();
+}
+
+void HQSession::applyReceiveWindowTuning() {
+  if (!sock_) {
+    return;
+  }
+  if (receiveSessionWindowSize_) {
+    auto newSize = connRecvWindow_.setLimit(
+      *receiveSessionWindowSize_,
+      getTunedSessionWindowLimit(*receiveSessionWindowSize_));
+    if (newSize) {
+      sock_->setConnectionFlowControlWindow(*newSize);
+    }
+  }
+  if (receiveStreamWindowSize_) {
+    const auto streamLimit =
+      getTunedStreamWindowLimit(*receiveStreamWindowSize_);
+    for (auto& it : streams_) {
+      auto newSize =
+        it.second.recvWindow_.setLimit(*receiveStreamWindowSize_, streamLimit);
+      if (newSize) {
+        sock_->setStreamFlowControlWindow(it.first, *newSize);
+      }
+    }
+  }
+}
+
+void HQSession::onIngressBodyConsumed(HQStreamTransportBase& stream,
+                                      uint32_t bytes) {
+  if (!sock_) {
+    return;
+  }
+  auto newSize = connRecvWindow_.onBytesConsumed(bytes, *this);
+  if (newSize) {
+    sock_->setConnectionFlowControlWindow(*newSize);
+  }
+  newSize = stream.recvWindow_.onBytesConsumed(bytes, *this);
+  if (newSize) {
+    sock_->setStreamFlowControlWindow(stream.getStreamId(), *newSize);
+  }
+}
+
+folly::Optional<uint32_t> HQSession::TunedReceiveWindow::setLimit(
+    uint32_t baseSize, uint32_t limit) {
+  if (size == 0) {
+    size = baseSize;
+  }
+  if (limit == 0) {
+    tuner.reset();
+    limit = baseSize;
+  } else if (tuner) {
+    tuner->setMaxCapacity(limit);
+  } else {
+    tuner = std::make_unique<ReceiveWindowTuner>(limit);
+  }
+  if (size > limit) {
+    // QUIC never retracts credit that was already advertised, so the window
+    // can be lowered right away.
+    size = limit;
+    return size;
+  }
+  return folly::none;
+}
+
+folly::Optional<uint32_t> HQSession::TunedReceiveWindow::onBytesConsumed(
+    uint32_t bytes, const HQSession& session) {
+  if (!tuner || !tuner->onBytesConsumed(size, bytes)) {
+    return folly::none;
+  }
+  auto target = tuner->getTargetCapacity(size, session.getRTT());
+  if (target == size) {
+    return folly::none;
+  }
+  size = target;
+  return size;
+}
+
 void HQSession::onFlowControlUpdate(quic::StreamId id) noexcept {
   VLOG(4) << __func__ << " sess=" << *this << ": streamID=" << id;
 
@@ -1952,6 +2032,9 @@ HQSession::HQStreamTransportBase::HQStreamTransportBase(
       << "Socket is null drainState=" << (int)session_.drainState_
       << " streams=" << (int)session_.streams_.size();
   realCodec_ = std::move(codec);
+  if (session_.isTransactionTimingsEnabled()) {
+    txn_.setTimingsEnabled(true);
+  }
   if (session_.version_ == HQVersion::HQ) {
     auto c = dynamic_cast<hq::HQStreamCodec*>(realCodec_.get());
     CHECK(c);
@@ -1964,6 +2047,9 @@ HQSession::HQStreamTransportBase::HQStreamTransportBase(
   if (session_.receiveStreamWindowSize_.hasValue()) {
     session_.sock_->setStreamFlowControlWindow(
         id, session_.receiveStreamWindowSize_.value());
+    recvWindow_.setLimit(session_.receiveStreamWindowSize_.value(),
+                         session_.getTunedStreamWindowLimit(
+                           session_.receiveStreamWindowSize_.value()));
   }
   codecFilterChain->setCallback(this);
   byteEventTracker_.setTTLBAStats(session_.sessionStats_);
@@ -2160,7 +2246,7 @@ void HQSession::HQStreamTransportBase::onHeadersComplete(
   txn_.onIngressHeadersComplete(std::move(msg));
 
   auto timeDiff = std::chrono::duration_cast<std::chrono::milliseconds>(
-      std::chrono::steady_clock::now() - createdTime);
+      getClock().now() - createdTime);
   QUIC_TRACE_SOCK(stream_event,
                   session_.sock_,
                   "on_headers",
@@ -2286,7 +2372,7 @@ void HQSession::HQStreamTransportBase::sendHeaders(HTTPTransaction* txn,
   notifyPendingEgress();
 
   auto timeDiff = std::chrono::duration_cast<std::chrono::milliseconds>(
-      std::chrono::steady_clock::now() - createdTime);
+      getClock().now() - createdTime);
   QUIC_TRACE_SOCK(stream_event,
                   session_.sock_,
                   "headers",
@@ -2337,7 +2423,7 @@ size_t HQSession::HQStreamTransportBase::sendEOM(
   pendingEOM_ = true;
   notifyPendingEgress();
   auto timeDiff = std::chrono::duration_cast<std::chrono::milliseconds>(
-      std::chrono::steady_clock::now() - createdTime);
+      getClock().now() - createdTime);
   QUIC_TRACE_SOCK(stream_event,
                   session_.sock_,
                   "eom",
@@ -2362,7 +2448,7 @@ size_t HQSession::HQStreamTransportBase::sendAbortImpl(HTTP3::ErrorCode code,
   abortEgress(true);
   // We generated 0 application bytes so return 0?
   auto timeDiff = std::chrono::duration_cast<std::chrono::milliseconds>(
-      std::chrono::steady_clock::now() - createdTime);
+      getClock().now() - createdTime);
   QUIC_TRACE_SOCK(stream_event,
                   session_.sock_,
                   "abort",
@@ -2438,7 +2524,7 @@ void HQSession::HQStreamTransportBase::onError(HTTPCodec::StreamID streamID,
 
   txn_.onError(error);
   auto timeDiff = std::chrono::duration_cast<std::chrono::milliseconds>(
-      std::chrono::steady_clock::now() - createdTime);
+      getClock().now() - createdTime);
   QUIC_TRACE_SOCK(stream_event,
                   session_.sock_,
                   "on_error",
@@ -2520,7 +2606,7 @@ size_t HQSession::HQStreamTransportBase::sendBody(
             << " txn=" << txn_;
     pendingEOM_ = true;
     auto timeDiff = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - createdTime);
+        getClock().now() - createdTime);
     QUIC_TRACE_SOCK(stream_event,
                     session_.sock_,
                     "eom",
@@ -2563,6 +2649,7 @@ void HQSession::HQStreamTransportBase::onMessageBegin(
   // NOTE: for H2 this is where we create a new stream and transaction.
   // for HQ there is nothing to do here, except caching the codec streamID
   codecStreamId_ = streamID;
+  txn_.onIngressMessageBegin();
 }
 
 std::ostream& operator<<(std::ostream& os, const HQSession& session) {
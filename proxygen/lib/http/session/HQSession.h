@@ -8,6 +8,7 @@
  *
  */
 #pragma once
+#include <proxygen/lib/http/ReceiveWindowTuner.h>
 #include <proxygen/lib/http/codec/HQControlCodec.h>
 #include <proxygen/lib/http/codec/HQUnidirectionalCodec.h>
 #include <proxygen/lib/http/codec/HQUtils.h>
@@ -315,6 +316,9 @@ class HQSession
       sock_->setConnectionFlowControlWindow(receiveSessionWindowSize);
     }
     receiveStreamWindowSize_ = (uint32_t)receiveStreamWindowSize;
+    receiveSessionWindowSize_ = (uint32_t)receiveSessionWindowSize;
+    connRecvWindow_.size = 0;
+    applyReceiveWindowTuning();
   }
 
   /**
@@ -617,6 +621,37 @@ class HQSession
 
   void pauseTransactions() override;
 
+  void applyReceiveWindowTuning() override;
+
+  /**
+   * A receive window being auto-tuned.  QUIC returns flow control credit on
+   * its own, so tuning only changes the window size given to the transport.
+   */
+  struct TunedReceiveWindow {
+    /**
+     * Sets the tuning limit, 0 disables tuning.  Returns the new window size
+     * if it has to shrink.
+     */
+    folly::Optional<uint32_t> setLimit(uint32_t baseSize, uint32_t limit);
+
+    /**
+     * Returns the new window size if consuming bytes made the tuner resize
+     * the window.
+     */
+    folly::Optional<uint32_t> onBytesConsumed(uint32_t bytes,
+                                              const HQSession& session);
+
+    std::unique_ptr<ReceiveWindowTuner> tuner;
+    uint32_t size{0};
+  };
+
+  /**
+   * Called as the application consumes ingress body bytes of stream.
+   */
+  void onIngressBodyConsumed(HQStreamTransportBase& stream, uint32_t bytes);
+
+  std::chrono::microseconds getRTT() const;
+
   void notifyEgressBodyBuffered(int64_t bytes);
 
   // Schedule the loop callback.
@@ -1127,6 +1162,15 @@ class HQSession
     void notifyIngressBodyProcessed(uint32_t bytes) noexcept override {
       VLOG(4) << __func__ << " txn=" << txn_;
       session_.notifyBodyProcessed(bytes);
+      session_.onIngressBodyConsumed(*this, bytes);
+    }
+
+    std::chrono::microseconds getRTT() const noexcept override {
+      return session_.getRTT();
+    }
+
+    const TimeUtil& getClock() const override {
+      return session_.getClock();
     }
 
     void notifyEgressBodyBuffered(int64_t bytes) noexcept override {
@@ -1377,6 +1421,7 @@ class HQSession
     bool readEOF_{false};
     bool detached_{false};
     bool ingressError_{false};
+    TunedReceiveWindow recvWindow_;
     enum class EOMType { CODEC, TRANSPORT };
     ConditionalGate<EOMType, 2> eomGate_;
 
@@ -1772,6 +1817,8 @@ class HQSession
    */
   uint32_t maxConcurrentIncomingStreams_{100};
   folly::Optional<uint32_t> receiveStreamWindowSize_;
+  folly::Optional<uint32_t> receiveSessionWindowSize_;
+  TunedReceiveWindow connRecvWindow_;
 
   uint64_t maxToSend_{0};
   bool scheduledWrite_{false};
@@ -15,7 +15,7 @@ namespace proxygen {
 HQStreamBase::HQStreamBase(HQSession& session,
                            HTTPCodecFilterChain& codecFilterChain)
     : codecFilterChain(codecFilterChain),
-      createdTime(std::chrono::steady_clock::now()),
+      createdTime(session.getClock().now()),
       session_(session) {
 }
 
@@ -60,6 +60,8 @@ static constexpr folly::StringPiece kServerLabel =
 
 namespace proxygen {
 
+constexpr uint32_t HTTPSession::kDefaultWriteCoalescingThreshold;
+
 HTTPSession::WriteSegment::WriteSegment(
     HTTPSession* session,
     uint64_t length)
@@ -262,6 +264,7 @@ void HTTPSession::setupCodec() {
 
   if (codec_->supportsSessionFlowControl() && !connFlowControl_) {
     connFlowControl_ = new FlowControlFilter(*this, writeBuf_, codec_.call());
+    connFlowControl_->setDeferWindowUpdates(coalesceWindowUpdates_);
     codec_.addFilters(std::unique_ptr<FlowControlFilter>(connFlowControl_));
     // if we really support switching from spdy <-> h2, we need to update
     // existing flow control filter
@@ -297,6 +300,7 @@ void HTTPSession::startNow() {
     connFlowControl_->setReceiveWindowSize(writeBuf_,
                                            receiveSessionWindowSize_);
   }
+  applyReceiveWindowTuning();
   // For HTTP/2 if we are currently draining it means we got notified to
   // shutdown before we sent a SETTINGS frame, so we defer sending a GOAWAY
   // util we've started and sent SETTINGS.
@@ -533,6 +537,8 @@ HTTPSession::readDataAvailable(size_t readSize) noexcept {
   VLOG(10) << "read completed on " << *this << ", bytes=" << readSize;
 
   DestructorGuard dg(this);
+  HTTPSessionProfiler::SessionScope profile(
+    *this, ProfiledCallback::READ_DATA_AVAILABLE);
   resetTimeout();
   readBuf_.postallocate(readSize);
 
@@ -556,6 +562,8 @@ HTTPSession::readBufferAvailable(std::unique_ptr<IOBuf> readBuf) noexcept {
   VLOG(5) << "read completed on " << *this << ", bytes=" << readSize;
 
   DestructorGuard dg(this);
+  HTTPSessionProfiler::SessionScope profile(
+    *this, ProfiledCallback::READ_DATA_AVAILABLE);
   resetTimeout();
   readBuf_.append(std::move(readBuf));
 
@@ -569,6 +577,9 @@ HTTPSession::readBufferAvailable(std::unique_ptr<IOBuf> readBuf) noexcept {
 void
 HTTPSession::processReadData() {
   FOLLY_SCOPED_TRACE_SECTION("HTTPSession - processReadData");
+  // Callers hold a DestructorGuard
+  HTTPSessionProfiler::SessionScope profile(
+    *this, ProfiledCallback::PROCESS_READ_DATA);
 
   // Pass the ingress data through the codec to parse it. The codec
   // will invoke various methods of the HTTPSession as callbacks.
@@ -736,6 +747,7 @@ HTTPSession::onMessageBegin(HTTPCodec::StreamID streamID, HTTPMessage* msg) {
 
   HTTPTransaction* txn = findTransaction(streamID);
   if (txn) {
+    txn->onIngressMessageBegin();
     if (isDownstream() && txn->isPushed()) {
       // Push streams are unidirectional (half-closed). If the downstream
       // attempts to send ingress, abort with STREAM_CLOSED error.
@@ -753,6 +765,7 @@ HTTPSession::onMessageBegin(HTTPCodec::StreamID streamID, HTTPMessage* msg) {
   if (!txn) {
     return;  // This could happen if the socket is bad.
   }
+  txn->onIngressMessageBegin();
 
   if (!codec_->supportsParallelRequests() && getPipelineStreamCount() > 1) {
     // The previous transaction hasn't completed yet. Pause reads until
@@ -818,6 +831,7 @@ HTTPSession::onPushMessageBegin(HTTPCodec::StreamID streamID,
   if (!txn) {
     return;  // This could happen if the socket is bad.
   }
+  txn->onIngressMessageBegin();
 
   if (!assocTxn->onPushedTransaction(txn)) {
     VLOG(1) << "Failed to add pushed txn " << streamID
@@ -862,6 +876,7 @@ HTTPSession::onExMessageBegin(HTTPCodec::StreamID streamID,
   if (!txn) {
     return;  // This could happen if the socket is bad.
   }
+  txn->onIngressMessageBegin();
   // control stream may be paused if the upstream is not ready yet
   if (controlTxn->isIngressPaused()) {
     txn->pauseIngress();
@@ -1250,6 +1265,12 @@ void HTTPSession::onPingRequest(uint64_t uniqueID) {
 
 void HTTPSession::onPingReply(uint64_t uniqueID) {
   VLOG(4) << *this << " got ping reply with id=" << uniqueID;
+  if (timePointInitialized(pingSentTime_)) {
+    auto sample = std::chrono::duration_cast<std::chrono::microseconds>(
+      getCurrentTime() - pingSentTime_);
+    pingRTT_ = pingRTT_.count() == 0 ? sample : (pingRTT_ * 7 + sample) / 8;
+    pingSentTime_ = TimePoint();
+  }
   if (infoCallback_) {
     infoCallback_->onPingReplyReceived();
   }
@@ -1437,6 +1458,7 @@ bool HTTPSession::onNativeProtocolUpgradeImpl(
                                            receiveSessionWindowSize_);
     scheduleWrite();
   }
+  applyReceiveWindowTuning();
 
   // Convert the transaction that contained the Upgrade header
   txn->reset(codec_->supportsStreamFlowControl(),
@@ -1956,6 +1978,11 @@ HTTPSession::detach(HTTPTransaction* txn) noexcept {
 size_t
 HTTPSession::sendWindowUpdate(HTTPTransaction* txn,
                               uint32_t bytes) noexcept {
+  if (coalesceWindowUpdates_) {
+    pendingWindowUpdates_[txn->getID()] += bytes;
+    scheduleWrite();
+    return 0;
+  }
   size_t sent = codec_->generateWindowUpdate(writeBuf_, txn->getID(), bytes);
   if (sent) {
     scheduleWrite();
@@ -1970,10 +1997,40 @@ HTTPSession::notifyIngressBodyProcessed(uint32_t bytes) noexcept {
   }
   if (connFlowControl_ &&
       connFlowControl_->ingressBytesProcessed(writeBuf_, bytes)) {
+    // A session window grown by auto-tuning needs a read buffer that holds
+    // all of it, or reads would pause before the window is used.  Never
+    // lower a limit, the application may have raised it itself.
+    auto capacity = connFlowControl_->getReceiveWindowCapacity();
+    if (getTunedSessionWindowLimit(receiveSessionWindowSize_) > 0 &&
+        capacity > getReadBufferLimit()) {
+      HTTPSessionBase::setReadBufferLimit(capacity);
+    }
     scheduleWrite();
   }
 }
 
+std::chrono::microseconds HTTPSession::getRTT() const noexcept {
+  return pingRTT_.count() > 0 ? pingRTT_ : transportInfo_.rtt;
+}
+
+void HTTPSession::applyReceiveWindowTuning() {
+  const auto sessionLimit =
+    getTunedSessionWindowLimit(receiveSessionWindowSize_);
+  const auto streamLimit = getTunedStreamWindowLimit(receiveStreamWindowSize_);
+  if (connFlowControl_) {
+    connFlowControl_->setReceiveWindowTuning(sessionLimit);
+  }
+  if (codec_->supportsStreamFlowControl()) {
+    for (auto& txn : transactions_) {
+      txn.second.setReceiveWindowTuning(streamLimit);
+    }
+  }
+  if ((sessionLimit || streamLimit) && started_ && getRTT().count() == 0) {
+    // The tuner needs an RTT estimate before it can grow anything
+    sendPing();
+  }
+}
+
 void
 HTTPSession::notifyEgressBodyBuffered(int64_t bytes) noexcept {
   if (HTTPSessionBase::notifyEgressBodyBuffered(bytes, true) &&
@@ -2125,6 +2182,8 @@ HTTPSession::runLoopCallback() noexcept {
   //   * The session has generated some egress data (see scheduleWrite())
   //   * Reads have become unpaused (see resumeReads())
   DestructorGuard dg(this);
+  HTTPSessionProfiler::SessionScope profile(
+    *this, ProfiledCallback::RUN_LOOP_CALLBACK);
   inLoopCallback_ = true;
   auto scopeg = folly::makeGuard([this] {
       inLoopCallback_ = false;
@@ -2134,6 +2193,10 @@ HTTPSession::runLoopCallback() noexcept {
     });
   VLOG(5) << *this << " in loop callback";
 
+  if (hasPendingWindowUpdates()) {
+    flushWindowUpdates();
+  }
+
   for (uint32_t i = 0; i < kMaxWritesPerLoop; ++i) {
     bodyBytesPerWriteBuf_ = 0;
     if (isPrioritySampled()) {
@@ -2151,6 +2214,10 @@ HTTPSession::runLoopCallback() noexcept {
       break;
     }
     uint64_t len = writeBuf->computeChainDataLength();
+    if (len <= writeCoalescingThreshold_ && writeBuf->isChained()) {
+      // Many tiny frames: one memcpy is cheaper than one iovec apiece
+      writeBuf->coalesce();
+    }
     VLOG(11) << *this
              << " bytes of egress to be written: " << len
              << " cork:" << cork << " eom:" << eom;
@@ -2211,12 +2278,38 @@ HTTPSession::scheduleWrite() {
   // batch helps us packetize the network traffic more efficiently,
   // as well as saving a few system calls.
   if (!isLoopCallbackScheduled() &&
-      (writeBuf_.front() || !txnEgressQueue_.empty())) {
+      (writeBuf_.front() || !txnEgressQueue_.empty() ||
+       hasPendingWindowUpdates())) {
     VLOG(5) << *this << " scheduling write callback";
     sock_->getEventBase()->runInLoop(this);
   }
 }
 
+void HTTPSession::setWindowUpdateCoalescing(bool enabled) {
+  coalesceWindowUpdates_ = enabled;
+  if (connFlowControl_) {
+    connFlowControl_->setDeferWindowUpdates(enabled);
+  }
+  if (!enabled && hasPendingWindowUpdates()) {
+    flushWindowUpdates();
+    scheduleWrite();
+  }
+}
+
+void HTTPSession::flushWindowUpdates() {
+  if (connFlowControl_) {
+    connFlowControl_->flushWindowUpdate(writeBuf_);
+  }
+  for (const auto& update : pendingWindowUpdates_) {
+    HTTPTransaction* txn = findTransaction(update.first);
+    // No point in crediting a stream that has finished receiving
+    if (txn && !txn->isIngressEOMSeen()) {
+      codec_->generateWindowUpdate(writeBuf_, update.first, update.second);
+    }
+  }
+  pendingWindowUpdates_.clear();
+}
+
 void
 HTTPSession::updateWriteCount() {
   if (numActiveWrites_ > 0 && writesUnpaused()) {
@@ -2456,6 +2549,9 @@ bool HTTPSession::shouldShutdown() const {
 size_t HTTPSession::sendPing() {
   const size_t bytes = codec_->generatePingRequest(writeBuf_);
   if (bytes) {
+    if (!timePointInitialized(pingSentTime_)) {
+      pingSentTime_ = getCurrentTime();
+    }
     scheduleWrite();
   }
   return bytes;
@@ -2547,6 +2643,9 @@ HTTPSession::createTransaction(
   if (isPrioritySampled()) {
     txn->setPrioritySampled(true /* sampled */);
   }
+  if (isTransactionTimingsEnabled()) {
+    txn->setTimingsEnabled(true);
+  }
 
   if (getNumTxnServed() > 0) {
     auto stats = txn->getSessionStats();
@@ -2561,6 +2660,8 @@ HTTPSession::createTransaction(
   ++liveTransactions_;
   incrementSeqNo();
   txn->setReceiveWindow(receiveStreamWindowSize_);
+  txn->setReceiveWindowTuning(
+    getTunedStreamWindowLimit(receiveStreamWindowSize_));
 
   if (isUpstream() && !txn->isPushed()) {
     incrementOutgoingStreams();
@@ -28,6 +28,7 @@
 #include <proxygen/lib/http/session/SecondaryAuthManagerBase.h>
 #include <queue>
 #include <set>
+#include <unordered_map>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <vector>
@@ -75,6 +76,11 @@ class HTTPSession:
     return sock_.get();
   }
 
+  // Shared by HTTPSessionBase and HTTPTransaction::Transport
+  const TimeUtil& getClock() const override {
+    return HTTPSessionBase::getClock();
+  }
+
   bool hasActiveTransactions() const override {
     return !transactions_.empty();
   }
@@ -147,6 +153,26 @@ class HTTPSession:
    */
   void setEgressBytesLimit(uint64_t bytesLimit);
 
+  static constexpr uint32_t kDefaultWriteCoalescingThreshold = 4096;
+
+  /**
+   * Writes whose total size is at most this many bytes are coalesced into a
+   * single contiguous buffer before being handed to the transport, so that
+   * many small frames (e.g. DATA frames from several streams) go out as one
+   * iovec.  0 disables coalescing.
+   */
+  void setWriteCoalescingThreshold(uint32_t bytes) {
+    writeCoalescingThreshold_ = bytes;
+  }
+
+  /**
+   * When enabled, WINDOW_UPDATEs that become due while ingress is processed
+   * are not generated right away.  The credit is accumulated per stream and
+   * for the session, and written as at most one WINDOW_UPDATE per stream at
+   * the end of the event loop iteration, together with the other egress.
+   */
+  void setWindowUpdateCoalescing(bool enabled);
+
   /**
    * Start reading from the transport and send any introductory messages
    * to the remote side. This function must be called once per session to
@@ -499,6 +525,16 @@ class HTTPSession:
    */
   void scheduleWrite();
 
+  /**
+   * Generates the WINDOW_UPDATEs deferred by window update coalescing.
+   */
+  void flushWindowUpdates();
+
+  bool hasPendingWindowUpdates() const {
+    return !pendingWindowUpdates_.empty() ||
+      (connFlowControl_ && connFlowControl_->hasPendingWindowUpdate());
+  }
+
   /**
    * Update the size of the unwritten egress data and invoke
    * callbacks if the size has crossed the buffering limit.
@@ -748,6 +784,11 @@ class HTTPSession:
   void onConnectionSendWindowOpen() override;
   void onConnectionSendWindowClosed() override;
 
+  // Shared by FlowControlFilter::Callback and HTTPTransaction::Transport
+  std::chrono::microseconds getRTT() const noexcept override;
+
+  void applyReceiveWindowTuning() override;
+
   /**
    * Get the id of the stream we should ack in a graceful GOAWAY
    */
@@ -977,11 +1018,30 @@ class HTTPSession:
    */
   uint64_t egressBytesLimit_{0};
 
+  /**
+   * Max size of a chained write that will be coalesced before writeChain
+   */
+  uint32_t writeCoalescingThreshold_{kDefaultWriteCoalescingThreshold};
+
+  /**
+   * Stream credit waiting for flushWindowUpdates(), only used with window
+   * update coalescing.
+   */
+  std::unordered_map<HTTPCodec::StreamID, uint32_t> pendingWindowUpdates_;
+  bool coalesceWindowUpdates_{false};
+
   // Flow control settings
   size_t initialReceiveWindow_{0};
   size_t receiveStreamWindowSize_{0};
   size_t receiveSessionWindowSize_{0};
 
+  /**
+   * Smoothed round trip time measured with PINGs, zero until the first reply.
+   * Only one PING is timed at a time.
+   */
+  std::chrono::microseconds pingRTT_{0};
+  TimePoint pingSentTime_;
+
   class ShutdownTransportCallback : public folly::EventBase::LoopCallback {
    public:
     explicit ShutdownTransportCallback(HTTPSession* session) :
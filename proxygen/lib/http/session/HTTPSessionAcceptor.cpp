@@ -116,10 +116,15 @@ void HTTPSessionAcceptor::onNewConnection(
   session->setFlowControl(accConfig_.initialReceiveWindow,
                           accConfig_.receiveStreamWindowSize,
                           accConfig_.receiveSessionWindowSize);
+  session->setReceiveWindowTuning(accConfig_.maxReceiveStreamWindowSize,
+                                  accConfig_.maxReceiveSessionWindowSize);
+  session->setWindowUpdateCoalescing(accConfig_.coalesceWindowUpdates);
+  session->setTransactionTimings(accConfig_.enableTransactionTimings);
   if (accConfig_.writeBufferLimit > 0) {
     session->setWriteBufferLimit(accConfig_.writeBufferLimit);
   }
   session->setSessionStats(downstreamSessionStats_);
+  session->setProfiler(sessionProfiler_);
   Acceptor::addConnection(session);
   session->startNow();
 }
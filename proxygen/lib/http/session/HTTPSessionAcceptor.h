@@ -122,6 +122,16 @@ protected:
 
   HTTPSessionStats* downstreamSessionStats_{nullptr};
 
+  /**
+   * Profile the callbacks of every session created from now on.  profiler
+   * must outlive those sessions.
+   */
+  void setSessionProfiler(HTTPSessionProfiler* profiler) {
+    sessionProfiler_ = profiler;
+  }
+
+  HTTPSessionProfiler* sessionProfiler_{nullptr};
+
   HTTPSession::InfoCallback* getSessionInfoCallback() {
     return sessionInfoCb_ ? sessionInfoCb_ : this;
   }
@@ -9,10 +9,12 @@
  */
 #include <proxygen/lib/http/session/HTTPSessionBase.h>
 
+#include <proxygen/lib/http/codec/HTTP1xCodec.h>
 #include <proxygen/lib/http/codec/HTTP2Codec.h>
 #include <proxygen/lib/http/session/ByteEventTracker.h>
 #include <proxygen/lib/http/session/HTTPSessionController.h>
 #include <proxygen/lib/http/session/HTTPSessionStats.h>
+#include <proxygen/lib/utils/CoarseTimeUtil.h>
 
 using folly::SocketAddress;
 using wangle::TransportInfo;
@@ -55,6 +57,12 @@ HTTPSessionBase::HTTPSessionBase(
   setController(controller);
 }
 
+HTTPSessionBase::~HTTPSessionBase() {
+  if (profiler_) {
+    profiler_->onSessionDestroyed(profile_);
+  }
+}
+
 void HTTPSessionBase::runDestroyCallbacks() {
   if (infoCallback_) {
     infoCallback_->onDestroy(*this);
@@ -81,6 +89,16 @@ void HTTPSessionBase::initCodecHeaderIndexingStrategy() {
     HTTP2Codec* h2Codec = static_cast<HTTP2Codec*>(codec_.getChainEndPtr());
     h2Codec->setHeaderIndexingStrategy(
       controller_->getHeaderIndexingStrategy());
+    if (auto hpackTemplate = controller_->getHPACKTemplate()) {
+      h2Codec->setHPACKTemplate(std::move(hpackTemplate));
+    }
+    h2Codec->setIngressHeadersBatching(
+      controller_->getIngressHeadersBatching());
+  } else if (controller_ &&
+             codec_->getProtocol() == CodecProtocol::HTTP_1_1 &&
+             controller_->getKeepIngressHeaderLines()) {
+    HTTP1xCodec* h1Codec = static_cast<HTTP1xCodec*>(codec_.getChainEndPtr());
+    h1Codec->setKeepIngressHeaderLines(true);
   }
 }
 
@@ -230,6 +248,16 @@ HTTPSessionBase::handleErrorDirectly(HTTPTransaction* txn,
   txn->onError(error);
 }
 
+const TimeUtil& HTTPSessionBase::getClock() const {
+  static const TimeUtil kSteadyClock;
+  auto eventBase = getEventBase();
+  if (eventBase != clockEventBase_) {
+    clockEventBase_ = eventBase;
+    clock_ = eventBase ? &CoarseTimeUtil::get(eventBase) : nullptr;
+  }
+  return clock_ ? *clock_ : kSteadyClock;
+}
+
 HTTPTransaction::Handler*
 HTTPSessionBase::getParseErrorHandler(HTTPTransaction* txn,
                                       const HTTPException& error) {
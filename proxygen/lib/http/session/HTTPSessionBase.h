@@ -16,6 +16,7 @@
 #include <wangle/acceptor/TransportInfo.h>
 #include <proxygen/lib/utils/Time.h>
 #include <proxygen/lib/http/codec/HTTPCodecFilter.h>
+#include <proxygen/lib/http/session/HTTPSessionProfiler.h>
 #include <proxygen/lib/http/session/HTTPTransaction.h>
 
 namespace proxygen {
@@ -90,7 +91,7 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     const WheelTimerInstance& timeout,
     HTTPCodec::StreamID rootNodeId);
 
-  virtual ~HTTPSessionBase() {}
+  virtual ~HTTPSessionBase();
 
   /**
    * Set the read buffer limit to be used for all new HTTPSessionBase objects.
@@ -132,6 +133,25 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     sessionStats_ = stats;
   }
 
+  /**
+   * Attribute the CPU time of this session's event base callbacks to
+   * profiler, which must outlive the session.
+   */
+  void setProfiler(HTTPSessionProfiler* profiler) {
+    profiler_ = profiler;
+  }
+
+  HTTPSessionProfiler* getProfiler() const {
+    return profiler_;
+  }
+
+  /**
+   * The CPU time of this session's callbacks while a profiler was set.
+   */
+  const SessionProfile& getProfile() const {
+    return profile_;
+  }
+
   virtual SessionType getType() const noexcept = 0;
 
   virtual folly::AsyncTransportWrapper* getTransport() = 0;
@@ -140,6 +160,13 @@ class HTTPSessionBase : public wangle::ManagedConnection {
 
   virtual folly::EventBase* getEventBase() const = 0;
 
+  /**
+   * The CoarseTimeUtil of the session's event base, or the steady clock
+   * while the session has none.  For timestamps on the request path that
+   * can be one loop iteration old.
+   */
+  const TimeUtil& getClock() const;
+
   /**
    * Called by handleErrorDirectly (when handling parse errors) if the
    * transaction has no handler.
@@ -211,6 +238,29 @@ class HTTPSessionBase : public wangle::ManagedConnection {
    size_t receiveStreamWindowSize,
    size_t receiveSessionWindowSize) = 0;
 
+  /**
+   * Enable receive window auto-tuning.  Session and stream receive windows
+   * start at the sizes given to setFlowControl and, while they rather than
+   * the application limit how fast the peer can send, grow up to these
+   * maxima (see ReceiveWindowTuner).  0 disables tuning of that window.
+   */
+  void setReceiveWindowTuning(uint32_t maxStreamWindowSize,
+                              uint32_t maxSessionWindowSize) {
+    maxStreamWindowSize_ = maxStreamWindowSize;
+    maxSessionWindowSize_ = maxSessionWindowSize;
+    applyReceiveWindowTuning();
+  }
+
+  /**
+   * While under memory pressure, receive windows grown by auto-tuning are
+   * shrunk back to the sizes given to setFlowControl, as the peer's data is
+   * consumed, and do not grow again until the pressure ends.
+   */
+  void setMemoryPressure(bool underPressure) {
+    memoryPressure_ = underPressure;
+    applyReceiveWindowTuning();
+  }
+
   /**
    * Set outgoing settings for this session
    */
@@ -255,6 +305,10 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     VLOG(4) << "write buffer limit: " << int(limit / 1000) << "KB";
   }
 
+  uint32_t getReadBufferLimit() const {
+    return readBufLimit_;
+  }
+
   void setReadBufferLimit(uint32_t limit) {
     readBufLimit_ = limit;
   }
@@ -317,6 +371,18 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     prioritySample_ = sampled;
   }
 
+  /**
+   * Record TransactionTimings on every transaction created from now on (see
+   * HTTPTransaction::setTimingsEnabled).
+   */
+  void setTransactionTimings(bool enabled) {
+    transactionTimings_ = enabled;
+  }
+
+  bool isTransactionTimingsEnabled() const {
+    return transactionTimings_;
+  }
+
   // public HTTPTransaction::Transport overrides
   const folly::SocketAddress& getLocalAddress()
     const noexcept /*override*/ {
@@ -479,7 +545,24 @@ class HTTPSessionBase : public wangle::ManagedConnection {
   bool notifyBodyProcessed(uint32_t bytes);
 
   void setLatestActive() {
-    latestActive_ = getCurrentTime();
+    latestActive_ = getClock().now();
+  }
+
+  /**
+   * Pushes the receive window tuning limits to the session and its streams.
+   */
+  virtual void applyReceiveWindowTuning() = 0;
+
+  /**
+   * The largest size the auto-tuner may grow a stream (session) window that
+   * was configured to baseSize to.  0 means tuning is disabled.
+   */
+  uint32_t getTunedStreamWindowLimit(uint32_t baseSize) const {
+    return getTunedWindowLimit(baseSize, maxStreamWindowSize_);
+  }
+
+  uint32_t getTunedSessionWindowLimit(uint32_t baseSize) const {
+    return getTunedWindowLimit(baseSize, maxSessionWindowSize_);
   }
 
   bool ingressLimitExceeded() const {
@@ -584,6 +667,13 @@ class HTTPSessionBase : public wangle::ManagedConnection {
   // single path to update controller_
   HTTPSessionController* controller_{nullptr};
 
+  uint32_t getTunedWindowLimit(uint32_t baseSize, uint32_t maxSize) const {
+    if (maxSize == 0) {
+      return 0;
+    }
+    return memoryPressure_ ? baseSize : std::max(baseSize, maxSize);
+  }
+
   // private ManagedConnection methods
   std::chrono::milliseconds getIdleTime() const override {
     if (timePointInitialized(latestActive_)) {
@@ -606,6 +696,10 @@ class HTTPSessionBase : public wangle::ManagedConnection {
    */
   TimePoint latestActive_{};
 
+  // getClock() looks the clock up again when the event base changes
+  mutable folly::EventBase* clockEventBase_{nullptr};
+  mutable const TimeUtil* clock_{nullptr};
+
   /**
    * The idle duration between latest two consecutive active status
    */
@@ -642,6 +736,19 @@ class HTTPSessionBase : public wangle::ManagedConnection {
   uint32_t readBufLimit_{kDefaultReadBufLimit};
   uint32_t writeBufLimit_{kDefaultWriteBufLimit};
 
+  /**
+   * Receive window auto-tuning limits, 0 when disabled.
+   */
+  uint32_t maxStreamWindowSize_{0};
+  uint32_t maxSessionWindowSize_{0};
+  bool memoryPressure_{false};
+
+  bool transactionTimings_{false};
+
+  HTTPSessionProfiler* profiler_{nullptr};
+  SessionProfile profile_;
+  friend class HTTPSessionProfiler::SessionScope;
+
   /**
    * Bytes of egress data sent to the socket but not yet written
    * to the network.
@@ -11,6 +11,7 @@
 
 #include <chrono>
 #include <glog/logging.h>
+#include <proxygen/lib/http/codec/compress/HPACKTemplate.h>
 #include <proxygen/lib/http/codec/compress/HeaderIndexingStrategy.h>
 
 namespace folly {
@@ -96,6 +97,30 @@ class HTTPSessionController {
   virtual const HeaderIndexingStrategy* getHeaderIndexingStrategy() const {
     return HeaderIndexingStrategy::getDefaultInstance();
   }
+
+  /**
+   * Returns the HPACK template H2 sessions offer to preload, or nullptr for
+   * none.  Both peers need the same template for it to be used.
+   */
+  virtual std::shared_ptr<const HPACKTemplate> getHPACKTemplate() const {
+    return nullptr;
+  }
+
+  /**
+   * Returns whether H2 sessions receive bursts of new requests from one read
+   * as a batch, see HTTP2Codec::setIngressHeadersBatching
+   */
+  virtual bool getIngressHeadersBatching() const {
+    return false;
+  }
+
+  /**
+   * Returns whether HTTP/1.x sessions keep the header lines of ingress
+   * messages, see HTTP1xCodec::setKeepIngressHeaderLines
+   */
+  virtual bool getKeepIngressHeaderLines() const {
+    return false;
+  }
 };
 
 
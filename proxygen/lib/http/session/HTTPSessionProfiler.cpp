@@ -0,0 +1,120 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/http/session/HTTPSessionProfiler.h>
+
+#include <proxygen/lib/http/session/HTTPSessionBase.h>
+
+#include <folly/Demangle.h>
+#include <folly/portability/Time.h>
+#include <glog/logging.h>
+
+namespace proxygen {
+
+const char* getProfiledCallbackString(ProfiledCallback callback) {
+  switch (callback) {
+    case ProfiledCallback::READ_DATA_AVAILABLE: return "readDataAvailable";
+    case ProfiledCallback::PROCESS_READ_DATA: return "processReadData";
+    case ProfiledCallback::RUN_LOOP_CALLBACK: return "runLoopCallback";
+    case ProfiledCallback::HANDLER: return "handler";
+  }
+  return "Unknown";
+}
+
+HTTPSessionProfiler::HTTPSessionProfiler(
+  HTTPSessionProfilerStats* stats,
+  std::chrono::microseconds slowThreshold)
+    : stats_(stats),
+      slowThreshold_(slowThreshold) {
+}
+
+std::chrono::nanoseconds HTTPSessionProfiler::getThreadCPUTime() noexcept {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+HTTPSessionProfiler::SessionScope::SessionScope(HTTPSessionBase& session,
+                                                ProfiledCallback callback)
+    : callback_(callback) {
+  if (session.getProfiler()) {
+    session_ = &session;
+    start_ = getThreadCPUTime();
+  }
+}
+
+HTTPSessionProfiler::SessionScope::~SessionScope() {
+  if (session_) {
+    session_->getProfiler()->onSessionCallback(
+      callback_, getThreadCPUTime() - start_, session_->profile_, *session_);
+  }
+}
+
+void HTTPSessionProfiler::onSessionCallback(ProfiledCallback callback,
+                                            std::chrono::nanoseconds cpuTime,
+                                            SessionProfile& profile,
+                                            const HTTPSessionBase& session) {
+  bool slow = cpuTime > slowThreshold_;
+  auto index = static_cast<size_t>(callback);
+  profile[index].add(cpuTime, slow);
+  totals_[index].add(cpuTime, slow);
+  if (stats_) {
+    stats_->recordCallbackTime(callback, cpuTime);
+  }
+  if (slow) {
+    VLOG(2) << "slow " << getProfiledCallbackString(callback) << " took "
+            << cpuTime.count() << "ns";
+    if (stats_) {
+      stats_->recordSlowSessionCallback(callback, cpuTime, session);
+    }
+  }
+}
+
+void HTTPSessionProfiler::onHandlerCallback(std::chrono::nanoseconds cpuTime,
+                                            CallbackProfile& profile,
+                                            const std::type_info& handler,
+                                            const char* callback) {
+  bool slow = cpuTime > slowThreshold_;
+  auto index = static_cast<size_t>(ProfiledCallback::HANDLER);
+  profile.add(cpuTime, slow);
+  totals_[index].add(cpuTime, slow);
+  if (stats_) {
+    stats_->recordCallbackTime(ProfiledCallback::HANDLER, cpuTime);
+  }
+  if (slow) {
+    auto name = folly::demangle(handler);
+    VLOG(2) << "slow " << name << "::" << callback << " took "
+            << cpuTime.count() << "ns";
+    if (stats_) {
+      stats_->recordSlowHandlerCallback(name, callback, cpuTime);
+    }
+  }
+}
+
+void HTTPSessionProfiler::onSessionDestroyed(const SessionProfile& profile) {
+  if (stats_) {
+    stats_->recordSessionProfile(profile);
+  }
+}
+
+void HTTPSessionProfiler::onHandlerDetached(const std::type_info& handler,
+                                            const CallbackProfile& profile) {
+  auto& totals = handlerProfiles_[std::type_index(handler)];
+  totals.calls += profile.calls;
+  totals.slowCalls += profile.slowCalls;
+  totals.cpuTime += profile.cpuTime;
+  totals.maxCpuTime = std::max(totals.maxCpuTime, profile.maxCpuTime);
+  if (stats_) {
+    stats_->recordHandlerProfile(folly::demangle(handler), profile);
+  }
+}
+
+}
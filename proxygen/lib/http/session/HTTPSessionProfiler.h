@@ -0,0 +1,196 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/Range.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace proxygen {
+
+class HTTPSessionBase;
+
+/**
+ * The event base callbacks that HTTPSessionProfiler attributes CPU time to.
+ * READ_DATA_AVAILABLE includes the PROCESS_READ_DATA it triggers.
+ */
+enum class ProfiledCallback : uint8_t {
+  READ_DATA_AVAILABLE = 0,
+  PROCESS_READ_DATA = 1,
+  RUN_LOOP_CALLBACK = 2,
+  HANDLER = 3,
+};
+
+constexpr size_t kNumProfiledCallbacks = 4;
+
+const char* getProfiledCallbackString(ProfiledCallback callback);
+
+struct CallbackProfile {
+  uint64_t calls{0};
+  // calls that took longer than the slow threshold
+  uint64_t slowCalls{0};
+  std::chrono::nanoseconds cpuTime{0};
+  std::chrono::nanoseconds maxCpuTime{0};
+
+  void add(std::chrono::nanoseconds time, bool slow) {
+    calls++;
+    slowCalls += slow;
+    cpuTime += time;
+    maxCpuTime = std::max(maxCpuTime, time);
+  }
+};
+
+/**
+ * Per session counters, indexed by ProfiledCallback.
+ */
+using SessionProfile = std::array<CallbackProfile, kNumProfiledCallbacks>;
+
+/**
+ * Receives what an HTTPSessionProfiler measures.  All methods are called on
+ * the event base thread of the profiled session.
+ */
+class HTTPSessionProfilerStats {
+ public:
+  virtual ~HTTPSessionProfilerStats() {}
+
+  // Every profiled session callback
+  virtual void recordCallbackTime(ProfiledCallback callback,
+                                  std::chrono::nanoseconds cpuTime) noexcept = 0;
+
+  // A session callback that took longer than the slow threshold
+  virtual void recordSlowSessionCallback(
+      ProfiledCallback callback,
+      std::chrono::nanoseconds cpuTime,
+      const HTTPSessionBase& session) noexcept = 0;
+
+  // A request handler callback that took longer than the slow threshold
+  virtual void recordSlowHandlerCallback(
+      folly::StringPiece handler,
+      folly::StringPiece callback,
+      std::chrono::nanoseconds cpuTime) noexcept = 0;
+
+  // The totals of a session, when it is destroyed
+  virtual void recordSessionProfile(const SessionProfile&) noexcept {}
+
+  // The totals of a request handler, when it is detached
+  virtual void recordHandlerProfile(folly::StringPiece /*handler*/,
+                                    const CallbackProfile&) noexcept {}
+};
+
+/**
+ * Measures the thread CPU time spent in HTTPSession's event base callbacks
+ * and in request handler callbacks, to find which session or handler stalls
+ * an IO thread.  Counters are kept per session (HTTPSessionBase::
+ * getProfile()), per handler class, and for the whole thread, and callbacks
+ * taking longer than slowThreshold are reported individually.
+ *
+ * One profiler serves the sessions of one event base and is not thread safe.
+ * Every measurement reads the thread CPU clock twice, so only enable it where
+ * that overhead is acceptable.
+ */
+class HTTPSessionProfiler {
+ public:
+  HTTPSessionProfiler(HTTPSessionProfilerStats* stats,
+                      std::chrono::microseconds slowThreshold);
+
+  static std::chrono::nanoseconds getThreadCPUTime() noexcept;
+
+  /**
+   * Times the enclosing scope as a callback of session, if it has a profiler.
+   * The session must outlive the scope.
+   */
+  class SessionScope {
+   public:
+    SessionScope(HTTPSessionBase& session, ProfiledCallback callback);
+    ~SessionScope();
+
+   private:
+    HTTPSessionBase* session_{nullptr};
+    ProfiledCallback callback_;
+    std::chrono::nanoseconds start_;
+  };
+
+  /**
+   * Times the enclosing scope as the given handler callback, if profiler is
+   * set.  profile accumulates the handler's totals.
+   */
+  class HandlerScope {
+   public:
+    HandlerScope(HTTPSessionProfiler* profiler,
+                 CallbackProfile& profile,
+                 const std::type_info& handler,
+                 const char* callback)
+        : profiler_(profiler),
+          profile_(profile),
+          handler_(handler),
+          callback_(callback) {
+      if (profiler_) {
+        start_ = getThreadCPUTime();
+      }
+    }
+
+    ~HandlerScope() {
+      if (profiler_) {
+        profiler_->onHandlerCallback(getThreadCPUTime() - start_, profile_,
+                                     handler_, callback_);
+      }
+    }
+
+   private:
+    HTTPSessionProfiler* profiler_;
+    CallbackProfile& profile_;
+    const std::type_info& handler_;
+    const char* callback_;
+    std::chrono::nanoseconds start_;
+  };
+
+  void onSessionCallback(ProfiledCallback callback,
+                         std::chrono::nanoseconds cpuTime,
+                         SessionProfile& profile,
+                         const HTTPSessionBase& session);
+
+  void onHandlerCallback(std::chrono::nanoseconds cpuTime,
+                         CallbackProfile& profile,
+                         const std::type_info& handler,
+                         const char* callback);
+
+  void onSessionDestroyed(const SessionProfile& profile);
+
+  void onHandlerDetached(const std::type_info& handler,
+                         const CallbackProfile& profile);
+
+  /**
+   * Totals of every session callback profiled on this thread.
+   */
+  const SessionProfile& getTotals() const {
+    return totals_;
+  }
+
+  /**
+   * Totals by the class of the request handler.
+   */
+  const std::unordered_map<std::type_index, CallbackProfile>&
+  getHandlerProfiles() const {
+    return handlerProfiles_;
+  }
+
+ private:
+  HTTPSessionProfilerStats* stats_;
+  const std::chrono::nanoseconds slowThreshold_;
+  SessionProfile totals_;
+  std::unordered_map<std::type_index, CallbackProfile> handlerProfiles_;
+};
+
+}
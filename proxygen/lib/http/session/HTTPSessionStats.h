@@ -15,6 +15,8 @@
 
 namespace proxygen {
 
+struct TransactionTimings;
+
 // This may be retired with a byte events refactor
 class HTTPSessionStats : public TTLBAStats {
  public:
@@ -27,6 +29,9 @@ class HTTPSessionStats : public TTLBAStats {
   virtual void recordSessionIdleTime(std::chrono::seconds) noexcept {}
   virtual void recordTransactionStalled() noexcept = 0;
   virtual void recordSessionStalled() noexcept = 0;
+  // Only called for transactions with timings enabled, right before the
+  // handler is detached.  Meant to feed per-milestone histograms.
+  virtual void recordTransactionTimings(const TransactionTimings&) noexcept {}
 };
 
 }
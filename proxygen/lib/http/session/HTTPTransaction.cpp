@@ -28,6 +28,8 @@ namespace {
   const std::chrono::seconds kRateLimitMaxDelay(10);
 }
 
+constexpr size_t HTTPTransaction::kEgressBodyHeadroom;
+
 HTTPTransaction::HTTPTransaction(TransportDirection direction,
                                  HTTPCodec::StreamID id,
                                  uint32_t seqNo,
@@ -72,6 +74,7 @@ HTTPTransaction::HTTPTransaction(TransportDirection direction,
     priorityFallback_(false),
     headRequest_(false),
     enableLastByteFlushedTracking_(false),
+    timingsEnabled_(false),
     transactionTimeout_(defaultTimeout),
     timer_(timer) {
 
@@ -116,6 +119,9 @@ void HTTPTransaction::onDelayedDestroy(bool delayed) {
   }
   VLOG(4) << "destroying transaction " << *this;
   deleting_ = true;
+  if (timingsEnabled_ && stats_) {
+    stats_->recordTransactionTimings(timings_);
+  }
   if (handler_) {
     handler_->detachTransaction();
     handler_ = nullptr;
@@ -159,6 +165,7 @@ void HTTPTransaction::reset(bool useFlowControl,
 void HTTPTransaction::onIngressHeadersComplete(
   std::unique_ptr<HTTPMessage> msg) {
   DestructorGuard g(this);
+  markTiming(&TransactionTimings::ingressHeadersComplete);
   msg->setSeqNo(seqNo_);
   if (isUpstream() && !isPushed() && msg->isResponse()) {
     lastResponseStatus_ = msg->getStatusCode();
@@ -214,6 +221,7 @@ void HTTPTransaction::processIngressHeadersComplete(
   }
   refreshTimeout();
   if (handler_ && !isIngressComplete()) {
+    markTiming(&TransactionTimings::handlerHeaders);
     handler_->onHeadersComplete(std::move(msg));
   }
 }
@@ -312,6 +320,9 @@ void HTTPTransaction::processIngressBody(unique_ptr<IOBuf> chain, size_t len) {
           divisor = 1;
         }
         if (uint32_t(recvToAck_) >= (recvWindow_.getCapacity() / divisor)) {
+          if (recvWindowTuner_) {
+            tuneReceiveWindow();
+          }
           flushWindowUpdate();
         }
       }
@@ -723,6 +734,7 @@ void HTTPTransaction::onEgressBodyFirstByte(
     }
     transportCallback_->firstByteFlushed();
   }
+  markTiming(&TransactionTimings::firstEgressBodyByteFlushed);
 }
 
 void HTTPTransaction::onEgressBodyLastByte(
@@ -734,6 +746,7 @@ void HTTPTransaction::onEgressBodyLastByte(
     }
     transportCallback_->lastByteFlushed();
   }
+  markTiming(&TransactionTimings::lastEgressByteFlushed);
 }
 
 void HTTPTransaction::onEgressBodyFirstByteTX() {
@@ -762,6 +775,7 @@ void HTTPTransaction::onEgressLastByteAck(std::chrono::milliseconds latency) {
   if (transportCallback_) {
     transportCallback_->lastByteAcked(latency);
   }
+  markTiming(&TransactionTimings::lastEgressByteAcked);
 }
 
 void HTTPTransaction::onLastEgressHeaderByteAcked() {
@@ -836,6 +850,7 @@ void HTTPTransaction::sendHeadersWithOptionalEOM(
       }
     }
   }
+  markTiming(&TransactionTimings::firstEgressHeaders);
   HTTPHeaderSize size;
   transport_.sendHeaders(this, headers, &size, eom);
   if (transportCallback_) {
@@ -995,7 +1010,7 @@ bool HTTPTransaction::maybeDelayForRateLimit() {
   }
 
   int64_t limitedDurationMs = (int64_t) millisecondsBetween(
-    getCurrentTime(),
+    transport_.getClock().now(),
     startRateLimit_
   ).count();
 
@@ -1343,7 +1358,7 @@ void HTTPTransaction::setEgressRateLimit(uint64_t bitsPerSecond) {
   if (bitsPerSecond > 0 && egressLimitBytesPerMs_ == 0) {
     VLOG(4) << "ratelim: Limit too low (" << bitsPerSecond << "), ignoring";
   }
-  startRateLimit_ = getCurrentTime();
+  startRateLimit_ = transport_.getClock().now();
   numLimitedBytesEgressed_ = 0;
 }
 
@@ -1503,6 +1518,34 @@ void HTTPTransaction::setReceiveWindow(uint32_t capacity) {
   flushWindowUpdate();
 }
 
+void HTTPTransaction::setReceiveWindowTuning(uint32_t maxCapacity) {
+  if (maxCapacity == 0) {
+    recvWindowTuner_.reset();
+  } else if (recvWindowTuner_) {
+    recvWindowTuner_->setMaxCapacity(maxCapacity);
+  } else {
+    recvWindowTuner_ = std::make_unique<ReceiveWindowTuner>(maxCapacity);
+  }
+}
+
+void HTTPTransaction::tuneReceiveWindow() {
+  const uint32_t capacity = recvWindow_.getCapacity();
+  const uint32_t target = recvWindowTuner_->getTargetCapacity(
+    capacity, transport_.getRTT());
+  if (target > capacity) {
+    if (recvWindow_.setCapacity(target)) {
+      recvToAck_ += target - capacity;
+    }
+  } else if (target < capacity && recvToAck_ > 0) {
+    // Only withhold credit for consumed bytes; the peer may already have
+    // sent up to the old capacity.
+    uint32_t shrink = std::min<uint32_t>(capacity - target, recvToAck_);
+    CHECK(recvWindow_.setCapacity(capacity - shrink));
+    recvToAck_ -= shrink;
+    VLOG(4) << "Shrunk recv window to " << capacity - shrink << " " << *this;
+  }
+}
+
 void HTTPTransaction::flushWindowUpdate() {
   if (recvToAck_ > 0 && useFlowControl_ && !isIngressEOMSeen() &&
       (direction_ == TransportDirection::DOWNSTREAM ||
@@ -21,6 +21,7 @@
 #include <proxygen/lib/http/HTTPHeaderSize.h>
 #include <proxygen/lib/http/HTTPMessage.h>
 #include <proxygen/lib/http/ProxygenErrorEnum.h>
+#include <proxygen/lib/http/ReceiveWindowTuner.h>
 #include <proxygen/lib/http/Window.h>
 #include <proxygen/lib/http/codec/HTTPCodec.h>
 #include <proxygen/lib/http/session/HTTP2PriorityQueue.h>
@@ -127,6 +128,39 @@ class TransactionInfo {
   bool isCompleted{false};
 };
 
+/**
+ * Monotonic timestamps of the milestones of a transaction, recorded once
+ * HTTPTransaction::setTimingsEnabled(true) has been called.  Each milestone
+ * is recorded the first time it happens; milestones that did not happen are
+ * left at the default TimePoint.
+ */
+struct TransactionTimings {
+  /** The codec started parsing the ingress message */
+  TimePoint firstIngressByte;
+  /** The ingress headers were parsed */
+  TimePoint ingressHeadersComplete;
+  /** The ingress headers were delivered to the handler (onRequest) */
+  TimePoint handlerHeaders;
+  /** The first egress headers were generated */
+  TimePoint firstEgressHeaders;
+  /** The first egress body byte was written to the socket */
+  TimePoint firstEgressBodyByteFlushed;
+  /** The last egress byte was written to the socket */
+  TimePoint lastEgressByteFlushed;
+  /** The peer acknowledged the last egress byte (needs ack tracking) */
+  TimePoint lastEgressByteAcked;
+
+  /**
+   * The time from one milestone to another, or zero if either is missing.
+   */
+  static std::chrono::microseconds between(TimePoint from, TimePoint to) {
+    if (from == TimePoint() || to == TimePoint() || to < from) {
+      return std::chrono::microseconds(0);
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from);
+  }
+};
+
 class HTTPSessionStats;
 class HTTPTransaction;
 class HTTPTransactionHandler {
@@ -475,6 +509,23 @@ class HTTPTransaction :
     virtual folly::Optional<const HTTPMessage::HTTPPriority>
         getHTTPPriority(uint8_t level) = 0;
 
+    /**
+     * The current round trip time estimate of the underlying connection,
+     * zero if unknown.  Used to auto-tune the receive window.
+     */
+    virtual std::chrono::microseconds getRTT() const noexcept {
+      return std::chrono::microseconds::zero();
+    }
+
+    /**
+     * The clock for the transaction's timestamps.  Sessions return the
+     * coarse clock of their event base.
+     */
+    virtual const TimeUtil& getClock() const {
+      static const TimeUtil kClock;
+      return kClock;
+    }
+
     virtual folly::Expected<folly::Unit, ErrorCode> peek(
         PeekCallback /* peekCallback */) {
       LOG(FATAL) << __func__ << " not supported";
@@ -642,6 +693,14 @@ class HTTPTransaction :
    */
   virtual void setReceiveWindow(uint32_t capacity);
 
+  /**
+   * Enable receive window auto-tuning.  Whenever a window update is due, the
+   * window may be grown up to maxCapacity (see ReceiveWindowTuner).  Calling
+   * this again with a smaller maxCapacity shrinks a grown window back as
+   * credit is returned.  0 disables auto-tuning.
+   */
+  void setReceiveWindowTuning(uint32_t maxCapacity);
+
   /**
    * Get the receive window of the transaction
    */
@@ -653,6 +712,13 @@ class HTTPTransaction :
     return maxDeferredIngress_;
   }
 
+  /**
+   * Invoked by the session when the codec starts parsing an ingress message
+   */
+  void onIngressMessageBegin() {
+    markTiming(&TransactionTimings::firstIngressByte);
+  }
+
   /**
    * Invoked by the session when the ingress headers are complete
    */
@@ -916,6 +982,14 @@ class HTTPTransaction :
   virtual void sendHeadersWithEOM(const HTTPMessage& headers);
   virtual void sendHeadersWithOptionalEOM(const HTTPMessage& headers, bool eom);
 
+  /**
+   * Headroom callers should reserve in unshared body buffers passed to
+   * sendBody().  It is large enough to hold an HTTP/2 or SPDY DATA frame
+   * header, which codecs then write in place rather than allocating and
+   * chaining a separate buffer for it.
+   */
+  static constexpr size_t kEgressBodyHeadroom = 16;
+
   /**
    * Send part or all of the egress message body to the Transport. If flow
    * control is enabled, the chunk boundaries may not be respected.
@@ -926,7 +1000,7 @@ class HTTPTransaction :
    *
    * @param body Message body data; the Transport will take care of
    *             applying any necessary protocol framing, such as
-   *             chunk headers.
+   *             chunk headers.  See kEgressBodyHeadroom.
    */
   virtual void sendBody(std::unique_ptr<folly::IOBuf> body);
 
@@ -1371,6 +1445,25 @@ class HTTPTransaction :
     enableLastByteFlushedTracking_ = enabled;
   }
 
+  /**
+   * Start recording TransactionTimings.  When enabled, the timings are
+   * reported to HTTPSessionStats::recordTransactionTimings() right before
+   * the handler is detached, and can be read with getTimings() until then.
+   * The first ingress byte is only recorded if this is called before the
+   * message begins, as the session does with setTransactionTimings().
+   */
+  void setTimingsEnabled(bool enabled) {
+    timingsEnabled_ = enabled;
+  }
+
+  bool isTimingsEnabled() const {
+    return timingsEnabled_;
+  }
+
+  const TransactionTimings& getTimings() const {
+    return timings_;
+  }
+
   /**
    * Allows the caller to peek into underlying transport's read buffer.
    * This, together with consume(), forms a scatter/gather API.
@@ -1524,8 +1617,20 @@ class HTTPTransaction :
    */
   void flushWindowUpdate();
 
+  /**
+   * Applies the receive window tuner's target capacity to recvWindow_ and
+   * recvToAck_.
+   */
+  void tuneReceiveWindow();
+
   bool updateContentLengthRemaining(size_t len);
 
+  void markTiming(TimePoint TransactionTimings::*milestone) {
+    if (timingsEnabled_ && timings_.*milestone == TimePoint()) {
+      timings_.*milestone = transport_.getClock().now();
+    }
+  }
+
   void rateLimitTimeoutExpired();
 
   class RateLimitCallback : public folly::HHWheelTimer::Callback {
@@ -1614,6 +1719,8 @@ class HTTPTransaction :
    */
   int32_t recvToAck_{0};
 
+  std::unique_ptr<ReceiveWindowTuner> recvWindowTuner_;
+
   /**
    * ID of request transaction (for pushed txns only)
    */
@@ -1685,6 +1792,7 @@ class HTTPTransaction :
   bool priorityFallback_:1;
   bool headRequest_:1;
   bool enableLastByteFlushedTracking_:1;
+  bool timingsEnabled_:1;
 
   static uint64_t egressBufferLimit_;
 
@@ -1713,6 +1821,8 @@ class HTTPTransaction :
   // Keeps track for body offset processed so far.
   // Includes skipped bytes for partially reliable transactions.
   uint64_t ingressBodyOffset_{0};
+
+  TransactionTimings timings_;
 };
 
 /**
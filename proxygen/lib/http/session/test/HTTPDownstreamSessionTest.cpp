@@ -3603,6 +3603,105 @@ TEST_F(HTTP2DownstreamSessionTest, TestSessionStallByFlowControl) {
   flushRequestsAndLoop();
 }
 
+TEST_F(HTTP2DownstreamSessionTest, TransactionTimings) {
+  NiceMock<MockHTTPSessionStats> stats;
+  httpSession_->setSessionStats(&stats);
+  httpSession_->setTransactionTimings(true);
+
+  sendRequest();
+
+  InSequence handlerSequence;
+  auto handler = addSimpleStrictHandler();
+  handler->expectHeaders();
+  handler->expectEOM([&] {
+      handler->sendReplyWithBody(200, 100);
+    });
+  TransactionTimings timings;
+  EXPECT_CALL(stats, recordTransactionTimings(_))
+    .WillOnce(SaveArg<0>(&timings));
+  handler->expectDetachTransaction();
+  flushRequestsAndLoop();
+
+  EXPECT_NE(TimePoint(), timings.firstIngressByte);
+  EXPECT_LE(timings.firstIngressByte, timings.ingressHeadersComplete);
+  EXPECT_LE(timings.ingressHeadersComplete, timings.handlerHeaders);
+  EXPECT_LE(timings.handlerHeaders, timings.firstEgressHeaders);
+  EXPECT_LE(timings.firstEgressHeaders, timings.firstEgressBodyByteFlushed);
+  EXPECT_LE(timings.firstEgressBodyByteFlushed,
+            timings.lastEgressByteFlushed);
+  // No ack tracking in this session
+  EXPECT_EQ(TimePoint(), timings.lastEgressByteAcked);
+  EXPECT_EQ(std::chrono::microseconds(0),
+            TransactionTimings::between(timings.firstIngressByte,
+                                        timings.lastEgressByteAcked));
+  gracefulShutdown();
+}
+
+namespace {
+
+class CountingProfilerStats : public HTTPSessionProfilerStats {
+ public:
+  void recordCallbackTime(ProfiledCallback callback,
+                          std::chrono::nanoseconds) noexcept override {
+    calls[static_cast<size_t>(callback)]++;
+  }
+
+  void recordSlowSessionCallback(ProfiledCallback,
+                                 std::chrono::nanoseconds,
+                                 const HTTPSessionBase&) noexcept override {
+    slowCalls++;
+  }
+
+  void recordSlowHandlerCallback(folly::StringPiece,
+                                 folly::StringPiece,
+                                 std::chrono::nanoseconds) noexcept override {
+  }
+
+  void recordSessionProfile(const SessionProfile&) noexcept override {
+    sessionProfiles++;
+  }
+
+  std::array<uint64_t, kNumProfiledCallbacks> calls{};
+  uint64_t slowCalls{0};
+  uint64_t sessionProfiles{0};
+};
+
+}
+
+TEST_F(HTTP2DownstreamSessionTest, Profiler) {
+  CountingProfilerStats stats;
+  HTTPSessionProfiler profiler(&stats, std::chrono::microseconds(0));
+  httpSession_->setProfiler(&profiler);
+
+  sendRequest();
+
+  InSequence handlerSequence;
+  auto handler = addSimpleStrictHandler();
+  handler->expectHeaders();
+  handler->expectEOM([&] {
+      handler->sendReplyWithBody(200, 100);
+    });
+  handler->expectDetachTransaction();
+  flushRequestsAndLoop();
+
+  const auto& profile = httpSession_->getProfile();
+  uint64_t slow = 0;
+  for (auto callback : {ProfiledCallback::READ_DATA_AVAILABLE,
+                        ProfiledCallback::PROCESS_READ_DATA,
+                        ProfiledCallback::RUN_LOOP_CALLBACK}) {
+    auto index = static_cast<size_t>(callback);
+    EXPECT_GT(profile[index].calls, 0);
+    EXPECT_LE(profile[index].slowCalls, profile[index].calls);
+    EXPECT_EQ(profile[index].calls, stats.calls[index]);
+    EXPECT_EQ(profile[index].calls, profiler.getTotals()[index].calls);
+    slow += profile[index].slowCalls;
+  }
+  EXPECT_EQ(slow, stats.slowCalls);
+
+  gracefulShutdown();
+  EXPECT_EQ(1, stats.sessionProfiles);
+}
+
 TEST_F(HTTP2DownstreamSessionTest, TestTransactionStallByFlowControl) {
   StrictMock<MockHTTPSessionStats> stats;
 
@@ -0,0 +1,317 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/test/TestUtils.h>
+#include <proxygen/lib/http/session/HTTPDownstreamSession.h>
+#include <proxygen/lib/http/session/HTTPSessionController.h>
+#include <proxygen/lib/http/session/test/HTTPSessionTest.h>
+#include <proxygen/lib/http/session/test/TestUtils.h>
+#include <proxygen/lib/test/AllocationCounter.h>
+#include <proxygen/lib/test/TestAsyncTransport.h>
+
+#include <array>
+
+using namespace folly;
+using namespace proxygen;
+
+/**
+ * Holds HTTPDownstreamSession to a heap allocation budget per request.  A
+ * GET with a small response goes through the session on a keepalive
+ * connection, and AllocationCounter attributes every allocation to a phase:
+ *
+ *  PARSE      reading and parsing the request, up to the handler
+ *  HANDLER    the handler, including creating it
+ *  SERIALIZE  the handler's sendHeaders/sendBody/sendEOM calls
+ *  WRITE      everything else in the loop, which is mostly the session
+ *             flushing egress to the transport, including TestAsyncTransport
+ *             recording each write
+ *
+ * When a budget fails, find the new allocation before raising it.
+ */
+
+namespace {
+
+enum Phase : size_t {
+  WRITE = 0,
+  PARSE,
+  HANDLER,
+  SERIALIZE,
+  // the test's own work between requests, not part of any budget
+  HARNESS,
+  kNumPhases
+};
+
+const char* kPhaseNames[] = {"write", "parse", "handler", "serialize",
+                             "harness"};
+
+using PhaseStats = std::array<AllocationStats, kNumPhases>;
+
+PhaseStats getPhaseStats() {
+  PhaseStats stats;
+  for (size_t i = 0; i < kNumPhases; i++) {
+    stats[i] = AllocationCounter::get(i);
+  }
+  return stats;
+}
+
+/**
+ * Attributes the session's read callbacks to PARSE.
+ */
+class PhaseTransport
+    : public TestAsyncTransport,
+      private AsyncTransportWrapper::ReadCallback {
+ public:
+  explicit PhaseTransport(EventBase* eventBase)
+      : TestAsyncTransport(eventBase) {}
+
+  void setReadCB(AsyncTransportWrapper::ReadCallback* callback) override {
+    sessionReadCallback_ = callback;
+    TestAsyncTransport::setReadCB(callback ? this : nullptr);
+  }
+
+  AsyncTransportWrapper::ReadCallback* getReadCallback() const override {
+    return sessionReadCallback_;
+  }
+
+ private:
+  void getReadBuffer(void** bufReturn, size_t* lenReturn) override {
+    AllocationCounter::PhaseScope phase(PARSE);
+    sessionReadCallback_->getReadBuffer(bufReturn, lenReturn);
+  }
+
+  void readDataAvailable(size_t len) noexcept override {
+    AllocationCounter::PhaseScope phase(PARSE);
+    sessionReadCallback_->readDataAvailable(len);
+  }
+
+  bool isBufferMovable() noexcept override {
+    return sessionReadCallback_->isBufferMovable();
+  }
+
+  void readBufferAvailable(std::unique_ptr<IOBuf> buf) noexcept override {
+    AllocationCounter::PhaseScope phase(PARSE);
+    sessionReadCallback_->readBufferAvailable(std::move(buf));
+  }
+
+  void readEOF() noexcept override {
+    sessionReadCallback_->readEOF();
+  }
+
+  void readErr(const AsyncSocketException& ex) noexcept override {
+    sessionReadCallback_->readErr(ex);
+  }
+
+  AsyncTransportWrapper::ReadCallback* sessionReadCallback_{nullptr};
+};
+
+/**
+ * Replies to every request with a fixed 100 byte body.
+ */
+class ReplyHandler : public HTTPTransactionHandler {
+ public:
+  explicit ReplyHandler(uint32_t& completed) : completed_(completed) {}
+
+  void setTransaction(HTTPTransaction* txn) noexcept override {
+    txn_ = txn;
+  }
+  void detachTransaction() noexcept override {
+    completed_++;
+    delete this;
+  }
+  void onHeadersComplete(std::unique_ptr<HTTPMessage>) noexcept override {}
+  void onBody(std::unique_ptr<IOBuf>) noexcept override {}
+  void onTrailers(std::unique_ptr<HTTPHeaders>) noexcept override {}
+  void onEOM() noexcept override {
+    HTTPMessage resp;
+    std::unique_ptr<IOBuf> body;
+    {
+      AllocationCounter::PhaseScope phase(HANDLER);
+      resp.setStatusCode(200);
+      resp.setStatusMessage("OK");
+      resp.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH, "100");
+      body = IOBuf::copyBuffer(std::string(100, 'a'));
+    }
+    AllocationCounter::PhaseScope phase(SERIALIZE);
+    txn_->sendHeaders(resp);
+    txn_->sendBody(std::move(body));
+    txn_->sendEOM();
+  }
+  void onUpgrade(UpgradeProtocol) noexcept override {}
+  void onError(const HTTPException& error) noexcept override {
+    ADD_FAILURE() << error.what();
+  }
+  void onEgressPaused() noexcept override {}
+  void onEgressResumed() noexcept override {}
+
+ private:
+  uint32_t& completed_;
+  HTTPTransaction* txn_{nullptr};
+};
+
+class ReplyController : public HTTPSessionController {
+ public:
+  HTTPTransactionHandler* getRequestHandler(HTTPTransaction&,
+                                            HTTPMessage*) override {
+    AllocationCounter::PhaseScope phase(HANDLER);
+    return new ReplyHandler(completed);
+  }
+
+  HTTPTransactionHandler* getParseErrorHandler(
+      HTTPTransaction*, const HTTPException&, const SocketAddress&) override {
+    return nullptr;
+  }
+
+  HTTPTransactionHandler* getTransactionTimeoutHandler(
+      HTTPTransaction*, const SocketAddress&) override {
+    return nullptr;
+  }
+
+  void attachSession(HTTPSessionBase*) override {}
+  void detachSession(const HTTPSessionBase*) override {
+    detached = true;
+  }
+
+  uint32_t completed{0};
+  // The session has been destroyed
+  bool detached{false};
+};
+
+}
+
+template <typename C>
+class HTTPSessionAllocationTest : public testing::Test {
+ public:
+  HTTPSessionAllocationTest()
+      : transport_(new PhaseTransport(&eventBase_)),
+        transactionTimeouts_(makeTimeoutSet(&eventBase_)),
+        deadline_(AsyncTimeout::make(eventBase_, [this] () noexcept {
+          timedOut_ = true;
+        })) {
+    httpSession_ = new HTTPDownstreamSession(
+      transactionTimeouts_.get(),
+      AsyncTransportWrapper::UniquePtr(transport_),
+      localAddr, peerAddr,
+      &controller_,
+      makeServerCodec<typename C::Codec>(C::version),
+      mockTransportInfo,
+      nullptr);
+    httpSession_->startNow();
+    clientCodec_ = makeClientCodec<typename C::Codec>(C::version);
+    clientCodec_->generateConnectionPreface(requests_);
+    clientCodec_->generateSettings(requests_);
+  }
+
+  void TearDown() override {
+    if (!controller_.detached) {
+      httpSession_->dropConnection();
+    }
+  }
+
+  /**
+   * Sends n requests one at a time and returns the allocations they made in
+   * each phase.  Stops early, setting timedOut_, if a request does not
+   * complete within 5 seconds.
+   */
+  PhaseStats run(uint32_t n) {
+    auto start = getPhaseStats();
+    for (uint32_t i = 0; i < n; i++) {
+      {
+        AllocationCounter::PhaseScope phase(HARNESS);
+        auto streamID = clientCodec_->createStream();
+        clientCodec_->generateHeader(requests_, streamID, getGetRequest(),
+                                     true);
+        transport_->addReadEvent(requests_, std::chrono::milliseconds(0));
+        transport_->startReadEvents();
+        // Wakes the loop up if the session errors or drops the request
+        deadline_->scheduleTimeout(5000);
+      }
+      auto target = controller_.completed + 1;
+      while (controller_.completed < target && !timedOut_) {
+        eventBase_.loopOnce();
+      }
+      AllocationCounter::PhaseScope phase(HARNESS);
+      deadline_->cancelTimeout();
+      if (timedOut_) {
+        break;
+      }
+      transport_->getWriteEvents()->clear();
+    }
+    auto end = getPhaseStats();
+    PhaseStats result;
+    for (size_t i = 0; i < kNumPhases; i++) {
+      result[i] = end[i] - start[i];
+    }
+    return result;
+  }
+
+  /**
+   * Checks the average allocations per request in each phase against the
+   * budgets, which are indexed by Phase.
+   */
+  void expectWithinBudget(const std::array<uint64_t, HARNESS>& budgets) {
+    // Warm up the session's buffers and, for HTTP/2, the SETTINGS exchange
+    run(2);
+    ASSERT_FALSE(timedOut_) << "A warm up request did not complete";
+    constexpr uint32_t kRequests = 10;
+    auto stats = run(kRequests);
+    ASSERT_FALSE(timedOut_) << "A request did not complete";
+
+    std::string breakdown;
+    for (size_t i = 0; i < HARNESS; i++) {
+      breakdown += folly::sformat("{}: {} allocations, {} bytes per request; ",
+                                  kPhaseNames[i],
+                                  stats[i].allocations / kRequests,
+                                  stats[i].bytes / kRequests);
+    }
+    for (size_t i = 0; i < HARNESS; i++) {
+      // Recorded in the test XML output, to calibrate the budgets from
+      RecordProperty(kPhaseNames[i],
+                     folly::to<std::string>(stats[i].allocations / kRequests));
+      EXPECT_LE(stats[i].allocations / kRequests, budgets[i])
+        << kPhaseNames[i] << " over budget. " << breakdown;
+    }
+    EXPECT_EQ(controller_.completed, kRequests + 2);
+  }
+
+ protected:
+  EventBase eventBase_;
+  PhaseTransport* transport_;  // invalid once httpSession_ is destroyed
+  folly::HHWheelTimer::UniquePtr transactionTimeouts_;
+  ReplyController controller_;
+  HTTPDownstreamSession* httpSession_;
+  IOBufQueue requests_{IOBufQueue::cacheChainLength()};
+  std::unique_ptr<HTTPCodec> clientCodec_;
+  std::unique_ptr<AsyncTimeout> deadline_;
+  bool timedOut_{false};
+};
+
+using HTTP1xSessionAllocationTest = HTTPSessionAllocationTest<HTTP1xCodecPair>;
+using HTTP2SessionAllocationTest = HTTPSessionAllocationTest<HTTP2CodecPair>;
+
+// Budgets are the allocations per request a run records (the write, parse,
+// handler and serialize properties of --gtest_output=xml) plus about 20%
+// headroom; lower them when the hot path gets leaner.
+//
+// TODO: these have not been calibrated yet, they are upper bounds estimated
+// from reading the hot path.  Replace them with measured numbers, noting the
+// build they were measured on here.
+
+TEST_F(HTTP1xSessionAllocationTest, GetWithinBudget) {
+  // write, parse, handler, serialize
+  expectWithinBudget({{40, 100, 25, 50}});
+}
+
+TEST_F(HTTP2SessionAllocationTest, GetWithinBudget) {
+  expectWithinBudget({{40, 120, 25, 60}});
+}
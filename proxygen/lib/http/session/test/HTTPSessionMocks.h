@@ -507,6 +507,8 @@ class MockHTTPSessionStats : public DummyHTTPSessionStats {
   GMOCK_NOEXCEPT_METHOD1(recordSessionIdleTime, void(std::chrono::seconds));
   GMOCK_NOEXCEPT_METHOD0(recordTransactionStalled, void());
   GMOCK_NOEXCEPT_METHOD0(recordSessionStalled, void());
+  GMOCK_NOEXCEPT_METHOD1(recordTransactionTimings,
+                         void(const TransactionTimings&));
 };
 
 } // namespace proxygen
@@ -2063,6 +2063,43 @@ TEST_F(MockHTTPUpstreamTest, GoawayPreHeaders) {
   // Session will delete itself after drain completes
 }
 
+TEST_F(MockHTTPUpstreamTest, CoalescedWindowUpdates) {
+  EXPECT_CALL(*codecPtr_, supportsStreamFlowControl())
+    .WillRepeatedly(Return(true));
+  httpSession_->setWindowUpdateCoalescing(true);
+
+  auto handler = openTransaction();
+  handler->sendRequest();
+  auto streamID = handler->txn_->getID();
+
+  handler->expectHeaders();
+  EXPECT_CALL(*handler, onBodyWithOffset(_, _))
+    .Times(4);
+  // The half window threshold is crossed twice, but the credit goes out in
+  // one frame at the end of the loop
+  EXPECT_CALL(*codecPtr_, generateWindowUpdate(_, streamID, 80000))
+    .WillOnce(Invoke([](folly::IOBufQueue& writeBuf,
+                        HTTPCodec::StreamID /*stream*/,
+                        uint32_t /*delta*/) {
+          writeBuf.append("window", 6);
+          return 6;
+        }));
+
+  auto resp = makeResponse(200);
+  codecCb_->onMessageBegin(streamID, resp.get());
+  codecCb_->onHeadersComplete(streamID, std::move(resp));
+  for (auto i = 0; i < 4; i++) {
+    codecCb_->onBody(streamID, makeBuf(20000), 0);
+  }
+  eventBase_.loopOnce();
+
+  handler->expectEOM();
+  handler->expectDetachTransaction();
+  codecCb_->onMessageComplete(streamID, false);
+  eventBase_.loopOnce();
+  httpSession_->dropConnection();
+}
+
 TEST_F(MockHTTPUpstreamTest, NoWindowUpdateOnDrain) {
   EXPECT_CALL(*codecPtr_, supportsStreamFlowControl())
     .WillRepeatedly(Return(true));
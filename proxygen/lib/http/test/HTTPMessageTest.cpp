@@ -429,6 +429,56 @@ TEST(HTTPHeaders, InitializerListStringPiece) {
   EXPECT_EQ("value", hdrs.getSingleOrEmpty(HTTP_HEADER_CONNECTION));
 }
 
+TEST(HTTPHeaders, WireBlock) {
+  HTTPHeaders hdrs;
+  hdrs.add(HTTP_HEADER_CONNECTION, "X-Hop");
+  hdrs.add("X-Hop", "1");
+  hdrs.add("X-End", "2");
+  hdrs.setWireBlock("X-End: 2\r\n", true);
+  EXPECT_TRUE(hdrs.getWireBlock().empty());
+
+  HTTPHeaders stripped;
+  hdrs.stripPerHopHeaders(stripped);
+  EXPECT_EQ(hdrs.getWireBlock(), "X-End: 2\r\n");
+
+  // Adding keeps the lines, and copies share them
+  hdrs.set("X-Added", "3");
+  HTTPHeaders copy(hdrs);
+  EXPECT_EQ(copy.getWireBlock(), "X-End: 2\r\n");
+  std::vector<string> added;
+  copy.forEachWithCodeAfterWireBlock([&] (HTTPHeaderCode,
+                                          const string& name,
+                                          const string&) {
+    added.push_back(name);
+  });
+  EXPECT_EQ(added, std::vector<string>({"X-Added"}));
+
+  // A Connection header added since could name a header in the lines
+  copy.add(HTTP_HEADER_CONNECTION, "X-End");
+  copy.stripPerHopHeaders(stripped);
+  EXPECT_TRUE(copy.getWireBlock().empty());
+
+  EXPECT_FALSE(hdrs.remove("X-Missing"));
+  EXPECT_FALSE(hdrs.getWireBlock().empty());
+  hdrs.remove("X-End");
+  EXPECT_TRUE(hdrs.getWireBlock().empty());
+
+  // Adding a framing header or Host drops them too
+  for (auto code : {HTTP_HEADER_CONTENT_LENGTH, HTTP_HEADER_TRANSFER_ENCODING,
+                    HTTP_HEADER_HOST}) {
+    HTTPHeaders framed;
+    framed.add("X-End", "2");
+    framed.setWireBlock("X-End: 2\r\n", false);
+    framed.add(code, "1");
+    EXPECT_TRUE(framed.getWireBlock().empty());
+  }
+  HTTPHeaders named;
+  named.add("X-End", "2");
+  named.setWireBlock("X-End: 2\r\n", false);
+  named.add("content-length", "1");
+  EXPECT_TRUE(named.getWireBlock().empty());
+}
+
 void testRemoveQueryParam(const string& url,
                           const string& queryParam,
                           const string& expectedUrl,
@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <glog/logging.h>
+#include <proxygen/lib/http/ShardedLruQuicPskCache.h>
+#include <proxygen/lib/http/SynchronizedLruQuicPskCache.h>
+
+#include <thread>
+#include <vector>
+
+using namespace proxygen;
+
+/**
+ * Resumption lookups from many threads, as when every worker of a client
+ * opens QUIC connections to the same set of origins.  Each iteration is one
+ * getPsk() of a random cached identity; the iterations are split across the
+ * threads, so time/iter falls as long as the cache scales.
+ *
+ * --put_every mixes in a putPsk() of a new ticket every that many lookups,
+ * which is how clients replace single use tickets.
+ */
+
+DEFINE_uint32(identities, 1000, "Cached identities");
+DEFINE_uint32(put_every, 0, "Lookups per putPsk(), 0 for lookups only");
+
+namespace {
+
+quic::QuicCachedPsk makePsk(const std::string& identity) {
+  quic::QuicCachedPsk psk;
+  psk.cachedPsk.psk = identity;
+  psk.cachedPsk.secret = std::string(48, 's');
+  psk.appParams = "h3";
+  return psk;
+}
+
+std::vector<std::string> makeIdentities() {
+  std::vector<std::string> identities;
+  for (uint32_t i = 0; i < FLAGS_identities; i++) {
+    identities.push_back(folly::sformat("origin{}.example.com:443", i));
+  }
+  return identities;
+}
+
+template <typename Cache>
+void runLookups(size_t iters, size_t numThreads) {
+  std::unique_ptr<Cache> cache;
+  std::vector<std::string> identities;
+  BENCHMARK_SUSPEND {
+    identities = makeIdentities();
+    // Shards hold an even share of the capacity, so give each room for
+    // every identity; getPsk() must never miss
+    cache = std::make_unique<Cache>(
+      identities.size() * ShardedLruQuicPskCache::kDefaultNumShards);
+    for (const auto& identity : identities) {
+      cache->putPsk(identity, makePsk(identity));
+    }
+  }
+
+  // Starting the threads is part of the measurement; run enough iterations
+  // (--bm_min_usec) that it does not matter
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < numThreads; t++) {
+    threads.emplace_back([&, t] {
+      size_t n = iters / numThreads + (t < iters % numThreads ? 1 : 0);
+      // xorshift, so the threads do not share a random number generator
+      uint64_t x = 88172645463325252ULL + t;
+      for (size_t i = 0; i < n; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        const auto& identity = identities[x % identities.size()];
+        auto psk = cache->getPsk(identity);
+        CHECK(psk);
+        folly::doNotOptimizeAway(psk);
+        if (FLAGS_put_every && i % FLAGS_put_every == 0) {
+          cache->putPsk(identity, makePsk(identity));
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+void synchronizedCache(size_t iters, size_t numThreads) {
+  runLookups<SynchronizedLruQuicPskCache>(iters, numThreads);
+}
+
+void shardedCache(size_t iters, size_t numThreads) {
+  runLookups<ShardedLruQuicPskCache>(iters, numThreads);
+}
+
+} // namespace
+
+BENCHMARK_PARAM(synchronizedCache, 1)
+BENCHMARK_RELATIVE_PARAM(shardedCache, 1)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(synchronizedCache, 4)
+BENCHMARK_RELATIVE_PARAM(shardedCache, 4)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(synchronizedCache, 16)
+BENCHMARK_RELATIVE_PARAM(shardedCache, 16)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(synchronizedCache, 32)
+BENCHMARK_RELATIVE_PARAM(shardedCache, 32)
+BENCHMARK_DRAW_LINE();
+BENCHMARK_PARAM(synchronizedCache, 64)
+BENCHMARK_RELATIVE_PARAM(shardedCache, 64)
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
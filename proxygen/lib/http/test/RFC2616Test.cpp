@@ -200,3 +200,77 @@ TEST(ByteRangeSpecTest, Invalids) {
   EXPECT_FALSE(parseByteRangeSpec(sp, dummy, dummy, dummy)) <<
     "Spec StringPiece ends before first byte in initial byte range";
 }
+
+TEST(RangeHeaderTest, Valids) {
+  using RFC2616::ByteRange;
+  std::vector<ByteRange> ranges;
+
+  ASSERT_TRUE(RFC2616::parseRangeHeader("bytes=0-499", 10000, ranges));
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(ByteRange(0, 499), ranges[0]);
+  ranges.clear();
+
+  ASSERT_TRUE(RFC2616::parseRangeHeader("bytes=-500", 10000, ranges));
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(ByteRange(9500, 9999), ranges[0]);
+  ranges.clear();
+
+  ASSERT_TRUE(RFC2616::parseRangeHeader("bytes=9500-", 10000, ranges));
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(ByteRange(9500, 9999), ranges[0]);
+  ranges.clear();
+
+  ASSERT_TRUE(
+    RFC2616::parseRangeHeader("bytes= 0-0 , -1,,500-20000", 10000, ranges));
+  ASSERT_EQ(3, ranges.size());
+  EXPECT_EQ(ByteRange(0, 0), ranges[0]);
+  EXPECT_EQ(ByteRange(9999, 9999), ranges[1]);
+  EXPECT_EQ(ByteRange(500, 9999), ranges[2]);
+  ranges.clear();
+
+  // suffix longer than the representation selects all of it
+  ASSERT_TRUE(RFC2616::parseRangeHeader("bytes=-20000", 100, ranges));
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(ByteRange(0, 99), ranges[0]);
+  ranges.clear();
+}
+
+TEST(RangeHeaderTest, Unsatisfiable) {
+  std::vector<RFC2616::ByteRange> ranges;
+
+  EXPECT_TRUE(RFC2616::parseRangeHeader("bytes=100-200", 100, ranges));
+  EXPECT_TRUE(ranges.empty());
+  EXPECT_TRUE(RFC2616::parseRangeHeader("bytes=-0", 100, ranges));
+  EXPECT_TRUE(ranges.empty());
+  EXPECT_TRUE(RFC2616::parseRangeHeader("bytes=0-10", 0, ranges));
+  EXPECT_TRUE(ranges.empty());
+
+  // the satisfiable subset is kept
+  EXPECT_TRUE(RFC2616::parseRangeHeader("bytes=200-300,0-9", 100, ranges));
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(RFC2616::ByteRange(0, 9), ranges[0]);
+}
+
+TEST(RangeHeaderTest, Invalids) {
+  std::vector<RFC2616::ByteRange> ranges;
+
+  EXPECT_FALSE(RFC2616::parseRangeHeader("0-10", 100, ranges)) <<
+    "Range must start with 'bytes='";
+  EXPECT_FALSE(RFC2616::parseRangeHeader("items=0-10", 100, ranges)) <<
+    "Range unit must be bytes";
+  EXPECT_FALSE(RFC2616::parseRangeHeader("bytes=", 100, ranges)) <<
+    "Range set must not be empty";
+  EXPECT_FALSE(RFC2616::parseRangeHeader("bytes=10", 100, ranges)) <<
+    "Range spec missing '-'";
+  EXPECT_FALSE(RFC2616::parseRangeHeader("bytes=10-5", 100, ranges)) <<
+    "Range last byte precedes first byte";
+  EXPECT_FALSE(RFC2616::parseRangeHeader("bytes=a-5", 100, ranges)) <<
+    "Range has invalid first byte";
+  EXPECT_FALSE(RFC2616::parseRangeHeader("bytes=0-5x", 100, ranges)) <<
+    "Range has trailing garbage";
+  EXPECT_FALSE(RFC2616::parseRangeHeader("bytes=--5", 100, ranges)) <<
+    "Range has invalid suffix length";
+  EXPECT_FALSE(RFC2616::parseRangeHeader("bytes=0-1,garbage", 100, ranges)) <<
+    "Range has an invalid second spec";
+  EXPECT_TRUE(ranges.empty()) << "Good specs before a bad one are not kept";
+}
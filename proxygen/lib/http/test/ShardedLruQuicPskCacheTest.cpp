@@ -0,0 +1,149 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Format.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/ShardedLruQuicPskCache.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace proxygen;
+
+namespace {
+
+quic::QuicCachedPsk makePsk(const std::string& ticket) {
+  quic::QuicCachedPsk psk;
+  psk.cachedPsk.psk = ticket;
+  psk.cachedPsk.secret = std::string(48, 's');
+  psk.appParams = "h3";
+  return psk;
+}
+
+std::string makeIdentity(size_t i) {
+  return folly::sformat("origin{}.example.com:443", i);
+}
+
+// The first count identities that cache keeps in shard
+std::vector<std::string> identitiesInShard(const ShardedLruQuicPskCache& cache,
+                                           size_t shard,
+                                           size_t count) {
+  std::vector<std::string> identities;
+  for (size_t i = 0; identities.size() < count; i++) {
+    auto identity = makeIdentity(i);
+    if (cache.getShardIndex(identity) == shard) {
+      identities.push_back(identity);
+    }
+  }
+  return identities;
+}
+
+}
+
+TEST(ShardedLruQuicPskCacheTest, PutGetRemove) {
+  ShardedLruQuicPskCache cache(16, 4);
+  EXPECT_EQ(cache.getNumShards(), 4);
+  EXPECT_FALSE(cache.getPsk("a.example.com:443"));
+
+  cache.putPsk("a.example.com:443", makePsk("ticket1"));
+  cache.putPsk("b.example.com:443", makePsk("ticket2"));
+  auto psk = cache.getPsk("a.example.com:443");
+  ASSERT_TRUE(psk);
+  EXPECT_EQ(psk->cachedPsk.psk, "ticket1");
+  EXPECT_EQ(psk->appParams, "h3");
+
+  // A new ticket replaces the old one
+  cache.putPsk("a.example.com:443", makePsk("ticket3"));
+  psk = cache.getPsk("a.example.com:443");
+  ASSERT_TRUE(psk);
+  EXPECT_EQ(psk->cachedPsk.psk, "ticket3");
+
+  cache.removePsk("a.example.com:443");
+  EXPECT_FALSE(cache.getPsk("a.example.com:443"));
+  cache.removePsk("missing.example.com:443");
+  psk = cache.getPsk("b.example.com:443");
+  ASSERT_TRUE(psk);
+  EXPECT_EQ(psk->cachedPsk.psk, "ticket2");
+}
+
+TEST(ShardedLruQuicPskCacheTest, NumShards) {
+  EXPECT_EQ(ShardedLruQuicPskCache(16, 3).getNumShards(), 4);
+  EXPECT_EQ(ShardedLruQuicPskCache(16, 0).getNumShards(), 1);
+  EXPECT_EQ(ShardedLruQuicPskCache(16).getNumShards(),
+            ShardedLruQuicPskCache::kDefaultNumShards);
+}
+
+TEST(ShardedLruQuicPskCacheTest, EvictPerShard) {
+  // Two entries per shard
+  ShardedLruQuicPskCache cache(8, 4);
+  auto full = identitiesInShard(cache, 1, 3);
+  auto other = identitiesInShard(cache, 2, 2);
+  for (const auto& identity : other) {
+    cache.putPsk(identity, makePsk(identity));
+  }
+  for (const auto& identity : full) {
+    cache.putPsk(identity, makePsk(identity));
+  }
+
+  // Only the full shard evicts, its least recently used entry
+  EXPECT_FALSE(cache.getPsk(full[0]));
+  EXPECT_TRUE(cache.getPsk(full[1]));
+  EXPECT_TRUE(cache.getPsk(full[2]));
+  for (const auto& identity : other) {
+    EXPECT_TRUE(cache.getPsk(identity));
+  }
+}
+
+TEST(ShardedLruQuicPskCacheTest, PromoteHotEntries) {
+  ShardedLruQuicPskCache cache(2, 1);
+  cache.putPsk("hot", makePsk("hot"));
+  cache.putPsk("cold", makePsk("cold"));
+  // Only a sample of hits promote, and this many include one
+  for (int i = 0; i < 8; i++) {
+    EXPECT_TRUE(cache.getPsk("hot"));
+  }
+  cache.putPsk("new", makePsk("new"));
+  EXPECT_TRUE(cache.getPsk("hot"));
+  EXPECT_FALSE(cache.getPsk("cold"));
+  EXPECT_TRUE(cache.getPsk("new"));
+}
+
+TEST(ShardedLruQuicPskCacheTest, ConcurrentAccess) {
+  ShardedLruQuicPskCache cache(64, 8);
+  std::atomic<size_t> mismatches{0};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 8; t++) {
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < 5000; i++) {
+        // Threads share identities, so they race on the same shards
+        auto identity = makeIdentity((i * 7 + t) % 100);
+        switch (i % 4) {
+          case 0:
+            cache.putPsk(identity, makePsk(identity));
+            break;
+          case 3:
+            cache.removePsk(identity);
+            break;
+          default:
+            if (auto psk = cache.getPsk(identity)) {
+              mismatches += (psk->cachedPsk.psk != identity);
+            }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(mismatches.load(), 0);
+
+  cache.putPsk(makeIdentity(0), makePsk(makeIdentity(0)));
+  EXPECT_TRUE(cache.getPsk(makeIdentity(0)));
+}
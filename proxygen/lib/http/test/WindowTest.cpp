@@ -8,6 +8,7 @@
  *
  */
 #include <folly/portability/GTest.h>
+#include <proxygen/lib/http/ReceiveWindowTuner.h>
 #include <proxygen/lib/http/Window.h>
 
 using namespace proxygen;
@@ -121,3 +122,42 @@ TEST(WindowTest, NewCapacityOverflow) {
   ASSERT_EQ(w.getSize(), std::numeric_limits<int32_t>::max());
   ASSERT_FALSE(w.setCapacity(std::numeric_limits<int32_t>::max() - 9));
 }
+
+TEST(ReceiveWindowTunerTest, Grow) {
+  ReceiveWindowTuner tuner(400);
+  const std::chrono::microseconds rtt(1000);
+  TimePoint now = getCurrentTime();
+
+  // No growth before the first credit return, or without an RTT
+  EXPECT_EQ(tuner.getTargetCapacity(100, rtt, now), 100);
+  now += std::chrono::microseconds(500);
+  EXPECT_EQ(tuner.getTargetCapacity(100, std::chrono::microseconds(0), now),
+            100);
+  // Window consumed within 2 RTTs doubles, up to the maximum
+  now += std::chrono::microseconds(500);
+  EXPECT_EQ(tuner.getTargetCapacity(100, rtt, now), 200);
+  now += std::chrono::microseconds(1500);
+  EXPECT_EQ(tuner.getTargetCapacity(200, rtt, now), 400);
+  now += std::chrono::microseconds(100);
+  EXPECT_EQ(tuner.getTargetCapacity(400, rtt, now), 400);
+  // Slow consumption does not grow the window
+  tuner.setMaxCapacity(1000);
+  now += std::chrono::microseconds(2000);
+  EXPECT_EQ(tuner.getTargetCapacity(400, rtt, now), 400);
+}
+
+TEST(ReceiveWindowTunerTest, Shrink) {
+  ReceiveWindowTuner tuner(400);
+  EXPECT_EQ(tuner.getTargetCapacity(400, std::chrono::microseconds(0)), 400);
+  tuner.setMaxCapacity(100);
+  EXPECT_EQ(tuner.getTargetCapacity(400, std::chrono::microseconds(0)), 100);
+}
+
+TEST(ReceiveWindowTunerTest, BytesConsumed) {
+  ReceiveWindowTuner tuner(400);
+  EXPECT_FALSE(tuner.onBytesConsumed(100, 30));
+  EXPECT_FALSE(tuner.onBytesConsumed(100, 19));
+  EXPECT_TRUE(tuner.onBytesConsumed(100, 1));
+  EXPECT_FALSE(tuner.onBytesConsumed(100, 49));
+  EXPECT_TRUE(tuner.onBytesConsumed(100, 1000));
+}
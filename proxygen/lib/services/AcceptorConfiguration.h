@@ -90,6 +90,27 @@ struct AcceptorConfiguration : public wangle::ServerSocketConfig {
   size_t receiveStreamWindowSize{65536};
   size_t receiveSessionWindowSize{65536};
 
+  /**
+   * Receive window auto-tuning.  When non-zero, the stream and session
+   * receive windows above grow up to these sizes while they limit how fast
+   * the peer can send (e.g. uploads over long RTT paths).
+   */
+  size_t maxReceiveStreamWindowSize{0};
+  size_t maxReceiveSessionWindowSize{0};
+
+  /**
+   * Defer WINDOW_UPDATEs to the end of the event loop iteration, merging the
+   * credit of each stream into one frame (see
+   * HTTPSession::setWindowUpdateCoalescing).
+   */
+  bool coalesceWindowUpdates{false};
+
+  /**
+   * Record TransactionTimings on every transaction (see
+   * HTTPSessionBase::setTransactionTimings).
+   */
+  bool enableTransactionTimings{false};
+
   /**
    * These parameters control how many bytes HTTPSession's will buffer in user
    * space before applying backpressure to handlers.  -1 means use the
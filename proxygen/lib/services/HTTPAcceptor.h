@@ -12,7 +12,6 @@
 #include <memory>
 #include <wangle/acceptor/Acceptor.h>
 #include <proxygen/lib/services/AcceptorConfiguration.h>
-#include <proxygen/lib/utils/AsyncTimeoutSet.h>
 #include <folly/io/async/AsyncServerSocket.h>
 #include <proxygen/lib/utils/WheelTimerInstance.h>
 
@@ -54,7 +53,6 @@ class HTTPAcceptor : public wangle::Acceptor {
  protected:
   AcceptorConfiguration accConfig_;
  private:
-  AsyncTimeoutSet::UniquePtr tcpEventsTimeouts_;
   std::unique_ptr<WheelTimerInstance> timer_;
 };
 
@@ -0,0 +1,147 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/test/AllocationCounter.h>
+
+#include <glog/logging.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+using proxygen::AllocationCounter;
+
+// Plain thread locals need no constructor, so they are safe to touch from
+// inside malloc
+thread_local uint64_t tlAllocations[AllocationCounter::kMaxPhases];
+thread_local uint64_t tlBytes[AllocationCounter::kMaxPhases];
+thread_local size_t tlPhase = 0;
+
+inline void count(size_t size) {
+  tlAllocations[tlPhase]++;
+  tlBytes[tlPhase] += size;
+}
+
+}
+
+#if defined(__GLIBC__)
+
+// Everything, free included, is routed to glibc's allocator so that memory
+// never crosses allocators if another malloc was linked in as well
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+  count(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+  count(n * size);
+  return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+  count(size);
+  return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+  count(size);
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+  return memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+  void* result = memalign(alignment, size);
+  if (!result) {
+    return ENOMEM;
+  }
+  *ptr = result;
+  return 0;
+}
+
+void free(void* ptr) {
+  __libc_free(ptr);
+}
+
+}
+
+#else
+
+void* operator new(size_t size) {
+  count(size);
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+#endif
+
+namespace proxygen {
+
+constexpr size_t AllocationCounter::kMaxPhases;
+
+AllocationStats AllocationCounter::get() {
+  AllocationStats stats;
+  for (size_t i = 0; i < kMaxPhases; i++) {
+    stats.allocations += tlAllocations[i];
+    stats.bytes += tlBytes[i];
+  }
+  return stats;
+}
+
+AllocationStats AllocationCounter::get(size_t phase) {
+  CHECK_LT(phase, kMaxPhases);
+  return {tlAllocations[phase], tlBytes[phase]};
+}
+
+bool AllocationCounter::countsMalloc() {
+#if defined(__GLIBC__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+AllocationCounter::PhaseScope::PhaseScope(size_t phase)
+    : previous_(tlPhase) {
+  CHECK_LT(phase, kMaxPhases);
+  tlPhase = phase;
+}
+
+AllocationCounter::PhaseScope::~PhaseScope() {
+  tlPhase = previous_;
+}
+
+}
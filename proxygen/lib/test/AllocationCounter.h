@@ -0,0 +1,78 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace proxygen {
+
+struct AllocationStats {
+  uint64_t allocations{0};
+  uint64_t bytes{0};
+
+  AllocationStats operator-(const AllocationStats& other) const {
+    return {allocations - other.allocations, bytes - other.bytes};
+  }
+};
+
+/**
+ * Counts the heap allocations made by each thread.  Linking
+ * AllocationCounter.cpp into a binary replaces its allocation functions:
+ * with glibc malloc, calloc and realloc are interposed, which also covers
+ * operator new and IOBuf buffers; elsewhere only operator new is counted.
+ * Only link it into binaries that need it: with glibc it takes over the
+ * process' allocator.
+ *
+ * Counters are per thread and only ever grow, so measure a region by
+ * subtracting the stats taken before it from the stats taken after it, or
+ * with a Scope.  Allocations are also attributed to the thread's current
+ * phase, a caller defined index set with PhaseScope, to break a region down.
+ */
+class AllocationCounter {
+ public:
+  static constexpr size_t kMaxPhases = 8;
+
+  // Totals of the calling thread
+  static AllocationStats get();
+
+  // Totals of the calling thread while in phase
+  static AllocationStats get(size_t phase);
+
+  // Whether malloc itself is counted, see above
+  static bool countsMalloc();
+
+  class Scope {
+   public:
+    Scope() : start_(get()) {}
+
+    AllocationStats get() const {
+      return AllocationCounter::get() - start_;
+    }
+
+   private:
+    AllocationStats start_;
+  };
+
+  /**
+   * Attributes the calling thread's allocations to phase until destroyed,
+   * then restores the previous phase.  Phase 0 applies outside any scope.
+   */
+  class PhaseScope {
+   public:
+    explicit PhaseScope(size_t phase);
+    ~PhaseScope();
+
+   private:
+    size_t previous_;
+  };
+};
+
+}
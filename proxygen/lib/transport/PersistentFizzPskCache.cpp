@@ -15,6 +15,80 @@ using namespace folly;
 
 namespace proxygen {
 
+PersistentFizzPskCache::PersistentFizzPskCache(
+    const std::string& filename,
+    wangle::PersistentCacheConfig config,
+    std::unique_ptr<fizz::Factory> factory)
+    : factory_(std::move(factory)),
+      cache_(std::make_unique<
+             wangle::FilePersistentCache<std::string, PersistentCachedPsk>>(
+          filename, std::move(config))) {
+}
+
+PersistentFizzPskCache::PersistentFizzPskCache(
+    const std::string& filename,
+    PskLogConfig config,
+    std::unique_ptr<fizz::Factory> factory)
+    : factory_(std::move(factory)) {
+  auto deserialize = [this] (const std::string& str) {
+    return deserializePsk(str, *factory_);
+  };
+  writeBehind_ =
+    std::make_unique<WriteBehindPskCache<fizz::client::CachedPsk>>(
+      filename, std::move(config), serializePsk, deserialize);
+}
+
+void PersistentFizzPskCache::setMaxPskUses(size_t maxUses) {
+  maxPskUses_ = maxUses;
+  if (writeBehind_) {
+    writeBehind_->setMaxPskUses(maxUses);
+  }
+}
+
+folly::Optional<fizz::client::CachedPsk> PersistentFizzPskCache::getPsk(
+    const std::string& identity) {
+  if (writeBehind_) {
+    return writeBehind_->getPsk(identity);
+  }
+  auto serialized = cache_->get(identity);
+  if (serialized) {
+    try {
+      auto deserialized = deserializePsk(serialized->serialized, *factory_);
+      serialized->uses++;
+      if (maxPskUses_ != 0 && serialized->uses >= maxPskUses_) {
+        cache_->remove(identity);
+      } else {
+        cache_->put(identity, *serialized);
+      }
+      return std::move(deserialized);
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Error deserializing PSK: " << ex.what();
+      cache_->remove(identity);
+    }
+  }
+  return folly::none;
+}
+
+void PersistentFizzPskCache::putPsk(const std::string& identity,
+                                    fizz::client::CachedPsk psk) {
+  if (writeBehind_) {
+    writeBehind_->putPsk(identity, std::move(psk));
+    return;
+  }
+  PersistentCachedPsk serialized;
+  serialized.serialized = serializePsk(psk);
+  serialized.uses = 0;
+  cache_->put(identity, std::move(serialized));
+}
+
+void PersistentFizzPskCache::removePsk(const std::string& identity) {
+  if (writeBehind_) {
+    writeBehind_->removePsk(identity);
+    return;
+  }
+  cache_->remove(identity);
+}
+
 std::string serializePsk(const fizz::client::CachedPsk& psk) {
   uint64_t ticketIssueTime =
       std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -12,6 +12,7 @@
 #include <fizz/client/PskCache.h>
 #include <fizz/protocol/Factory.h>
 #include <fizz/protocol/OpenSSLFactory.h>
+#include <proxygen/lib/transport/WriteBehindPskCache.h>
 #include <wangle/client/persistence/FilePersistentCache.h>
 
 namespace proxygen {
@@ -25,6 +26,14 @@ struct PersistentCachedPsk {
   size_t uses{0};
 };
 
+/**
+ * A PskCache persisted to a file.  Given a wangle::PersistentCacheConfig, PSKs
+ * are serialized and written through a wangle::FilePersistentCache on the
+ * calling thread.  Given a PskLogConfig, they are kept in memory and written
+ * behind, in batches, by a PersistentPskLog; this keeps serialization and
+ * file I/O off the threads that make connections.  The two modes use
+ * different file formats.
+ */
 class PersistentFizzPskCache : public fizz::client::PskCache {
  public:
   ~PersistentFizzPskCache() override = default;
@@ -32,53 +41,33 @@ class PersistentFizzPskCache : public fizz::client::PskCache {
   PersistentFizzPskCache(const std::string& filename,
                          wangle::PersistentCacheConfig config,
                          std::unique_ptr<fizz::Factory> factory =
-                             std::make_unique<fizz::OpenSSLFactory>())
-      : cache_(filename, std::move(config)), factory_(std::move(factory)) {
-  }
+                             std::make_unique<fizz::OpenSSLFactory>());
+
+  PersistentFizzPskCache(const std::string& filename,
+                         PskLogConfig config,
+                         std::unique_ptr<fizz::Factory> factory =
+                             std::make_unique<fizz::OpenSSLFactory>());
 
-  void setMaxPskUses(size_t maxUses) {
-    maxPskUses_ = maxUses;
-  }
+  void setMaxPskUses(size_t maxUses);
 
   folly::Optional<fizz::client::CachedPsk> getPsk(
-      const std::string& identity) override {
-    auto serialized = cache_.get(identity);
-    if (serialized) {
-      try {
-        auto deserialized = deserializePsk(serialized->serialized, *factory_);
-        serialized->uses++;
-        if (maxPskUses_ != 0 && serialized->uses >= maxPskUses_) {
-          cache_.remove(identity);
-        } else {
-          cache_.put(identity, *serialized);
-        }
-        return std::move(deserialized);
-      } catch (const std::exception& ex) {
-        LOG(ERROR) << "Error deserializing PSK: " << ex.what();
-        cache_.remove(identity);
-      }
-    }
-    return folly::none;
-  }
+      const std::string& identity) override;
 
   void putPsk(const std::string& identity,
-              fizz::client::CachedPsk psk) override {
-    PersistentCachedPsk serialized;
-    serialized.serialized = serializePsk(psk);
-    serialized.uses = 0;
-    cache_.put(identity, std::move(serialized));
-  }
+              fizz::client::CachedPsk psk) override;
 
-  void removePsk(const std::string& identity) override {
-    cache_.remove(identity);
-  }
+  void removePsk(const std::string& identity) override;
 
  private:
-  wangle::FilePersistentCache<std::string, PersistentCachedPsk> cache_;
+  std::unique_ptr<fizz::Factory> factory_;
 
-  size_t maxPskUses_{5};
+  // Exactly one of these is set
+  std::unique_ptr<
+      wangle::FilePersistentCache<std::string, PersistentCachedPsk>>
+      cache_;
+  std::unique_ptr<WriteBehindPskCache<fizz::client::CachedPsk>> writeBehind_;
 
-  std::unique_ptr<fizz::Factory> factory_;
+  size_t maxPskUses_{5};
 };
 } // namespace proxygen
 
@@ -0,0 +1,424 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/transport/PersistentPskLog.h>
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/hash/Checksum.h>
+#include <folly/lang/Bits.h>
+#include <folly/system/MemoryMapping.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * File layout, all integers big endian:
+ *
+ *   header:  uint32 magic, uint32 version
+ *   record:  uint32 body length, uint32 crc32c of body, body
+ *   body:    uint8 op, uint16 identity length, identity, then
+ *              kPut:    uint32 uses, value (the rest of the body)
+ *              kUses:   uint32 uses
+ *              kRemove: nothing
+ */
+namespace {
+
+constexpr uint32_t kMagic = 0x50534b4c; // "PSKL"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 8;
+constexpr size_t kRecordHeaderSize = 8;
+
+// Smaller files are not worth rewriting
+constexpr uint64_t kMinCompactionSize = 16 * 1024;
+
+enum class Op : uint8_t {
+  kPut = 1,
+  kUses = 2,
+  kRemove = 3,
+};
+
+template <typename T>
+void appendBE(std::string& out, T value) {
+  value = folly::Endian::big(value);
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T loadBE(const uint8_t* data) {
+  return folly::Endian::big(folly::loadUnaligned<T>(data));
+}
+
+uint64_t putRecordSize(const std::string& identity, const std::string& value) {
+  return kRecordHeaderSize + 1 + sizeof(uint16_t) + identity.size() +
+    sizeof(uint32_t) + value.size();
+}
+
+/**
+ * Appends one record; fill appends the body after the op and identity.
+ */
+template <typename F>
+void appendRecord(std::string& out,
+                  Op op,
+                  const std::string& identity,
+                  F fill) {
+  auto start = out.size();
+  out.append(kRecordHeaderSize, '\0');
+  out.push_back(static_cast<char>(op));
+  appendBE<uint16_t>(out, identity.size());
+  out.append(identity);
+  fill(out);
+
+  uint32_t length = out.size() - start - kRecordHeaderSize;
+  uint32_t crc = folly::crc32c(
+    reinterpret_cast<const uint8_t*>(out.data() + start + kRecordHeaderSize),
+    length);
+  length = folly::Endian::big(length);
+  crc = folly::Endian::big(crc);
+  memcpy(&out[start], &length, sizeof(length));
+  memcpy(&out[start + sizeof(length)], &crc, sizeof(crc));
+}
+
+void appendPut(std::string& out,
+               const std::string& identity,
+               const proxygen::PersistentPskLog::Record& record) {
+  appendRecord(out, Op::kPut, identity, [&record] (std::string& body) {
+    appendBE<uint32_t>(body, record.uses);
+    body.append(record.value);
+  });
+}
+
+std::string makeHeader() {
+  std::string header;
+  appendBE<uint32_t>(header, kMagic);
+  appendBE<uint32_t>(header, kVersion);
+  return header;
+}
+
+/**
+ * Whether data starts with the header, or is part of one left by a crash
+ * while the file was being created.
+ */
+bool hasHeader(folly::ByteRange data) {
+  auto header = makeHeader();
+  auto length = std::min(data.size(), header.size());
+  return memcmp(data.data(), header.data(), length) == 0;
+}
+
+} // namespace
+
+namespace proxygen {
+
+PersistentPskLog::PersistentPskLog(std::string filename, PskLogConfig config)
+    : filename_(std::move(filename)),
+      config_(std::move(config)) {
+  load();
+  if (config_.syncInterval.count() > 0) {
+    writer_ = std::thread([this] { writeLoop(); });
+  }
+}
+
+PersistentPskLog::~PersistentPskLog() {
+  if (writer_.joinable()) {
+    {
+      std::lock_guard<std::mutex> guard(pendingMutex_);
+      stop_ = true;
+    }
+    pendingCV_.notify_one();
+    writer_.join();
+  }
+  sync();
+}
+
+void PersistentPskLog::load() {
+  std::lock_guard<std::mutex> guard(writeMutex_);
+  try {
+    file_ = folly::File(filename_, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    struct stat st;
+    folly::checkUnixError(fstat(file_.fd(), &st), "fstat ", filename_);
+    if (st.st_size > 0) {
+      folly::MemoryMapping mapping(file_.fd(), 0, st.st_size);
+      if (!hasHeader(mapping.range())) {
+        // Likely the other mode's cache; leave it for that mode to read
+        LOG(ERROR) << filename_ << " is not a PSK log, not overwriting it";
+        file_ = folly::File();
+        return;
+      }
+      replay(mapping.range());
+    }
+    if (fileSize_ < static_cast<uint64_t>(st.st_size)) {
+      LOG(WARNING) << "Discarding " << st.st_size - fileSize_
+                   << " unreadable bytes of " << filename_;
+      folly::checkUnixError(ftruncate(file_.fd(), fileSize_),
+                            "ftruncate ", filename_);
+    }
+    if (fileSize_ == 0) {
+      auto header = makeHeader();
+      if (!append(folly::StringPiece(header))) {
+        file_ = folly::File();
+      }
+    }
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Error loading PSKs from " << filename_ << ": " << ex.what();
+    file_ = folly::File();
+    fileSize_ = 0;
+  }
+}
+
+void PersistentPskLog::replay(folly::ByteRange data) {
+  if (data.size() < kHeaderSize ||
+      loadBE<uint32_t>(data.data()) != kMagic ||
+      loadBE<uint32_t>(data.data() + sizeof(uint32_t)) != kVersion) {
+    return;
+  }
+  // fileSize_ ends up at the end of the last good record
+  fileSize_ = kHeaderSize;
+  data.advance(kHeaderSize);
+
+  while (data.size() >= kRecordHeaderSize) {
+    auto length = loadBE<uint32_t>(data.data());
+    auto crc = loadBE<uint32_t>(data.data() + sizeof(uint32_t));
+    if (length > data.size() - kRecordHeaderSize) {
+      return;
+    }
+    auto body = folly::ByteRange(data.data() + kRecordHeaderSize, length);
+    if (folly::crc32c(body.data(), body.size()) != crc) {
+      return;
+    }
+
+    if (body.size() < 1 + sizeof(uint16_t)) {
+      return;
+    }
+    auto op = static_cast<Op>(body[0]);
+    auto identityLength = loadBE<uint16_t>(body.data() + 1);
+    body.advance(1 + sizeof(uint16_t));
+    if (body.size() < identityLength) {
+      return;
+    }
+    std::string identity(reinterpret_cast<const char*>(body.data()),
+                         identityLength);
+    body.advance(identityLength);
+
+    auto it = records_.find(identity);
+    switch (op) {
+      case Op::kPut: {
+        if (body.size() < sizeof(uint32_t)) {
+          return;
+        }
+        Record record;
+        record.uses = loadBE<uint32_t>(body.data());
+        body.advance(sizeof(uint32_t));
+        record.value = folly::StringPiece(body).str();
+        if (it != records_.end()) {
+          liveBytes_ -= putRecordSize(identity, it->second.value);
+        }
+        liveBytes_ += putRecordSize(identity, record.value);
+        records_[identity] = std::move(record);
+        break;
+      }
+      case Op::kUses:
+        if (body.size() != sizeof(uint32_t)) {
+          return;
+        }
+        if (it != records_.end()) {
+          it->second.uses = loadBE<uint32_t>(body.data());
+        }
+        break;
+      case Op::kRemove:
+        if (!body.empty()) {
+          return;
+        }
+        if (it != records_.end()) {
+          liveBytes_ -= putRecordSize(identity, it->second.value);
+          records_.erase(it);
+        }
+        break;
+      default:
+        return;
+    }
+    data.advance(kRecordHeaderSize + length);
+    fileSize_ += kRecordHeaderSize + length;
+  }
+}
+
+PersistentPskLog::Records PersistentPskLog::getRecords() const {
+  std::lock_guard<std::mutex> guard(writeMutex_);
+  return records_;
+}
+
+uint64_t PersistentPskLog::getFileSize() const {
+  std::lock_guard<std::mutex> guard(writeMutex_);
+  return fileSize_;
+}
+
+void PersistentPskLog::put(const std::string& identity,
+                           folly::Function<std::string()> serialize) {
+  queue(identity, [&serialize] (Update& update) {
+    update.serialize = std::move(serialize);
+    update.uses = 0;
+    update.remove = false;
+  });
+}
+
+void PersistentPskLog::setUses(const std::string& identity, uint32_t uses) {
+  queue(identity, [uses] (Update& update) {
+    if (!update.remove) {
+      update.uses = uses;
+    }
+  });
+}
+
+void PersistentPskLog::remove(const std::string& identity) {
+  queue(identity, [] (Update& update) {
+    update.serialize = nullptr;
+    update.uses = folly::none;
+    update.remove = true;
+  });
+}
+
+void PersistentPskLog::queue(const std::string& identity,
+                             folly::FunctionRef<void(Update&)> change) {
+  bool full;
+  {
+    std::lock_guard<std::mutex> guard(pendingMutex_);
+    change(pending_[identity]);
+    full = pending_.size() >= config_.maxPendingUpdates;
+  }
+  if (full) {
+    pendingCV_.notify_one();
+  }
+}
+
+void PersistentPskLog::sync() {
+  // Held across taking the updates, so batches are written in order
+  std::lock_guard<std::mutex> guard(writeMutex_);
+  Updates updates;
+  {
+    std::lock_guard<std::mutex> pendingGuard(pendingMutex_);
+    updates.swap(pending_);
+  }
+
+  std::string out;
+  for (auto& entry : updates) {
+    const auto& identity = entry.first;
+    auto& update = entry.second;
+    auto it = records_.find(identity);
+
+    if (update.serialize) {
+      folly::Optional<std::string> value;
+      try {
+        value = update.serialize();
+      } catch (const std::exception& ex) {
+        LOG(ERROR) << "Error serializing PSK: " << ex.what();
+      }
+      if (value && identity.size() <= std::numeric_limits<uint16_t>::max()) {
+        Record record;
+        record.value = std::move(*value);
+        record.uses = update.uses.value_or(0);
+        if (it != records_.end()) {
+          liveBytes_ -= putRecordSize(identity, it->second.value);
+        }
+        liveBytes_ += putRecordSize(identity, record.value);
+        appendPut(out, identity, record);
+        records_[identity] = std::move(record);
+        continue;
+      }
+      update.remove = true;
+    }
+
+    if (update.remove) {
+      if (it != records_.end()) {
+        liveBytes_ -= putRecordSize(identity, it->second.value);
+        records_.erase(it);
+        appendRecord(out, Op::kRemove, identity, [] (std::string&) {});
+      }
+    } else if (update.uses && it != records_.end() &&
+               it->second.uses != *update.uses) {
+      auto uses = *update.uses;
+      it->second.uses = uses;
+      appendRecord(out, Op::kUses, identity, [uses] (std::string& body) {
+        appendBE<uint32_t>(body, uses);
+      });
+    }
+  }
+
+  if (!out.empty()) {
+    append(folly::StringPiece(out));
+  }
+  if (fileSize_ >= kMinCompactionSize &&
+      fileSize_ > config_.compactionRatio * (kHeaderSize + liveBytes_)) {
+    compact();
+  }
+}
+
+bool PersistentPskLog::append(folly::StringPiece data) {
+  if (!file_) {
+    return false;
+  }
+  auto written = folly::pwriteFull(file_.fd(), data.data(), data.size(),
+                                   fileSize_);
+  if (written != static_cast<ssize_t>(data.size())) {
+    PLOG(ERROR) << "Error writing PSKs to " << filename_;
+    // Do not leave part of a record for the next write to follow
+    if (ftruncate(file_.fd(), fileSize_) != 0) {
+      PLOG(ERROR) << "Error truncating " << filename_;
+    }
+    return false;
+  }
+  fileSize_ += data.size();
+  return true;
+}
+
+void PersistentPskLog::compact() {
+  auto out = makeHeader();
+  for (const auto& record : records_) {
+    appendPut(out, record.first, record.second);
+  }
+
+  // Written beside the log and renamed over it, so a crash leaves one or
+  // the other
+  auto tmpFilename = filename_ + ".tmp";
+  try {
+    folly::File tmpFile(tmpFilename,
+                        O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    auto written = folly::writeFull(tmpFile.fd(), out.data(), out.size());
+    if (written != static_cast<ssize_t>(out.size())) {
+      folly::throwSystemError("write ", tmpFilename);
+    }
+    folly::checkUnixError(folly::fsyncNoInt(tmpFile.fd()),
+                          "fsync ", tmpFilename);
+    folly::checkUnixError(rename(tmpFilename.c_str(), filename_.c_str()),
+                          "rename ", tmpFilename);
+    file_ = std::move(tmpFile);
+    fileSize_ = out.size();
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Error compacting PSKs: " << ex.what();
+    unlink(tmpFilename.c_str());
+  }
+}
+
+void PersistentPskLog::writeLoop() {
+  std::unique_lock<std::mutex> lock(pendingMutex_);
+  while (!stop_) {
+    pendingCV_.wait_for(lock, config_.syncInterval, [this] {
+      return stop_ || pending_.size() >= config_.maxPendingUpdates;
+    });
+    lock.unlock();
+    sync();
+    lock.lock();
+  }
+}
+
+} // namespace proxygen
@@ -0,0 +1,142 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Function.h>
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace proxygen {
+
+struct PskLogConfig {
+  // Most PSKs the write-behind caches keep; the least recently used are
+  // dropped from memory and from the file
+  size_t capacity{1000};
+  // How long an update may wait before it is written.  Zero disables the
+  // writer thread, and updates are then only written by sync()
+  std::chrono::milliseconds syncInterval{std::chrono::seconds(5)};
+  // Write early once this many identities have updates waiting
+  size_t maxPendingUpdates{128};
+  // Rewrite the file once it is this many times larger than its live records
+  double compactionRatio{2.0};
+};
+
+/**
+ * Write-behind storage for serialized PSKs, used by PersistentFizzPskCache
+ * and PersistentQuicPskCache when they are given a PskLogConfig.
+ *
+ * Updates are only queued by the caller.  Updates to the same identity are
+ * combined, and a writer thread serializes them and appends them to the file
+ * with one write every syncInterval.  The file is an append-only log of
+ * checksummed binary records; it is memory mapped and replayed when the log
+ * is constructed, and rewritten with only the live records once it grows
+ * past compactionRatio times their size.  A record torn by a crash fails its
+ * checksum, and it and anything after it are discarded.
+ *
+ * All methods are thread safe.
+ */
+class PersistentPskLog {
+ public:
+  struct Record {
+    std::string value;
+    uint32_t uses{0};
+  };
+
+  using Records = std::unordered_map<std::string, Record>;
+
+  /**
+   * Loads filename, creating it if needed.  Errors opening the file are
+   * logged, and the log then only keeps records in memory.  So is a file
+   * that is not a PSK log, such as one written by wangle's
+   * FilePersistentCache; it is left as it is.
+   */
+  PersistentPskLog(std::string filename, PskLogConfig config);
+
+  /**
+   * Stops the writer thread and writes whatever is still queued.
+   */
+  ~PersistentPskLog();
+
+  PersistentPskLog(const PersistentPskLog&) = delete;
+  PersistentPskLog& operator=(const PersistentPskLog&) = delete;
+
+  /**
+   * The records as of the last sync().  Right after construction, what was
+   * loaded from the file.
+   */
+  Records getRecords() const;
+
+  /**
+   * Queues a new value for identity with zero uses.  serialize is called
+   * later, on the writer thread, unless a newer update replaces it first.
+   * If it throws, the identity is removed.
+   */
+  void put(const std::string& identity,
+           folly::Function<std::string()> serialize);
+
+  /**
+   * Queues a new use count for identity.  Ignored if identity has no value.
+   */
+  void setUses(const std::string& identity, uint32_t uses);
+
+  void remove(const std::string& identity);
+
+  /**
+   * Serializes and writes every queued update on the calling thread.
+   */
+  void sync();
+
+  uint64_t getFileSize() const;
+
+ private:
+  struct Update {
+    folly::Function<std::string()> serialize;
+    folly::Optional<uint32_t> uses;
+    bool remove{false};
+  };
+
+  using Updates = std::unordered_map<std::string, Update>;
+
+  void queue(const std::string& identity,
+             folly::FunctionRef<void(Update&)> change);
+  void load();
+  void replay(folly::ByteRange data);
+  bool append(folly::StringPiece data);
+  void compact();
+  void writeLoop();
+
+  const std::string filename_;
+  const PskLogConfig config_;
+
+  // Guarded by pendingMutex_; the caller side
+  std::mutex pendingMutex_;
+  std::condition_variable pendingCV_;
+  Updates pending_;
+  bool stop_{false};
+
+  // Guarded by writeMutex_; the writer side
+  mutable std::mutex writeMutex_;
+  folly::File file_;
+  uint64_t fileSize_{0};
+  uint64_t liveBytes_{0};
+  Records records_;
+
+  std::thread writer_;
+};
+
+} // namespace proxygen
@@ -16,6 +16,76 @@ namespace {
 constexpr auto FIZZ_PSK = "psk";
 constexpr auto QUIC_PARAMS = "quic";
 constexpr auto USES = "uses";
+
+void writeQuicParams(const quic::QuicCachedPsk& quicCachedPsk,
+                     folly::io::Appender& appender) {
+  fizz::detail::write(quicCachedPsk.transportParams.negotiatedVersion,
+                      appender);
+  fizz::detail::write(quicCachedPsk.transportParams.idleTimeout, appender);
+  fizz::detail::write(quicCachedPsk.transportParams.maxRecvPacketSize,
+                      appender);
+  fizz::detail::write(quicCachedPsk.transportParams.initialMaxData, appender);
+  fizz::detail::write(
+      quicCachedPsk.transportParams.initialMaxStreamDataBidiLocal, appender);
+  fizz::detail::write(
+      quicCachedPsk.transportParams.initialMaxStreamDataBidiRemote, appender);
+  fizz::detail::write(quicCachedPsk.transportParams.initialMaxStreamDataUni,
+                      appender);
+  fizz::detail::write(quicCachedPsk.transportParams.initialMaxStreamsBidi,
+                      appender);
+  fizz::detail::write(quicCachedPsk.transportParams.initialMaxStreamsUni,
+                      appender);
+  fizz::detail::writeBuf<uint16_t>(
+      folly::IOBuf::wrapBuffer(folly::StringPiece(quicCachedPsk.appParams)),
+      appender);
+}
+
+void readQuicParams(folly::io::Cursor& cursor,
+                    quic::QuicCachedPsk& quicCachedPsk) {
+  fizz::detail::read(quicCachedPsk.transportParams.negotiatedVersion, cursor);
+  fizz::detail::read(quicCachedPsk.transportParams.idleTimeout, cursor);
+  fizz::detail::read(quicCachedPsk.transportParams.maxRecvPacketSize, cursor);
+  fizz::detail::read(quicCachedPsk.transportParams.initialMaxData, cursor);
+  fizz::detail::read(
+      quicCachedPsk.transportParams.initialMaxStreamDataBidiLocal, cursor);
+  fizz::detail::read(
+      quicCachedPsk.transportParams.initialMaxStreamDataBidiRemote, cursor);
+  fizz::detail::read(quicCachedPsk.transportParams.initialMaxStreamDataUni,
+                     cursor);
+  fizz::detail::read(quicCachedPsk.transportParams.initialMaxStreamsBidi,
+                     cursor);
+  fizz::detail::read(quicCachedPsk.transportParams.initialMaxStreamsUni,
+                     cursor);
+
+  std::unique_ptr<folly::IOBuf> appParams;
+  fizz::detail::readBuf<uint16_t>(appParams, cursor);
+  quicCachedPsk.appParams = appParams->moveToFbString().toStdString();
+}
+
+// The write-behind format: the fizz PSK, then the QUIC parameters
+std::string serializeQuicPsk(const quic::QuicCachedPsk& quicCachedPsk) {
+  auto fizzPsk = proxygen::serializePsk(quicCachedPsk.cachedPsk);
+  auto serialized = folly::IOBuf::create(0);
+  folly::io::Appender appender(serialized.get(), 512);
+  fizz::detail::writeBuf<uint32_t>(
+      folly::IOBuf::wrapBuffer(folly::StringPiece(fizzPsk)), appender);
+  writeQuicParams(quicCachedPsk, appender);
+  return serialized->moveToFbString().toStdString();
+}
+
+quic::QuicCachedPsk deserializeQuicPsk(const std::string& str,
+                                       const fizz::Factory& factory) {
+  auto buf = folly::IOBuf::wrapBuffer(str.data(), str.length());
+  folly::io::Cursor cursor(buf.get());
+  std::unique_ptr<folly::IOBuf> fizzPsk;
+  fizz::detail::readBuf<uint32_t>(fizzPsk, cursor);
+
+  quic::QuicCachedPsk quicCachedPsk;
+  quicCachedPsk.cachedPsk =
+      proxygen::deserializePsk(fizzPsk->moveToFbString().toStdString(), factory);
+  readQuicParams(cursor, quicCachedPsk);
+  return quicCachedPsk;
+}
 } // namespace
 
 namespace proxygen {
@@ -23,16 +93,37 @@ PersistentQuicPskCache::PersistentQuicPskCache(
     const std::string& filename,
     wangle::PersistentCacheConfig config,
     std::unique_ptr<fizz::Factory> factory)
-    : cache_(filename, std::move(config)), factory_(std::move(factory)) {
+    : factory_(std::move(factory)),
+      cache_(std::make_unique<
+             wangle::FilePersistentCache<std::string, PersistentQuicCachedPsk>>(
+          filename, std::move(config))) {
+}
+
+PersistentQuicPskCache::PersistentQuicPskCache(
+    const std::string& filename,
+    PskLogConfig config,
+    std::unique_ptr<fizz::Factory> factory)
+    : factory_(std::move(factory)) {
+  auto deserialize = [this](const std::string& str) {
+    return deserializeQuicPsk(str, *factory_);
+  };
+  writeBehind_ = std::make_unique<WriteBehindPskCache<quic::QuicCachedPsk>>(
+      filename, std::move(config), serializeQuicPsk, deserialize);
 }
 
 void PersistentQuicPskCache::setMaxPskUses(size_t maxUses) {
   maxPskUses_ = maxUses;
+  if (writeBehind_) {
+    writeBehind_->setMaxPskUses(maxUses);
+  }
 }
 
 folly::Optional<quic::QuicCachedPsk> PersistentQuicPskCache::getPsk(
     const std::string& identity) {
-  auto cachedPsk = cache_.get(identity);
+  if (writeBehind_) {
+    return writeBehind_->getPsk(identity);
+  }
+  auto cachedPsk = cache_->get(identity);
   if (!cachedPsk) {
     return folly::none;
   }
@@ -43,72 +134,45 @@ folly::Optional<quic::QuicCachedPsk> PersistentQuicPskCache::getPsk(
     auto buf = folly::IOBuf::wrapBuffer(cachedPsk->quicParams.data(),
                                         cachedPsk->quicParams.length());
     folly::io::Cursor cursor(buf.get());
-    fizz::detail::read(quicCachedPsk.transportParams.negotiatedVersion, cursor);
-    fizz::detail::read(quicCachedPsk.transportParams.idleTimeout, cursor);
-    fizz::detail::read(quicCachedPsk.transportParams.maxRecvPacketSize, cursor);
-    fizz::detail::read(quicCachedPsk.transportParams.initialMaxData, cursor);
-    fizz::detail::read(
-        quicCachedPsk.transportParams.initialMaxStreamDataBidiLocal, cursor);
-    fizz::detail::read(
-        quicCachedPsk.transportParams.initialMaxStreamDataBidiRemote, cursor);
-    fizz::detail::read(quicCachedPsk.transportParams.initialMaxStreamDataUni,
-                       cursor);
-    fizz::detail::read(quicCachedPsk.transportParams.initialMaxStreamsBidi,
-                       cursor);
-    fizz::detail::read(quicCachedPsk.transportParams.initialMaxStreamsUni,
-                       cursor);
-
-    std::unique_ptr<folly::IOBuf> appParams;
-    fizz::detail::readBuf<uint16_t>(appParams, cursor);
-    quicCachedPsk.appParams = appParams->moveToFbString().toStdString();
+    readQuicParams(cursor, quicCachedPsk);
 
     cachedPsk->uses++;
     if (maxPskUses_ != 0 && cachedPsk->uses >= maxPskUses_) {
-      cache_.remove(identity);
+      cache_->remove(identity);
     } else {
-      cache_.put(identity, *cachedPsk);
+      cache_->put(identity, *cachedPsk);
     }
     return std::move(quicCachedPsk);
   } catch (const std::exception& ex) {
     LOG(ERROR) << "Error deserializing PSK: " << ex.what();
-    cache_.remove(identity);
+    cache_->remove(identity);
     return folly::none;
   }
 }
 
 void PersistentQuicPskCache::putPsk(const std::string& identity,
                                     quic::QuicCachedPsk quicCachedPsk) {
+  if (writeBehind_) {
+    writeBehind_->putPsk(identity, std::move(quicCachedPsk));
+    return;
+  }
   PersistentQuicCachedPsk cachedPsk;
   cachedPsk.fizzPsk = serializePsk(quicCachedPsk.cachedPsk);
 
   auto quicParams = folly::IOBuf::create(0);
   folly::io::Appender appender(quicParams.get(), 512);
-  fizz::detail::write(quicCachedPsk.transportParams.negotiatedVersion,
-                      appender);
-  fizz::detail::write(quicCachedPsk.transportParams.idleTimeout, appender);
-  fizz::detail::write(quicCachedPsk.transportParams.maxRecvPacketSize,
-                      appender);
-  fizz::detail::write(quicCachedPsk.transportParams.initialMaxData, appender);
-  fizz::detail::write(
-      quicCachedPsk.transportParams.initialMaxStreamDataBidiLocal, appender);
-  fizz::detail::write(
-      quicCachedPsk.transportParams.initialMaxStreamDataBidiRemote, appender);
-  fizz::detail::write(quicCachedPsk.transportParams.initialMaxStreamDataUni,
-                      appender);
-  fizz::detail::write(quicCachedPsk.transportParams.initialMaxStreamsBidi,
-                      appender);
-  fizz::detail::write(quicCachedPsk.transportParams.initialMaxStreamsUni,
-                      appender);
-  fizz::detail::writeBuf<uint16_t>(
-      folly::IOBuf::wrapBuffer(folly::StringPiece(quicCachedPsk.appParams)),
-      appender);
+  writeQuicParams(quicCachedPsk, appender);
   cachedPsk.quicParams = quicParams->moveToFbString().toStdString();
   cachedPsk.uses = 0;
-  cache_.put(identity, std::move(cachedPsk));
+  cache_->put(identity, std::move(cachedPsk));
 }
 
 void PersistentQuicPskCache::removePsk(const std::string& identity) {
-  cache_.remove(identity);
+  if (writeBehind_) {
+    writeBehind_->removePsk(identity);
+    return;
+  }
+  cache_->remove(identity);
 }
 } // namespace proxygen
 
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <proxygen/lib/transport/PersistentFizzPskCache.h>
+#include <proxygen/lib/transport/WriteBehindPskCache.h>
 
 #include <folly/Optional.h>
 #include <folly/dynamic.h>
@@ -30,6 +31,11 @@ struct PersistentQuicCachedPsk {
   size_t uses{0};
 };
 
+/**
+ * A QuicPskCache persisted to a file.  Like PersistentFizzPskCache, written
+ * through a wangle::FilePersistentCache or, given a PskLogConfig, written
+ * behind by a PersistentPskLog.
+ */
 class PersistentQuicPskCache : public quic::QuicPskCache {
  public:
   PersistentQuicPskCache(const std::string& filename,
@@ -37,6 +43,11 @@ class PersistentQuicPskCache : public quic::QuicPskCache {
                          std::unique_ptr<fizz::Factory> factory =
                              std::make_unique<fizz::OpenSSLFactory>());
 
+  PersistentQuicPskCache(const std::string& filename,
+                         PskLogConfig config,
+                         std::unique_ptr<fizz::Factory> factory =
+                             std::make_unique<fizz::OpenSSLFactory>());
+
   void setMaxPskUses(size_t maxUses);
 
   folly::Optional<quic::QuicCachedPsk> getPsk(
@@ -46,9 +57,13 @@ class PersistentQuicPskCache : public quic::QuicPskCache {
   void removePsk(const std::string& identity) override;
 
  private:
-  wangle::FilePersistentCache<std::string, PersistentQuicCachedPsk> cache_;
-  size_t maxPskUses_{5};
   std::unique_ptr<fizz::Factory> factory_;
+  // Exactly one of these is set
+  std::unique_ptr<
+      wangle::FilePersistentCache<std::string, PersistentQuicCachedPsk>>
+      cache_;
+  std::unique_ptr<WriteBehindPskCache<quic::QuicCachedPsk>> writeBehind_;
+  size_t maxPskUses_{5};
 };
 
 } // namespace proxygen
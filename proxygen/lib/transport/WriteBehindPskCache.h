@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <proxygen/lib/transport/PersistentPskLog.h>
+
+#include <folly/container/EvictingCacheMap.h>
+#include <glog/logging.h>
+
+#include <functional>
+#include <mutex>
+
+namespace proxygen {
+
+/**
+ * The write-behind mode of PersistentFizzPskCache and PersistentQuicPskCache.
+ * PSKs are kept deserialized in an LRU map, so lookups neither deserialize
+ * nor touch the file.  Changes are queued on a PersistentPskLog, whose writer
+ * thread calls serialize.  What the log loaded is deserialized up front.
+ */
+template <typename Psk>
+class WriteBehindPskCache {
+ public:
+  using SerializeFn = std::function<std::string(const Psk&)>;
+  using DeserializeFn = std::function<Psk(const std::string&)>;
+
+  WriteBehindPskCache(std::string filename,
+                      PskLogConfig config,
+                      SerializeFn serialize,
+                      const DeserializeFn& deserialize)
+      : serialize_(std::move(serialize)),
+        log_(std::move(filename), config),
+        psks_(config.capacity) {
+    psks_.setPruneHook([this] (std::string identity, Entry&&) {
+      log_.remove(identity);
+    });
+    for (auto& record : log_.getRecords()) {
+      try {
+        Entry entry{deserialize(record.second.value), record.second.uses};
+        psks_.set(record.first, std::move(entry));
+      } catch (const std::exception& ex) {
+        LOG(ERROR) << "Error deserializing PSK: " << ex.what();
+        log_.remove(record.first);
+      }
+    }
+  }
+
+  void setMaxPskUses(size_t maxUses) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    maxPskUses_ = maxUses;
+  }
+
+  folly::Optional<Psk> getPsk(const std::string& identity) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = psks_.find(identity);
+    if (it == psks_.end()) {
+      return folly::none;
+    }
+    Psk psk = it->second.psk;
+    auto uses = ++it->second.uses;
+    if (maxPskUses_ != 0 && uses >= maxPskUses_) {
+      psks_.erase(identity);
+      log_.remove(identity);
+    } else {
+      log_.setUses(identity, uses);
+    }
+    return std::move(psk);
+  }
+
+  void putPsk(const std::string& identity, Psk psk) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    psks_.set(identity, Entry{psk, 0});
+    log_.put(identity, [this, psk = std::move(psk)] {
+      return serialize_(psk);
+    });
+  }
+
+  void removePsk(const std::string& identity) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    psks_.erase(identity);
+    log_.remove(identity);
+  }
+
+  /**
+   * Writes every queued change on the calling thread.
+   */
+  void sync() {
+    log_.sync();
+  }
+
+ private:
+  struct Entry {
+    Psk psk;
+    uint32_t uses;
+  };
+
+  // Used by log_'s writer thread until log_ is destroyed
+  const SerializeFn serialize_;
+  PersistentPskLog log_;
+
+  std::mutex mutex_;
+  folly::EvictingCacheMap<std::string, Entry> psks_;
+  size_t maxPskUses_{5};
+};
+
+} // namespace proxygen
@@ -0,0 +1,200 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/transport/PersistentFizzPskCache.h>
+#include <proxygen/lib/transport/PersistentQuicPskCache.h>
+
+using namespace proxygen;
+
+namespace {
+
+fizz::client::CachedPsk makeFizzPsk(const std::string& ticket) {
+  fizz::client::CachedPsk psk;
+  psk.psk = ticket;
+  psk.secret = std::string(48, 's');
+  psk.type = fizz::PskType::Resumption;
+  psk.version = fizz::ProtocolVersion::tls_1_3;
+  psk.cipher = fizz::CipherSuite::TLS_AES_128_GCM_SHA256;
+  psk.group = fizz::NamedGroup::x25519;
+  psk.alpn = std::string("h3");
+  psk.ticketAgeAdd = 1234;
+  psk.maxEarlyDataSize = 16384;
+  return psk;
+}
+
+quic::QuicCachedPsk makeQuicPsk(const std::string& ticket) {
+  quic::QuicCachedPsk psk;
+  psk.cachedPsk = makeFizzPsk(ticket);
+  psk.transportParams.initialMaxData = 1000000;
+  psk.transportParams.initialMaxStreamsBidi = 100;
+  psk.appParams = "app params";
+  return psk;
+}
+
+void expectFizzPsk(const folly::Optional<fizz::client::CachedPsk>& psk,
+                   const std::string& ticket) {
+  ASSERT_TRUE(psk);
+  EXPECT_EQ(psk->psk, ticket);
+  EXPECT_EQ(psk->secret, std::string(48, 's'));
+  EXPECT_EQ(psk->cipher, fizz::CipherSuite::TLS_AES_128_GCM_SHA256);
+  EXPECT_EQ(psk->group, fizz::NamedGroup::x25519);
+  EXPECT_EQ(psk->alpn, std::string("h3"));
+  EXPECT_EQ(psk->ticketAgeAdd, 1234);
+  EXPECT_EQ(psk->maxEarlyDataSize, 16384);
+}
+
+void expectQuicPsk(const folly::Optional<quic::QuicCachedPsk>& psk,
+                   const std::string& ticket) {
+  ASSERT_TRUE(psk);
+  expectFizzPsk(psk->cachedPsk, ticket);
+  EXPECT_EQ(psk->transportParams.initialMaxData, 1000000);
+  EXPECT_EQ(psk->transportParams.initialMaxStreamsBidi, 100);
+  EXPECT_EQ(psk->appParams, "app params");
+}
+
+} // namespace
+
+/**
+ * Runs each test against both modes of the caches: written through by a
+ * wangle::FilePersistentCache, and written behind by a PersistentPskLog.
+ */
+class PersistentPskCacheTest : public testing::TestWithParam<bool> {
+ protected:
+  template <typename Cache>
+  std::unique_ptr<Cache> open() {
+    std::unique_ptr<Cache> cache;
+    if (GetParam()) {
+      PskLogConfig config;
+      // Only write on sync() and destruction
+      config.syncInterval = std::chrono::milliseconds(0);
+      cache = std::make_unique<Cache>(file_.path().string(), config);
+    } else {
+      cache = std::make_unique<Cache>(
+          file_.path().string(),
+          wangle::PersistentCacheConfig::Builder()
+              .setCapacity(1000)
+              .setSyncInterval(std::chrono::seconds(1))
+              .build());
+    }
+    cache->setMaxPskUses(3);
+    return cache;
+  }
+
+  folly::test::TemporaryFile file_;
+};
+
+TEST_P(PersistentPskCacheTest, FizzPutGetRemove) {
+  auto cache = open<PersistentFizzPskCache>();
+  EXPECT_FALSE(cache->getPsk("a"));
+  cache->putPsk("a", makeFizzPsk("ticket a"));
+  cache->putPsk("b", makeFizzPsk("ticket b"));
+  expectFizzPsk(cache->getPsk("a"), "ticket a");
+  expectFizzPsk(cache->getPsk("b"), "ticket b");
+  cache->removePsk("a");
+  EXPECT_FALSE(cache->getPsk("a"));
+}
+
+TEST_P(PersistentPskCacheTest, FizzUses) {
+  auto cache = open<PersistentFizzPskCache>();
+  cache->putPsk("a", makeFizzPsk("ticket a"));
+  expectFizzPsk(cache->getPsk("a"), "ticket a");
+  expectFizzPsk(cache->getPsk("a"), "ticket a");
+  expectFizzPsk(cache->getPsk("a"), "ticket a");
+  EXPECT_FALSE(cache->getPsk("a"));
+}
+
+TEST_P(PersistentPskCacheTest, FizzReload) {
+  auto cache = open<PersistentFizzPskCache>();
+  cache->putPsk("a", makeFizzPsk("ticket a"));
+  cache->putPsk("b", makeFizzPsk("ticket b"));
+  cache->putPsk("c", makeFizzPsk("ticket c"));
+  expectFizzPsk(cache->getPsk("a"), "ticket a");
+  expectFizzPsk(cache->getPsk("a"), "ticket a");
+  cache->removePsk("b");
+  cache.reset();
+
+  cache = open<PersistentFizzPskCache>();
+  EXPECT_FALSE(cache->getPsk("b"));
+  expectFizzPsk(cache->getPsk("c"), "ticket c");
+  // The use count was kept, so this is the last use
+  expectFizzPsk(cache->getPsk("a"), "ticket a");
+  EXPECT_FALSE(cache->getPsk("a"));
+}
+
+TEST_P(PersistentPskCacheTest, QuicPutGetRemove) {
+  auto cache = open<PersistentQuicPskCache>();
+  EXPECT_FALSE(cache->getPsk("a"));
+  cache->putPsk("a", makeQuicPsk("ticket a"));
+  cache->putPsk("b", makeQuicPsk("ticket b"));
+  expectQuicPsk(cache->getPsk("a"), "ticket a");
+  expectQuicPsk(cache->getPsk("b"), "ticket b");
+  cache->removePsk("a");
+  EXPECT_FALSE(cache->getPsk("a"));
+}
+
+TEST_P(PersistentPskCacheTest, QuicUses) {
+  auto cache = open<PersistentQuicPskCache>();
+  cache->putPsk("a", makeQuicPsk("ticket a"));
+  expectQuicPsk(cache->getPsk("a"), "ticket a");
+  expectQuicPsk(cache->getPsk("a"), "ticket a");
+  expectQuicPsk(cache->getPsk("a"), "ticket a");
+  EXPECT_FALSE(cache->getPsk("a"));
+}
+
+TEST_P(PersistentPskCacheTest, QuicReload) {
+  auto cache = open<PersistentQuicPskCache>();
+  cache->putPsk("a", makeQuicPsk("ticket a"));
+  cache->putPsk("b", makeQuicPsk("ticket b"));
+  cache->putPsk("c", makeQuicPsk("ticket c"));
+  expectQuicPsk(cache->getPsk("a"), "ticket a");
+  expectQuicPsk(cache->getPsk("a"), "ticket a");
+  cache->removePsk("b");
+  cache.reset();
+
+  cache = open<PersistentQuicPskCache>();
+  EXPECT_FALSE(cache->getPsk("b"));
+  expectQuicPsk(cache->getPsk("c"), "ticket c");
+  // The use count was kept, so this is the last use
+  expectQuicPsk(cache->getPsk("a"), "ticket a");
+  EXPECT_FALSE(cache->getPsk("a"));
+}
+
+INSTANTIATE_TEST_CASE_P(
+  PersistentPskCache,
+  PersistentPskCacheTest,
+  ::testing::Values(false, true));
+
+TEST(PersistentPskCacheModesTest, OtherModeFile) {
+  folly::test::TemporaryFile file;
+  auto writeThroughConfig = [] {
+    return wangle::PersistentCacheConfig::Builder()
+        .setCapacity(1000)
+        .setSyncInterval(std::chrono::seconds(1))
+        .build();
+  };
+  {
+    PersistentFizzPskCache cache(file.path().string(), writeThroughConfig());
+    cache.putPsk("a", makeFizzPsk("ticket a"));
+  }
+
+  // The write-behind mode cannot read the file, and leaves it alone
+  {
+    PskLogConfig config;
+    config.syncInterval = std::chrono::milliseconds(0);
+    PersistentFizzPskCache cache(file.path().string(), config);
+    EXPECT_FALSE(cache.getPsk("a"));
+    cache.putPsk("b", makeFizzPsk("ticket b"));
+  }
+
+  PersistentFizzPskCache cache(file.path().string(), writeThroughConfig());
+  expectFizzPsk(cache.getPsk("a"), "ticket a");
+  EXPECT_FALSE(cache.getPsk("b"));
+}
@@ -0,0 +1,158 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/transport/PersistentPskLog.h>
+
+using namespace proxygen;
+
+class PersistentPskLogTest : public testing::Test {
+ protected:
+  PskLogConfig config() {
+    PskLogConfig config;
+    // Only write on sync()
+    config.syncInterval = std::chrono::milliseconds(0);
+    return config;
+  }
+
+  std::unique_ptr<PersistentPskLog> open() {
+    return std::make_unique<PersistentPskLog>(file_.path().string(),
+                                              config());
+  }
+
+  std::string read() {
+    std::string contents;
+    EXPECT_TRUE(folly::readFile(file_.path().string().c_str(), contents));
+    return contents;
+  }
+
+  folly::test::TemporaryFile file_;
+};
+
+TEST_F(PersistentPskLogTest, Reload) {
+  auto log = open();
+  log->put("a", [] { return std::string("psk a"); });
+  log->put("b", [] { return std::string("psk b"); });
+  log->put("c", [] { return std::string("psk c"); });
+  log->sync();
+  log->setUses("a", 3);
+  log->remove("b");
+  log.reset();
+
+  auto records = open()->getRecords();
+  EXPECT_EQ(records.size(), 2);
+  EXPECT_EQ(records["a"].value, "psk a");
+  EXPECT_EQ(records["a"].uses, 3);
+  EXPECT_EQ(records["c"].value, "psk c");
+  EXPECT_EQ(records["c"].uses, 0);
+}
+
+TEST_F(PersistentPskLogTest, SerializeOnSync) {
+  auto log = open();
+  size_t serialized = 0;
+  log->put("a", [&] { serialized++; return std::string("old"); });
+  log->put("a", [&] { serialized++; return std::string("new"); });
+  EXPECT_EQ(serialized, 0);
+  log->setUses("a", 1);
+  log->sync();
+  // Only the newest value is serialized
+  EXPECT_EQ(serialized, 1);
+  EXPECT_EQ(log->getRecords()["a"].value, "new");
+  EXPECT_EQ(log->getRecords()["a"].uses, 1);
+
+  log->setUses("missing", 1);
+  log->put("b", [] () -> std::string { throw std::runtime_error("bad"); });
+  log->sync();
+  EXPECT_EQ(log->getRecords().size(), 1);
+}
+
+TEST_F(PersistentPskLogTest, TornRecord) {
+  auto log = open();
+  log->put("a", [] { return std::string("psk a"); });
+  log->sync();
+  auto size = log->getFileSize();
+  log->put("b", [] { return std::string("psk b"); });
+  log.reset();
+
+  // Cut the last record short, as a crash during the write would
+  auto contents = read();
+  ASSERT_GT(contents.size(), size + 4);
+  contents.resize(contents.size() - 4);
+  EXPECT_TRUE(folly::writeFile(contents, file_.path().string().c_str()));
+
+  log = open();
+  EXPECT_EQ(log->getFileSize(), size);
+  EXPECT_EQ(log->getRecords().size(), 1);
+  EXPECT_EQ(log->getRecords()["a"].value, "psk a");
+
+  // Appends continue after the good records
+  log->put("c", [] { return std::string("psk c"); });
+  log.reset();
+  EXPECT_EQ(open()->getRecords().size(), 2);
+}
+
+TEST_F(PersistentPskLogTest, ForeignFile) {
+  // As wangle::FilePersistentCache would write it
+  std::string json("[[\"a\",{\"psk\":\"psk a\",\"uses\":0}]]");
+  EXPECT_TRUE(folly::writeFile(json, file_.path().string().c_str()));
+  auto log = open();
+  EXPECT_TRUE(log->getRecords().empty());
+  // Kept in memory only
+  log->put("b", [] { return std::string("psk b"); });
+  log->sync();
+  EXPECT_EQ(log->getRecords().size(), 1);
+  log.reset();
+  EXPECT_EQ(read(), json);
+}
+
+TEST_F(PersistentPskLogTest, PartialHeader) {
+  // Left by a crash while the file was being created
+  auto log = open();
+  log.reset();
+  auto contents = read();
+  contents.resize(3);
+  EXPECT_TRUE(folly::writeFile(contents, file_.path().string().c_str()));
+
+  log = open();
+  log->put("a", [] { return std::string("psk a"); });
+  log.reset();
+  EXPECT_EQ(open()->getRecords().size(), 1);
+}
+
+TEST_F(PersistentPskLogTest, Compact) {
+  auto log = open();
+  std::string value(1000, 'x');
+  for (int i = 0; i < 100; i++) {
+    log->put("a", [&] { return value; });
+    log->sync();
+  }
+  // Rewritten to about one record
+  EXPECT_LT(log->getFileSize(), 20 * value.size());
+  log->put("b", [&] { return value; });
+  log.reset();
+
+  auto records = open()->getRecords();
+  EXPECT_EQ(records.size(), 2);
+  EXPECT_EQ(records["a"].value, value);
+}
+
+TEST_F(PersistentPskLogTest, WriterThread) {
+  auto cfg = config();
+  cfg.syncInterval = std::chrono::hours(1);
+  cfg.maxPendingUpdates = 1;
+  PersistentPskLog log(file_.path().string(), cfg);
+  log.put("a", [] { return std::string("psk a"); });
+  // Written without waiting for syncInterval
+  while (log.getRecords().empty()) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(log.getRecords()["a"].value, "psk a");
+}
@@ -0,0 +1,142 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/transport/WriteBehindPskCache.h>
+
+#include <cstring>
+
+using namespace proxygen;
+
+class WriteBehindPskCacheTest : public testing::Test {
+ protected:
+  using Cache = WriteBehindPskCache<std::string>;
+
+  PskLogConfig config() {
+    PskLogConfig config;
+    // Only write on sync()
+    config.syncInterval = std::chrono::milliseconds(0);
+    return config;
+  }
+
+  std::unique_ptr<Cache> open(PskLogConfig cfg) {
+    return std::make_unique<Cache>(
+      file_.path().string(),
+      cfg,
+      [] (const std::string& psk) { return "serialized " + psk; },
+      [] (const std::string& str) {
+        if (str.find("serialized ") != 0) {
+          throw std::runtime_error("bad psk");
+        }
+        return str.substr(strlen("serialized "));
+      });
+  }
+
+  std::unique_ptr<Cache> open() {
+    return open(config());
+  }
+
+  PersistentPskLog::Records records() {
+    return PersistentPskLog(file_.path().string(), config()).getRecords();
+  }
+
+  folly::test::TemporaryFile file_;
+};
+
+TEST_F(WriteBehindPskCacheTest, PutGetRemove) {
+  auto cache = open();
+  EXPECT_FALSE(cache->getPsk("a"));
+  cache->putPsk("a", "psk a");
+  cache->putPsk("b", "psk b");
+  EXPECT_EQ(cache->getPsk("a"), std::string("psk a"));
+  EXPECT_EQ(cache->getPsk("b"), std::string("psk b"));
+
+  cache->removePsk("a");
+  EXPECT_FALSE(cache->getPsk("a"));
+  cache->putPsk("b", "psk b2");
+  EXPECT_EQ(cache->getPsk("b"), std::string("psk b2"));
+}
+
+TEST_F(WriteBehindPskCacheTest, Uses) {
+  auto cache = open();
+  cache->setMaxPskUses(3);
+  cache->putPsk("a", "psk a");
+  cache->putPsk("b", "psk b");
+  EXPECT_TRUE(cache->getPsk("a"));
+  EXPECT_TRUE(cache->getPsk("a"));
+  EXPECT_TRUE(cache->getPsk("b"));
+  cache->sync();
+  auto written = records();
+  EXPECT_EQ(written["a"].uses, 2);
+  EXPECT_EQ(written["b"].uses, 1);
+
+  // The third use is the last
+  EXPECT_TRUE(cache->getPsk("a"));
+  EXPECT_FALSE(cache->getPsk("a"));
+  cache->sync();
+  EXPECT_EQ(records().count("a"), 0);
+
+  // Zero means no limit
+  cache->setMaxPskUses(0);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(cache->getPsk("b"));
+  }
+}
+
+TEST_F(WriteBehindPskCacheTest, Reload) {
+  auto cache = open();
+  cache->setMaxPskUses(3);
+  cache->putPsk("a", "psk a");
+  cache->putPsk("b", "psk b");
+  cache->putPsk("c", "psk c");
+  EXPECT_TRUE(cache->getPsk("a"));
+  EXPECT_TRUE(cache->getPsk("a"));
+  cache->removePsk("b");
+  // Written on destruction without a sync()
+  cache.reset();
+
+  cache = open();
+  cache->setMaxPskUses(3);
+  EXPECT_FALSE(cache->getPsk("b"));
+  EXPECT_EQ(cache->getPsk("c"), std::string("psk c"));
+  // The use count was kept, so this is the last use
+  EXPECT_EQ(cache->getPsk("a"), std::string("psk a"));
+  EXPECT_FALSE(cache->getPsk("a"));
+}
+
+TEST_F(WriteBehindPskCacheTest, Evict) {
+  auto cfg = config();
+  cfg.capacity = 2;
+  auto cache = open(cfg);
+  cache->putPsk("a", "psk a");
+  cache->putPsk("b", "psk b");
+  cache->putPsk("c", "psk c");
+  EXPECT_FALSE(cache->getPsk("a"));
+  cache.reset();
+
+  // Dropped from the file too
+  auto written = records();
+  EXPECT_EQ(written.size(), 2);
+  EXPECT_EQ(written.count("a"), 0);
+}
+
+TEST_F(WriteBehindPskCacheTest, BadRecord) {
+  {
+    PersistentPskLog log(file_.path().string(), config());
+    log.put("a", [] { return std::string("serialized psk a"); });
+    log.put("b", [] { return std::string("garbage"); });
+  }
+
+  auto cache = open();
+  EXPECT_EQ(cache->getPsk("a"), std::string("psk a"));
+  EXPECT_FALSE(cache->getPsk("b"));
+  cache.reset();
+  EXPECT_EQ(records().count("b"), 0);
+}
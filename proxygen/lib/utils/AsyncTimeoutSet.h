@@ -36,6 +36,9 @@ namespace proxygen {
  *
  * Note, this class may not be needed given libevent's
  * event_base_init_common_timeout(). We should look into using that.
+ *
+ * New code should use TimerWheel, which schedules and cancels in O(1) for
+ * any mix of intervals and shares one timeout per event base.
  */
 class AsyncTimeoutSet : private folly::AsyncTimeout,
                         public folly::DelayedDestruction {
@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/BinaryTraceEvent.h>
+
+#include <folly/String.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace proxygen {
+
+constexpr size_t BinaryTraceEvent::kMaxFields;
+constexpr size_t BinaryTraceEvent::kStringCapacity;
+
+BinaryTraceEvent::BinaryTraceEvent(TraceEventType type, uint32_t parentID):
+  type_(type),
+  id_(TraceEvent::nextID()),
+  parentID_(parentID) {
+}
+
+const BinaryTraceEvent::Field* BinaryTraceEvent::findField(
+    TraceFieldType key) const {
+  for (size_t i = 0; i < numFields_; i++) {
+    if (fields_[i].key == key) {
+      return &fields_[i];
+    }
+  }
+  return nullptr;
+}
+
+BinaryTraceEvent::Field* BinaryTraceEvent::getOrAddField(TraceFieldType key) {
+  auto field = const_cast<Field*>(findField(key));
+  if (field) {
+    return field;
+  }
+  if (numFields_ == kMaxFields) {
+    stateFlags_ |= TRUNCATED;
+    return nullptr;
+  }
+  field = &fields_[numFields_++];
+  field->key = key;
+  field->offset = 0;
+  field->length = 0;
+  return field;
+}
+
+bool BinaryTraceEvent::addString(TraceFieldType key, FieldKind kind,
+                                 folly::StringPiece value) {
+  Field* field = getOrAddField(key);
+  if (!field) {
+    return false;
+  }
+  // A replaced string keeps its old arena bytes; events are short lived and
+  // values are rarely replaced, so the arena is never compacted.
+  size_t length = std::min(value.size(), kStringCapacity - stringsUsed_);
+  field->kind = kind;
+  field->intValue = 0;
+  field->offset = stringsUsed_;
+  field->length = length;
+  memcpy(strings_ + stringsUsed_, value.data(), length);
+  stringsUsed_ += length;
+  if (length < value.size()) {
+    stateFlags_ |= TRUNCATED;
+    return false;
+  }
+  return true;
+}
+
+bool BinaryTraceEvent::addMeta(TraceFieldType key, folly::StringPiece value) {
+  return addString(key, FieldKind::STRING, value);
+}
+
+bool BinaryTraceEvent::addMeta(TraceFieldType key,
+                               const std::vector<std::string>& value) {
+  std::string joined;
+  for (size_t i = 0; i < value.size(); i++) {
+    if (i > 0) {
+      joined.push_back('\0');
+    }
+    joined.append(value[i]);
+  }
+  bool complete = addString(key, FieldKind::STRING_LIST, joined);
+  auto field = const_cast<Field*>(findField(key));
+  if (field) {
+    // the element count tells an empty list from a list of one empty string
+    field->intValue = value.size();
+  }
+  return complete;
+}
+
+TraceEvent BinaryTraceEvent::toTraceEvent() const {
+  TraceEvent event(type_, parentID_);
+  event.id_ = id_;
+  if (hasStarted()) {
+    event.start(start_);
+  }
+  if (hasEnded()) {
+    event.end(end_);
+  }
+  for (size_t i = 0; i < numFields_; i++) {
+    const auto& field = fields_[i];
+    switch (field.kind) {
+      case FieldKind::INT:
+        event.addMeta(field.key, field.intValue);
+        break;
+      case FieldKind::STRING:
+        event.addMeta(field.key, getString(field).str());
+        break;
+      case FieldKind::STRING_LIST: {
+        std::vector<std::string> list;
+        if (field.intValue > 0) {
+          folly::split('\0', getString(field), list);
+        }
+        event.addMeta(field.key, std::move(list));
+        break;
+      }
+    }
+  }
+  return event;
+}
+
+}
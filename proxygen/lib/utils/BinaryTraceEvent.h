@@ -0,0 +1,179 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <proxygen/lib/utils/Time.h>
+#include <proxygen/lib/utils/TraceEvent.h>
+#include <proxygen/lib/utils/TraceEventType.h>
+#include <proxygen/lib/utils/TraceFieldType.h>
+
+#include <folly/Range.h>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Fixed layout, trivially copyable counterpart of TraceEvent.  Fields live in
+ * a small inline array keyed by TraceFieldType and string values are packed
+ * into an inline arena, so recording an event never allocates and copying it
+ * into a ring buffer is a memcpy.  Fields or strings that do not fit are
+ * dropped (strings are cut short) and the event is marked truncated.
+ *
+ * Convert with toTraceEvent() wherever the map based representation is
+ * needed; ids come from the same counter as TraceEvent.
+ */
+class BinaryTraceEvent {
+ public:
+  static constexpr size_t kMaxFields = 12;
+  // Offsets and lengths into the arena are stored in a byte
+  static constexpr size_t kStringCapacity = 192;
+
+  enum class FieldKind : uint8_t {
+    INT,
+    STRING,
+    // A string list, stored as its elements separated by '\0'
+    STRING_LIST,
+  };
+
+  struct Field {
+    int64_t intValue;
+    TraceFieldType key;
+    uint8_t offset;
+    uint8_t length;
+    FieldKind kind;
+  };
+
+  explicit BinaryTraceEvent(TraceEventType type, uint32_t parentID = 0);
+
+  void start(TimePoint startTime = getCurrentTime()) {
+    stateFlags_ |= STARTED;
+    start_ = startTime;
+  }
+
+  void end(TimePoint endTime = getCurrentTime()) {
+    stateFlags_ |= ENDED;
+    end_ = endTime;
+  }
+
+  bool hasStarted() const {
+    return stateFlags_ & STARTED;
+  }
+
+  bool hasEnded() const {
+    return stateFlags_ & ENDED;
+  }
+
+  /**
+   * @Returns true if a field or part of a string value was dropped.
+   */
+  bool isTruncated() const {
+    return stateFlags_ & TRUNCATED;
+  }
+
+  TimePoint getStartTime() const {
+    return start_;
+  }
+
+  TimePoint getEndTime() const {
+    return end_;
+  }
+
+  TraceEventType getType() const {
+    return type_;
+  }
+
+  uint32_t getID() const {
+    return id_;
+  }
+
+  void setParentID(uint32_t parent) {
+    parentID_ = parent;
+  }
+
+  uint32_t getParentID() const {
+    return parentID_;
+  }
+
+  /**
+   * Adds or replaces the value of key.  @Returns false if the value had to be
+   * dropped or truncated.
+   */
+  template <typename T,
+            typename = typename std::enable_if<std::is_integral<T>::value,
+                                               void>::type>
+  bool addMeta(TraceFieldType key, T value) {
+    Field* field = getOrAddField(key);
+    if (!field) {
+      return false;
+    }
+    field->kind = FieldKind::INT;
+    field->intValue = static_cast<int64_t>(value);
+    return true;
+  }
+
+  bool addMeta(TraceFieldType key, folly::StringPiece value);
+
+  bool addMeta(TraceFieldType key, const std::vector<std::string>& value);
+
+  size_t getNumFields() const {
+    return numFields_;
+  }
+
+  const Field& getField(size_t i) const {
+    return fields_[i];
+  }
+
+  /**
+   * @Returns the field for key, or nullptr.
+   */
+  const Field* findField(TraceFieldType key) const;
+
+  /**
+   * The raw bytes of a STRING or STRING_LIST field.
+   */
+  folly::StringPiece getString(const Field& field) const {
+    return folly::StringPiece(strings_ + field.offset, field.length);
+  }
+
+  TraceEvent toTraceEvent() const;
+
+ private:
+  enum State : uint8_t {
+    STARTED = 1,
+    ENDED = 2,
+    TRUNCATED = 4,
+  };
+
+  Field* getOrAddField(TraceFieldType key);
+  bool addString(TraceFieldType key, FieldKind kind,
+                 folly::StringPiece value);
+
+  TraceEventType type_;
+  uint32_t id_;
+  uint32_t parentID_;
+  uint8_t stateFlags_{0};
+  uint8_t numFields_{0};
+  uint8_t stringsUsed_{0};
+  TimePoint start_;
+  TimePoint end_;
+  Field fields_[kMaxFields];
+  char strings_[kStringCapacity];
+};
+
+static_assert(std::is_trivially_copyable<BinaryTraceEvent>::value,
+              "BinaryTraceEvent must stay memcpy-able");
+static_assert(BinaryTraceEvent::kStringCapacity <= 255,
+              "string offsets are stored in a byte");
+
+}
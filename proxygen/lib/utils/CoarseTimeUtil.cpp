@@ -0,0 +1,58 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/CoarseTimeUtil.h>
+
+#include <folly/io/async/EventBaseLocal.h>
+
+namespace proxygen {
+
+CoarseTimeUtil::CoarseTimeUtil(folly::EventBase* eventBase, TimeUtil* clock)
+    : eventBase_(eventBase),
+      clock_(clock ? clock : &defaultClock_) {
+}
+
+CoarseTimeUtil& CoarseTimeUtil::get(folly::EventBase* eventBase) {
+  // Leaked so event bases destroyed during static destruction can still
+  // release their clock
+  static auto clocks =
+    new folly::EventBaseLocal<std::unique_ptr<CoarseTimeUtil>>();
+  eventBase->dcheckIsInEventBaseThread();
+  auto create = [eventBase] {
+    return std::make_unique<CoarseTimeUtil>(eventBase);
+  };
+  return *clocks->getOrCreateFn(*eventBase, create);
+}
+
+TimePoint CoarseTimeUtil::now() const {
+  if (cache_.valid) {
+    return cache_.time;
+  }
+  return refresh();
+}
+
+TimePoint CoarseTimeUtil::preciseNow() const {
+  return refresh();
+}
+
+void CoarseTimeUtil::setClock(TimeUtil* clock) {
+  clock_ = clock ? clock : &defaultClock_;
+  cache_.valid = false;
+}
+
+TimePoint CoarseTimeUtil::refresh() const {
+  cache_.time = clock_->now();
+  if (!cache_.valid) {
+    cache_.valid = true;
+    eventBase_->runInLoop(&cache_, true /* this iteration */);
+  }
+  return cache_.time;
+}
+
+}
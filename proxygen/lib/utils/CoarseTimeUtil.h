@@ -0,0 +1,71 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/io/async/EventBase.h>
+#include <proxygen/lib/utils/Time.h>
+
+namespace proxygen {
+
+/**
+ * A steady clock that reads the time once per event loop iteration.  The
+ * first now() in an iteration reads the underlying clock, and every later
+ * now() in the same iteration returns that time, so code that stamps
+ * several events per request pays for a single clock read.
+ *
+ * Times are at most one loop iteration old, including the time spent in
+ * handlers before the read.  Use preciseNow() where that matters, like RTT
+ * samples; it also refreshes the cached time.
+ *
+ * Must only be used from the event base thread.  Tests can set a
+ * MockTimeUtil as the underlying clock.
+ */
+class CoarseTimeUtil : public TimeUtil {
+ public:
+  explicit CoarseTimeUtil(folly::EventBase* eventBase,
+                          TimeUtil* clock = nullptr);
+
+  /**
+   * The clock of eventBase, created on first use and destroyed with the
+   * event base.
+   */
+  static CoarseTimeUtil& get(folly::EventBase* eventBase);
+
+  TimePoint now() const override;
+
+  TimePoint preciseNow() const;
+
+  /**
+   * Replaces the underlying clock, nullptr for the steady clock.  The clock
+   * must outlive this object or be replaced first.
+   */
+  void setClock(TimeUtil* clock);
+
+ private:
+  // Forgets the time at the end of the loop iteration it was read in
+  class Cache : public folly::EventBase::LoopCallback {
+   public:
+    void runLoopCallback() noexcept override {
+      valid = false;
+    }
+
+    bool valid{false};
+    TimePoint time;
+  };
+
+  TimePoint refresh() const;
+
+  folly::EventBase* eventBase_;
+  TimeUtil defaultClock_;
+  TimeUtil* clock_;
+  mutable Cache cache_;
+};
+
+}
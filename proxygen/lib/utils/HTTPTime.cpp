@@ -37,4 +37,15 @@ folly::Optional<int64_t> parseHTTPDateTime(const std::string& s) {
   return folly::none;
 }
 
+std::string formatHTTPDateTime(int64_t secondsSinceEpoch) {
+  struct tm tm = {};
+  time_t t = static_cast<time_t>(secondsSinceEpoch);
+  if (gmtime_r(&t, &tm) == nullptr) {
+    return std::string();
+  }
+  char buf[32];
+  auto len = strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+  return std::string(buf, len);
+}
+
 } // proxygen
@@ -17,4 +17,10 @@ namespace proxygen {
 
 folly::Optional<int64_t> parseHTTPDateTime(const std::string& s);
 
+/**
+ * Formats seconds since the epoch as an RFC 7231 IMF-fixdate, for example
+ * "Sun, 06 Nov 1994 08:49:37 GMT", suitable for Last-Modified and Date.
+ */
+std::string formatHTTPDateTime(int64_t secondsSinceEpoch);
+
 } // proxygen
@@ -0,0 +1,306 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/TimerWheel.h>
+
+#include <folly/ScopeGuard.h>
+#include <folly/io/async/EventBaseLocal.h>
+#include <folly/lang/Bits.h>
+#include <glog/logging.h>
+#include <proxygen/lib/utils/CoarseTimeUtil.h>
+
+#include <algorithm>
+#include <limits>
+
+using std::chrono::milliseconds;
+
+namespace proxygen {
+
+constexpr uint32_t TimerWheel::kBitsPerLevel;
+constexpr uint32_t TimerWheel::kSlotsPerLevel;
+constexpr uint32_t TimerWheel::kLevels;
+
+namespace {
+
+constexpr uint32_t kSlotMask = TimerWheel::kSlotsPerLevel - 1;
+// Callbacks further out are parked in the top level until they get closer
+constexpr uint64_t kMaxTicks =
+  uint64_t(1) << (TimerWheel::kBitsPerLevel * TimerWheel::kLevels);
+constexpr uint64_t kNotArmed = std::numeric_limits<uint64_t>::max();
+
+}
+
+TimerWheel::Callback::~Callback() {
+  cancelTimeout();
+}
+
+void TimerWheel::Callback::cancelTimeout() {
+  if (wheel_) {
+    wheel_->cancel(this);
+  }
+}
+
+milliseconds TimerWheel::Callback::getTimeRemaining() const {
+  if (!wheel_) {
+    return milliseconds(0);
+  }
+  auto expiration =
+    wheel_->start_ + wheel_->tick_ * static_cast<int64_t>(expirationTick_);
+  auto now = wheel_->preciseNow();
+  if (expiration <= now) {
+    return milliseconds(0);
+  }
+  return std::chrono::duration_cast<milliseconds>(expiration - now);
+}
+
+uint32_t TimerWheel::Level::findOccupied(uint32_t start) const {
+  if (start >= kSlotsPerLevel) {
+    return kSlotsPerLevel;
+  }
+  size_t word = start / 64;
+  uint64_t bits = occupied[word] & (~uint64_t(0) << (start % 64));
+  while (!bits) {
+    if (++word == occupied.size()) {
+      return kSlotsPerLevel;
+    }
+    bits = occupied[word];
+  }
+  return word * 64 + folly::findFirstSet(bits) - 1;
+}
+
+TimerWheel::TimerWheel(folly::TimeoutManager* timeoutManager,
+                       milliseconds tick,
+                       TimeUtil* clock)
+    : folly::AsyncTimeout(timeoutManager),
+      tick_(std::max(tick, milliseconds(1))),
+      clock_(clock ? *clock : defaultClock_),
+      start_(clock_.now()) {
+}
+
+TimerWheel::TimerWheel(folly::TimeoutManager* timeoutManager,
+                       milliseconds tick,
+                       CoarseTimeUtil* clock)
+    : TimerWheel(timeoutManager, tick, static_cast<TimeUtil*>(clock)) {
+  coarseClock_ = clock;
+}
+
+TimerWheel::~TimerWheel() {
+  // destroy() cancelled everything, and DelayedDestruction keeps us alive
+  // through timeoutExpired()
+  DCHECK_EQ(count_, 0);
+  DCHECK(!inTimeoutExpired_);
+}
+
+TimerWheel& TimerWheel::get(folly::EventBase* eventBase) {
+  // Leaked so event bases destroyed during static destruction can still
+  // release their wheel
+  static auto wheels = new folly::EventBaseLocal<UniquePtr>();
+  eventBase->dcheckIsInEventBaseThread();
+  auto create = [eventBase] {
+    return UniquePtr(new TimerWheel(eventBase, milliseconds(1),
+                                    &CoarseTimeUtil::get(eventBase)));
+  };
+  return *wheels->getOrCreateFn(*eventBase, create);
+}
+
+void TimerWheel::destroy() {
+  for (auto& level : levels_) {
+    for (auto& slot : level.slots) {
+      while (!slot.empty()) {
+        cancel(&slot.front());
+      }
+    }
+  }
+  while (!expired_.empty()) {
+    cancel(&expired_.front());
+  }
+  folly::AsyncTimeout::cancelTimeout();
+  DelayedDestruction::destroy();
+}
+
+TimePoint TimerWheel::preciseNow() const {
+  // A cached time would make callbacks scheduled late in a loop iteration,
+  // after a slow handler, fire early
+  return coarseClock_ ? coarseClock_->preciseNow() : clock_.now();
+}
+
+uint64_t TimerWheel::getTickAt(TimePoint time) const {
+  return static_cast<uint64_t>((time - start_) / tick_);
+}
+
+void TimerWheel::scheduleTimeout(Callback* callback, milliseconds timeout) {
+  callback->cancelTimeout();
+  auto now = preciseNow();
+  if (count_ == 0 && !inTimeoutExpired_) {
+    // Nothing to cascade, so skip the ticks that passed while idle
+    nextTick_ = std::max(nextTick_, getTickAt(now));
+  }
+
+  // Round up, so the callback never fires early
+  auto expiration = now - start_ + std::max(timeout, milliseconds(0));
+  auto tick = std::chrono::duration_cast<TimePoint::duration>(tick_);
+  callback->expirationTick_ = static_cast<uint64_t>(
+    (expiration + tick - TimePoint::duration(1)) / tick);
+  callback->wheel_ = this;
+  callback->context_ = folly::RequestContext::saveContext();
+  count_++;
+  insert(callback);
+
+  // The armed wake up may already come early enough, it never comes later
+  // than the first expiration
+  if (callback->expirationTick_ < armedTick_) {
+    scheduleNextWakeup();
+  }
+}
+
+void TimerWheel::insert(Callback* callback) {
+  uint64_t expiration = std::max(callback->expirationTick_, nextTick_);
+  uint64_t delta = expiration - nextTick_;
+  if (delta >= kMaxTicks) {
+    expiration = nextTick_ + kMaxTicks - 1;
+    delta = kMaxTicks - 1;
+  }
+  uint32_t level = 0;
+  while (delta >> (kBitsPerLevel * (level + 1))) {
+    level++;
+  }
+  uint32_t slot = (expiration >> (kBitsPerLevel * level)) & kSlotMask;
+  levels_[level].slots[slot].push_back(*callback);
+  levels_[level].setOccupied(slot);
+}
+
+void TimerWheel::cancel(Callback* callback) {
+  DCHECK_EQ(callback->wheel_, this);
+  callback->hook_.unlink();
+  callback->wheel_ = nullptr;
+  callback->context_.reset();
+  count_--;
+  // The wake up stays armed; it is cheaper to wake up for nothing than to
+  // re-arm on every cancel
+}
+
+void TimerWheel::cascade(uint32_t level) {
+  uint32_t slot = (nextTick_ >> (kBitsPerLevel * level)) & kSlotMask;
+  CallbackList callbacks;
+  callbacks.splice(callbacks.end(), levels_[level].slots[slot]);
+  levels_[level].clearOccupied(slot);
+  while (!callbacks.empty()) {
+    auto& callback = callbacks.front();
+    callbacks.pop_front();
+    insert(&callback);
+  }
+}
+
+void TimerWheel::advance(uint64_t tick) {
+  while (nextTick_ <= tick) {
+    uint32_t index = nextTick_ & kSlotMask;
+    if (index == 0) {
+      // Level 0 wrapped: bring down the next slot of each level above that
+      // wrapped as well
+      for (uint32_t level = 1; level < kLevels; level++) {
+        cascade(level);
+        if ((nextTick_ >> (kBitsPerLevel * level)) & kSlotMask) {
+          break;
+        }
+      }
+    }
+    auto& level0 = levels_[0];
+    uint32_t slot = level0.findOccupied(index);
+    uint64_t slotTick = nextTick_ - index + slot;
+    if (slot < kSlotsPerLevel && slotTick <= tick) {
+      expired_.splice(expired_.end(), level0.slots[slot]);
+      level0.clearOccupied(slot);
+      nextTick_ = slotTick + 1;
+    } else {
+      // Skip the ticks with nothing to expire or cascade
+      nextTick_ = std::min(getNextEventTick(), tick + 1);
+    }
+  }
+}
+
+uint64_t TimerWheel::getNextEventTick() const {
+  uint64_t next = kNotArmed;
+  for (uint32_t level = 0; level < kLevels; level++) {
+    uint32_t shift = kBitsPerLevel * level;
+    uint32_t index = (nextTick_ >> shift) & kSlotMask;
+    uint64_t pageStart =
+      nextTick_ >> (shift + kBitsPerLevel) << (shift + kBitsPerLevel);
+    // The current slot of a level above was cascaded when the wheel entered
+    // it, unless nextTick_ is where it starts
+    bool entered = nextTick_ & ((uint64_t(1) << shift) - 1);
+    uint32_t slot = levels_[level].findOccupied(index + (entered ? 1 : 0));
+    if (slot < kSlotsPerLevel) {
+      next = std::min(next, pageStart + (uint64_t(slot) << shift));
+    } else if (levels_[level].findOccupied(0) < kSlotsPerLevel) {
+      // Only slots for the next page, which are reached when this one ends
+      next = std::min(next,
+                      pageStart + (uint64_t(1) << (shift + kBitsPerLevel)));
+    }
+  }
+  return next;
+}
+
+void TimerWheel::scheduleNextWakeup() {
+  if (inTimeoutExpired_) {
+    // timeoutExpired() does this before it returns
+    return;
+  }
+  if (count_ == 0) {
+    folly::AsyncTimeout::cancelTimeout();
+    armedTick_ = kNotArmed;
+    return;
+  }
+  armedTick_ = getNextEventTick();
+  DCHECK_NE(armedTick_, kNotArmed);
+  auto wakeup = start_ + tick_ * static_cast<int64_t>(armedTick_);
+  auto now = preciseNow();
+  milliseconds delay(0);
+  if (wakeup > now) {
+    // Round up, waking up early would just cost another wake up
+    delay = std::chrono::duration_cast<milliseconds>(wakeup - now);
+    if (now + delay < wakeup) {
+      delay += milliseconds(1);
+    }
+  }
+  // Waking up early for far off callbacks is fine, the next wake up is
+  // scheduled from there
+  auto maxDelay = std::numeric_limits<uint32_t>::max();
+  folly::AsyncTimeout::scheduleTimeout(
+    static_cast<uint32_t>(std::min<int64_t>(delay.count(), maxDelay)));
+}
+
+void TimerWheel::timeoutExpired() noexcept {
+  // If destroy() is called by a callback, delay actual destruction until
+  // timeoutExpired() returns
+  DestructorGuard dg(this);
+
+  DCHECK(!inTimeoutExpired_);
+  inTimeoutExpired_ = true;
+  armedTick_ = kNotArmed;
+  SCOPE_EXIT {
+    inTimeoutExpired_ = false;
+    scheduleNextWakeup();
+  };
+
+  // One clock read for the whole batch.  Callbacks that become due while it
+  // runs wait for the next wake up.  The time may be cached, since being
+  // behind only expires callbacks later.
+  advance(getTickAt(clock_.now()));
+  while (!expired_.empty()) {
+    auto& callback = expired_.front();
+    expired_.pop_front();
+    callback.wheel_ = nullptr;
+    count_--;
+    auto context = std::move(callback.context_);
+    folly::RequestContextScopeGuard rctxScopeGuard(context);
+    callback.timeoutExpired();
+  }
+}
+
+}
@@ -0,0 +1,203 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <folly/IntrusiveList.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/DelayedDestruction.h>
+#include <folly/io/async/Request.h>
+#include <folly/io/async/TimeoutManager.h>
+#include <proxygen/lib/utils/Time.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+namespace folly {
+class EventBase;
+}
+
+namespace proxygen {
+
+class CoarseTimeUtil;
+
+/**
+ * A hierarchical timing wheel: one event base timeout drives any number of
+ * callbacks, each with its own timeout.  Scheduling and cancelling are O(1).
+ *
+ * Time is cut into ticks.  Level 0 has a slot for each of the next 256
+ * ticks, and each level above covers 256 times the range of the one below.
+ * A callback goes into the lowest level that covers its expiration and only
+ * moves down (cascades) when the wheel reaches its slot, so callbacks that
+ * are cancelled before getting close to expiring, like idle timeouts that
+ * are pushed back on every request, are never touched again.
+ *
+ * The wheel only wakes up for occupied slots, and each wake up expires
+ * every due callback as one batch, reading the clock once.  Callbacks fire
+ * no earlier than their timeout and up to one tick late.
+ *
+ * Most code should share the wheel of its event base, see get().
+ */
+class TimerWheel : private folly::AsyncTimeout,
+                   public folly::DelayedDestruction {
+ public:
+  using UniquePtr = std::unique_ptr<TimerWheel, Destructor>;
+
+  static constexpr uint32_t kBitsPerLevel = 8;
+  static constexpr uint32_t kSlotsPerLevel = 1 << kBitsPerLevel;
+  static constexpr uint32_t kLevels = 4;
+
+  /**
+   * A callback to be notified when a timeout has expired.  Like
+   * AsyncTimeoutSet::Callback, but every schedule picks its own timeout.
+   */
+  class Callback {
+   public:
+    Callback() {}
+
+    virtual ~Callback();
+
+    /**
+     * timeoutExpired() is invoked when the timeout has expired.
+     */
+    virtual void timeoutExpired() noexcept = 0;
+
+    /**
+     * Cancel the timeout, if it is running.
+     */
+    void cancelTimeout();
+
+    /**
+     * Return true if this timeout is currently scheduled, and false otherwise.
+     */
+    bool isScheduled() const {
+      return wheel_ != nullptr;
+    }
+
+    /**
+     * The time left until the timeout expires, zero if it is not scheduled.
+     */
+    std::chrono::milliseconds getTimeRemaining() const;
+
+   private:
+    folly::IntrusiveListHook hook_;
+    TimerWheel* wheel_{nullptr};
+    uint64_t expirationTick_{0};
+    std::shared_ptr<folly::RequestContext> context_;
+
+    friend class TimerWheel;
+  };
+
+  /**
+   * @param tick   the resolution of the wheel
+   * @param clock  for tests; must outlive the wheel
+   */
+  explicit TimerWheel(
+    folly::TimeoutManager* timeoutManager,
+    std::chrono::milliseconds tick = std::chrono::milliseconds(1),
+    TimeUtil* clock = nullptr);
+
+  /**
+   * Reads the precise time of clock when scheduling, and its cached time
+   * when expiring a batch.  The cached time can be a loop iteration old,
+   * which only makes callbacks late.  clock must outlive the wheel.
+   */
+  TimerWheel(folly::TimeoutManager* timeoutManager,
+             std::chrono::milliseconds tick,
+             CoarseTimeUtil* clock);
+
+  /**
+   * The wheel of eventBase, created on first use and destroyed with the
+   * event base.  Must be called from the event base thread.  It reads the
+   * time from the CoarseTimeUtil of the event base.
+   */
+  static TimerWheel& get(folly::EventBase* eventBase);
+
+  /**
+   * Cancels every pending callback without invoking it and destroys the
+   * wheel.
+   */
+  void destroy() override;
+
+  /**
+   * Schedule callback to be invoked after timeout.  If the callback is
+   * already scheduled, on this or another wheel, that timeout is cancelled.
+   */
+  void scheduleTimeout(Callback* callback, std::chrono::milliseconds timeout);
+
+  std::chrono::milliseconds getTick() const {
+    return tick_;
+  }
+
+  /**
+   * The number of scheduled callbacks.
+   */
+  size_t count() const {
+    return count_;
+  }
+
+ protected:
+  ~TimerWheel() override;
+
+ private:
+  using CallbackList = folly::IntrusiveList<Callback, &Callback::hook_>;
+
+  struct Level {
+    std::array<CallbackList, kSlotsPerLevel> slots;
+    // A set bit may belong to a slot whose callbacks were all cancelled
+    std::array<uint64_t, kSlotsPerLevel / 64> occupied{};
+
+    void setOccupied(uint32_t slot) {
+      occupied[slot / 64] |= uint64_t(1) << (slot % 64);
+    }
+    void clearOccupied(uint32_t slot) {
+      occupied[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    }
+    // The first slot at or after start that may be occupied, or
+    // kSlotsPerLevel
+    uint32_t findOccupied(uint32_t start) const;
+  };
+
+  TimerWheel(TimerWheel const &) = delete;
+  TimerWheel& operator=(TimerWheel const &) = delete;
+
+  // The time to schedule from, never behind the real time
+  TimePoint preciseNow() const;
+  uint64_t getTickAt(TimePoint time) const;
+  void insert(Callback* callback);
+  void cancel(Callback* callback);
+  void cascade(uint32_t level);
+  // Moves the callbacks due up to and including tick to expired_
+  void advance(uint64_t tick);
+  // The first tick from nextTick_ on with callbacks to expire or cascade
+  uint64_t getNextEventTick() const;
+  void scheduleNextWakeup();
+
+  // Methods inherited from AsyncTimeout
+  void timeoutExpired() noexcept override;
+
+  const std::chrono::milliseconds tick_;
+  TimeUtil defaultClock_;
+  TimeUtil& clock_;
+  CoarseTimeUtil* coarseClock_{nullptr};
+  const TimePoint start_;
+  // The next tick advance() will process
+  uint64_t nextTick_{0};
+  // The tick the AsyncTimeout is scheduled for, max if it is not
+  uint64_t armedTick_{std::numeric_limits<uint64_t>::max()};
+  std::array<Level, kLevels> levels_;
+  CallbackList expired_;
+  size_t count_{0};
+  bool inTimeoutExpired_{false};
+};
+
+}
@@ -29,9 +29,13 @@ std::ostream& operator<<(std::ostream& os, TraceFieldType fieldType) {
 
 TraceEvent::TraceEvent(TraceEventType type, uint32_t parentID):
   type_(type),
+  id_(nextID()),
   parentID_(parentID) {
+}
+
+uint32_t TraceEvent::nextID() {
   static std::atomic<uint32_t> counter(0);
-  id_ = counter++;
+  return counter++;
 }
 
 void TraceEvent::start(const TimeUtil& tm) {
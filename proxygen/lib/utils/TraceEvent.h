@@ -139,6 +139,12 @@ class TraceEvent {
 
   FB_EXPORT explicit TraceEvent(TraceEventType type, uint32_t parentID = 0);
 
+  /**
+   * Returns a fresh event id.  Shared with BinaryTraceEvent so that ids stay
+   * unique across both representations.
+   */
+  FB_EXPORT static uint32_t nextID();
+
   /**
    * Sets the start time to the current time according to the TimeUtil.
    */
@@ -245,6 +251,7 @@ class TraceEvent {
                                     const TraceEvent& event);
 
   friend class Iterator;
+  friend class BinaryTraceEvent;
 
  private:
   template<typename T>
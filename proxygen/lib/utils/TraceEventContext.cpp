@@ -10,6 +10,7 @@
 
 #include <proxygen/lib/utils/TraceEventContext.h>
 #include <proxygen/lib/utils/TraceEventObserver.h>
+#include <proxygen/lib/utils/TraceEventRecorder.h>
 
 namespace proxygen {
 
@@ -19,6 +20,16 @@ void TraceEventContext::traceEventAvailable(TraceEvent event) {
   }
 }
 
+void TraceEventContext::traceEventAvailable(const BinaryTraceEvent& event) {
+  if (recorder_) {
+    recorder_->record(event);
+    return;
+  }
+  for (const auto observer : observers_) {
+    observer->binaryTraceEventAvailable(event);
+  }
+}
+
 bool TraceEventContext::isAllTraceEventNeeded() const {
   return allTraceEventNeeded_;
 }
@@ -15,7 +15,9 @@
 namespace proxygen {
 
 struct TraceEventObserver;
+class BinaryTraceEvent;
 class TraceEvent;
+class TraceEventRecorder;
 
 class TraceEventContext {
  public:
@@ -41,6 +43,20 @@ class TraceEventContext {
 
   void traceEventAvailable(TraceEvent event);
 
+  /**
+   * Hands event to the recorder if one is set, so that observers run off the
+   * calling thread; otherwise delivers it to the observers right away.
+   */
+  void traceEventAvailable(const BinaryTraceEvent& event);
+
+  /**
+   * Routes binary trace events through recorder, which must outlive this
+   * context and delivers them to its own observers.
+   */
+  void setRecorder(TraceEventRecorder* recorder) {
+    recorder_ = recorder;
+  }
+
   bool isAllTraceEventNeeded() const;
 
  private:
@@ -50,6 +66,8 @@ class TraceEventContext {
   // Whether the observers actually care about all trace events from this
   // context or only necessary ones.
   bool allTraceEventNeeded_;
+
+  TraceEventRecorder* recorder_{nullptr};
 };
 
 }
@@ -9,6 +9,7 @@
  */
 #pragma once
 
+#include <proxygen/lib/utils/BinaryTraceEvent.h>
 #include <proxygen/lib/utils/TraceEvent.h>
 
 namespace proxygen {
@@ -20,6 +21,12 @@ struct TraceEventObserver {
   virtual ~TraceEventObserver() {}
   virtual void traceEventAvailable(TraceEvent) noexcept {}
   virtual void emitTraceEvents(std::vector<TraceEvent>) noexcept {}
+  // Observers that can consume the binary form directly should override this
+  // to skip the conversion
+  virtual void binaryTraceEventAvailable(
+      const BinaryTraceEvent& event) noexcept {
+    traceEventAvailable(event.toTraceEvent());
+  }
 };
 
 }
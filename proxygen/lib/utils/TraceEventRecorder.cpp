@@ -0,0 +1,98 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <proxygen/lib/utils/TraceEventRecorder.h>
+
+#include <proxygen/lib/utils/TraceEventObserver.h>
+
+#include <algorithm>
+
+namespace proxygen {
+
+constexpr size_t TraceEventRecorder::kDefaultRingCapacity;
+
+TraceEventRecorder::TraceEventRecorder(
+  std::vector<TraceEventObserver*> observers,
+  size_t ringCapacity,
+  std::chrono::milliseconds drainInterval)
+    : observers_(std::move(observers)),
+      ringCapacity_(ringCapacity),
+      drainInterval_(drainInterval) {
+  if (drainInterval_.count() > 0) {
+    drainer_ = std::thread([this] { drainLoop(); });
+  }
+}
+
+TraceEventRecorder::~TraceEventRecorder() {
+  if (drainer_.joinable()) {
+    {
+      std::lock_guard<std::mutex> guard(stopMutex_);
+      stop_ = true;
+    }
+    stopCV_.notify_one();
+    drainer_.join();
+  }
+  drain();
+}
+
+TraceEventRecorder::Ring& TraceEventRecorder::getLocalRing() {
+  auto& ring = *localRing_;
+  if (!ring) {
+    ring = std::make_shared<Ring>(ringCapacity_);
+    rings_.wlock()->push_back(ring);
+  }
+  return *ring;
+}
+
+bool TraceEventRecorder::record(const BinaryTraceEvent& event) noexcept {
+  if (!getLocalRing().queue.write(event)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+size_t TraceEventRecorder::drain() {
+  std::lock_guard<std::mutex> guard(drainMutex_);
+  size_t delivered = 0;
+  {
+    auto rings = rings_.copy();
+    for (auto& ring : rings) {
+      while (auto event = ring->queue.frontPtr()) {
+        for (const auto observer : observers_) {
+          observer->binaryTraceEventAvailable(*event);
+        }
+        ring->queue.popFront();
+        delivered++;
+      }
+    }
+  }
+  // Forget the rings of threads that have exited once they are empty.  The
+  // registry then holds the last reference, and nothing can write to them.
+  auto rings = rings_.wlock();
+  rings->erase(
+    std::remove_if(rings->begin(), rings->end(),
+                   [] (const std::shared_ptr<Ring>& ring) {
+                     return ring.use_count() == 1 && ring->queue.isEmpty();
+                   }),
+    rings->end());
+  return delivered;
+}
+
+void TraceEventRecorder::drainLoop() {
+  std::unique_lock<std::mutex> lock(stopMutex_);
+  while (!stop_) {
+    stopCV_.wait_for(lock, drainInterval_, [this] { return stop_; });
+    lock.unlock();
+    drain();
+    lock.lock();
+  }
+}
+
+}
@@ -0,0 +1,110 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#pragma once
+
+#include <proxygen/lib/utils/BinaryTraceEvent.h>
+
+#include <folly/ProducerConsumerQueue.h>
+#include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace proxygen {
+
+struct TraceEventObserver;
+
+/**
+ * Moves BinaryTraceEvents off the threads that produce them.  Every recording
+ * thread gets its own single producer, single consumer ring, so record() is a
+ * lock-free copy into memory only that thread writes.  A drainer thread
+ * empties the rings every drainInterval and hands the events to the observers,
+ * which therefore run on the drainer thread and not on the event base that
+ * produced the event.
+ *
+ * When a ring is full the event is dropped and counted rather than blocking
+ * the producer.
+ */
+class TraceEventRecorder {
+ public:
+  static constexpr size_t kDefaultRingCapacity = 4096;
+
+  /**
+   * @param observers       must outlive the recorder
+   * @param ringCapacity    events buffered per recording thread
+   * @param drainInterval   how often the drainer thread runs; zero disables
+   *                        the thread and events are only delivered by drain()
+   */
+  explicit TraceEventRecorder(
+    std::vector<TraceEventObserver*> observers,
+    size_t ringCapacity = kDefaultRingCapacity,
+    std::chrono::milliseconds drainInterval = std::chrono::milliseconds(10));
+
+  /**
+   * Stops the drainer and delivers whatever is still buffered.
+   */
+  ~TraceEventRecorder();
+
+  TraceEventRecorder(const TraceEventRecorder&) = delete;
+  TraceEventRecorder& operator=(const TraceEventRecorder&) = delete;
+
+  /**
+   * Buffers event in the calling thread's ring.  @Returns false if the ring
+   * was full and the event was dropped.
+   */
+  bool record(const BinaryTraceEvent& event) noexcept;
+
+  /**
+   * Delivers every buffered event to the observers on the calling thread and
+   * returns how many were delivered.
+   */
+  size_t drain();
+
+  uint64_t getNumDropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Ring {
+    // One slot of a ProducerConsumerQueue always stays empty
+    explicit Ring(size_t capacity) : queue(capacity + 1) {}
+
+    folly::ProducerConsumerQueue<BinaryTraceEvent> queue;
+  };
+
+  Ring& getLocalRing();
+  void drainLoop();
+
+  const std::vector<TraceEventObserver*> observers_;
+  const size_t ringCapacity_;
+  const std::chrono::milliseconds drainInterval_;
+
+  // Every ring ever handed to a thread, until the thread exits and the ring
+  // has been emptied
+  folly::Synchronized<std::vector<std::shared_ptr<Ring>>> rings_;
+  folly::ThreadLocal<std::shared_ptr<Ring>> localRing_;
+  std::atomic<uint64_t> dropped_{0};
+
+  // Each ring must only have one consumer at a time
+  std::mutex drainMutex_;
+
+  std::mutex stopMutex_;
+  std::condition_variable stopCV_;
+  bool stop_{false};
+  std::thread drainer_;
+};
+
+}
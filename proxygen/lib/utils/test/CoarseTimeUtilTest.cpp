@@ -0,0 +1,48 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/utils/CoarseTimeUtil.h>
+#include <proxygen/lib/utils/test/MockTime.h>
+
+using namespace proxygen;
+using std::chrono::milliseconds;
+
+TEST(CoarseTimeUtilTest, OneReadPerLoop) {
+  folly::EventBase evb;
+  MockTimeUtil mockClock;
+  mockClock.advance(milliseconds(100));
+  CoarseTimeUtil clock(&evb, &mockClock);
+
+  auto start = clock.now();
+  EXPECT_EQ(start, mockClock.now());
+  mockClock.advance(milliseconds(5));
+  EXPECT_EQ(clock.now(), start);
+
+  // The precise time refreshes the cached one
+  EXPECT_EQ(clock.preciseNow(), start + milliseconds(5));
+  EXPECT_EQ(clock.now(), start + milliseconds(5));
+
+  mockClock.advance(milliseconds(5));
+  evb.loopOnce();
+  EXPECT_EQ(clock.now(), start + milliseconds(10));
+}
+
+TEST(CoarseTimeUtilTest, PerEventBase) {
+  folly::EventBase evb;
+  MockTimeUtil mockClock;
+  auto& clock = CoarseTimeUtil::get(&evb);
+  EXPECT_EQ(&clock, &CoarseTimeUtil::get(&evb));
+
+  clock.now();
+  clock.setClock(&mockClock);
+  EXPECT_EQ(clock.now(), mockClock.now());
+  clock.setClock(nullptr);
+}
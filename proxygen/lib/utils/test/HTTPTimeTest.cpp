@@ -10,6 +10,7 @@
 #include <folly/portability/GTest.h>
 #include <proxygen/lib/utils/HTTPTime.h>
 
+using proxygen::formatHTTPDateTime;
 using proxygen::parseHTTPDateTime;
 
 TEST(HTTPTimeTests, InvalidTimeTest) {
@@ -87,3 +88,12 @@ TEST(HTTPTimeTests, TzToUnixTsTest) {
   auto o = parseHTTPDateTime("Thu, 01 Jan 1970 00:00:01");
   EXPECT_FALSE(o.hasValue());
 }
+
+TEST(HTTPTimeTests, FormatTimeTest) {
+  EXPECT_EQ(formatHTTPDateTime(0), "Thu, 01 Jan 1970 00:00:00 GMT");
+  EXPECT_EQ(formatHTTPDateTime(1528926229),
+            "Wed, 13 Jun 2018 21:43:49 GMT");
+  auto roundTrip = parseHTTPDateTime(formatHTTPDateTime(784111777));
+  ASSERT_TRUE(roundTrip.hasValue());
+  EXPECT_EQ(roundTrip.value(), 784111777);
+}
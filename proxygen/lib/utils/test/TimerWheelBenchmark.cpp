@@ -0,0 +1,180 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/Benchmark.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HHWheelTimer.h>
+#include <proxygen/lib/utils/AsyncTimeoutSet.h>
+#include <proxygen/lib/utils/TimerWheel.h>
+#include <vector>
+
+using namespace folly;
+using namespace proxygen;
+using std::chrono::milliseconds;
+
+/**
+ * Schedule/cancel churn of a keepalive heavy server: many connections each
+ * holding an idle timeout that is pushed back on every request, and short
+ * lived request timeouts that are almost always cancelled before they fire.
+ *
+ *  KeepaliveChurn  reschedules one of --timeouts outstanding 60s timeouts
+ *  ScheduleCancel  schedules a 5s timeout and cancels it, with --timeouts
+ *                  60s timeouts outstanding
+ *
+ * None of the timeouts fire while the benchmark runs.
+ */
+
+DEFINE_uint32(timeouts, 100000, "Outstanding timeouts");
+
+namespace {
+
+const milliseconds kIdleTimeout(60000);
+const milliseconds kRequestTimeout(5000);
+
+class WheelCallback : public TimerWheel::Callback {
+ public:
+  void timeoutExpired() noexcept override {}
+};
+
+class HHWheelCallback : public HHWheelTimer::Callback {
+ public:
+  void timeoutExpired() noexcept override {}
+};
+
+class TimeoutSetCallback : public AsyncTimeoutSet::Callback {
+ public:
+  void timeoutExpired() noexcept override {}
+};
+
+/**
+ * Adapts each timer to schedule(callback, timeout).  AsyncTimeoutSet has a
+ * fixed interval, so it gets a set per timeout.
+ */
+struct Wheel {
+  using Callback = WheelCallback;
+
+  explicit Wheel(EventBase* evb)
+      : wheel(new TimerWheel(evb)) {}
+
+  void schedule(Callback* callback, milliseconds timeout) {
+    wheel->scheduleTimeout(callback, timeout);
+  }
+
+  TimerWheel::UniquePtr wheel;
+};
+
+struct HHWheel {
+  using Callback = HHWheelCallback;
+
+  explicit HHWheel(EventBase* evb)
+      : timer(HHWheelTimer::newTimer(evb)) {}
+
+  void schedule(Callback* callback, milliseconds timeout) {
+    timer->scheduleTimeout(callback, timeout);
+  }
+
+  HHWheelTimer::UniquePtr timer;
+};
+
+struct TimeoutSet {
+  using Callback = TimeoutSetCallback;
+
+  explicit TimeoutSet(EventBase* evb)
+      : idle(new AsyncTimeoutSet(evb, kIdleTimeout)),
+        request(new AsyncTimeoutSet(evb, kRequestTimeout)) {}
+
+  void schedule(Callback* callback, milliseconds timeout) {
+    (timeout == kIdleTimeout ? idle : request)->scheduleTimeout(callback);
+  }
+
+  AsyncTimeoutSet::UniquePtr idle;
+  AsyncTimeoutSet::UniquePtr request;
+};
+
+template <typename Timer>
+void keepaliveChurn(size_t iters) {
+  EventBase evb;
+  std::unique_ptr<Timer> timer;
+  std::vector<typename Timer::Callback> callbacks;
+  BENCHMARK_SUSPEND {
+    timer = std::make_unique<Timer>(&evb);
+    callbacks = std::vector<typename Timer::Callback>(FLAGS_timeouts);
+    for (auto& callback : callbacks) {
+      timer->schedule(&callback, kIdleTimeout);
+    }
+  }
+  for (size_t i = 0; i < iters; i++) {
+    timer->schedule(&callbacks[i % callbacks.size()], kIdleTimeout);
+  }
+  BENCHMARK_SUSPEND {
+    for (auto& callback : callbacks) {
+      callback.cancelTimeout();
+    }
+    timer.reset();
+  }
+}
+
+template <typename Timer>
+void scheduleCancel(size_t iters) {
+  EventBase evb;
+  std::unique_ptr<Timer> timer;
+  std::vector<typename Timer::Callback> callbacks;
+  typename Timer::Callback request;
+  BENCHMARK_SUSPEND {
+    timer = std::make_unique<Timer>(&evb);
+    callbacks = std::vector<typename Timer::Callback>(FLAGS_timeouts);
+    for (auto& callback : callbacks) {
+      timer->schedule(&callback, kIdleTimeout);
+    }
+  }
+  for (size_t i = 0; i < iters; i++) {
+    timer->schedule(&request, kRequestTimeout);
+    request.cancelTimeout();
+  }
+  BENCHMARK_SUSPEND {
+    for (auto& callback : callbacks) {
+      callback.cancelTimeout();
+    }
+    timer.reset();
+  }
+}
+
+}
+
+BENCHMARK(KeepaliveChurnTimerWheel, iters) {
+  keepaliveChurn<Wheel>(iters);
+}
+
+BENCHMARK_RELATIVE(KeepaliveChurnHHWheelTimer, iters) {
+  keepaliveChurn<HHWheel>(iters);
+}
+
+BENCHMARK_RELATIVE(KeepaliveChurnAsyncTimeoutSet, iters) {
+  keepaliveChurn<TimeoutSet>(iters);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(ScheduleCancelTimerWheel, iters) {
+  scheduleCancel<Wheel>(iters);
+}
+
+BENCHMARK_RELATIVE(ScheduleCancelHHWheelTimer, iters) {
+  scheduleCancel<HHWheel>(iters);
+}
+
+BENCHMARK_RELATIVE(ScheduleCancelAsyncTimeoutSet, iters) {
+  scheduleCancel<TimeoutSet>(iters);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
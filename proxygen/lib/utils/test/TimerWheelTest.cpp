@@ -0,0 +1,394 @@
+/*
+ *  Copyright (c) 2019-present, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ *
+ */
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventUtil.h>
+#include <folly/io/async/test/MockTimeoutManager.h>
+#include <folly/io/async/test/UndelayedDestruction.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/utils/CoarseTimeUtil.h>
+#include <proxygen/lib/utils/TimerWheel.h>
+#include <proxygen/lib/utils/test/MockTime.h>
+#include <boost/container/flat_map.hpp>
+#include <functional>
+#include <vector>
+
+using namespace proxygen;
+using namespace testing;
+using folly::AsyncTimeout;
+using folly::test::MockTimeoutManager;
+using std::chrono::milliseconds;
+
+using StackTimerWheel = folly::UndelayedDestruction<TimerWheel>;
+
+class TestCallback : public TimerWheel::Callback {
+ public:
+  explicit TestCallback(MockTimeUtil& clock) : clock_(clock) {}
+
+  void timeoutExpired() noexcept override {
+    timestamps.push_back(now());
+    if (fn) {
+      fn();
+    }
+  }
+
+  milliseconds now() const {
+    return std::chrono::duration_cast<milliseconds>(
+      clock_.now().time_since_epoch());
+  }
+
+  std::vector<milliseconds> timestamps;
+  std::function<void()> fn;
+
+ private:
+  MockTimeUtil& clock_;
+};
+
+class TimerWheelTest : public testing::Test {
+ public:
+  void SetUp() override {
+    EXPECT_CALL(timeoutManager_, attachTimeoutManager(_, _))
+      .WillRepeatedly(Return());
+
+    EXPECT_CALL(timeoutManager_, scheduleTimeout(_, _))
+      .WillRepeatedly(Invoke([this] (AsyncTimeout* p, milliseconds t) {
+            timeoutManager_.cancelTimeout(p);
+            folly::event_ref_flags(p->getEvent()) |= EVLIST_TIMEOUT;
+            timeouts_.emplace(t + now(), p);
+            wakeups_++;
+            return true;
+          }));
+
+    EXPECT_CALL(timeoutManager_, cancelTimeout(_))
+      .WillRepeatedly(Invoke([this] (AsyncTimeout* p) {
+            for (auto it = timeouts_.begin(); it != timeouts_.end(); it++) {
+              if (it->second == p) {
+                timeouts_.erase(it);
+                break;
+              }
+            }
+          }));
+  }
+
+  milliseconds now() const {
+    return std::chrono::duration_cast<milliseconds>(
+      clock_.now().time_since_epoch());
+  }
+
+  /**
+   * Advances the clock to ms, firing the timeouts that are due on the way.
+   */
+  void setClock(milliseconds ms) {
+    while (!timeouts_.empty() && timeouts_.begin()->first <= ms) {
+      fireNext();
+    }
+    if (ms > now()) {
+      clock_.advance(ms - now());
+    }
+  }
+
+  /**
+   * Fires timeouts until there are none left.
+   */
+  void loop() {
+    while (!timeouts_.empty()) {
+      fireNext();
+    }
+  }
+
+ protected:
+  void fireNext() {
+    auto it = timeouts_.begin();
+    if (it->first > now()) {
+      clock_.advance(it->first - now());
+    }
+    AsyncTimeout* timeout = it->second;
+    timeouts_.erase(it);
+    folly::event_ref_flags(timeout->getEvent()) &= ~EVLIST_TIMEOUT;
+    timeout->timeoutExpired();
+  }
+
+  MockTimeoutManager timeoutManager_;
+  MockTimeUtil clock_;
+  boost::container::flat_multimap<milliseconds, AsyncTimeout*> timeouts_;
+  uint32_t wakeups_{0};
+};
+
+/*
+ * Test callbacks with different timeouts fire in order, on time
+ */
+TEST_F(TimerWheelTest, FireOnce) {
+  StackTimerWheel wheel(&timeoutManager_, milliseconds(1), &clock_);
+
+  TestCallback t1(clock_);
+  TestCallback t2(clock_);
+  TestCallback t3(clock_);
+
+  wheel.scheduleTimeout(&t1, milliseconds(5));
+  setClock(milliseconds(2));
+  wheel.scheduleTimeout(&t2, milliseconds(10));
+  wheel.scheduleTimeout(&t3, milliseconds(3));
+  EXPECT_EQ(wheel.count(), 3);
+  EXPECT_TRUE(t1.isScheduled());
+  EXPECT_EQ(t2.getTimeRemaining(), milliseconds(10));
+
+  setClock(milliseconds(5));
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  ASSERT_EQ(t3.timestamps.size(), 1);
+  EXPECT_EQ(t1.timestamps[0], milliseconds(5));
+  EXPECT_EQ(t3.timestamps[0], milliseconds(5));
+  EXPECT_FALSE(t1.isScheduled());
+  EXPECT_EQ(t2.getTimeRemaining(), milliseconds(7));
+
+  loop();
+  ASSERT_EQ(t2.timestamps.size(), 1);
+  EXPECT_EQ(t2.timestamps[0], milliseconds(12));
+  EXPECT_EQ(wheel.count(), 0);
+}
+
+/*
+ * Test due callbacks fire as one batch, with a single wake up
+ */
+TEST_F(TimerWheelTest, BatchedExpiry) {
+  StackTimerWheel wheel(&timeoutManager_, milliseconds(1), &clock_);
+
+  std::vector<std::unique_ptr<TestCallback>> callbacks;
+  for (uint32_t i = 0; i < 100; i++) {
+    callbacks.emplace_back(new TestCallback(clock_));
+    wheel.scheduleTimeout(callbacks.back().get(), milliseconds(10 + i % 3));
+  }
+  auto armed = wakeups_;
+
+  // The loop was blocked until t=20, everything expires at once
+  clock_.advance(milliseconds(20));
+  fireNext();
+  for (auto& callback : callbacks) {
+    ASSERT_EQ(callback->timestamps.size(), 1);
+    EXPECT_EQ(callback->timestamps[0], milliseconds(20));
+  }
+  EXPECT_EQ(wakeups_, armed);
+  EXPECT_TRUE(timeouts_.empty());
+}
+
+/*
+ * Test a coarser tick rounds timeouts up, never firing them early
+ */
+TEST_F(TimerWheelTest, CoarseTick) {
+  StackTimerWheel wheel(&timeoutManager_, milliseconds(10), &clock_);
+
+  TestCallback t1(clock_);
+  TestCallback t2(clock_);
+
+  setClock(milliseconds(3));
+  wheel.scheduleTimeout(&t1, milliseconds(1));
+  wheel.scheduleTimeout(&t2, milliseconds(17));
+
+  loop();
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  ASSERT_EQ(t2.timestamps.size(), 1);
+  EXPECT_EQ(t1.timestamps[0], milliseconds(10));
+  EXPECT_EQ(t2.timestamps[0], milliseconds(20));
+}
+
+/*
+ * Test a wheel on a coarse clock schedules from the precise time, so a
+ * callback scheduled after a slow handler does not fire early
+ */
+TEST_F(TimerWheelTest, CoarseClock) {
+  folly::EventBase evb;
+  CoarseTimeUtil coarse(&evb, &clock_);
+  StackTimerWheel wheel(&timeoutManager_, milliseconds(1), &coarse);
+
+  TestCallback t1(clock_);
+  TestCallback t2(clock_);
+
+  coarse.now();
+  wheel.scheduleTimeout(&t1, milliseconds(20));
+  // A handler runs for 18ms after the time was cached
+  clock_.advance(milliseconds(18));
+  wheel.scheduleTimeout(&t2, milliseconds(25));
+  evb.loopOnce();
+
+  loop();
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  ASSERT_EQ(t2.timestamps.size(), 1);
+  EXPECT_EQ(t1.timestamps[0], milliseconds(20));
+  EXPECT_EQ(t2.timestamps[0], milliseconds(43));
+}
+
+/*
+ * Test cancelling and rescheduling, including from a callback
+ */
+TEST_F(TimerWheelTest, CancelAndReschedule) {
+  StackTimerWheel wheel(&timeoutManager_, milliseconds(1), &clock_);
+
+  TestCallback t5_1(clock_);
+  TestCallback t5_2(clock_);
+  TestCallback t5_3(clock_);
+  TestCallback t10(clock_);
+  TestCallback t20(clock_);
+
+  wheel.scheduleTimeout(&t5_1, milliseconds(5));
+  wheel.scheduleTimeout(&t5_2, milliseconds(5));
+  wheel.scheduleTimeout(&t5_3, milliseconds(5));
+  wheel.scheduleTimeout(&t10, milliseconds(10));
+  wheel.scheduleTimeout(&t20, milliseconds(20));
+
+  // Cancel a callback that is due in the same batch, and one that is not
+  t5_1.fn = [&] {
+    t5_2.cancelTimeout();
+    t20.cancelTimeout();
+  };
+  t5_3.fn = [&] {
+    t5_3.fn = nullptr;
+    wheel.scheduleTimeout(&t5_3, milliseconds(5));
+  };
+  // Pushing a callback back does not fire it at its old time
+  setClock(milliseconds(4));
+  wheel.scheduleTimeout(&t10, milliseconds(10));
+
+  loop();
+  ASSERT_EQ(t5_1.timestamps.size(), 1);
+  EXPECT_EQ(t5_1.timestamps[0], milliseconds(5));
+  EXPECT_EQ(t5_2.timestamps.size(), 0);
+  ASSERT_EQ(t5_3.timestamps.size(), 2);
+  EXPECT_EQ(t5_3.timestamps[1], milliseconds(10));
+  ASSERT_EQ(t10.timestamps.size(), 1);
+  EXPECT_EQ(t10.timestamps[0], milliseconds(14));
+  EXPECT_EQ(t20.timestamps.size(), 0);
+  EXPECT_EQ(wheel.count(), 0);
+  // Nothing left to wait for
+  EXPECT_EQ(now(), milliseconds(14));
+}
+
+/*
+ * Test timeouts on every level of the wheel, which cascade down as they get
+ * closer to expiring
+ */
+TEST_F(TimerWheelTest, Cascade) {
+  StackTimerWheel wheel(&timeoutManager_, milliseconds(1), &clock_);
+
+  std::vector<milliseconds> intervals = {
+    milliseconds(255), milliseconds(256), milliseconds(300),
+    milliseconds(65535), milliseconds(65536), milliseconds(70000),
+    milliseconds(16777216), milliseconds(20000000)};
+  std::vector<std::unique_ptr<TestCallback>> callbacks;
+  // Start mid page, so that slots do not line up with the intervals
+  setClock(milliseconds(100));
+  for (auto interval : intervals) {
+    callbacks.emplace_back(new TestCallback(clock_));
+    wheel.scheduleTimeout(callbacks.back().get(), interval);
+  }
+
+  loop();
+  for (size_t i = 0; i < intervals.size(); i++) {
+    ASSERT_EQ(callbacks[i]->timestamps.size(), 1) << intervals[i].count();
+    EXPECT_EQ(callbacks[i]->timestamps[0], milliseconds(100) + intervals[i]);
+  }
+}
+
+/*
+ * Test scheduling while the wheel is behind the clock, waiting for a far off
+ * callback, where the slot the new callback cascades from starts on the tick
+ * after the current one
+ */
+TEST_F(TimerWheelTest, ScheduleWhileBehind) {
+  StackTimerWheel wheel(&timeoutManager_, milliseconds(1), &clock_);
+
+  TestCallback t1(clock_);
+  TestCallback t2(clock_);
+  wheel.scheduleTimeout(&t1, milliseconds(20000000));
+  setClock(milliseconds(500223));
+  // Cascades from level 2 to the level 1 slot starting at 500224
+  wheel.scheduleTimeout(&t2, milliseconds(77));
+
+  setClock(milliseconds(600000));
+  ASSERT_EQ(t2.timestamps.size(), 1);
+  EXPECT_EQ(t2.timestamps[0], milliseconds(500300));
+  loop();
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  EXPECT_EQ(t1.timestamps[0], milliseconds(20000000));
+}
+
+/*
+ * Test a timeout beyond the range of the wheel still fires on time
+ */
+TEST_F(TimerWheelTest, BeyondRange) {
+  StackTimerWheel wheel(&timeoutManager_, milliseconds(1000), &clock_);
+
+  TestCallback t(clock_);
+  // The wheel covers 2^32 ticks, about 136 years at this tick
+  milliseconds timeout(5000000000000);
+  wheel.scheduleTimeout(&t, timeout);
+  loop();
+  ASSERT_EQ(t.timestamps.size(), 1);
+  EXPECT_EQ(t.timestamps[0], timeout);
+}
+
+/*
+ * Test scheduling again after the wheel was idle for a while
+ */
+TEST_F(TimerWheelTest, Idle) {
+  StackTimerWheel wheel(&timeoutManager_, milliseconds(1), &clock_);
+
+  TestCallback t(clock_);
+  wheel.scheduleTimeout(&t, milliseconds(1));
+  loop();
+  setClock(milliseconds(1000000));
+  wheel.scheduleTimeout(&t, milliseconds(300));
+  loop();
+  ASSERT_EQ(t.timestamps.size(), 2);
+  EXPECT_EQ(t.timestamps[1], milliseconds(1000300));
+}
+
+/*
+ * Test destroying a wheel with callbacks outstanding, including from a
+ * callback
+ */
+TEST_F(TimerWheelTest, DestroyTimerWheel) {
+  TimerWheel::UniquePtr wheel(
+    new TimerWheel(&timeoutManager_, milliseconds(1), &clock_));
+
+  TestCallback t1(clock_);
+  TestCallback t2(clock_);
+  TestCallback t3(clock_);
+  TestCallback t4(clock_);
+
+  wheel->scheduleTimeout(&t1, milliseconds(5));
+  wheel->scheduleTimeout(&t2, milliseconds(5));
+  wheel->scheduleTimeout(&t3, milliseconds(5));
+  wheel->scheduleTimeout(&t4, milliseconds(500));
+
+  // Destroy the wheel in its own timeoutExpired()
+  t1.fn = [&] { wheel.reset(); };
+  loop();
+
+  EXPECT_EQ(t1.timestamps.size(), 1);
+  EXPECT_EQ(t2.timestamps.size() + t3.timestamps.size(), 0);
+  EXPECT_EQ(t4.timestamps.size(), 0);
+  EXPECT_FALSE(t2.isScheduled());
+  EXPECT_FALSE(t4.isScheduled());
+}
+
+/*
+ * Test a callback deleted while scheduled is cancelled
+ */
+TEST_F(TimerWheelTest, DeleteCallback) {
+  StackTimerWheel wheel(&timeoutManager_, milliseconds(1), &clock_);
+
+  auto t1 = std::make_unique<TestCallback>(clock_);
+  TestCallback t2(clock_);
+  wheel.scheduleTimeout(t1.get(), milliseconds(5));
+  wheel.scheduleTimeout(&t2, milliseconds(5));
+  t1.reset();
+  EXPECT_EQ(wheel.count(), 1);
+
+  loop();
+  EXPECT_EQ(t2.timestamps.size(), 1);
+}
@@ -7,15 +7,21 @@
  *  of patent rights can be found in the PATENTS file in the same directory.
  *
  */
+#include <proxygen/lib/utils/BinaryTraceEvent.h>
 #include <proxygen/lib/utils/Exception.h>
 #include <proxygen/lib/utils/TraceEvent.h>
+#include <proxygen/lib/utils/TraceEventContext.h>
+#include <proxygen/lib/utils/TraceEventObserver.h>
+#include <proxygen/lib/utils/TraceEventRecorder.h>
 #include <proxygen/lib/utils/TraceEventType.h>
 #include <proxygen/lib/utils/TraceFieldType.h>
 
 #include <folly/portability/GTest.h>
 #include <folly/portability/GMock.h>
 
+#include <algorithm>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace proxygen;
@@ -247,3 +253,155 @@ TEST(TraceEventTest, StringArrayValueToString) {
 
   ASSERT_EQ(out.str(), traceEvent.toString());
 }
+
+TEST(TraceEventTest, BinaryToTraceEvent) {
+  BinaryTraceEvent binary(TraceEventType::TotalRequest, 1);
+  binary.start(TimePoint(std::chrono::milliseconds(100)));
+  binary.end(TimePoint(std::chrono::milliseconds(200)));
+  binary.addMeta(TraceFieldType::StatusCode, 200);
+  binary.addMeta(TraceFieldType::IsSecure, true);
+  binary.addMeta(TraceFieldType::Protocol, "h2");
+  binary.addMeta(TraceFieldType::CallPath,
+                 std::vector<std::string>{"A", "", "C"});
+  binary.addMeta(TraceFieldType::Uri, std::vector<std::string>{});
+  // replaces the earlier value
+  binary.addMeta(TraceFieldType::StatusCode, 404);
+  EXPECT_FALSE(binary.isTruncated());
+  EXPECT_EQ(5, binary.getNumFields());
+
+  auto event = binary.toTraceEvent();
+  EXPECT_EQ(binary.getID(), event.getID());
+  EXPECT_EQ(1, event.getParentID());
+  EXPECT_EQ(TraceEventType::TotalRequest, event.getType());
+  EXPECT_TRUE(event.hasStarted());
+  EXPECT_TRUE(event.hasEnded());
+  EXPECT_EQ(binary.getStartTime(), event.getStartTime());
+  EXPECT_EQ(binary.getEndTime(), event.getEndTime());
+  EXPECT_EQ(404,
+      event.getTraceFieldDataAs<int64_t>(TraceFieldType::StatusCode));
+  bool isSecure = false;
+  EXPECT_TRUE(event.readBoolMeta(TraceFieldType::IsSecure, isSecure));
+  EXPECT_TRUE(isSecure);
+  EXPECT_EQ("h2",
+      event.getTraceFieldDataAs<std::string>(TraceFieldType::Protocol));
+  EXPECT_EQ((std::vector<std::string>{"A", "", "C"}),
+      event.getTraceFieldDataAs<std::vector<std::string>>(
+          TraceFieldType::CallPath));
+  EXPECT_TRUE(event.getTraceFieldDataAs<std::vector<std::string>>(
+                TraceFieldType::Uri).empty());
+}
+
+TEST(TraceEventTest, BinaryTruncation) {
+  BinaryTraceEvent binary(TraceEventType::TotalRequest);
+  std::string longValue(BinaryTraceEvent::kStringCapacity + 10, 'a');
+  EXPECT_FALSE(binary.addMeta(TraceFieldType::Uri, longValue));
+  EXPECT_TRUE(binary.isTruncated());
+  EXPECT_EQ(BinaryTraceEvent::kStringCapacity,
+            binary.getString(*binary.findField(TraceFieldType::Uri)).size());
+  // The arena is full but integers still fit
+  EXPECT_TRUE(binary.addMeta(TraceFieldType::StatusCode, 200));
+
+  const TraceFieldType fields[] = {
+    TraceFieldType::ErrorStage, TraceFieldType::Error,
+    TraceFieldType::ProxygenError, TraceFieldType::HTTPStatus,
+    TraceFieldType::DirectionError, TraceFieldType::CodecError,
+    TraceFieldType::CallPath, TraceFieldType::IsSecure,
+    TraceFieldType::UsingProxy, TraceFieldType::Protocol,
+    TraceFieldType::SecurityProtocol,
+  };
+  size_t added = 0;
+  for (auto field : fields) {
+    added += binary.addMeta(field, 1);
+  }
+  EXPECT_EQ(BinaryTraceEvent::kMaxFields, binary.getNumFields());
+  EXPECT_EQ(BinaryTraceEvent::kMaxFields - 2, added);
+  EXPECT_EQ(BinaryTraceEvent::kMaxFields,
+            binary.toTraceEvent().getMetaData().size());
+}
+
+namespace {
+
+class CountingObserver : public TraceEventObserver {
+ public:
+  void binaryTraceEventAvailable(
+      const BinaryTraceEvent& event) noexcept override {
+    ids.push_back(event.getID());
+  }
+
+  std::vector<uint32_t> ids;
+};
+
+class ConvertingObserver : public TraceEventObserver {
+ public:
+  void traceEventAvailable(TraceEvent event) noexcept override {
+    events.push_back(std::move(event));
+  }
+
+  std::vector<TraceEvent> events;
+};
+
+}
+
+TEST(TraceEventTest, RecorderDrain) {
+  CountingObserver observer;
+  TraceEventRecorder recorder({&observer}, 16, std::chrono::milliseconds(0));
+
+  std::vector<uint32_t> ids;
+  for (int i = 0; i < 4; i++) {
+    BinaryTraceEvent event(TraceEventType::TotalRequest);
+    ids.push_back(event.getID());
+    EXPECT_TRUE(recorder.record(event));
+  }
+  std::thread([&] {
+    for (int i = 0; i < 4; i++) {
+      BinaryTraceEvent event(TraceEventType::TotalRequest);
+      ids.push_back(event.getID());
+      EXPECT_TRUE(recorder.record(event));
+    }
+  }).join();
+  EXPECT_TRUE(observer.ids.empty());
+
+  EXPECT_EQ(8, recorder.drain());
+  std::sort(ids.begin(), ids.end());
+  std::sort(observer.ids.begin(), observer.ids.end());
+  EXPECT_EQ(ids, observer.ids);
+  EXPECT_EQ(0, recorder.drain());
+  EXPECT_EQ(0, recorder.getNumDropped());
+}
+
+TEST(TraceEventTest, RecorderDropsWhenFull) {
+  CountingObserver observer;
+  TraceEventRecorder recorder({&observer}, 2, std::chrono::milliseconds(0));
+  BinaryTraceEvent event(TraceEventType::TotalRequest);
+  EXPECT_TRUE(recorder.record(event));
+  EXPECT_TRUE(recorder.record(event));
+  EXPECT_FALSE(recorder.record(event));
+  EXPECT_EQ(1, recorder.getNumDropped());
+  EXPECT_EQ(2, recorder.drain());
+  EXPECT_TRUE(recorder.record(event));
+}
+
+TEST(TraceEventTest, RecorderDrainerThread) {
+  ConvertingObserver observer;
+  {
+    TraceEventRecorder recorder({&observer});
+    TraceEventContext context;
+    context.setRecorder(&recorder);
+    BinaryTraceEvent event(TraceEventType::TotalRequest);
+    event.addMeta(TraceFieldType::Protocol, "h2");
+    context.traceEventAvailable(event);
+  }
+  // The destructor delivers anything the drainer has not picked up yet
+  ASSERT_EQ(1, observer.events.size());
+  EXPECT_EQ("h2", observer.events[0].getTraceFieldDataAs<std::string>(
+                    TraceFieldType::Protocol));
+}
+
+TEST(TraceEventTest, ContextDeliversBinaryWithoutRecorder) {
+  ConvertingObserver observer;
+  TraceEventContext context(0, &observer);
+  BinaryTraceEvent event(TraceEventType::TotalRequest);
+  context.traceEventAvailable(event);
+  ASSERT_EQ(1, observer.events.size());
+  EXPECT_EQ(event.getID(), observer.events[0].getID());
+}